@@ -34,6 +34,7 @@
 #include "guilib/TextureManager.h"
 #include "cores/IPlayer.h"
 #include "cores/VideoPlayer/DVDFileInfo.h"
+#include "cores/VideoPlayer/DVDPrefetch.h"
 #include "cores/AudioEngine/AEFactory.h"
 #include "cores/AudioEngine/DSPAddons/ActiveAEDSP.h"
 #include "cores/AudioEngine/Utils/AEUtil.h"
@@ -2796,6 +2797,9 @@ bool CApplication::Cleanup()
       m_ServiceManager.reset();
     }
 
+    // close pooled database connections, after everything that writes to them
+    CDatabaseManager::GetInstance().Deinitialize();
+
     return true;
   }
   catch (...)
@@ -3773,6 +3777,39 @@ void CApplication::UpdateFileState()
   }
 }
 
+void CApplication::PrefetchNextItem()
+{
+  if (g_advancedSettings.m_videoPrefetchNextItem <= 0 || !m_pPlayer->IsPlayingVideo())
+    return;
+
+  if (m_itemCurrentFile->IsStack())
+    return;
+
+  double remaining = GetTotalTime() - GetTime();
+  if (GetTotalTime() <= 0 || remaining > g_advancedSettings.m_videoPrefetchNextItem)
+    return;
+
+  int iPlaylist = g_playlistPlayer.GetCurrentPlaylist();
+  if (iPlaylist != PLAYLIST_VIDEO)
+    return;
+
+  int iNext = g_playlistPlayer.GetNextSong();
+  CPlayList& playlist = g_playlistPlayer.GetPlaylist(iPlaylist);
+  if (iNext < 0 || iNext >= playlist.size())
+    return;
+
+  // items which have to be resolved first are opened the regular way
+  const CFileItem& file = *playlist[iNext];
+  if (!file.IsVideo() || file.IsStack() || file.IsPlugin() || URIUtils::IsUPnP(file.GetPath()))
+    return;
+
+  const CPlayerCoreFactory& factory = CPlayerCoreFactory::GetInstance();
+  if (factory.GetPlayerType(factory.GetDefaultPlayer(file)) != "video")
+    return;
+
+  CDVDPrefetch::GetInstance().Prefetch(file);
+}
+
 void CApplication::LoadVideoSettings(const CFileItem& item)
 {
   CVideoDatabase dbs;
@@ -4249,6 +4286,9 @@ bool CApplication::OnMessage(CGUIMessage& message)
         m_pPlayer->m_iPlaySpeed = 1;
       }
 
+      // drop a prefetched item the player did not pick up
+      CDVDPrefetch::GetInstance().Clear();
+
       if (!m_pPlayer->IsPlaying())
       {
         g_audioManager.Enable(true);
@@ -4466,6 +4506,9 @@ void CApplication::ProcessSlow()
   // Store our file state for use on close()
   UpdateFileState();
 
+  // Get the next playlist item ready while the current one ends
+  PrefetchNextItem();
+
   // Check if we need to activate the screensaver / DPMS.
   CheckScreenSaverAndDPMS();
 
@@ -500,6 +500,11 @@ protected:
   PlayBackRet PlayStack(const CFileItem& item, bool bRestart);
   int  GetActiveWindowID(void);
 
+  /*! \brief Open the next video playlist item in the background shortly
+   before the current one ends, see CDVDPrefetch
+  */
+  void PrefetchNextItem();
+
   float NavigationIdleTime();
 
   bool InitDirectoriesLinux();
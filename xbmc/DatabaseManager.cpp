@@ -19,6 +19,7 @@
  */
 
 #include "DatabaseManager.h"
+#include "dbwrappers/DatabasePool.h"
 #include "utils/log.h"
 #include "addons/AddonDatabase.h"
 #include "view/ViewDatabase.h"
@@ -70,8 +71,17 @@ void CDatabaseManager::Initialize(bool addonsOnly)
 
 void CDatabaseManager::Deinitialize()
 {
+  std::vector<DatabasePoolStats> stats;
+  GetPoolStats(stats);
+  for (std::vector<DatabasePoolStats>::const_iterator i = stats.begin(); i != stats.end(); ++i)
+    CLog::Log(LOGDEBUG, "%s, pool %s: opened %u, reused %u, max in use %u, writes %u, waited %u for %.1f ms (max %.1f ms), timed out %u",
+              __FUNCTION__, i->name.c_str(), i->opened, i->reused, i->maxInUse, i->writes, i->writeWaits,
+              i->writeWaitTime / 1000.0, i->writeWaitTimeMax / 1000.0, i->writeTimeouts);
+
   CSingleLock lock(m_section);
   m_dbStatus.clear();
+  // connections still in use close once they are handed back
+  m_pools.clear();
 }
 
 bool CDatabaseManager::CanOpen(const std::string &name)
@@ -83,6 +93,27 @@ bool CDatabaseManager::CanOpen(const std::string &name)
   return false; // db isn't even attempted to update yet
 }
 
+std::shared_ptr<CDatabaseConnectionPool> CDatabaseManager::GetConnectionPool(const std::string &key, const std::string &name, bool sqlite)
+{
+  if (g_advancedSettings.m_databasePoolSize <= 0)
+    return std::shared_ptr<CDatabaseConnectionPool>();
+
+  CSingleLock lock(m_section);
+  std::shared_ptr<CDatabaseConnectionPool> &pool = m_pools[key];
+  if (!pool)
+    pool.reset(new CDatabaseConnectionPool(name, g_advancedSettings.m_databasePoolSize, sqlite));
+  return pool;
+}
+
+void CDatabaseManager::GetPoolStats(std::vector<DatabasePoolStats> &stats)
+{
+  CSingleLock lock(m_section);
+  stats.resize(m_pools.size());
+  size_t n = 0;
+  for (std::map<std::string, std::shared_ptr<CDatabaseConnectionPool> >::const_iterator i = m_pools.begin(); i != m_pools.end(); ++i)
+    i->second->GetStats(stats[n++]);
+}
+
 void CDatabaseManager::UpdateDatabase(CDatabase &db, DatabaseSettings *settings)
 {
   std::string name = db.GetBaseDBName();
@@ -21,11 +21,15 @@
 #pragma once
 
 #include <map>
+#include <memory>
 #include <string>
+#include <vector>
 #include "threads/CriticalSection.h"
 
 class CDatabase;
+class CDatabaseConnectionPool;
 class DatabaseSettings;
+struct DatabasePoolStats;
 
 /*!
  \ingroup database
@@ -64,6 +68,23 @@ public:
    */ 
   bool CanOpen(const std::string &name);
 
+  /*! \brief Get the connection pool of a database.
+
+   The pool is created on first use and shared by all CDatabase instances
+   connecting to the same database.
+
+   \param key identifies the database, e.g. type, host and name.
+   \param name the database name, for the statistics.
+   \param sqlite whether it's a sqlite database, these only allow one writer at a time.
+   \return the pool, or empty if pooling is disabled in advancedsettings.
+   */
+  std::shared_ptr<CDatabaseConnectionPool> GetConnectionPool(const std::string &key, const std::string &name, bool sqlite);
+
+  /*! \brief Get the statistics of all connection pools.
+   \param stats the statistics, one entry per pool.
+   */
+  void GetPoolStats(std::vector<DatabasePoolStats> &stats);
+
 private:
   // private construction, and no assignements; use the provided singleton methods
   CDatabaseManager();
@@ -75,6 +96,7 @@ private:
   void UpdateStatus(const std::string &name, DB_STATUS status);
   void UpdateDatabase(CDatabase &db, DatabaseSettings *settings = NULL);
 
-  CCriticalSection            m_section;     ///< Critical section protecting m_dbStatus.
+  CCriticalSection            m_section;     ///< Critical section protecting m_dbStatus and m_pools.
   std::map<std::string, DB_STATUS> m_dbStatus;    ///< Our database status map.
+  std::map<std::string, std::shared_ptr<CDatabaseConnectionPool> > m_pools; ///< Connection pools by database.
 };
@@ -50,3 +50,8 @@ ActiveAE::CActiveAEDSP &CServiceBroker::GetADSP()
 {
   return g_application.m_ServiceManager->GetADSPManager();
 }
+
+CVideoLibraryIndex &CServiceBroker::GetVideoLibraryIndex()
+{
+  return g_application.m_ServiceManager->GetVideoLibraryIndex();
+}
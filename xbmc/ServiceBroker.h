@@ -39,6 +39,7 @@ namespace PVR
   class CPVRManager;
 }
 
+class CVideoLibraryIndex;
 class XBPython;
 
 class CServiceBroker
@@ -50,4 +51,5 @@ public:
   static XBPython &GetXBPython();
   static PVR::CPVRManager &GetPVRManager();
   static ActiveAE::CActiveAEDSP& GetADSP();
+  static CVideoLibraryIndex &GetVideoLibraryIndex();
 };
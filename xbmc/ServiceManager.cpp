@@ -26,12 +26,16 @@
 #include "interfaces/generic/ScriptInvocationManager.h"
 #include "interfaces/python/XBPython.h"
 #include "pvr/PVRManager.h"
+#include "video/VideoLibraryIndex.h"
 
 bool CServiceManager::Init1()
 {
   m_announcementManager.reset(new ANNOUNCEMENT::CAnnouncementManager());
   m_announcementManager->Start();
 
+  m_videoLibraryIndex.reset(new CVideoLibraryIndex());
+  m_announcementManager->AddAnnouncer(m_videoLibraryIndex.get());
+
   m_XBPython.reset(new XBPython());
   CScriptInvocationManager::GetInstance().RegisterLanguageInvocationHandler(m_XBPython.get(), ".py");
 
@@ -72,6 +76,8 @@ void CServiceManager::Deinit()
   m_addonMgr.reset();
   CScriptInvocationManager::GetInstance().UnregisterLanguageInvocationHandler(m_XBPython.get());
   m_XBPython.reset();
+  m_announcementManager->RemoveAnnouncer(m_videoLibraryIndex.get());
+  m_videoLibraryIndex.reset();
   m_announcementManager.reset();
 }
 
@@ -104,3 +110,8 @@ ActiveAE::CActiveAEDSP& CServiceManager::GetADSPManager()
 {
   return *m_ADSPManager;
 }
+
+CVideoLibraryIndex& CServiceManager::GetVideoLibraryIndex()
+{
+  return *m_videoLibraryIndex;
+}
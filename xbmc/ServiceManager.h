@@ -41,6 +41,7 @@ namespace PVR
 class CPVRManager;
 }
 
+class CVideoLibraryIndex;
 class XBPython;
 
 class CServiceManager
@@ -56,6 +57,7 @@ public:
   XBPython& GetXBPython();
   PVR::CPVRManager& GetPVRManager();
   ActiveAE::CActiveAEDSP& GetADSPManager();
+  CVideoLibraryIndex& GetVideoLibraryIndex();
 
 protected:
   std::unique_ptr<ADDON::CAddonMgr> m_addonMgr;
@@ -64,4 +66,5 @@ protected:
   std::unique_ptr<XBPython> m_XBPython;
   std::unique_ptr<PVR::CPVRManager> m_PVRManager;
   std::unique_ptr<ActiveAE::CActiveAEDSP> m_ADSPManager;
+  std::unique_ptr<CVideoLibraryIndex> m_videoLibraryIndex;
 };
@@ -554,8 +554,8 @@ bool CAddonDatabase::GetAddon(int id, AddonPtr &addon)
     m_pDS2->query(sql);
     if (!m_pDS2->eof())
     {
-      const dbiplus::query_data &data = m_pDS2->get_result_set().records;
-      const dbiplus::sql_record* const record = data[0];
+      const dbiplus::result_set &data = m_pDS2->get_result_set();
+      const dbiplus::sql_record* const record = data.record(0);
 
       CAddonBuilder builder;
       builder.SetId(record->at(addon_addonID).get_asString());
@@ -577,13 +577,14 @@ bool CAddonDatabase::GetAddon(int id, AddonPtr &addon)
       ADDONDEPS dependencies;
       /* while this is a cartesion join and we'll typically get multiple rows, we rely on the fact that
          extrainfo and dependencies are maps, so insert() will insert the first instance only */
-      for (dbiplus::query_data::const_iterator i = data.begin(); i != data.end(); ++i)
+      for (unsigned int i = 0; i < data.size(); i++)
       {
-        const dbiplus::sql_record* const record = *i;
+        const dbiplus::sql_record* const record = data.record(i);
         if (!record->at(addonextra_key).get_asString().empty())
           extrainfo.insert(std::make_pair(record->at(addonextra_key).get_asString(), record->at(addonextra_value).get_asString()));
         if (!m_pDS2->fv(dependencies_addon).get_asString().empty())
           dependencies.insert(std::make_pair(record->at(dependencies_addon).get_asString(), std::make_pair(AddonVersion(record->at(dependencies_version).get_asString()), record->at(dependencies_optional).get_asBool())));
+        data.release_decoded(i);
       }
       builder.SetExtrainfo(std::move(extrainfo));
       builder.SetDependencies(std::move(dependencies));
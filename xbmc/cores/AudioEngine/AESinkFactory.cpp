@@ -46,6 +46,7 @@
 #include "Sinks/AESinkNULL.h"
 
 #include "utils/log.h"
+#include "utils/StringUtils.h"
 
 #include <algorithm>
 
@@ -173,6 +174,17 @@ IAESink *CAESinkFactory::Create(std::string &device, AEAudioFormat &desiredForma
 void CAESinkFactory::EnumerateEx(AESinkInfoList &list, bool force)
 {
   AESinkInfo info;
+
+  // run without audio hardware, e.g. for benchmarks
+  const char *envSink = getenv("AE_SINK");
+  if (envSink && StringUtils::EqualsNoCase(envSink, "NULL"))
+  {
+    info.m_sinkName = "NULL";
+    CAESinkNULL::EnumerateDevicesEx(info.m_deviceInfoList, force);
+    list.push_back(info);
+    return;
+  }
+
 #if defined(TARGET_WINDOWS)
 
   info.m_deviceInfoList.clear();
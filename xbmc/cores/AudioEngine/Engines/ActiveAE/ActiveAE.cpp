@@ -25,6 +25,7 @@ using namespace ActiveAE;
 #include "ActiveAEStream.h"
 #include "cores/AudioEngine/DSPAddons/ActiveAEDSP.h"
 #include "cores/AudioEngine/DSPAddons/ActiveAEDSPProcess.h"
+#include "cores/AudioEngine/Utils/AEKernels.h"
 #include "cores/AudioEngine/Utils/AEUtil.h"
 #include "cores/AudioEngine/Utils/AEStreamInfo.h"
 #include "cores/AudioEngine/AEResampleFactory.h"
@@ -33,11 +34,22 @@ using namespace ActiveAE;
 #include "settings/Settings.h"
 #include "windowing/WindowingFactory.h"
 #include "utils/log.h"
+#include "utils/StringUtils.h"
+#include "utils/TimeUtils.h"
 
 #define MAX_CACHE_LEVEL 0.4   // total cache time of stream in seconds
 #define MAX_WATER_LEVEL 0.2   // buffered time after stream stages in seconds
 #define MAX_BUFFER_TIME 0.1   // max time of a buffer in seconds
 
+// low latency profile, see CActiveAE::ApplyProfile
+#define LOW_CACHE_LEVEL 0.1
+#define LOW_WATER_LEVEL 0.04
+#define LOW_BUFFER_TIME 0.01
+
+#define MAX_ENCODE_PENDING 2  // packets queued for the encoder thread
+
+#define SOUNDCACHE_UNUSED (8 * 1024 * 1024) // bytes of decoded sounds kept after their last use
+
 void CEngineStats::Reset(unsigned int sampleRate, bool pcm)
 {
   CSingleLock lock(m_lock);
@@ -49,6 +61,58 @@ void CEngineStats::Reset(unsigned int sampleRate, bool pcm)
   m_pcmOutput = pcm;
 }
 
+void CEngineStats::AddStageTime(EStage stage, int64_t ticks)
+{
+  CSingleLock lock(m_lock);
+  m_stageTime[stage] += ticks;
+}
+
+void CEngineStats::GetStageTimes(double seconds[STAGE_MAX], int64_t &frames)
+{
+  CSingleLock lock(m_lock);
+  double frequency = (double)CurrentHostFrequency();
+  for (int i = 0; i < STAGE_MAX; i++)
+    seconds[i] = m_stageTime[i] / frequency;
+  frames = m_processedFrames;
+}
+
+void CEngineStats::ResetStageTimes()
+{
+  CSingleLock lock(m_lock);
+  for (int i = 0; i < STAGE_MAX; i++)
+    m_stageTime[i] = 0;
+  m_processedFrames = 0;
+  m_underruns = 0;
+  m_encodedFrames = 0;
+}
+
+void CEngineStats::AddEncodeTime(int64_t ticks)
+{
+  CSingleLock lock(m_lock);
+  m_stageTime[STAGE_ENCODE] += ticks;
+  m_encodedFrames++;
+}
+
+double CEngineStats::GetEncodeTimePerFrame()
+{
+  CSingleLock lock(m_lock);
+  if (!m_encodedFrames)
+    return 0.0;
+  return (double)m_stageTime[STAGE_ENCODE] / CurrentHostFrequency() / m_encodedFrames;
+}
+
+void CEngineStats::AddUnderrun()
+{
+  CSingleLock lock(m_lock);
+  m_underruns++;
+}
+
+unsigned int CEngineStats::GetUnderruns()
+{
+  CSingleLock lock(m_lock);
+  return m_underruns;
+}
+
 void CEngineStats::UpdateSinkDelay(const AEDelayStatus& status, int samples)
 {
   CSingleLock lock(m_lock);
@@ -65,6 +129,8 @@ void CEngineStats::AddSamples(int samples, std::list<CActiveAEStream*> &streams)
 {
   CSingleLock lock(m_lock);
   m_bufferedSamples += samples;
+  if (m_pcmOutput)
+    m_processedFrames += samples;
 
   for (auto stream : streams)
   {
@@ -126,8 +192,7 @@ void CEngineStats::UpdateStream(CActiveAEStream *stream)
       }
 
       CSingleLock lock(stream->m_statsLock);
-      std::deque<CSampleBuffer*>::iterator itBuf;
-      for(itBuf=stream->m_processingSamples.begin(); itBuf!=stream->m_processingSamples.end(); ++itBuf)
+      for(CSampleBufferQueue::iterator itBuf = stream->m_processingSamples.begin(); itBuf != stream->m_processingSamples.end(); ++itBuf)
       {
         if (m_pcmOutput)
           delay += (float)(*itBuf)->pkt->nb_samples / (*itBuf)->pkt->config.sample_rate;
@@ -216,7 +281,7 @@ float CEngineStats::GetCacheTime(CActiveAEStream *stream)
 
 float CEngineStats::GetCacheTotal(CActiveAEStream *stream)
 {
-  return MAX_CACHE_LEVEL + m_sinkCacheTotal;
+  return m_cacheLevel + m_sinkCacheTotal;
 }
 
 float CEngineStats::GetWaterLevel()
@@ -268,7 +333,9 @@ CActiveAE::CActiveAE() :
   CThread("ActiveAE"),
   m_controlPort("OutputControlPort", &m_inMsgEvent, &m_outMsgEvent),
   m_dataPort("OutputDataPort", &m_inMsgEvent, &m_outMsgEvent),
-  m_sink(&m_outMsgEvent)
+  m_sink(&m_outMsgEvent),
+  m_encodeStage(&m_outMsgEvent),
+  m_soundCache(SOUNDCACHE_UNUSED)
 {
   m_sinkBuffers = NULL;
   m_silenceBuffers = NULL;
@@ -282,11 +349,14 @@ CActiveAE::CActiveAE() :
   m_aeMuted = false;
   m_mode = MODE_PCM;
   m_encoder = NULL;
+  m_encodePending = 0;
   m_vizInitialized = false;
   m_sinkHasVolume = false;
   m_aeGUISoundForce = false;
   m_stats.Reset(44100, true);
+  m_stats.ResetStageTimes();
   m_streamIdGen = 0;
+  ApplyProfile(false);
 }
 
 CActiveAE::~CActiveAE()
@@ -301,9 +371,12 @@ void CActiveAE::Dispose()
   m_bStop = true;
   m_outMsgEvent.Set();
   StopThread();
+  m_resampleWorkers.Stop();
+  m_encodeStage.Dispose();
   m_controlPort.Purge();
   m_dataPort.Purge();
   m_sink.Dispose();
+  m_soundCache.Clear();
 }
 
 //-----------------------------------------------------------------------------
@@ -364,15 +437,6 @@ void CActiveAE::StateMachine(int signal, Protocol *port, Message *msg)
         case CActiveAEControlProtocol::APPFOCUSED:
           m_sink.m_controlPort.SendOutMessage(CSinkControlProtocol::APPFOCUSED, msg->data, sizeof(bool));
           return;
-        case CActiveAEControlProtocol::STREAMRESAMPLEMODE:
-          MsgStreamParameter *par;
-          par = (MsgStreamParameter*)msg->data;
-          if (par->stream)
-          {
-            par->stream->m_resampleMode = par->parameter.int_par;
-            par->stream->m_resampleIntegral = 0.0;
-          }
-          return;
         default:
           break;
         }
@@ -427,6 +491,17 @@ void CActiveAE::StateMachine(int signal, Protocol *port, Message *msg)
           break;
         }
       }
+      else if (port == &m_encodeStage.m_dataPort)
+      {
+        switch (signal)
+        {
+        case CEncodeDataProtocol::ENCODED:
+          EncodeDone((SEncodeJob*)msg->data);
+          return;
+        default:
+          break;
+        }
+      }
       {
         std::string portName = port == NULL ? "timer" : port->portName;
         CLog::Log(LOGWARNING, "CActiveAE::%s - signal: %d from port: %s not handled for state: %d", __FUNCTION__, signal, portName.c_str(), m_state);
@@ -500,7 +575,7 @@ void CActiveAE::StateMachine(int signal, Protocol *port, Message *msg)
             m_extTimeout = 0;
             return;
           }
-          if (!m_sinkBuffers->m_inputSamples.empty() || !m_sinkBuffers->m_outputSamples.empty())
+          if (!m_sinkBuffers->m_inputSamples.empty() || !m_sinkBuffers->m_outputSamples.empty() || m_encodePending)
           {
             m_extTimeout = 100;
             return;
@@ -622,27 +697,6 @@ void CActiveAE::StateMachine(int signal, Protocol *port, Message *msg)
           msg->Reply(CActiveAEControlProtocol::ACC);
           m_extTimeout = 0;
           return;
-        case CActiveAEControlProtocol::STREAMAMP:
-          MsgStreamParameter *par;
-          par = (MsgStreamParameter*)msg->data;
-          par->stream->m_limiter.SetAmplification(par->parameter.float_par);
-          par->stream->m_amplify = par->parameter.float_par;
-          return;
-        case CActiveAEControlProtocol::STREAMVOLUME:
-          par = (MsgStreamParameter*)msg->data;
-          par->stream->m_volume = par->parameter.float_par;
-          return;
-        case CActiveAEControlProtocol::STREAMRGAIN:
-          par = (MsgStreamParameter*)msg->data;
-          par->stream->m_rgain = par->parameter.float_par;
-          return;
-        case CActiveAEControlProtocol::STREAMRESAMPLERATIO:
-          par = (MsgStreamParameter*)msg->data;
-          if (par->stream->m_resampleBuffers)
-          {
-            par->stream->m_resampleBuffers->m_resampleRatio = par->parameter.double_par;
-          }
-          return;
         case CActiveAEControlProtocol::STREAMFFMPEGINFO:
           MsgStreamFFmpegInfo *info;
           info = (MsgStreamFFmpegInfo*)msg->data;
@@ -777,6 +831,19 @@ void CActiveAE::StateMachine(int signal, Protocol *port, Message *msg)
           break;
         }
       }
+      else if (port == &m_encodeStage.m_dataPort)
+      {
+        switch (signal)
+        {
+        case CEncodeDataProtocol::ENCODED:
+          EncodeDone((SEncodeJob*)msg->data);
+          m_extTimeout = 0;
+          m_state = AE_TOP_CONFIGURED_PLAY;
+          return;
+        default:
+          break;
+        }
+      }
       break;
 
     case AE_TOP_CONFIGURED_SUSPEND:
@@ -834,6 +901,17 @@ void CActiveAE::StateMachine(int signal, Protocol *port, Message *msg)
           break;
         }
       }
+      else if (port == &m_encodeStage.m_dataPort)
+      {
+        switch (signal)
+        {
+        case CEncodeDataProtocol::ENCODED:
+          EncodeDone((SEncodeJob*)msg->data);
+          return;
+        default:
+          break;
+        }
+      }
       else if (port == NULL) // timeout
       {
         switch (signal)
@@ -991,6 +1069,12 @@ void CActiveAE::Process()
       gotMsg = true;
       port = &m_sink.m_dataPort;
     }
+    // check encoder data port
+    else if (m_encodeStage.m_dataPort.ReceiveInMessage(&msg))
+    {
+      gotMsg = true;
+      port = &m_encodeStage.m_dataPort;
+    }
     else if (!m_extDeferData)
     {
       // check data port
@@ -1097,11 +1181,15 @@ void CActiveAE::Configure(AEAudioFormat *desiredFmt)
   std::string device = (m_sinkRequestFormat.m_dataFormat == AE_FMT_RAW) ? m_settings.passthoughdevice : m_settings.device;
   std::string driver;
   CAESinkFactory::ParseDevice(device, driver);
+  // passthrough keeps its buffering, packets of some formats are longer than a low latency period
+  bool lowlatency = m_settings.lowlatency && m_sinkRequestFormat.m_dataFormat != AE_FMT_RAW;
   if ((!CompareFormat(m_sinkRequestFormat, m_sinkFormat) && !CompareFormat(m_sinkRequestFormat, oldSinkRequestFormat)) ||
       m_currDevice.compare(device) != 0 ||
-      m_settings.driver.compare(driver) != 0)
+      m_settings.driver.compare(driver) != 0 ||
+      lowlatency != m_lowLatency)
   {
     FlushEngine();
+    ApplyProfile(lowlatency);
     if (!InitSink())
       return;
     m_settings.driver = driver;
@@ -1114,12 +1202,16 @@ void CActiveAE::Configure(AEAudioFormat *desiredFmt)
     {
       // limit buffer size in case of sink returns large buffer
       double buffertime = (double)m_sinkFormat.m_frames / m_sinkFormat.m_sampleRate;
-      if (buffertime > MAX_BUFFER_TIME)
+      if (buffertime > m_bufferTime)
       {
-        CLog::Log(LOGWARNING, "ActiveAE::%s - sink returned large buffer of %d ms, reducing to %d ms", __FUNCTION__, (int)(buffertime * 1000), (int)(MAX_BUFFER_TIME*1000));
-        m_sinkFormat.m_frames = MAX_BUFFER_TIME * m_sinkFormat.m_sampleRate;
+        CLog::Log(m_lowLatency ? LOGDEBUG : LOGWARNING, "ActiveAE::%s - sink returned large buffer of %d ms, reducing to %d ms", __FUNCTION__, (int)(buffertime * 1000), (int)(m_bufferTime*1000));
+        m_sinkFormat.m_frames = m_bufferTime * m_sinkFormat.m_sampleRate;
       }
     }
+
+    if (m_lowLatency)
+      CLog::Log(LOGINFO, "ActiveAE::%s - low latency profile, period %d ms, stream cache %d ms", __FUNCTION__,
+                (int)(1000 * m_sinkFormat.m_frames / m_sinkFormat.m_sampleRate), (int)(1000 * m_cacheLevel));
   }
 
   if (m_silenceBuffers)
@@ -1141,13 +1233,16 @@ void CActiveAE::Configure(AEAudioFormat *desiredFmt)
     inputFormat.m_frameSize = inputFormat.m_channelLayout.Count() *
                               (CAEUtil::DataFormatToBits(inputFormat.m_dataFormat) >> 3);
     m_silenceBuffers = new CActiveAEBufferPool(inputFormat);
-    m_silenceBuffers->Create(MAX_WATER_LEVEL*1000);
+    m_silenceBuffers->Create(m_waterLevel*1000);
     sinkInputFormat = inputFormat;
     m_internalFormat = inputFormat;
 
     bool streaming = false;
     m_sink.m_controlPort.SendOutMessage(CSinkControlProtocol::STREAMING, &streaming, sizeof(bool));
 
+    FinishEncode();
+    if (m_encoder)
+      CLog::Log(LOGDEBUG, "ActiveAE::%s - encoder took %.2f ms per frame", __FUNCTION__, m_stats.GetEncodeTimePerFrame() * 1000);
     delete m_encoder;
     m_encoder = NULL;
 
@@ -1221,7 +1316,7 @@ void CActiveAE::Configure(AEAudioFormat *desiredFmt)
         if (!m_encoderBuffers)
         {
           m_encoderBuffers = new CActiveAEBufferPool(format);
-          m_encoderBuffers->Create(MAX_WATER_LEVEL*1000);
+          m_encoderBuffers->Create(m_waterLevel*1000);
         }
       }
 
@@ -1266,7 +1361,8 @@ void CActiveAE::Configure(AEAudioFormat *desiredFmt)
 
         // create buffer pool
         (*it)->m_inputBuffers = new CActiveAEBufferPool((*it)->m_format);
-        (*it)->m_inputBuffers->Create(MAX_CACHE_LEVEL*1000);
+        (*it)->m_inputBuffers->Create(m_cacheLevel*1000);
+        (*it)->m_processingSamples.Reserve((*it)->m_inputBuffers->m_allSamples.size());
         (*it)->m_streamSpace = (*it)->m_format.m_frameSize * (*it)->m_format.m_frames;
 
         // if input format does not follow ffmpeg channel mask, we may need to remap channels
@@ -1286,7 +1382,7 @@ void CActiveAE::Configure(AEAudioFormat *desiredFmt)
         (*it)->m_resampleBuffers->m_bypassDSP = (*it)->m_bypassDSP;
         if (useDSP && !(*it)->m_resampleBuffers->m_bypassDSP)
           (*it)->m_resampleBuffers->SetExtraData((*it)->m_profile, (*it)->m_matrixEncoding, (*it)->m_audioServiceType);
-        (*it)->m_resampleBuffers->Create(MAX_CACHE_LEVEL*1000, false, m_settings.stereoupmix, m_settings.normalizelevels, useDSP);
+        (*it)->m_resampleBuffers->Create(m_cacheLevel*1000, false, m_settings.stereoupmix, m_settings.normalizelevels, useDSP);
 
         m_stats.SetDSP(useDSP);
       }
@@ -1345,7 +1441,7 @@ void CActiveAE::Configure(AEAudioFormat *desiredFmt)
   if (!m_sinkBuffers)
   {
     m_sinkBuffers = new CActiveAEBufferPoolResample(sinkInputFormat, m_sinkFormat, m_settings.resampleQuality);
-    m_sinkBuffers->Create(MAX_WATER_LEVEL*1000, true, false);
+    m_sinkBuffers->Create(m_waterLevel*1000, true, false);
   }
 
   // reset gui sounds
@@ -1440,6 +1536,13 @@ void CActiveAE::DiscardStream(CActiveAEStream *stream)
       if ((*it)->m_resampleBuffers)
         m_discardBufferPools.push_back((*it)->m_resampleBuffers);
       CLog::Log(LOGDEBUG, "CActiveAE::DiscardStream - audio stream deleted");
+      if ((*it)->m_resampleCycles)
+      {
+        double frequency = (double)CurrentHostFrequency();
+        CLog::Log(LOGDEBUG, "CActiveAE::DiscardStream - resample cost avg: %.3f ms, max: %.3f ms, cycles: %u",
+                  (*it)->m_resampleTime * 1000.0 / frequency / (*it)->m_resampleCycles,
+                  (*it)->m_resampleTimeMax * 1000.0 / frequency, (*it)->m_resampleCycles);
+      }
       m_stats.RemoveStream((*it)->m_id);
       delete (*it)->m_streamPort;
       delete (*it);
@@ -1477,6 +1580,7 @@ void CActiveAE::SFlushStream(CActiveAEStream *stream)
 
 void CActiveAE::FlushEngine()
 {
+  FinishEncode();
   if (m_sinkBuffers)
     m_sinkBuffers->Flush();
   if (m_vizBuffers)
@@ -1503,6 +1607,37 @@ void CActiveAE::FlushEngine()
   m_stats.Reset(m_sinkFormat.m_sampleRate, m_mode == MODE_PCM);
 }
 
+void CActiveAE::EncodeDone(SEncodeJob *job)
+{
+  m_encodePending--;
+  m_stats.AddEncodeTime(job->time);
+  job->in->Return();
+  // samples were counted when the job was queued
+  m_sinkBuffers->m_inputSamples.push_back(job->out);
+}
+
+void CActiveAE::FinishEncode()
+{
+  // wait for packets in flight, encoder and buffers must not change under the encoder thread.
+  // the stage answers every job, so don't give up: a job left behind would use freed buffers
+  Message *msg;
+  bool logged = false;
+  while (m_encodePending)
+  {
+    if (m_encodeStage.m_dataPort.ReceiveInMessage(&msg))
+    {
+      if (msg->signal == CEncodeDataProtocol::ENCODED)
+        EncodeDone((SEncodeJob*)msg->data);
+      msg->Release();
+    }
+    else if (!m_outMsgEvent.WaitMSec(1000) && !logged)
+    {
+      CLog::Log(LOGERROR, "ActiveAE::%s - encoder does not respond, still waiting", __FUNCTION__);
+      logged = true;
+    }
+  }
+}
+
 void CActiveAE::ClearDiscardedBuffers()
 {
   auto it = m_discardBufferPools.begin();
@@ -1517,7 +1652,7 @@ void CActiveAE::ClearDiscardedBuffers()
     if ((*it)->m_allSamples.size() == (*it)->m_freeSamples.size())
     {
       delete (*it);
-      CLog::Log(LOGDEBUG, "CActiveAE::ClearDiscardedBuffers - buffer pool deleted");
+      CLog::Log(LOGDEBUG, "CActiveAE::ClearDiscardedBuffers - buffer pool deleted, %u runtime allocations so far", CActiveAEBufferPool::GetRuntimeAllocations());
       it = m_discardBufferPools.erase(it);
     }
     else
@@ -1728,18 +1863,34 @@ bool CActiveAE::NeedReconfigureSink()
   std::string driver;
   CAESinkFactory::ParseDevice(device, driver);
 
+  bool lowlatency = m_settings.lowlatency && newFormat.m_dataFormat != AE_FMT_RAW;
+
   if (!CompareFormat(newFormat, m_sinkFormat) ||
       m_currDevice.compare(device) != 0 ||
-      m_settings.driver.compare(driver) != 0)
+      m_settings.driver.compare(driver) != 0 ||
+      lowlatency != m_lowLatency)
     return true;
 
   return false;
 }
 
+void CActiveAE::ApplyProfile(bool lowlatency)
+{
+  // low latency shrinks every stage: the period of sink, mixer and stream buffers,
+  // the number of buffers queued for the sink and the cache of the streams
+  m_lowLatency = lowlatency;
+  m_cacheLevel = lowlatency ? LOW_CACHE_LEVEL : MAX_CACHE_LEVEL;
+  m_waterLevel = lowlatency ? LOW_WATER_LEVEL : MAX_WATER_LEVEL;
+  m_bufferTime = lowlatency ? LOW_BUFFER_TIME : MAX_BUFFER_TIME;
+  m_stats.SetCacheLevel(m_cacheLevel);
+}
+
 bool CActiveAE::InitSink()
 {
   SinkConfig config;
   config.format = m_sinkRequestFormat;
+  // period requested from the sink, 0 leaves it to the sink
+  config.format.m_frames = m_lowLatency ? m_bufferTime * m_sinkRequestFormat.m_sampleRate : 0;
   config.stats = &m_stats;
   config.device = (m_sinkRequestFormat.m_dataFormat == AE_FMT_RAW) ? &m_settings.passthoughdevice :
                                                                      &m_settings.device;
@@ -1842,17 +1993,97 @@ void CActiveAE::UnconfigureSink()
 }
 
 
-bool CActiveAE::RunStages()
+bool CActiveAE::ResampleStreams()
 {
   bool busy = false;
 
-  // serve input streams
+  m_resampleJobs.clear();
   std::list<CActiveAEStream*>::iterator it;
   for (it = m_streams.begin(); it != m_streams.end(); ++it)
   {
-    if ((*it)->m_resampleBuffers && !(*it)->m_paused)
-      busy = (*it)->m_resampleBuffers->ResampleBuffers();
+    if (!(*it)->m_resampleBuffers || (*it)->m_paused)
+      continue;
+
+    // audio dsp addons are shared by all streams, keep them on this thread
+    CActiveAEBufferPoolResample *pool = (*it)->m_resampleBuffers;
+    if (pool->m_useDSP || pool->m_changeDSP)
+    {
+      busy |= pool->ResampleBuffers();
+      continue;
+    }
+
+    SResampleJob job;
+    job.pool = pool;
+    job.busy = false;
+    job.time = 0;
+    m_resampleJobs.push_back(job);
+  }
+
+  m_resampleWorkers.Run(m_resampleJobs);
+
+  // jobs are in the order of streams without dsp
+  std::vector<SResampleJob>::iterator itJob = m_resampleJobs.begin();
+  for (it = m_streams.begin(); it != m_streams.end() && itJob != m_resampleJobs.end(); ++it)
+  {
+    if ((*it)->m_resampleBuffers != itJob->pool)
+      continue;
 
+    busy |= itJob->busy;
+    (*it)->m_resampleTime += itJob->time;
+    (*it)->m_resampleTimeMax = std::max((*it)->m_resampleTimeMax, itJob->time);
+    (*it)->m_resampleCycles++;
+    ++itJob;
+  }
+
+  return busy;
+}
+
+/**
+ * take over the scalar parameters the owners of the streams have changed
+ * since the last cycle
+ */
+void CActiveAE::ApplyStreamParameters()
+{
+  std::list<CActiveAEStream*>::iterator it;
+  for (it = m_streams.begin(); it != m_streams.end(); ++it)
+  {
+    CActiveAEStream *stream = *it;
+    float value;
+    double ratio;
+    int mode;
+
+    if (stream->m_shadowAmplify.Fetch(value))
+    {
+      stream->m_limiter.SetAmplification(value);
+      stream->m_amplify = value;
+    }
+    if (stream->m_shadowVolume.Fetch(value))
+      stream->m_volume = value;
+    if (stream->m_shadowRgain.Fetch(value))
+      stream->m_rgain = value;
+    if (stream->m_shadowResampleMode.Fetch(mode))
+    {
+      stream->m_resampleMode = mode;
+      stream->m_resampleIntegral = 0.0;
+    }
+    if (stream->m_resampleBuffers && stream->m_shadowResampleRatio.Fetch(ratio))
+      stream->m_resampleBuffers->m_resampleRatio = ratio;
+  }
+}
+
+bool CActiveAE::RunStages()
+{
+  ApplyStreamParameters();
+
+  // resample input streams, in parallel if there are several
+  int64_t start = CurrentHostCounter();
+  bool busy = ResampleStreams();
+  m_stats.AddStageTime(CEngineStats::STAGE_RESAMPLE, CurrentHostCounter() - start);
+
+  // serve input streams
+  std::list<CActiveAEStream*>::iterator it;
+  for (it = m_streams.begin(); it != m_streams.end(); ++it)
+  {
     if ((*it)->m_streamIsBuffering &&
         (*it)->m_resampleBuffers &&
         ((*it)->m_resampleBuffers->m_inputSamples.size() > (*it)->m_resampleBuffers->m_allSamples.size() * 0.5))
@@ -1869,14 +2100,20 @@ bool CActiveAE::RunStages()
       float buftime = (float)(*it)->m_inputBuffers->m_format.m_frames / (*it)->m_inputBuffers->m_format.m_sampleRate;
       if ((*it)->m_inputBuffers->m_format.m_dataFormat == AE_FMT_RAW)
         buftime = (*it)->m_inputBuffers->m_format.m_streamInfo.GetDuration() / 1000;
-      while ((time < MAX_CACHE_LEVEL || (*it)->m_streamIsBuffering) && !(*it)->m_inputBuffers->m_freeSamples.empty())
+      // hand all buffers over in one go, the stream wakes up once for them.
+      // reserve only allocates when a stream comes with a larger pool
+      m_streamBuffers.clear();
+      m_streamBuffers.reserve((*it)->m_inputBuffers->m_allSamples.size());
+      while ((time < m_cacheLevel || (*it)->m_streamIsBuffering) && !(*it)->m_inputBuffers->m_freeSamples.empty())
       {
         buffer = (*it)->m_inputBuffers->GetFreeBuffer();
         (*it)->m_processingSamples.push_back(buffer);
-        (*it)->m_streamPort->SendInMessage(CActiveAEDataProtocol::STREAMBUFFER, &buffer, sizeof(CSampleBuffer*));
         (*it)->IncFreeBuffers();
+        m_streamBuffers.push_back(buffer);
         time += buftime;
       }
+      if (!m_streamBuffers.empty())
+        (*it)->m_streamPort->SendInMessages(CActiveAEDataProtocol::STREAMBUFFER, m_streamBuffers.data(), sizeof(CSampleBuffer*), m_streamBuffers.size());
     }
     else
     {
@@ -1910,8 +2147,9 @@ bool CActiveAE::RunStages()
     }
   }
 
-  if (m_stats.GetWaterLevel() < MAX_WATER_LEVEL &&
-     (m_mode != MODE_TRANSCODE || (m_encoderBuffers && !m_encoderBuffers->m_freeSamples.empty())))
+  if (m_stats.GetWaterLevel() < m_waterLevel &&
+     (m_mode != MODE_TRANSCODE || (m_encoderBuffers && !m_encoderBuffers->m_freeSamples.empty() &&
+                                   m_encodePending < MAX_ENCODE_PENDING)))
   {
     // calculate sync error
     for (it = m_streams.begin(); it != m_streams.end(); ++it)
@@ -1938,6 +2176,7 @@ bool CActiveAE::RunStages()
     // mix streams and sounds sounds
     if (m_mode != MODE_RAW)
     {
+      start = CurrentHostCounter();
       CSampleBuffer *out = NULL;
       if (!m_sounds_playing.empty() && m_streams.empty())
       {
@@ -2049,15 +2288,7 @@ bool CActiveAE::RunStages()
 
               for(int j=0; j<out->pkt->planes; j++)
               {
-#ifdef __SSE__
-                CAEUtil::SSEMulArray((float*)out->pkt->data[j]+i*nb_floats, volume, nb_floats);
-#else
-                float* fbuffer = (float*) out->pkt->data[j]+i*nb_floats;
-                for (int k = 0; k < nb_floats; ++k)
-                {
-                  fbuffer[k] *= volume;
-                }
-#endif
+                CAEKernels::Mul((float*)out->pkt->data[j]+i*nb_floats, volume, nb_floats);
               }
             }
           }
@@ -2118,24 +2349,8 @@ bool CActiveAE::RunStages()
               {
                 float *dst = (float*)out->pkt->data[j]+i*nb_floats;
                 float *src = (float*)mix->pkt->data[j]+i*nb_floats;
-#ifdef __SSE__
-                CAEUtil::SSEMulAddArray(dst, src, volume, nb_floats);
-                for (int k = 0; k < nb_floats; ++k)
-                {
-                  if (fabs(dst[k]) > 1.0f)
-                  {
-                    needClamp = true;
-                    break;
-                  }
-                }
-#else
-                for (int k = 0; k < nb_floats; ++k)
-                {
-                  dst[k] += src[k] * volume;
-                  if (fabs(dst[k]) > 1.0f)
-                    needClamp = true;
-                }
-#endif
+                if (CAEKernels::MulAdd(dst, src, volume, nb_floats) > 1.0f)
+                  needClamp = true;
               }
             }
             mix->Return();
@@ -2150,7 +2365,7 @@ bool CActiveAE::RunStages()
         int nb_floats = out->pkt->nb_samples * out->pkt->config.channels / out->pkt->planes;
         for(int i=0; i<out->pkt->planes; i++)
         {
-          CAEUtil::ClampArray((float*)out->pkt->data[i], nb_floats);
+          CAEKernels::Clamp((float*)out->pkt->data[i], nb_floats);
         }
       }
 
@@ -2214,18 +2429,21 @@ bool CActiveAE::RunStages()
         if (!m_sinkHasVolume || m_muted)
           Deamplify(*(out->pkt));
 
+        m_stats.AddStageTime(CEngineStats::STAGE_MIX, CurrentHostCounter() - start);
+
+        // encoding overlaps with mixing the next packet, see EncodeDone
         if (m_mode == MODE_TRANSCODE && m_encoder)
         {
-          CSampleBuffer *buf = m_encoderBuffers->GetFreeBuffer();
-          buf->pkt->nb_samples = m_encoder->Encode(out->pkt->data[0], out->pkt->planes*out->pkt->linesize,
-                                                   buf->pkt->data[0], buf->pkt->planes*buf->pkt->linesize);
-
-          // set pts of last sample
-          buf->pkt_start_offset = buf->pkt->nb_samples;
-          buf->timestamp = out->timestamp;
-
-          out->Return();
-          out = buf;
+          SEncodeJob job;
+          job.encoder = m_encoder;
+          job.in = out;
+          job.out = m_encoderBuffers->GetFreeBuffer();
+          job.time = 0;
+          m_encodeStage.Encode(job);
+          m_encodePending++;
+          // count the packet now, the delay must include packets in flight
+          m_stats.AddSamples(1, m_streams);
+          out = NULL;
         }
         busy = true;
       }
@@ -2263,7 +2481,9 @@ bool CActiveAE::RunStages()
   }
 
   // serve sink buffers
+  start = CurrentHostCounter();
   busy |= m_sinkBuffers->ResampleBuffers();
+  m_stats.AddStageTime(CEngineStats::STAGE_SINK, CurrentHostCounter() - start);
   while(!m_sinkBuffers->m_outputSamples.empty())
   {
     CSampleBuffer *out = NULL;
@@ -2281,6 +2501,8 @@ bool CActiveAE::HasWork()
 {
   if (!m_sounds_playing.empty())
     return true;
+  if (m_encodePending)
+    return true;
   if (!m_sinkBuffers->m_inputSamples.empty())
     return true;
   if (!m_sinkBuffers->m_outputSamples.empty())
@@ -2509,12 +2731,7 @@ void CActiveAE::MixSounds(CSoundPacket &dstSample)
       out = (float*)dstSample.data[j];
       sample_buffer = (float*)(it->sound->GetSound(false)->data[j]+start);
       int nb_floats = mix_samples * dstSample.config.channels / dstSample.planes;
-#ifdef __SSE__
-      CAEUtil::SSEMulAddArray(out, sample_buffer, volume, nb_floats);
-#else
-      for (int k = 0; k < nb_floats; ++k)
-        *out++ += *sample_buffer++ * volume;
-#endif
+      CAEKernels::MulAdd(out, sample_buffer, volume, nb_floats);
     }
 
     it->samples_played += mix_samples;
@@ -2540,13 +2757,7 @@ void CActiveAE::Deamplify(CSoundPacket &dstSample)
     for(int j=0; j<dstSample.planes; j++)
     {
       buffer = (float*)dstSample.data[j];
-#ifdef __SSE__
-      CAEUtil::SSEMulArray(buffer, volume, nb_floats);
-#else
-      float *fbuffer = buffer;
-      for (int i = 0; i < nb_floats; i++)
-        *fbuffer++ *= volume;
-#endif
+      CAEKernels::Mul(buffer, volume, nb_floats);
     }
   }
 }
@@ -2564,6 +2775,8 @@ void CActiveAE::LoadSettings()
   m_settings.channels = (m_sink.GetDeviceType(m_settings.device) == AE_DEVTYPE_IEC958) ? AE_CH_LAYOUT_2_0 : CSettings::GetInstance().GetInt(CSettings::SETTING_AUDIOOUTPUT_CHANNELS);
   m_settings.samplerate = CSettings::GetInstance().GetInt(CSettings::SETTING_AUDIOOUTPUT_SAMPLERATE);
 
+  m_settings.lowlatency = CSettings::GetInstance().GetBool(CSettings::SETTING_AUDIOOUTPUT_LOWLATENCY);
+
   m_settings.dspaddonsenabled = IsSettingVisible(CSettings::SETTING_AUDIOOUTPUT_DSPADDONSENABLED) ? CSettings::GetInstance().GetBool(CSettings::SETTING_AUDIOOUTPUT_DSPADDONSENABLED) : false;
 
   m_settings.stereoupmix = IsSettingVisible(CSettings::SETTING_AUDIOOUTPUT_STEREOUPMIX) ? CSettings::GetInstance().GetBool(CSettings::SETTING_AUDIOOUTPUT_STEREOUPMIX) : false;
@@ -2638,6 +2851,7 @@ void CActiveAE::OnSettingsChange(const std::string& setting)
       setting == CSettings::SETTING_AUDIOOUTPUT_CHANNELS               ||
       setting == CSettings::SETTING_AUDIOOUTPUT_STEREOUPMIX            ||
       setting == CSettings::SETTING_AUDIOOUTPUT_STREAMSILENCE          ||
+      setting == CSettings::SETTING_AUDIOOUTPUT_LOWLATENCY             ||
       setting == CSettings::SETTING_AUDIOOUTPUT_PROCESSQUALITY         ||
       setting == CSettings::SETTING_AUDIOOUTPUT_PASSTHROUGH            ||
       setting == CSettings::SETTING_AUDIOOUTPUT_SAMPLERATE             ||
@@ -2954,6 +3168,16 @@ IAESound *CActiveAE::MakeSound(const std::string& file)
   }
   int fileSize = sound->GetFileSize();
 
+  // same content as a sound loaded before, e.g. by the previous skin
+  std::shared_ptr<CSoundPacket> cached = m_soundCache.Get(sound->GetCacheKey(), "");
+  if (cached)
+  {
+    sound->SetSound(true, cached);
+    sound->Finish();
+    m_dataPort.SendOutMessage(CActiveAEDataProtocol::NEWSOUND, &sound, sizeof(CActiveAESound*));
+    return sound;
+  }
+
   fmt_ctx = avformat_alloc_context();
   unsigned char* buffer = (unsigned char*)av_malloc(SOUNDBUFFER_SIZE+FF_INPUT_BUFFER_PADDING_SIZE);
   io_ctx = avio_alloc_context(buffer, SOUNDBUFFER_SIZE, 0,
@@ -3067,6 +3291,7 @@ IAESound *CActiveAE::MakeSound(const std::string& file)
   }
 
   sound->Finish();
+  m_soundCache.Store(sound->GetCacheKey(), "", sound->ShareSound(true));
 
   // register sound
   m_dataPort.SendOutMessage(CActiveAEDataProtocol::NEWSOUND, &sound, sizeof(CActiveAESound*));
@@ -3149,6 +3374,19 @@ bool CActiveAE::ResampleSound(CActiveAESound *sound)
     }
   }
 
+  std::string format = StringUtils::Format("%s %d %s %d %s",
+                                          CAEUtil::DataFormatToStr(m_internalFormat.m_dataFormat),
+                                          m_internalFormat.m_sampleRate,
+                                          ((std::string)m_internalFormat.m_channelLayout).c_str(),
+                                          m_settings.resampleQuality,
+                                          ((std::string)outChannels).c_str());
+  std::shared_ptr<CSoundPacket> cached = m_soundCache.Get(sound->GetCacheKey(), format);
+  if (cached)
+  {
+    sound->SetSound(false, cached);
+    return true;
+  }
+
   IAEResample *resampler = CAEResampleFactory::Create(AERESAMPLEFACTORY_QUICK_RESAMPLE);
   resampler->Init(dst_config.channel_layout,
                   dst_config.channels,
@@ -3187,6 +3425,7 @@ bool CActiveAE::ResampleSound(CActiveAESound *sound)
 
   delete resampler;
   sound->SetConverted(true);
+  m_soundCache.Store(sound->GetCacheKey(), format, sound->ShareSound(false));
   return true;
 }
 
@@ -3286,51 +3525,6 @@ void CActiveAE::PauseStream(CActiveAEStream *stream, bool pause)
                                    &stream, sizeof(CActiveAEStream*));
 }
 
-void CActiveAE::SetStreamAmplification(CActiveAEStream *stream, float amplify)
-{
-  MsgStreamParameter msg;
-  msg.stream = stream;
-  msg.parameter.float_par = amplify;
-  m_controlPort.SendOutMessage(CActiveAEControlProtocol::STREAMAMP,
-                                     &msg, sizeof(MsgStreamParameter));
-}
-
-void CActiveAE::SetStreamReplaygain(CActiveAEStream *stream, float rgain)
-{
-  MsgStreamParameter msg;
-  msg.stream = stream;
-  msg.parameter.float_par = rgain;
-  m_controlPort.SendOutMessage(CActiveAEControlProtocol::STREAMRGAIN,
-                                     &msg, sizeof(MsgStreamParameter));
-}
-
-void CActiveAE::SetStreamVolume(CActiveAEStream *stream, float volume)
-{
-  MsgStreamParameter msg;
-  msg.stream = stream;
-  msg.parameter.float_par = volume;
-  m_controlPort.SendOutMessage(CActiveAEControlProtocol::STREAMVOLUME,
-                                     &msg, sizeof(MsgStreamParameter));
-}
-
-void CActiveAE::SetStreamResampleRatio(CActiveAEStream *stream, double ratio)
-{
-  MsgStreamParameter msg;
-  msg.stream = stream;
-  msg.parameter.double_par = ratio;
-  m_controlPort.SendOutMessage(CActiveAEControlProtocol::STREAMRESAMPLERATIO,
-                                     &msg, sizeof(MsgStreamParameter));
-}
-
-void CActiveAE::SetStreamResampleMode(CActiveAEStream *stream, int mode)
-{
-  MsgStreamParameter msg;
-  msg.stream = stream;
-  msg.parameter.int_par = mode;
-  m_controlPort.SendOutMessage(CActiveAEControlProtocol::STREAMRESAMPLEMODE,
-                               &msg, sizeof(MsgStreamParameter));
-}
-
 void CActiveAE::SetStreamFFmpegInfo(CActiveAEStream *stream, int profile, enum AVMatrixEncoding matrix_encoding, enum AVAudioServiceType audio_service_type)
 {
   MsgStreamFFmpegInfo msg;
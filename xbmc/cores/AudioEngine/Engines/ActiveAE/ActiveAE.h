@@ -27,6 +27,9 @@
 #include "cores/AudioEngine/Interfaces/AESound.h"
 #include "cores/AudioEngine/AEFactory.h"
 #include "cores/AudioEngine/Engines/ActiveAE/ActiveAEBuffer.h"
+#include "cores/AudioEngine/Engines/ActiveAE/ActiveAEEncodeStage.h"
+#include "cores/AudioEngine/Engines/ActiveAE/ActiveAEResampleWorkers.h"
+#include "cores/AudioEngine/Engines/ActiveAE/ActiveAESoundCache.h"
 
 #include "guilib/DispResource.h"
 #include <queue>
@@ -63,6 +66,7 @@ struct AudioSettings
   bool normalizelevels;
   bool passthrough;
   bool dspaddonsenabled;
+  bool lowlatency;
   int config;
   int guisoundmode;
   unsigned int samplerate;
@@ -84,11 +88,6 @@ public:
     PAUSESTREAM,
     RESUMESTREAM,
     FLUSHSTREAM,
-    STREAMRGAIN,
-    STREAMVOLUME,
-    STREAMAMP,
-    STREAMRESAMPLERATIO,
-    STREAMRESAMPLEMODE,
     STREAMFADE,
     STREAMFFMPEGINFO,
     STOPSOUND,
@@ -143,17 +142,6 @@ struct MsgStreamSample
   CActiveAEStream *stream;
 };
 
-struct MsgStreamParameter
-{
-  CActiveAEStream *stream;
-  union
-  {
-    float float_par;
-    double double_par;
-    int int_par;
-  } parameter;
-};
-
 struct MsgStreamFade
 {
   CActiveAEStream *stream;
@@ -190,11 +178,32 @@ public:
   void SetCurrentSinkFormat(AEAudioFormat SinkFormat);
   void SetSinkCacheTotal(float time) { m_sinkCacheTotal = time; }
   void SetSinkLatency(float time) { m_sinkLatency = time; }
+  void SetCacheLevel(float time) { m_cacheLevel = time; }
   bool IsSuspended();
   bool HasDSP();
   AEAudioFormat GetCurrentSinkFormat();
+
+  // time spent in the stages, for benchmarks. encoding runs on a thread of its own
+  enum EStage
+  {
+    STAGE_RESAMPLE = 0,
+    STAGE_MIX,
+    STAGE_ENCODE,
+    STAGE_SINK,
+    STAGE_MAX
+  };
+  void AddStageTime(EStage stage, int64_t ticks);
+  void GetStageTimes(double seconds[STAGE_MAX], int64_t &frames);
+  void ResetStageTimes();
+  void AddEncodeTime(int64_t ticks);
+  double GetEncodeTimePerFrame();
+
+  // the output device ran dry, counted since ResetStageTimes
+  void AddUnderrun();
+  unsigned int GetUnderruns();
 protected:
   float m_sinkCacheTotal;
+  float m_cacheLevel;
   float m_sinkLatency;
   int m_bufferedSamples;
   unsigned int m_sinkSampleRate;
@@ -214,6 +223,10 @@ protected:
     CAESyncInfo::AESyncState m_syncState;
   };
   std::vector<StreamStats> m_streamStats;
+  int64_t m_stageTime[STAGE_MAX];
+  int64_t m_processedFrames;
+  unsigned int m_encodedFrames;
+  unsigned int m_underruns;
 };
 
 class CActiveAE : public IAE, public IDispResource, private CThread
@@ -271,6 +284,10 @@ public:
   virtual void OnResetDisplay();
   virtual void OnAppFocusChange(bool focus);
 
+  /* engine statistics and cpu time of the engine thread in 100ns units, for benchmarks */
+  CEngineStats* GetStats() { return &m_stats; }
+  int64_t GetEngineUsage() { return GetAbsoluteUsage(); }
+
 protected:
   void PlaySound(CActiveAESound *sound);
   uint8_t **AllocSoundSample(SampleConfig &config, int &samples, int &bytes_per_sample, int &planes, int &linesize);
@@ -282,11 +299,6 @@ protected:
   void FlushStream(CActiveAEStream *stream);
   void PauseStream(CActiveAEStream *stream, bool pause);
   void StopSound(CActiveAESound *sound);
-  void SetStreamAmplification(CActiveAEStream *stream, float amplify);
-  void SetStreamReplaygain(CActiveAEStream *stream, float rgain);
-  void SetStreamVolume(CActiveAEStream *stream, float volume);
-  void SetStreamResampleRatio(CActiveAEStream *stream, double ratio);
-  void SetStreamResampleMode(CActiveAEStream *stream, int mode);
   void SetStreamFFmpegInfo(CActiveAEStream *stream, int profile, enum AVMatrixEncoding matrix_encoding, enum AVAudioServiceType audio_service_type);
   void SetStreamFade(CActiveAEStream *stream, float from, float target, unsigned int millis);
 
@@ -301,6 +313,7 @@ protected:
   void LoadSettings();
   bool NeedReconfigureBuffers();
   bool NeedReconfigureSink();
+  void ApplyProfile(bool lowlatency);
   void ApplySettingsToFormat(AEAudioFormat &format, AudioSettings &settings, int *mode = NULL);
   void Configure(AEAudioFormat *desiredFmt = NULL);
   AEAudioFormat GetInputFormat(AEAudioFormat *desiredFmt = NULL);
@@ -308,12 +321,16 @@ protected:
   void DiscardStream(CActiveAEStream *stream);
   void SFlushStream(CActiveAEStream *stream);
   void FlushEngine();
+  void EncodeDone(SEncodeJob *job);
+  void FinishEncode();
   void ClearDiscardedBuffers();
   void SStopSound(CActiveAESound *sound);
   void DiscardSound(CActiveAESound *sound);
   void ChangeResamplers();
 
   bool RunStages();
+  void ApplyStreamParameters();
+  bool ResampleStreams();
   bool HasWork();
   CSampleBuffer* SyncStream(CActiveAEStream *stream);
 
@@ -346,6 +363,8 @@ protected:
   }m_mode;
 
   CActiveAESink m_sink;
+  CActiveAEEncodeStage m_encodeStage;
+  unsigned int m_encodePending;
   AEAudioFormat m_sinkFormat;
   AEAudioFormat m_sinkRequestFormat;
   AEAudioFormat m_encoderFormat;
@@ -354,6 +373,12 @@ protected:
   AudioSettings m_settings;
   CEngineStats m_stats;
   IAEEncoder *m_encoder;
+
+  // buffering profile, see ApplyProfile
+  bool m_lowLatency;
+  float m_cacheLevel;
+  float m_waterLevel;
+  float m_bufferTime;
   std::string m_currDevice;
 
   // buffers
@@ -367,6 +392,9 @@ protected:
   std::list<CActiveAEStream*> m_streams;
   std::list<CActiveAEBufferPool*> m_discardBufferPools;
   unsigned int m_streamIdGen;
+  CActiveAEResampleWorkers m_resampleWorkers;
+  std::vector<SResampleJob> m_resampleJobs;
+  std::vector<CSampleBuffer*> m_streamBuffers; // reused by RunStages, holds no buffers in between
 
   // gui sounds
   struct SoundState
@@ -376,6 +404,7 @@ protected:
   };
   std::list<SoundState> m_sounds_playing;
   std::vector<CActiveAESound*> m_sounds;
+  CActiveAESoundCache m_soundCache;
 
   float m_volume; // volume on a 0..1 scale corresponding to a proportion along the dB scale
   float m_volumeScaled; // multiplier to scale samples in order to achieve the volume specified in m_volume
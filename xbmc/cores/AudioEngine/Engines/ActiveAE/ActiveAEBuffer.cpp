@@ -24,24 +24,58 @@
 #include "cores/AudioEngine/Engines/ActiveAE/ActiveAE.h"
 #include "cores/AudioEngine/Utils/AEUtil.h"
 #include "cores/AudioEngine/AEResampleFactory.h"
+#include "utils/log.h"
+
+extern "C" {
+#include "libavutil/mem.h"
+#include "libavutil/samplefmt.h"
+}
 
 using namespace ActiveAE;
 
 /* typecast AE to CActiveAE */
 #define AE (*((CActiveAE*)CAEFactory::GetEngine()))
 
+// cache line
+#define AE_BUFFER_ALIGN 64
+
 CSoundPacket::CSoundPacket(SampleConfig conf, int samples) : config(conf)
 {
   data = AE.AllocSoundSample(config, samples, bytes_per_sample, planes, linesize);
   max_nb_samples = samples;
   nb_samples = 0;
   pause_burst_ms = 0;
+  owns_data = true;
+}
+
+CSoundPacket::CSoundPacket(SampleConfig conf, int samples, uint8_t *buffer) : config(conf)
+{
+  planes = av_sample_fmt_is_planar(config.fmt) ? config.channels : 1;
+  data = new uint8_t*[planes];
+  av_samples_fill_arrays(data, &linesize, buffer, config.channels, samples, config.fmt, AE_BUFFER_ALIGN);
+  bytes_per_sample = av_get_bytes_per_sample(config.fmt);
+  max_nb_samples = samples;
+  nb_samples = 0;
+  pause_burst_ms = 0;
+  owns_data = false;
 }
 
 CSoundPacket::~CSoundPacket()
 {
   if (data)
-    AE.FreeSoundSample(data);
+  {
+    if (owns_data)
+      AE.FreeSoundSample(data);
+    else
+      delete [] data;
+  }
+}
+
+int CSoundPacket::GetBufferSize(SampleConfig &conf, int samples)
+{
+  int linesize;
+  int size = av_samples_get_buffer_size(&linesize, conf.channels, samples, conf.fmt, AE_BUFFER_ALIGN);
+  return (size + AE_BUFFER_ALIGN - 1) & ~(AE_BUFFER_ALIGN - 1);
 }
 
 CSampleBuffer::CSampleBuffer() : pkt(NULL), pool(NULL)
@@ -69,6 +103,50 @@ void CSampleBuffer::Return()
     pool->ReturnBuffer(this);
 }
 
+//-----------------------------------------------------------------------------
+
+CSampleBufferQueue::CSampleBufferQueue()
+{
+  m_head = 0;
+  m_size = 0;
+  m_mask = 0;
+  m_ring.resize(1);
+}
+
+void CSampleBufferQueue::Reserve(unsigned int size)
+{
+  if (size <= m_ring.size())
+    return;
+
+  unsigned int capacity = m_ring.size();
+  while (capacity < size)
+    capacity *= 2;
+
+  std::vector<CSampleBuffer*> ring(capacity);
+  for (unsigned int i = 0; i < m_size; i++)
+    ring[i] = m_ring[(m_head + i) & m_mask];
+  m_ring.swap(ring);
+  m_head = 0;
+  m_mask = capacity - 1;
+}
+
+void CSampleBufferQueue::push_back(CSampleBuffer *buffer)
+{
+  if (m_size == m_ring.size())
+  {
+    // sizes are reserved on creation of the pools, so this should not happen in steady state
+    Reserve(m_size * 2);
+    CActiveAEBufferPool::CountRuntimeAllocation();
+    CLog::Log(LOGDEBUG, "CSampleBufferQueue::%s - grown to %u buffers", __FUNCTION__, m_size * 2);
+  }
+  m_ring[(m_head + m_size) & m_mask] = buffer;
+  m_size++;
+}
+
+//-----------------------------------------------------------------------------
+
+std::atomic<unsigned int> CActiveAEBufferPool::m_runtimeAllocations(0);
+
 CActiveAEBufferPool::CActiveAEBufferPool(AEAudioFormat format)
 {
   m_format = format;
@@ -79,17 +157,14 @@ CActiveAEBufferPool::CActiveAEBufferPool(AEAudioFormat format)
     m_format.m_channelLayout.Reset();
     m_format.m_channelLayout += AE_CH_FC;
   }
+  m_buffers = NULL;
+  m_slab = NULL;
 }
 
 CActiveAEBufferPool::~CActiveAEBufferPool()
 {
-  CSampleBuffer *buffer;
-  while(!m_allSamples.empty())
-  {
-    buffer = m_allSamples.front();
-    m_allSamples.pop_front();
-    delete buffer;
-  }
+  delete [] m_buffers;
+  av_free(m_slab);
 }
 
 CSampleBuffer* CActiveAEBufferPool::GetFreeBuffer()
@@ -98,8 +173,9 @@ CSampleBuffer* CActiveAEBufferPool::GetFreeBuffer()
 
   if (!m_freeSamples.empty())
   {
-    buf = m_freeSamples.front();
-    m_freeSamples.pop_front();
+    // most recently returned buffer first, its memory is likely still cached
+    buf = m_freeSamples.back();
+    m_freeSamples.pop_back();
     buf->refCount = 1;
   }
   return buf;
@@ -109,12 +185,12 @@ void CActiveAEBufferPool::ReturnBuffer(CSampleBuffer *buffer)
 {
   buffer->pkt->nb_samples = 0;
   buffer->pkt->pause_burst_ms = 0;
+  // capacity was reserved for all buffers in Create
   m_freeSamples.push_back(buffer);
 }
 
 bool CActiveAEBufferPool::Create(unsigned int totaltime)
 {
-  CSampleBuffer *buffer;
   SampleConfig config;
   config.fmt = CAEUtil::GetAVSampleFormat(m_format.m_dataFormat);
   config.bits_per_sample = CAEUtil::DataFormatToUsedBits(m_format.m_dataFormat);
@@ -132,14 +208,36 @@ bool CActiveAEBufferPool::Create(unsigned int totaltime)
   unsigned int n = 0;
   while (time < totaltime || n < 5)
   {
-    buffer = new CSampleBuffer();
+    time += buffertime;
+    n++;
+  }
+
+  // one slab for the samples of all buffers, every buffer starts at a cache line
+  int size = CSoundPacket::GetBufferSize(config, m_format.m_frames);
+  if (size <= 0)
+  {
+    CLog::Log(LOGERROR, "CActiveAEBufferPool::%s - invalid format", __FUNCTION__);
+    return false;
+  }
+  m_slab = (uint8_t*)av_malloc((size_t)size * n + AE_BUFFER_ALIGN);
+  if (!m_slab)
+  {
+    CLog::Log(LOGERROR, "CActiveAEBufferPool::%s - failed to allocate %u buffers of %d bytes", __FUNCTION__, n, size);
+    return false;
+  }
+  uint8_t *slab = (uint8_t*)(((uintptr_t)m_slab + AE_BUFFER_ALIGN - 1) & ~(uintptr_t)(AE_BUFFER_ALIGN - 1));
+
+  m_buffers = new CSampleBuffer[n];
+  m_allSamples.reserve(n);
+  m_freeSamples.reserve(n);
+  for (unsigned int i = 0; i < n; i++)
+  {
+    CSampleBuffer *buffer = &m_buffers[i];
     buffer->pool = this;
-    buffer->pkt = new CSoundPacket(config, m_format.m_frames);
+    buffer->pkt = new CSoundPacket(config, m_format.m_frames, slab + (size_t)size * i);
 
     m_allSamples.push_back(buffer);
     m_freeSamples.push_back(buffer);
-    time += buffertime;
-    n++;
   }
 
   return true;
@@ -201,6 +299,10 @@ bool CActiveAEBufferPoolResample::Create(unsigned int totaltime, bool remap, boo
 {
   CActiveAEBufferPool::Create(totaltime);
 
+  // the queues also hold buffers of other pools, e.g. all streams feed the sink
+  m_inputSamples.Reserve(m_allSamples.size() * 2);
+  m_outputSamples.Reserve(m_allSamples.size() * 2);
+
   m_remap = remap;
   m_stereoUpmix = upmix;
   m_useResampler = m_changeResampler;                                       /* if m_changeResampler is true on Create, system require the usage of resampler */
@@ -547,19 +649,18 @@ bool CActiveAEBufferPoolResample::ResampleBuffers(int64_t timestamp)
 float CActiveAEBufferPoolResample::GetDelay()
 {
   float delay = 0;
-  std::deque<CSampleBuffer*>::iterator itBuf;
 
   if (m_procSample)
     delay += (float)m_procSample->pkt->nb_samples / m_procSample->pkt->config.sample_rate;
   if (m_dspSample)
     delay += (float)m_dspSample->pkt->nb_samples / m_dspSample->pkt->config.sample_rate;
 
-  for(itBuf=m_inputSamples.begin(); itBuf!=m_inputSamples.end(); ++itBuf)
+  for(CSampleBufferQueue::iterator itBuf = m_inputSamples.begin(); itBuf != m_inputSamples.end(); ++itBuf)
   {
     delay += (float)(*itBuf)->pkt->nb_samples / (*itBuf)->pkt->config.sample_rate;
   }
 
-  for(itBuf=m_outputSamples.begin(); itBuf!=m_outputSamples.end(); ++itBuf)
+  for(CSampleBufferQueue::iterator itBuf = m_outputSamples.begin(); itBuf != m_outputSamples.end(); ++itBuf)
   {
     delay += (float)(*itBuf)->pkt->nb_samples / (*itBuf)->pkt->config.sample_rate;
   }
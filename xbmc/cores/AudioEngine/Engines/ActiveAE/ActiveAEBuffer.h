@@ -22,7 +22,8 @@
 #include "cores/AudioEngine/Utils/AEAudioFormat.h"
 #include "cores/AudioEngine/Interfaces/AE.h"
 #include "cores/AudioEngine/DSPAddons/ActiveAEDSP.h"
-#include <deque>
+#include <atomic>
+#include <vector>
 
 extern "C" {
 #include "libavutil/avutil.h"
@@ -49,7 +50,9 @@ class CSoundPacket
 {
 public:
   CSoundPacket(SampleConfig conf, int samples);
+  CSoundPacket(SampleConfig conf, int samples, uint8_t *buffer);
   ~CSoundPacket();
+  static int GetBufferSize(SampleConfig &conf, int samples);
   uint8_t **data;                        // array with pointers to planes of data
   SampleConfig config;
   int bytes_per_sample;                  // bytes per sample and per channel
@@ -58,6 +61,7 @@ public:
   int nb_samples;                        // number of frames used
   int max_nb_samples;                    // max number of frames this packet can hold
   int pause_burst_ms;
+  bool owns_data;                        // false if data points into the slab of a buffer pool
 };
 
 class CActiveAEBufferPool;
@@ -76,6 +80,47 @@ public:
   int refCount;
 };
 
+/**
+ * fifo of sample buffers, a ring that only grows if it runs full
+ */
+class CSampleBufferQueue
+{
+public:
+  class iterator
+  {
+  public:
+    iterator(const CSampleBufferQueue *queue, unsigned int pos) : m_queue(queue), m_pos(pos) {}
+    CSampleBuffer* operator*() const { return m_queue->m_ring[(m_queue->m_head + m_pos) & m_queue->m_mask]; }
+    iterator& operator++() { m_pos++; return *this; }
+    bool operator!=(const iterator &rhs) const { return m_pos != rhs.m_pos; }
+    bool operator==(const iterator &rhs) const { return m_pos == rhs.m_pos; }
+  private:
+    const CSampleBufferQueue *m_queue;
+    unsigned int m_pos;
+  };
+
+  CSampleBufferQueue();
+  void Reserve(unsigned int size);
+  void push_back(CSampleBuffer *buffer);
+  void pop_front() { m_head = (m_head + 1) & m_mask; m_size--; }
+  CSampleBuffer* front() const { return m_ring[m_head]; }
+  bool empty() const { return m_size == 0; }
+  size_t size() const { return m_size; }
+  iterator begin() const { return iterator(this, 0); }
+  iterator end() const { return iterator(this, m_size); }
+
+private:
+  std::vector<CSampleBuffer*> m_ring;
+  unsigned int m_head;
+  unsigned int m_size;
+  unsigned int m_mask;
+};
+
+/**
+ * All buffers of a pool share one cache aligned slab of sample memory which
+ * is allocated on Create. Pools and their queues are only accessed by the
+ * engine thread, after Create getting and returning buffers never allocates.
+ */
 class CActiveAEBufferPool
 {
 public:
@@ -84,9 +129,21 @@ public:
   virtual bool Create(unsigned int totaltime);
   CSampleBuffer *GetFreeBuffer();
   void ReturnBuffer(CSampleBuffer *buffer);
+
+  /**
+   * number of heap allocations done by pools and sample queues after
+   * their creation, should stay constant while streams are playing
+   */
+  static unsigned int GetRuntimeAllocations() { return m_runtimeAllocations; }
+  static void CountRuntimeAllocation() { m_runtimeAllocations++; }
+
   AEAudioFormat m_format;
-  std::deque<CSampleBuffer*> m_allSamples;
-  std::deque<CSampleBuffer*> m_freeSamples;
+  std::vector<CSampleBuffer*> m_allSamples;
+  std::vector<CSampleBuffer*> m_freeSamples;
+protected:
+  CSampleBuffer *m_buffers;
+  uint8_t *m_slab;
+  static std::atomic<unsigned int> m_runtimeAllocations;
 };
 
 class IAEResample;
@@ -105,8 +162,8 @@ public:
   void Flush();
   AEAudioFormat m_inputFormat;
   AEAudioFormat m_dspFormat;
-  std::deque<CSampleBuffer*> m_inputSamples;
-  std::deque<CSampleBuffer*> m_outputSamples;
+  CSampleBufferQueue m_inputSamples;
+  CSampleBufferQueue m_outputSamples;
   CSampleBuffer *m_procSample;
   IAEResample *m_resampler;
   CSampleBuffer *m_dspSample;
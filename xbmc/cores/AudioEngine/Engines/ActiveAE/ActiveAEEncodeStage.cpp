@@ -0,0 +1,83 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "ActiveAEEncodeStage.h"
+#include "ActiveAEBuffer.h"
+#include "cores/AudioEngine/Interfaces/AEEncoder.h"
+#include "utils/TimeUtils.h"
+
+using namespace ActiveAE;
+
+CActiveAEEncodeStage::CActiveAEEncodeStage(CEvent *inMsgEvent) :
+  CThread("AEEncoder"),
+  m_dataPort("EncoderDataPort", inMsgEvent, &m_outMsgEvent)
+{
+}
+
+void CActiveAEEncodeStage::Encode(SEncodeJob &job)
+{
+  if (!IsRunning())
+  {
+    Create();
+    SetPriority(THREAD_PRIORITY_ABOVE_NORMAL);
+  }
+  m_dataPort.SendOutMessage(CEncodeDataProtocol::ENCODE, &job, sizeof(SEncodeJob));
+}
+
+void CActiveAEEncodeStage::Dispose()
+{
+  m_bStop = true;
+  m_outMsgEvent.Set();
+  StopThread();
+  m_dataPort.Purge();
+}
+
+void CActiveAEEncodeStage::Process()
+{
+  Message *msg;
+
+  while (!m_bStop)
+  {
+    if (!m_dataPort.ReceiveOutMessage(&msg))
+    {
+      AbortableWait(m_outMsgEvent);
+      continue;
+    }
+
+    if (msg->signal == CEncodeDataProtocol::ENCODE)
+    {
+      SEncodeJob *job = (SEncodeJob*)msg->data;
+      CSampleBuffer *in = job->in;
+      CSampleBuffer *out = job->out;
+
+      int64_t start = CurrentHostCounter();
+      out->pkt->nb_samples = job->encoder->Encode(in->pkt->data[0], in->pkt->planes*in->pkt->linesize,
+                                                  out->pkt->data[0], out->pkt->planes*out->pkt->linesize);
+      job->time = CurrentHostCounter() - start;
+
+      // set pts of last sample
+      out->pkt_start_offset = out->pkt->nb_samples;
+      out->timestamp = in->timestamp;
+
+      m_dataPort.SendInMessage(CEncodeDataProtocol::ENCODED, job, sizeof(SEncodeJob));
+    }
+    msg->Release();
+  }
+}
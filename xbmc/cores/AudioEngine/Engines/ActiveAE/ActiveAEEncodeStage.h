@@ -0,0 +1,79 @@
+#pragma once
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "threads/Event.h"
+#include "threads/Thread.h"
+#include "utils/ActorProtocol.h"
+
+#include <stdint.h>
+
+class IAEEncoder;
+
+namespace ActiveAE
+{
+
+using namespace Actor;
+
+class CSampleBuffer;
+
+struct SEncodeJob
+{
+  IAEEncoder *encoder;
+  CSampleBuffer *in;                     // mixed samples
+  CSampleBuffer *out;                    // encoded packet
+  int64_t time;                          // host ticks spent encoding
+};
+
+class CEncodeDataProtocol : public Protocol
+{
+public:
+  CEncodeDataProtocol(std::string name, CEvent* inEvent, CEvent *outEvent) : Protocol(name, inEvent, outEvent) {};
+  enum OutSignal
+  {
+    ENCODE = 0,
+  };
+  enum InSignal
+  {
+    ENCODED,
+  };
+};
+
+/**
+ * Encodes mixed packets on a thread of its own, so the engine mixes the next
+ * packet while the current one is encoded. Jobs are sent as ENCODE and come
+ * back as ENCODED in the same order. Buffers are only touched by the engine
+ * before sending and after receiving a job.
+ */
+class CActiveAEEncodeStage : private CThread
+{
+public:
+  CActiveAEEncodeStage(CEvent *inMsgEvent);
+  void Encode(SEncodeJob &job);
+  void Dispose();
+  CEncodeDataProtocol m_dataPort;
+
+protected:
+  virtual void Process();
+
+  CEvent m_outMsgEvent;
+};
+
+}
@@ -0,0 +1,141 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "ActiveAEResampleWorkers.h"
+#include "ActiveAEBuffer.h"
+#include "threads/SingleLock.h"
+#include "utils/CPUInfo.h"
+#include "utils/log.h"
+#include "utils/TimeUtils.h"
+
+#include <algorithm>
+
+using namespace ActiveAE;
+
+// more threads don't pay off for the handful of streams played at once
+#define MAX_RESAMPLE_WORKERS 3
+
+CActiveAEResampleWorkers::CWorker::CWorker(CActiveAEResampleWorkers *workers)
+  : CThread("AEResample"), m_workers(workers)
+{
+}
+
+void CActiveAEResampleWorkers::CWorker::Process()
+{
+  while (!m_bStop)
+  {
+    if (AbortableWait(m_wake) != WAIT_SIGNALED)
+      break;
+    m_workers->RunJobs();
+  }
+}
+
+CActiveAEResampleWorkers::CActiveAEResampleWorkers()
+{
+  m_started = false;
+  m_jobs = NULL;
+  m_next = 0;
+  m_pending = 0;
+}
+
+CActiveAEResampleWorkers::~CActiveAEResampleWorkers()
+{
+  Stop();
+}
+
+void CActiveAEResampleWorkers::Start()
+{
+  m_started = true;
+
+  // the engine thread does a share of the work itself
+  int count = std::min(g_cpuInfo.getCPUCount() - 1, MAX_RESAMPLE_WORKERS);
+  for (int i = 0; i < count; i++)
+  {
+    CWorker *worker = new CWorker(this);
+    worker->Create();
+    m_workers.push_back(worker);
+  }
+  CLog::Log(LOGDEBUG, "CActiveAEResampleWorkers::%s - started %d workers", __FUNCTION__, count);
+}
+
+void CActiveAEResampleWorkers::Stop()
+{
+  for (std::vector<CWorker*>::iterator it = m_workers.begin(); it != m_workers.end(); ++it)
+  {
+    (*it)->StopThread();
+    delete (*it);
+  }
+  m_workers.clear();
+  m_started = false;
+}
+
+void CActiveAEResampleWorkers::Run(std::vector<SResampleJob> &jobs)
+{
+  if (jobs.size() > 1 && !m_started)
+    Start();
+
+  if (jobs.size() <= 1 || m_workers.empty())
+  {
+    for (std::vector<SResampleJob>::iterator it = jobs.begin(); it != jobs.end(); ++it)
+      RunJob(*it);
+    return;
+  }
+
+  {
+    CSingleLock lock(m_lock);
+    m_jobs = &jobs;
+    m_next = 0;
+    m_pending = jobs.size();
+    m_done.Reset();
+  }
+
+  size_t wake = std::min(m_workers.size(), jobs.size() - 1);
+  for (size_t i = 0; i < wake; i++)
+    m_workers[i]->m_wake.Set();
+
+  RunJobs();
+
+  // join, a worker may still be busy with the last job
+  m_done.Wait();
+
+  CSingleLock lock(m_lock);
+  m_jobs = NULL;
+}
+
+void CActiveAEResampleWorkers::RunJobs()
+{
+  CSingleLock lock(m_lock);
+  while (m_jobs && m_next < m_jobs->size())
+  {
+    SResampleJob &job = (*m_jobs)[m_next++];
+    lock.Leave();
+    RunJob(job);
+    lock.Enter();
+    if (--m_pending == 0)
+      m_done.Set();
+  }
+}
+
+void CActiveAEResampleWorkers::RunJob(SResampleJob &job)
+{
+  int64_t start = CurrentHostCounter();
+  job.busy = job.pool->ResampleBuffers();
+  job.time = CurrentHostCounter() - start;
+}
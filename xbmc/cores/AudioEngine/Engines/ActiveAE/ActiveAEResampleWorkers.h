@@ -0,0 +1,82 @@
+#pragma once
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "threads/CriticalSection.h"
+#include "threads/Event.h"
+#include "threads/Thread.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace ActiveAE
+{
+
+class CActiveAEBufferPoolResample;
+
+struct SResampleJob
+{
+  CActiveAEBufferPoolResample *pool;
+  bool busy;                             // result of ResampleBuffers
+  int64_t time;                          // host ticks spent resampling
+};
+
+/**
+ * Runs ResampleBuffers of independent streams in parallel. The engine thread
+ * takes part and Run only returns after all jobs are done, so mixing always
+ * sees the result of every stream of the cycle.
+ */
+class CActiveAEResampleWorkers
+{
+public:
+  CActiveAEResampleWorkers();
+  ~CActiveAEResampleWorkers();
+
+  /**
+   * resample all jobs, serially if there is only one job or one cpu
+   */
+  void Run(std::vector<SResampleJob> &jobs);
+  void Stop();
+
+protected:
+  class CWorker : public CThread
+  {
+  public:
+    CWorker(CActiveAEResampleWorkers *workers);
+    CEvent m_wake;
+  protected:
+    virtual void Process();
+    CActiveAEResampleWorkers *m_workers;
+  };
+
+  void Start();
+  void RunJobs();
+  static void RunJob(SResampleJob &job);
+
+  std::vector<CWorker*> m_workers;
+  bool m_started;
+  CCriticalSection m_lock;
+  CEvent m_done;
+  std::vector<SResampleJob> *m_jobs;
+  size_t m_next;
+  size_t m_pending;
+};
+
+}
@@ -24,12 +24,13 @@
 #include "cores/AudioEngine/Utils/AEUtil.h"
 #include "cores/AudioEngine/Utils/AEStreamInfo.h"
 #include "cores/AudioEngine/Utils/AEBitstreamPacker.h"
-#include "utils/EndianSwap.h"
+#include "cores/AudioEngine/Utils/AEKernels.h"
 #include "ActiveAE.h"
 #include "cores/AudioEngine/AEResampleFactory.h"
 
 #include "settings/Settings.h"
 #include "utils/log.h"
+#include "utils/TimeUtils.h"
 
 #include <new> // for std::bad_alloc
 #include <algorithm>
@@ -50,6 +51,7 @@ CActiveAESink::CActiveAESink(CEvent *inMsgEvent) :
   m_stats = nullptr;
   m_volume = 0.0;
   m_packer = nullptr;
+  m_outputEnd = 0;
 }
 
 void CActiveAESink::Start()
@@ -490,6 +492,7 @@ void CActiveAESink::StateMachine(int signal, Protocol *port, Message *msg)
         switch (signal)
         {
         case CSinkDataProtocol::SAMPLE:
+          m_outputEnd = 0;
           OutputSamples(&m_sampleOfSilence);
           m_state = S_TOP_CONFIGURED_PLAY;
           m_extTimeout = 0;
@@ -784,6 +787,8 @@ void CActiveAESink::OpenSink()
 
   CLog::Log(LOGINFO, "CActiveAESink::OpenSink - initialize sink");
 
+  m_outputEnd = 0;
+
   if (m_sink)
   {
     m_sink->Drain();
@@ -908,6 +913,15 @@ unsigned int CActiveAESink::OutputSamples(CSampleBuffer* samples)
   uint8_t* p_mergebuffer = NULL;
   AEDelayStatus status;
 
+  // a write after the device has played out all data is a dropout
+  int64_t now = CurrentHostCounter();
+  if (m_outputEnd && now > m_outputEnd)
+  {
+    m_stats->AddUnderrun();
+    CLog::Log(LOGDEBUG, "CActiveAESink::OutputSamples - underrun, device idle for %d ms",
+              (int)((now - m_outputEnd) * 1000 / CurrentHostFrequency()));
+  }
+
   if (m_requestedFormat.m_dataFormat == AE_FMT_RAW)
   {
     if (m_needIecPack)
@@ -958,12 +972,12 @@ unsigned int CActiveAESink::OutputSamples(CSampleBuffer* samples)
         case SKIP_SWAP:
           break;
         case NEED_BYTESWAP:
-          Endian_Swap16_buf((uint16_t *)buffer[0], (uint16_t *)buffer[0], size / 2);
+          CAEKernels::Swap16((uint16_t *)buffer[0], (uint16_t *)buffer[0], size / 2);
           break;
         case CHECK_SWAP:
           SwapInit(samples);
           if (m_swapState == NEED_BYTESWAP)
-            Endian_Swap16_buf((uint16_t *)buffer[0], (uint16_t *)buffer[0], size / 2);
+            CAEKernels::Swap16((uint16_t *)buffer[0], (uint16_t *)buffer[0], size / 2);
           break;
         default:
           break;
@@ -994,6 +1008,7 @@ unsigned int CActiveAESink::OutputSamples(CSampleBuffer* samples)
         m_sink->AddPause(samples->pkt->pause_burst_ms);
         m_sink->GetDelay(status);
         m_stats->UpdateSinkDelay(status, samples->pool ? 1 : 0);
+        SetOutputEnd(status);
         return status.delay * 1000;
       }
     }
@@ -1045,9 +1060,16 @@ unsigned int CActiveAESink::OutputSamples(CSampleBuffer* samples)
   if (m_requestedFormat.m_dataFormat == AE_FMT_RAW)
     m_stats->UpdateSinkDelay(status, samples->pool ? 1 : 0);
 
+  SetOutputEnd(status);
   return status.delay * 1000;
 }
 
+void CActiveAESink::SetOutputEnd(const AEDelayStatus &status)
+{
+  // allow some jitter of the reported delay
+  m_outputEnd = CurrentHostCounter() + (int64_t)((status.delay + 0.005) * CurrentHostFrequency());
+}
+
 void CActiveAESink::SwapInit(CSampleBuffer* samples)
 {
   if ((m_requestedFormat.m_dataFormat == AE_FMT_RAW) && CAEUtil::S16NeedsByteSwap(AE_FMT_S16NE, m_sinkFormat.m_dataFormat))
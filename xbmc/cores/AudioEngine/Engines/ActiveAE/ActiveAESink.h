@@ -114,6 +114,7 @@ protected:
   bool NeedIECPacking();
 
   unsigned int OutputSamples(CSampleBuffer* samples);
+  void SetOutputEnd(const AEDelayStatus &status);
   void SwapInit(CSampleBuffer* samples);
 
   void GenerateNoise();
@@ -146,6 +147,7 @@ protected:
   CEngineStats *m_stats;
   float m_volume;
   int m_sinkLatency;
+  int64_t m_outputEnd; // host counter when the device runs dry, 0 if not playing
   CAEBitstreamPacker *m_packer;
   bool m_needIecPack;
 };
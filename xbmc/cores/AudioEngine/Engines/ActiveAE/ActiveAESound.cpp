@@ -23,6 +23,7 @@
 #include "cores/AudioEngine/AEFactory.h"
 #include "ActiveAE.h"
 #include "ActiveAESound.h"
+#include "ActiveAESoundCache.h"
 #include "utils/log.h"
 
 extern "C" {
@@ -41,8 +42,6 @@ CActiveAESound::CActiveAESound(const std::string &filename) :
   m_volume         (1.0f    ),
   m_channel        (AE_CH_NULL)
 {
-  m_orig_sound = NULL;
-  m_dst_sound = NULL;
   m_pFile = NULL;
   m_isSeekPossible = false;
   m_fileSize = 0;
@@ -51,8 +50,6 @@ CActiveAESound::CActiveAESound(const std::string &filename) :
 
 CActiveAESound::~CActiveAESound()
 {
-  delete m_orig_sound;
-  delete m_dst_sound;
   Finish();
 }
 
@@ -74,14 +71,13 @@ bool CActiveAESound::IsPlaying()
 
 uint8_t** CActiveAESound::InitSound(bool orig, SampleConfig config, int nb_samples)
 {
-  CSoundPacket **info;
+  std::shared_ptr<CSoundPacket> *info;
   if (orig)
     info = &m_orig_sound;
   else
     info = &m_dst_sound;
 
-  delete *info;
-  *info = new CSoundPacket(config, nb_samples);
+  info->reset(new CSoundPacket(config, nb_samples));
 
   (*info)->nb_samples = 0;
   m_isConverted = false;
@@ -90,7 +86,7 @@ uint8_t** CActiveAESound::InitSound(bool orig, SampleConfig config, int nb_sampl
 
 bool CActiveAESound::StoreSound(bool orig, uint8_t **buffer, int samples, int linesize)
 {
-  CSoundPacket **info;
+  std::shared_ptr<CSoundPacket> *info;
   if (orig)
     info = &m_orig_sound;
   else
@@ -117,6 +113,14 @@ bool CActiveAESound::StoreSound(bool orig, uint8_t **buffer, int samples, int li
 }
 
 CSoundPacket *CActiveAESound::GetSound(bool orig)
+{
+  if (orig)
+    return m_orig_sound.get();
+  else
+    return m_dst_sound.get();
+}
+
+std::shared_ptr<CSoundPacket> CActiveAESound::ShareSound(bool orig)
 {
   if (orig)
     return m_orig_sound;
@@ -124,6 +128,15 @@ CSoundPacket *CActiveAESound::GetSound(bool orig)
     return m_dst_sound;
 }
 
+void CActiveAESound::SetSound(bool orig, const std::shared_ptr<CSoundPacket> &sound)
+{
+  if (orig)
+    m_orig_sound = sound;
+  else
+    m_dst_sound = sound;
+  m_isConverted = !orig && sound;
+}
+
 bool CActiveAESound::Prepare()
 {
   unsigned int flags = READ_TRUNCATED | READ_CHUNKED;
@@ -137,6 +150,8 @@ bool CActiveAESound::Prepare()
   }
   m_isSeekPossible = m_pFile->IoControl(IOCTRL_SEEK_POSSIBLE, NULL) != 0;
   m_fileSize = m_pFile->GetLength();
+  if (m_isSeekPossible)
+    m_cacheKey = CActiveAESoundCache::GetKey(*m_pFile);
   return true;
 }
 
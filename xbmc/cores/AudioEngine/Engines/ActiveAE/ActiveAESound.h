@@ -22,6 +22,8 @@
 #include "cores/AudioEngine/Interfaces/AESound.h"
 #include "filesystem/File.h"
 
+#include <memory>
+
 class DllAvUtil;
 
 namespace ActiveAE
@@ -45,6 +47,8 @@ public:
   uint8_t** InitSound(bool orig, SampleConfig config, int nb_samples);
   bool StoreSound(bool orig, uint8_t **buffer, int samples, int linesize);
   CSoundPacket *GetSound(bool orig);
+  std::shared_ptr<CSoundPacket> ShareSound(bool orig);
+  void SetSound(bool orig, const std::shared_ptr<CSoundPacket> &sound);
 
   bool IsConverted() { return m_isConverted; }
   void SetConverted(bool state) { m_isConverted = state; }
@@ -54,6 +58,7 @@ public:
   int GetChunkSize();
   int GetFileSize() { return m_fileSize; }
   bool IsSeekPossible() { return m_isSeekPossible; }
+  const std::string& GetCacheKey() { return m_cacheKey; }
 
   static int Read(void *h, uint8_t* buf, int size);
   static int64_t Seek(void *h, int64_t pos, int whence);
@@ -63,11 +68,12 @@ protected:
   XFILE::CFile *m_pFile;
   bool m_isSeekPossible;
   int m_fileSize;
+  std::string m_cacheKey;
   float m_volume;
   AEChannel m_channel;
 
-  CSoundPacket *m_orig_sound;
-  CSoundPacket *m_dst_sound;
+  std::shared_ptr<CSoundPacket> m_orig_sound;
+  std::shared_ptr<CSoundPacket> m_dst_sound;
 
   bool m_isConverted;
 };
@@ -0,0 +1,135 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "ActiveAESoundCache.h"
+#include "ActiveAEBuffer.h"
+#include "filesystem/File.h"
+#include "threads/SingleLock.h"
+#include "utils/md5.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace ActiveAE;
+
+CActiveAESoundCache::CActiveAESoundCache(size_t maxUnused) :
+  m_maxUnused(maxUnused),
+  m_useCount(0)
+{
+}
+
+std::string CActiveAESoundCache::GetKey(XFILE::CFile &file)
+{
+  XBMC::XBMC_MD5 md5;
+  uint8_t buffer[4096];
+  ssize_t read;
+  while ((read = file.Read(buffer, sizeof(buffer))) > 0)
+    md5.append(buffer, read);
+
+  if (read < 0 || file.Seek(0, SEEK_SET) != 0)
+    return "";
+
+  return md5.getDigest();
+}
+
+std::shared_ptr<CSoundPacket> CActiveAESoundCache::Get(const std::string &key, const std::string &format)
+{
+  if (key.empty())
+    return std::shared_ptr<CSoundPacket>();
+
+  CSingleLock lock(m_lock);
+  std::map<std::string, SEntry>::iterator it = m_entries.find(key + "/" + format);
+  if (it == m_entries.end())
+    return std::shared_ptr<CSoundPacket>();
+
+  it->second.lastUse = ++m_useCount;
+  return it->second.sound;
+}
+
+void CActiveAESoundCache::Store(const std::string &key, const std::string &format, const std::shared_ptr<CSoundPacket> &sound)
+{
+  if (key.empty() || !sound)
+    return;
+
+  CSingleLock lock(m_lock);
+  SEntry &entry = m_entries[key + "/" + format];
+  entry.sound = sound;
+  entry.size = (size_t)sound->max_nb_samples * sound->bytes_per_sample * sound->config.channels;
+  entry.lastUse = ++m_useCount;
+  Trim();
+}
+
+void CActiveAESoundCache::Clear()
+{
+  CSingleLock lock(m_lock);
+  m_entries.clear();
+}
+
+size_t CActiveAESoundCache::GetSize()
+{
+  CSingleLock lock(m_lock);
+  size_t size = 0;
+  for (std::map<std::string, SEntry>::iterator it = m_entries.begin(); it != m_entries.end(); ++it)
+    size += it->second.size;
+  return size;
+}
+
+size_t CActiveAESoundCache::GetUnusedSize()
+{
+  CSingleLock lock(m_lock);
+  size_t size = 0;
+  for (std::map<std::string, SEntry>::iterator it = m_entries.begin(); it != m_entries.end(); ++it)
+  {
+    if (it->second.sound.unique())
+      size += it->second.size;
+  }
+  return size;
+}
+
+/**
+ * drop buffers no sound refers to, least recently used first, until the
+ * unused ones fit into the budget
+ */
+void CActiveAESoundCache::Trim()
+{
+  std::vector<std::map<std::string, SEntry>::iterator> unused;
+  size_t size = 0;
+  for (std::map<std::string, SEntry>::iterator it = m_entries.begin(); it != m_entries.end(); ++it)
+  {
+    if (it->second.sound.unique())
+    {
+      unused.push_back(it);
+      size += it->second.size;
+    }
+  }
+
+  if (size <= m_maxUnused)
+    return;
+
+  std::sort(unused.begin(), unused.end(),
+            [](const std::map<std::string, SEntry>::iterator &a, const std::map<std::string, SEntry>::iterator &b)
+            { return a->second.lastUse < b->second.lastUse; });
+
+  for (size_t i = 0; i < unused.size() && size > m_maxUnused; i++)
+  {
+    size -= unused[i]->second.size;
+    m_entries.erase(unused[i]);
+  }
+}
@@ -0,0 +1,83 @@
+#pragma once
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "threads/CriticalSection.h"
+
+#include <map>
+#include <memory>
+#include <stdint.h>
+#include <string>
+
+namespace XFILE
+{
+class CFile;
+}
+
+namespace ActiveAE
+{
+
+class CSoundPacket;
+
+/**
+ * Decoded GUI sounds, addressed by the digest of the sound file.
+ * Sounds with the same content share one buffer, and so do their copies
+ * converted to the sink format. Buffers no sound uses any more are kept up
+ * to a budget, so reloading a skin or sound pack does not decode and
+ * resample everything again.
+ */
+class CActiveAESoundCache
+{
+public:
+  CActiveAESoundCache(size_t maxUnused);
+
+  /**
+   * digest of the file content, the file is rewound afterwards
+   * @return empty string if the file can not be read or rewound
+   */
+  static std::string GetKey(XFILE::CFile &file);
+
+  /**
+   * @param format empty for the decoded sound, else a description of the
+   *               sink format the sound was converted to
+   */
+  std::shared_ptr<CSoundPacket> Get(const std::string &key, const std::string &format);
+  void Store(const std::string &key, const std::string &format, const std::shared_ptr<CSoundPacket> &sound);
+  void Clear();
+
+  size_t GetSize();
+  size_t GetUnusedSize();
+
+protected:
+  struct SEntry
+  {
+    std::shared_ptr<CSoundPacket> sound;
+    size_t size;
+    uint64_t lastUse;
+  };
+  void Trim();
+
+  CCriticalSection m_lock;
+  std::map<std::string, SEntry> m_entries;
+  size_t m_maxUnused;
+  uint64_t m_useCount;
+};
+
+}
@@ -40,6 +40,9 @@ CActiveAEStream::CActiveAEStream(AEAudioFormat *format, unsigned int streamid)
   m_format = *format;
   m_id = streamid;
   m_bufferedTime = 0;
+  m_resampleTime = 0;
+  m_resampleTimeMax = 0;
+  m_resampleCycles = 0;
   m_currentBuffer = NULL;
   m_drain = false;
   m_paused = false;
@@ -466,7 +469,7 @@ float CActiveAEStream::GetAmplification()
 void CActiveAEStream::SetAmplification(float amplify)
 {
   m_streamAmplify = amplify;
-  AE.SetStreamAmplification(this, m_streamAmplify);
+  m_shadowAmplify.Set(m_streamAmplify);
 }
 
 float CActiveAEStream::GetReplayGain()
@@ -477,7 +480,7 @@ float CActiveAEStream::GetReplayGain()
 void CActiveAEStream::SetReplayGain(float factor)
 {
   m_streamRgain = std::max( 0.0f, factor);
-  AE.SetStreamReplaygain(this, m_streamRgain);
+  m_shadowRgain.Set(m_streamRgain);
 }
 
 float CActiveAEStream::GetVolume()
@@ -488,7 +491,7 @@ float CActiveAEStream::GetVolume()
 void CActiveAEStream::SetVolume(float volume)
 {
   m_streamVolume = std::max( 0.0f, std::min(1.0f, volume));
-  AE.SetStreamVolume(this, m_streamVolume);
+  m_shadowVolume.Set(m_streamVolume);
 }
 
 double CActiveAEStream::GetResampleRatio()
@@ -499,14 +502,14 @@ double CActiveAEStream::GetResampleRatio()
 void CActiveAEStream::SetResampleRatio(double ratio)
 {
   if (ratio != m_streamResampleRatio)
-    AE.SetStreamResampleRatio(this, ratio);
+    m_shadowResampleRatio.Set(ratio);
   m_streamResampleRatio = ratio;
 }
 
 void CActiveAEStream::SetResampleMode(int mode)
 {
   if (mode != m_streamResampleMode)
-    AE.SetStreamResampleMode(this, mode);
+    m_shadowResampleMode.Set(mode);
   m_streamResampleMode = mode;
 }
 
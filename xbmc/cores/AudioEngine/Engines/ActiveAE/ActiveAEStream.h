@@ -89,6 +89,35 @@ protected:
   XbmcThreads::EndTime m_timer;
 };
 
+/**
+ * Scalar stream parameter, set by the owner of the stream and picked up by
+ * the engine once per cycle, without a message to the engine thread.
+ * The engine only takes the value after it has been set, so it may keep
+ * changing its working copy in between, e.g. while fading.
+ */
+template<typename T>
+class CShadowParameter
+{
+public:
+  CShadowParameter() : m_value(T()), m_changed(false) {}
+  void Set(T value)
+  {
+    m_value.store(value, std::memory_order_relaxed);
+    m_changed.store(true, std::memory_order_release);
+  }
+  bool Fetch(T &value)
+  {
+    if (!m_changed.load(std::memory_order_relaxed) ||
+        !m_changed.exchange(false, std::memory_order_acquire))
+      return false;
+    value = m_value.load(std::memory_order_relaxed);
+    return true;
+  }
+
+protected:
+  std::atomic<T> m_value;
+  std::atomic_bool m_changed;
+};
 
 class CActiveAEStream : public IAEStream
 {
@@ -174,10 +203,17 @@ protected:
   double m_lastPtsJump;
   std::atomic_int m_errorInterval;
 
+  // set by the owner, applied by CActiveAE::ApplyStreamParameters
+  CShadowParameter<float> m_shadowVolume;
+  CShadowParameter<float> m_shadowRgain;
+  CShadowParameter<float> m_shadowAmplify;
+  CShadowParameter<double> m_shadowResampleRatio;
+  CShadowParameter<int> m_shadowResampleMode;
+
   // only accessed by engine
   CActiveAEBufferPool *m_inputBuffers;
   CActiveAEBufferPoolResample *m_resampleBuffers;
-  std::deque<CSampleBuffer*> m_processingSamples;
+  CSampleBufferQueue m_processingSamples;
   CActiveAEDataProtocol *m_streamPort;
   CEvent m_inMsgEvent;
   bool m_drain;
@@ -188,6 +224,9 @@ protected:
   float m_rgain;
   float m_amplify;
   float m_bufferedTime;
+  int64_t m_resampleTime;      // host ticks spent in ResampleBuffers
+  int64_t m_resampleTimeMax;
+  unsigned int m_resampleCycles;
   int m_fadingSamples;
   float m_fadingBase;
   float m_fadingTarget;
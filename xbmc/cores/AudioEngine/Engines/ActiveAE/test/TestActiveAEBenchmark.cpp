@@ -0,0 +1,278 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/AudioEngine/AEFactory.h"
+#include "cores/AudioEngine/Engines/ActiveAE/ActiveAE.h"
+#include "cores/AudioEngine/Interfaces/AEStream.h"
+#include "settings/Settings.h"
+#include "threads/SystemClock.h"
+
+#ifdef TARGET_POSIX
+#include "linux/XTimeUtils.h"
+#endif
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+using namespace ActiveAE;
+
+namespace
+{
+
+// long enough for the engine to settle
+const unsigned int BENCH_MS = 4000;
+const unsigned int WARMUP_MS = 1000;
+
+struct SSource
+{
+  IAEStream *stream;
+  AEAudioFormat format;
+  std::vector<float> data;
+  uint64_t frames;
+  double phase;
+};
+
+void Generate(SSource &source, unsigned int frames)
+{
+  // a sine per channel, so resampling and mixing work on real signal
+  unsigned int channels = source.format.m_channelLayout.Count();
+  source.data.resize(frames * channels);
+  for (unsigned int i = 0; i < frames; i++)
+  {
+    for (unsigned int c = 0; c < channels; c++)
+      source.data[i * channels + c] = 0.25f * sinf(source.phase * (c + 1));
+    source.phase += 2.0 * 3.14159265358979 * 440.0 / source.format.m_sampleRate;
+  }
+}
+
+}
+
+class TestActiveAEBenchmark : public testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    // run on the NULL sink, which consumes audio in real time
+    const char *sink = getenv("AE_SINK");
+    m_hadSink = sink != NULL;
+    m_sink = sink ? sink : "";
+#if defined(TARGET_WINDOWS)
+    _putenv("AE_SINK=NULL");
+#else
+    setenv("AE_SINK", "NULL", 1);
+#endif
+    ASSERT_TRUE(CAEFactory::LoadEngine());
+    ASSERT_TRUE(CAEFactory::StartEngine());
+  }
+
+  virtual void TearDown()
+  {
+    for (std::vector<SSource>::iterator it = m_sources.begin(); it != m_sources.end(); ++it)
+      CAEFactory::FreeStream(it->stream);
+    m_sources.clear();
+    CAEFactory::UnLoadEngine();
+
+    // later tests pick the sink as usual
+#if defined(TARGET_WINDOWS)
+    _putenv(("AE_SINK=" + m_sink).c_str());
+#else
+    if (m_hadSink)
+      setenv("AE_SINK", m_sink.c_str(), 1);
+    else
+      unsetenv("AE_SINK");
+#endif
+  }
+
+  void AddSource(unsigned int sampleRate, AEStdChLayout layout)
+  {
+    SSource source;
+    source.format.m_dataFormat = AE_FMT_FLOAT;
+    source.format.m_sampleRate = sampleRate;
+    source.format.m_channelLayout = layout;
+    source.format.m_frameSize = source.format.m_channelLayout.Count() * sizeof(float);
+    source.frames = 0;
+    source.phase = 0.0;
+    source.stream = CAEFactory::MakeStream(source.format);
+    ASSERT_TRUE(source.stream != NULL);
+    m_sources.push_back(source);
+  }
+
+  // feed every stream as much as it takes
+  void Feed()
+  {
+    for (std::vector<SSource>::iterator it = m_sources.begin(); it != m_sources.end(); ++it)
+    {
+      unsigned int frames = it->stream->GetSpace() / it->format.m_frameSize;
+      if (!frames)
+        continue;
+      Generate(*it, frames);
+      const uint8_t *planes[1] = { (const uint8_t*)it->data.data() };
+      double pts = 1000.0 * it->frames / it->format.m_sampleRate;
+      it->frames += it->stream->AddData(planes, 0, frames, pts);
+    }
+  }
+
+  std::vector<SSource> m_sources;
+  bool m_hadSink;
+  std::string m_sink;
+};
+
+class TestActiveAELowLatency : public TestActiveAEBenchmark
+{
+protected:
+  virtual void SetUp()
+  {
+    CSettings::GetInstance().SetBool(CSettings::SETTING_AUDIOOUTPUT_LOWLATENCY, true);
+    TestActiveAEBenchmark::SetUp();
+  }
+
+  virtual void TearDown()
+  {
+    TestActiveAEBenchmark::TearDown();
+    CSettings::GetInstance().SetBool(CSettings::SETTING_AUDIOOUTPUT_LOWLATENCY, false);
+  }
+};
+
+// runs in real time and only reports numbers, run with --gtest_also_run_disabled_tests
+TEST_F(TestActiveAEBenchmark, DISABLED_MixTwoStreams)
+{
+  // a music stream that needs resampling and a 5.1 stream that gets mixed in
+  AddSource(44100, AE_CH_LAYOUT_2_0);
+  AddSource(48000, AE_CH_LAYOUT_5_1);
+
+  CActiveAE *engine = dynamic_cast<CActiveAE*>(CAEFactory::GetEngine());
+  ASSERT_TRUE(engine != NULL);
+
+  // wait for buffering to finish before measuring
+  XbmcThreads::EndTime warmup(WARMUP_MS);
+  while (!warmup.IsTimePast())
+  {
+    Feed();
+    Sleep(5);
+  }
+
+  engine->GetStats()->ResetStageTimes();
+  int64_t usageStart = engine->GetEngineUsage();
+  unsigned int start = XbmcThreads::SystemClockMillis();
+
+  // the position derived from the reported delay must advance like the wall clock
+  const SSource &master = m_sources.front();
+  double offset = 0.0;
+  double maxError = 0.0;
+  double sumError = 0.0;
+  unsigned int samples = 0;
+
+  unsigned int elapsed = 0;
+  while (elapsed < BENCH_MS)
+  {
+    Feed();
+
+    elapsed = XbmcThreads::SystemClockMillis() - start;
+    double played = (double)master.frames / master.format.m_sampleRate - master.stream->GetDelay();
+    double error = played - elapsed / 1000.0;
+    if (samples == 0)
+      offset = error;
+    error = fabs(error - offset);
+    maxError = std::max(maxError, error);
+    sumError += error;
+    samples++;
+
+    Sleep(5);
+  }
+
+  double cpu = (engine->GetEngineUsage() - usageStart) / 10000000.0;
+  double stages[CEngineStats::STAGE_MAX];
+  int64_t frames;
+  engine->GetStats()->GetStageTimes(stages, frames);
+  AEAudioFormat sinkFormat = engine->GetCurrentSinkFormat();
+  double seconds = elapsed / 1000.0;
+
+  std::cout << "sink: " << sinkFormat.m_sampleRate << " Hz, " << sinkFormat.m_channelLayout.Count() << " channels" << std::endl
+            << "frames: " << frames << " (" << frames / seconds << " frames/s)" << std::endl
+            << "engine cpu: " << cpu * 1000.0 << " ms (" << 100.0 * cpu / seconds << "%)" << std::endl
+            << "resample: " << stages[CEngineStats::STAGE_RESAMPLE] * 1000.0 << " ms" << std::endl
+            << "mix: " << stages[CEngineStats::STAGE_MIX] * 1000.0 << " ms" << std::endl
+            << "encode: " << stages[CEngineStats::STAGE_ENCODE] * 1000.0 << " ms" << std::endl
+            << "sink: " << stages[CEngineStats::STAGE_SINK] * 1000.0 << " ms" << std::endl
+            << "delay error avg: " << sumError / samples * 1000.0 << " ms, max: " << maxError * 1000.0 << " ms" << std::endl;
+
+  EXPECT_GT(frames, 0);
+}
+
+// runs in real time, run with --gtest_also_run_disabled_tests
+TEST_F(TestActiveAELowLatency, DISABLED_Stable)
+{
+  AddSource(48000, AE_CH_LAYOUT_2_0);
+
+  CActiveAE *engine = dynamic_cast<CActiveAE*>(CAEFactory::GetEngine());
+  ASSERT_TRUE(engine != NULL);
+
+  XbmcThreads::EndTime warmup(WARMUP_MS);
+  while (!warmup.IsTimePast())
+  {
+    Feed();
+    Sleep(5);
+  }
+
+  engine->GetStats()->ResetStageTimes();
+  unsigned int start = XbmcThreads::SystemClockMillis();
+
+  // delay from adding a sample until it is heard, as used for a/v sync
+  const SSource &source = m_sources.front();
+  double maxDelay = 0.0;
+  double sumDelay = 0.0;
+  unsigned int samples = 0;
+
+  unsigned int elapsed = 0;
+  while (elapsed < BENCH_MS)
+  {
+    Feed();
+
+    double delay = source.stream->GetDelay();
+    maxDelay = std::max(maxDelay, delay);
+    sumDelay += delay;
+    samples++;
+
+    Sleep(5);
+    elapsed = XbmcThreads::SystemClockMillis() - start;
+  }
+
+  double stages[CEngineStats::STAGE_MAX];
+  int64_t frames;
+  engine->GetStats()->GetStageTimes(stages, frames);
+  unsigned int underruns = engine->GetStats()->GetUnderruns();
+  AEAudioFormat sinkFormat = engine->GetCurrentSinkFormat();
+
+  std::cout << "period: " << 1000 * sinkFormat.m_frames / sinkFormat.m_sampleRate << " ms" << std::endl
+            << "delay avg: " << sumDelay / samples * 1000.0 << " ms, max: " << maxDelay * 1000.0 << " ms" << std::endl
+            << "underruns: " << underruns << std::endl;
+
+  // stream cache, water level and device buffer are well below the default profile
+  EXPECT_LE(sinkFormat.m_frames, sinkFormat.m_sampleRate / 100);
+  EXPECT_LT(maxDelay, 0.25);
+  EXPECT_EQ(underruns, 0u);
+  EXPECT_GT(frames, (int64_t)(sinkFormat.m_sampleRate * elapsed / 1000 * 0.9));
+}
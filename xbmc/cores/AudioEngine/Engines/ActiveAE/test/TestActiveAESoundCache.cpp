@@ -0,0 +1,103 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/AudioEngine/Engines/ActiveAE/ActiveAEBuffer.h"
+#include "cores/AudioEngine/Engines/ActiveAE/ActiveAESoundCache.h"
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+using namespace ActiveAE;
+
+namespace
+{
+
+// stereo float, 8 bytes per frame
+const size_t FRAME_BYTES = 8;
+
+class CTestSound
+{
+public:
+  CTestSound(int frames) : m_buffer(frames * FRAME_BYTES + 64)
+  {
+    SampleConfig config;
+    config.fmt = AV_SAMPLE_FMT_FLT;
+    config.channel_layout = AV_CH_LAYOUT_STEREO;
+    config.channels = 2;
+    config.sample_rate = 48000;
+    config.bits_per_sample = 32;
+    config.dither_bits = 0;
+    m_sound.reset(new CSoundPacket(config, frames, m_buffer.data()));
+  }
+
+  std::shared_ptr<CSoundPacket> m_sound;
+
+private:
+  std::vector<uint8_t> m_buffer;
+};
+
+}
+
+TEST(TestActiveAESoundCache, Share)
+{
+  CActiveAESoundCache cache(0);
+  CTestSound sound(1000);
+  cache.Store("click", "", sound.m_sound);
+  cache.Store("click", "float 48000", sound.m_sound);
+
+  EXPECT_EQ(sound.m_sound, cache.Get("click", ""));
+  EXPECT_EQ(sound.m_sound, cache.Get("click", "float 48000"));
+  EXPECT_FALSE(cache.Get("click", "float 44100"));
+  EXPECT_FALSE(cache.Get("back", ""));
+  // sounds without a key are never cached
+  cache.Store("", "", sound.m_sound);
+  EXPECT_FALSE(cache.Get("", ""));
+}
+
+TEST(TestActiveAESoundCache, KeepUnused)
+{
+  // room for two unused sounds
+  CActiveAESoundCache cache(2000 * FRAME_BYTES);
+  {
+    CTestSound a(1000), b(1000), c(1000);
+    cache.Store("a", "", a.m_sound);
+    cache.Store("b", "", b.m_sound);
+    cache.Store("c", "", c.m_sound);
+    EXPECT_EQ(3000 * FRAME_BYTES, cache.GetSize());
+    EXPECT_EQ(0u, cache.GetUnusedSize());
+
+    // a was used last
+    EXPECT_TRUE(cache.Get("a", "") != nullptr);
+  }
+  EXPECT_EQ(3000 * FRAME_BYTES, cache.GetUnusedSize());
+
+  // the next store trims the least recently used until the rest fits
+  CTestSound d(500);
+  cache.Store("d", "", d.m_sound);
+  EXPECT_FALSE(cache.Get("b", ""));
+  EXPECT_TRUE(cache.Get("c", "") != nullptr);
+  EXPECT_TRUE(cache.Get("a", "") != nullptr);
+  EXPECT_TRUE(cache.Get("d", "") != nullptr);
+  EXPECT_EQ(2500 * FRAME_BYTES, cache.GetSize());
+
+  cache.Clear();
+  EXPECT_EQ(0u, cache.GetSize());
+}
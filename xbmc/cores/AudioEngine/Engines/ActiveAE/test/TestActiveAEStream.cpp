@@ -0,0 +1,69 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/AudioEngine/Engines/ActiveAE/ActiveAE.h"
+#include "cores/AudioEngine/Engines/ActiveAE/ActiveAEStream.h"
+
+#include "gtest/gtest.h"
+
+#include <thread>
+
+using namespace ActiveAE;
+
+TEST(TestActiveAEShadowParameter, Fetch)
+{
+  CShadowParameter<float> volume;
+  float value = 0.5f;
+  EXPECT_FALSE(volume.Fetch(value));
+  EXPECT_EQ(0.5f, value);
+
+  volume.Set(0.1f);
+  volume.Set(0.2f);
+  EXPECT_TRUE(volume.Fetch(value));
+  EXPECT_EQ(0.2f, value);
+  // taken once, the engine keeps its own copy afterwards
+  EXPECT_FALSE(volume.Fetch(value));
+}
+
+TEST(TestActiveAEShadowParameter, Concurrent)
+{
+  const int updates = 100000;
+  CShadowParameter<double> ratio;
+
+  std::thread owner([&]()
+  {
+    for (int i = 1; i <= updates; i++)
+      ratio.Set(i);
+  });
+
+  // the engine never sees a value older than one it has seen before
+  double last = 0.0;
+  double value;
+  while (last < updates)
+  {
+    if (ratio.Fetch(value))
+    {
+      ASSERT_GE(value, last);
+      last = value;
+    }
+  }
+  owner.join();
+  EXPECT_EQ(updates, last);
+}
@@ -515,6 +515,7 @@ bool CAESinkALSA::Initialize(AEAudioFormat &format, std::string &device)
   ALSAConfig inconfig, outconfig;
   inconfig.format = format.m_dataFormat;
   inconfig.sampleRate = format.m_sampleRate;
+  inconfig.periodSize = format.m_frames; // requested by the engine, 0 for default
 
   /*
    * We can't use the better GetChannelLayout() at this point as the device
@@ -759,6 +760,13 @@ bool CAESinkALSA::InitializeHW(const ALSAConfig &inconfig, ALSAConfig &outconfig
   */
   periodSize = std::min(periodSize, bufferSize / 4);
 
+  /* engine asks for low latency, keep 4 of its periods */
+  if (inconfig.periodSize > 0)
+  {
+    periodSize = std::min(periodSize, (snd_pcm_uframes_t) inconfig.periodSize);
+    bufferSize = std::min(bufferSize, periodSize * 4);
+  }
+
   CLog::Log(LOGDEBUG, "CAESinkALSA::InitializeHW - Request: periodSize %lu, bufferSize %lu", periodSize, bufferSize);
 
   snd_pcm_hw_params_t *hw_params_copy;
@@ -22,6 +22,7 @@
 
 #include <stdint.h>
 #include <limits.h>
+#include <algorithm>
 
 #include "AESinkNULL.h"
 #include "cores/AudioEngine/Utils/AEUtil.h"
@@ -43,15 +44,20 @@ CAESinkNULL::~CAESinkNULL()
 
 bool CAESinkNULL::Initialize(AEAudioFormat &format, std::string &device)
 {
-  // setup for a 250ms sink feed from SoftAE 
+  // setup for a 250ms sink feed from SoftAE, or the period the engine asked for
+  unsigned int requested = format.m_frames;
   format.m_dataFormat    = (format.m_dataFormat == AE_FMT_RAW) ? AE_FMT_S16NE : AE_FMT_FLOAT;
   format.m_frames        = format.m_sampleRate / 1000 * 250;
+  if (requested > 0 && requested < format.m_frames)
+    format.m_frames      = requested;
   format.m_frameSize     = format.m_channelLayout.Count() * (CAEUtil::DataFormatToBits(format.m_dataFormat) >> 3);
   m_format = format;
 
-  // setup a pretend 500ms internal buffer
+  // setup a pretend 500ms internal buffer, 4 periods for low latency
   m_sink_frameSize = format.m_channelLayout.Count() * CAEUtil::DataFormatToBits(format.m_dataFormat) >> 3;
   m_sinkbuffer_size = m_sink_frameSize * format.m_sampleRate / 2;
+  if (requested > 0)
+    m_sinkbuffer_size = std::min(m_sinkbuffer_size, m_sink_frameSize * format.m_frames * 4);
   m_sinkbuffer_sec_per_byte = 1.0 / (double)(m_sink_frameSize * format.m_sampleRate);
 
   m_draining = false;
@@ -111,6 +117,24 @@ void CAESinkNULL::EnumerateDevices (AEDeviceList &devices, bool passthrough)
   // we never return any devices
 }
 
+void CAESinkNULL::EnumerateDevicesEx(AEDeviceInfoList &list, bool force)
+{
+  // only listed if requested with AE_SINK=NULL, for running headless
+  CAEDeviceInfo info;
+  info.m_deviceName = "NULL";
+  info.m_displayName = "NULL";
+  info.m_displayNameExtra = "discards all audio";
+  info.m_deviceType = AE_DEVTYPE_PCM;
+  info.m_channels = AE_CH_LAYOUT_7_1;
+  info.m_dataFormats.push_back(AE_FMT_FLOAT);
+  info.m_sampleRates.push_back(44100);
+  info.m_sampleRates.push_back(48000);
+  info.m_sampleRates.push_back(96000);
+  info.m_sampleRates.push_back(192000);
+  info.m_wantsIECPassthrough = false;
+  list.push_back(info);
+}
+
 void CAESinkNULL::Process()
 {
   CLog::Log(LOGDEBUG, "CAESinkNULL::Process");
@@ -130,11 +154,12 @@ void CAESinkNULL::Process()
       m_draining = false;
     }
 
-    // pretend we have a 64k audio buffer
-    unsigned int min_buffer_size = 64 * 1024;
+    // pretend the hardware reads periods of 10ms, small enough to
+    // keep the reported delay accurate
+    unsigned int period_size = m_sink_frameSize * m_format.m_sampleRate / 100;
     unsigned int read_bytes = m_sinkbuffer_level;
-    if (read_bytes > min_buffer_size)
-      read_bytes = min_buffer_size;
+    if (read_bytes > period_size)
+      read_bytes = period_size;
 
     if (read_bytes > 0)
     {
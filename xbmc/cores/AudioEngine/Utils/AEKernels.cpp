@@ -0,0 +1,603 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "AEKernels.h"
+#include "utils/CPUInfo.h"
+#include "utils/log.h"
+
+#include <algorithm>
+#include <math.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP > 0)
+#define AE_KERNELS_SSE
+#include <xmmintrin.h>
+#endif
+
+// the integer kernels of the SSE set need SSE2
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AE_KERNELS_SSE2
+#include <emmintrin.h>
+#endif
+
+// the AVX2 kernels are compiled for AVX2 function by function, the rest of
+// the binary does not require it
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#if defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+#define AE_KERNELS_AVX2
+#define AE_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && _MSC_VER >= 1800
+#define AE_KERNELS_AVX2
+#define AE_TARGET_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON) || defined(__aarch64__)
+#define AE_KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace
+{
+
+/* same rational tanh approximation as CAEUtil::SoftClamp, it reaches
+   exactly +-1 at +-3 */
+const float CLAMP_LIMIT = 3.0f;
+const float CLAMP_C1 = 27.0f;
+const float CLAMP_C2 = 9.0f;
+
+inline float SoftClamp(float x)
+{
+  if (x < -CLAMP_LIMIT)
+    return -1.0f;
+  else if (x > CLAMP_LIMIT)
+    return 1.0f;
+  float y = x * x;
+  return x * (CLAMP_C1 + y) / (CLAMP_C1 + CLAMP_C2 * y);
+}
+
+inline uint32_t LowestBit(uint32_t mask)
+{
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return index;
+#else
+  return __builtin_ctz(mask);
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// C
+//-----------------------------------------------------------------------------
+
+void MulC(float *data, float mul, uint32_t count)
+{
+  for (uint32_t i = 0; i < count; i++)
+    data[i] *= mul;
+}
+
+float MulAddC(float *data, const float *add, float mul, uint32_t count)
+{
+  float peak = 0.0f;
+  for (uint32_t i = 0; i < count; i++)
+  {
+    data[i] += add[i] * mul;
+    peak = std::max(peak, fabsf(data[i]));
+  }
+  return peak;
+}
+
+void ClampC(float *data, uint32_t count)
+{
+  for (uint32_t i = 0; i < count; i++)
+    data[i] = SoftClamp(data[i]);
+}
+
+float PeakC(const float *data, uint32_t count)
+{
+  float peak = 0.0f;
+  for (uint32_t i = 0; i < count; i++)
+    peak = std::max(peak, fabsf(data[i]));
+  return peak;
+}
+
+void Swap16C(uint16_t *dst, const uint16_t *src, uint32_t count)
+{
+  for (uint32_t i = 0; i < count; i++)
+    dst[i] = (uint16_t)((src[i] >> 8) | (src[i] << 8));
+}
+
+uint32_t FindSyncC(const uint8_t *data, uint32_t count, const uint16_t *syncs, uint32_t numSyncs)
+{
+  // most bytes can not start a sync word, reject them with a bitmap lookup
+  uint32_t first[8] = { 0 };
+  for (uint32_t s = 0; s < numSyncs; s++)
+    first[syncs[s] >> 13] |= 1u << ((syncs[s] >> 8) & 31);
+
+  for (uint32_t i = 0; i < count; i++)
+  {
+    if (!(first[data[i] >> 5] & (1u << (data[i] & 31))))
+      continue;
+
+    uint16_t word = (data[i] << 8) | data[i + 1];
+    for (uint32_t s = 0; s < numSyncs; s++)
+    {
+      if (word == syncs[s])
+        return i;
+    }
+  }
+  return count;
+}
+
+//-----------------------------------------------------------------------------
+// SSE
+//-----------------------------------------------------------------------------
+
+#ifdef AE_KERNELS_SSE
+inline float HorizontalMax(__m128 v)
+{
+  v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+  v = _mm_max_ss(v, _mm_shuffle_ps(v, v, 1));
+  return _mm_cvtss_f32(v);
+}
+
+void MulSSE(float *data, float mul, uint32_t count)
+{
+  const __m128 m = _mm_set1_ps(mul);
+  uint32_t i = 0;
+  for (; i + 4 <= count; i += 4)
+    _mm_storeu_ps(data + i, _mm_mul_ps(_mm_loadu_ps(data + i), m));
+  MulC(data + i, mul, count - i);
+}
+
+float MulAddSSE(float *data, const float *add, float mul, uint32_t count)
+{
+  const __m128 m = _mm_set1_ps(mul);
+  const __m128 sign = _mm_set1_ps(-0.0f);
+  __m128 peak = _mm_setzero_ps();
+  uint32_t i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128 out = _mm_add_ps(_mm_loadu_ps(data + i), _mm_mul_ps(_mm_loadu_ps(add + i), m));
+    _mm_storeu_ps(data + i, out);
+    peak = _mm_max_ps(peak, _mm_andnot_ps(sign, out));
+  }
+  return std::max(HorizontalMax(peak), MulAddC(data + i, add + i, mul, count - i));
+}
+
+void ClampSSE(float *data, uint32_t count)
+{
+  const __m128 c1 = _mm_set1_ps(CLAMP_C1);
+  const __m128 c2 = _mm_set1_ps(CLAMP_C2);
+  const __m128 hi = _mm_set1_ps(CLAMP_LIMIT);
+  const __m128 lo = _mm_set1_ps(-CLAMP_LIMIT);
+  uint32_t i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128 x = _mm_max_ps(_mm_min_ps(_mm_loadu_ps(data + i), hi), lo);
+    __m128 y = _mm_mul_ps(x, x);
+    __m128 out = _mm_div_ps(_mm_mul_ps(x, _mm_add_ps(c1, y)), _mm_add_ps(c1, _mm_mul_ps(c2, y)));
+    _mm_storeu_ps(data + i, out);
+  }
+  ClampC(data + i, count - i);
+}
+
+float PeakSSE(const float *data, uint32_t count)
+{
+  const __m128 sign = _mm_set1_ps(-0.0f);
+  __m128 peak = _mm_setzero_ps();
+  uint32_t i = 0;
+  for (; i + 4 <= count; i += 4)
+    peak = _mm_max_ps(peak, _mm_andnot_ps(sign, _mm_loadu_ps(data + i)));
+  return std::max(HorizontalMax(peak), PeakC(data + i, count - i));
+}
+
+#ifdef AE_KERNELS_SSE2
+void Swap16SSE(uint16_t *dst, const uint16_t *src, uint32_t count)
+{
+  uint32_t i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+    _mm_storeu_si128((__m128i*)(dst + i), _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8)));
+  }
+  Swap16C(dst + i, src + i, count - i);
+}
+
+uint32_t FindSyncSSE(const uint8_t *data, uint32_t count, const uint16_t *syncs, uint32_t numSyncs)
+{
+  if (numSyncs > CAEKernels::MAX_SYNCS)
+    numSyncs = CAEKernels::MAX_SYNCS;
+
+  __m128i hi[CAEKernels::MAX_SYNCS];
+  __m128i lo[CAEKernels::MAX_SYNCS];
+  for (uint32_t s = 0; s < numSyncs; s++)
+  {
+    hi[s] = _mm_set1_epi8((char)(syncs[s] >> 8));
+    lo[s] = _mm_set1_epi8((char)(syncs[s] & 0xFF));
+  }
+
+  // compare 16 offsets at once, the second load reads one byte ahead
+  uint32_t i = 0;
+  for (; i + 16 <= count; i += 16)
+  {
+    __m128i a = _mm_loadu_si128((const __m128i*)(data + i));
+    __m128i b = _mm_loadu_si128((const __m128i*)(data + i + 1));
+    __m128i match = _mm_setzero_si128();
+    for (uint32_t s = 0; s < numSyncs; s++)
+      match = _mm_or_si128(match, _mm_and_si128(_mm_cmpeq_epi8(a, hi[s]), _mm_cmpeq_epi8(b, lo[s])));
+    uint32_t mask = _mm_movemask_epi8(match);
+    if (mask)
+      return i + LowestBit(mask);
+  }
+  return i + FindSyncC(data + i, count - i, syncs, numSyncs);
+}
+#else
+// SSE alone has no integer vectors
+void Swap16SSE(uint16_t *dst, const uint16_t *src, uint32_t count)
+{
+  Swap16C(dst, src, count);
+}
+
+uint32_t FindSyncSSE(const uint8_t *data, uint32_t count, const uint16_t *syncs, uint32_t numSyncs)
+{
+  return FindSyncC(data, count, syncs, numSyncs);
+}
+#endif
+#endif
+
+//-----------------------------------------------------------------------------
+// AVX2
+//-----------------------------------------------------------------------------
+
+#ifdef AE_KERNELS_AVX2
+AE_TARGET_AVX2 inline float HorizontalMax(__m256 v)
+{
+  __m128 m = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+  m = _mm_max_ss(m, _mm_shuffle_ps(m, m, 1));
+  return _mm_cvtss_f32(m);
+}
+
+AE_TARGET_AVX2 void MulAVX2(float *data, float mul, uint32_t count)
+{
+  const __m256 m = _mm256_set1_ps(mul);
+  uint32_t i = 0;
+  for (; i + 8 <= count; i += 8)
+    _mm256_storeu_ps(data + i, _mm256_mul_ps(_mm256_loadu_ps(data + i), m));
+  MulC(data + i, mul, count - i);
+}
+
+AE_TARGET_AVX2 float MulAddAVX2(float *data, const float *add, float mul, uint32_t count)
+{
+  const __m256 m = _mm256_set1_ps(mul);
+  const __m256 sign = _mm256_set1_ps(-0.0f);
+  __m256 peak = _mm256_setzero_ps();
+  uint32_t i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    __m256 out = _mm256_add_ps(_mm256_loadu_ps(data + i), _mm256_mul_ps(_mm256_loadu_ps(add + i), m));
+    _mm256_storeu_ps(data + i, out);
+    peak = _mm256_max_ps(peak, _mm256_andnot_ps(sign, out));
+  }
+  return std::max(HorizontalMax(peak), MulAddC(data + i, add + i, mul, count - i));
+}
+
+AE_TARGET_AVX2 void ClampAVX2(float *data, uint32_t count)
+{
+  const __m256 c1 = _mm256_set1_ps(CLAMP_C1);
+  const __m256 c2 = _mm256_set1_ps(CLAMP_C2);
+  const __m256 hi = _mm256_set1_ps(CLAMP_LIMIT);
+  const __m256 lo = _mm256_set1_ps(-CLAMP_LIMIT);
+  uint32_t i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    __m256 x = _mm256_max_ps(_mm256_min_ps(_mm256_loadu_ps(data + i), hi), lo);
+    __m256 y = _mm256_mul_ps(x, x);
+    __m256 out = _mm256_div_ps(_mm256_mul_ps(x, _mm256_add_ps(c1, y)), _mm256_add_ps(c1, _mm256_mul_ps(c2, y)));
+    _mm256_storeu_ps(data + i, out);
+  }
+  ClampC(data + i, count - i);
+}
+
+AE_TARGET_AVX2 float PeakAVX2(const float *data, uint32_t count)
+{
+  const __m256 sign = _mm256_set1_ps(-0.0f);
+  __m256 peak = _mm256_setzero_ps();
+  uint32_t i = 0;
+  for (; i + 8 <= count; i += 8)
+    peak = _mm256_max_ps(peak, _mm256_andnot_ps(sign, _mm256_loadu_ps(data + i)));
+  return std::max(HorizontalMax(peak), PeakC(data + i, count - i));
+}
+
+AE_TARGET_AVX2 void Swap16AVX2(uint16_t *dst, const uint16_t *src, uint32_t count)
+{
+  const __m256i order = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+                                         1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+  uint32_t i = 0;
+  for (; i + 16 <= count; i += 16)
+  {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(src + i));
+    _mm256_storeu_si256((__m256i*)(dst + i), _mm256_shuffle_epi8(v, order));
+  }
+  Swap16C(dst + i, src + i, count - i);
+}
+
+AE_TARGET_AVX2 uint32_t FindSyncAVX2(const uint8_t *data, uint32_t count, const uint16_t *syncs, uint32_t numSyncs)
+{
+  if (numSyncs > CAEKernels::MAX_SYNCS)
+    numSyncs = CAEKernels::MAX_SYNCS;
+
+  __m256i hi[CAEKernels::MAX_SYNCS];
+  __m256i lo[CAEKernels::MAX_SYNCS];
+  for (uint32_t s = 0; s < numSyncs; s++)
+  {
+    hi[s] = _mm256_set1_epi8((char)(syncs[s] >> 8));
+    lo[s] = _mm256_set1_epi8((char)(syncs[s] & 0xFF));
+  }
+
+  uint32_t i = 0;
+  for (; i + 32 <= count; i += 32)
+  {
+    __m256i a = _mm256_loadu_si256((const __m256i*)(data + i));
+    __m256i b = _mm256_loadu_si256((const __m256i*)(data + i + 1));
+    __m256i match = _mm256_setzero_si256();
+    for (uint32_t s = 0; s < numSyncs; s++)
+      match = _mm256_or_si256(match, _mm256_and_si256(_mm256_cmpeq_epi8(a, hi[s]), _mm256_cmpeq_epi8(b, lo[s])));
+    uint32_t mask = (uint32_t)_mm256_movemask_epi8(match);
+    if (mask)
+      return i + LowestBit(mask);
+  }
+  return i + FindSyncC(data + i, count - i, syncs, numSyncs);
+}
+#endif
+
+//-----------------------------------------------------------------------------
+// NEON
+//-----------------------------------------------------------------------------
+
+#ifdef AE_KERNELS_NEON
+inline float HorizontalMax(float32x4_t v)
+{
+#if defined(__aarch64__)
+  return vmaxvq_f32(v);
+#else
+  float32x2_t m = vpmax_f32(vget_low_f32(v), vget_high_f32(v));
+  m = vpmax_f32(m, m);
+  return vget_lane_f32(m, 0);
+#endif
+}
+
+void MulNEON(float *data, float mul, uint32_t count)
+{
+  uint32_t i = 0;
+  for (; i + 4 <= count; i += 4)
+    vst1q_f32(data + i, vmulq_n_f32(vld1q_f32(data + i), mul));
+  MulC(data + i, mul, count - i);
+}
+
+float MulAddNEON(float *data, const float *add, float mul, uint32_t count)
+{
+  float32x4_t peak = vdupq_n_f32(0.0f);
+  uint32_t i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    float32x4_t out = vmlaq_n_f32(vld1q_f32(data + i), vld1q_f32(add + i), mul);
+    vst1q_f32(data + i, out);
+    peak = vmaxq_f32(peak, vabsq_f32(out));
+  }
+  return std::max(HorizontalMax(peak), MulAddC(data + i, add + i, mul, count - i));
+}
+
+void ClampNEON(float *data, uint32_t count)
+{
+  const float32x4_t c1 = vdupq_n_f32(CLAMP_C1);
+  const float32x4_t hi = vdupq_n_f32(CLAMP_LIMIT);
+  const float32x4_t lo = vdupq_n_f32(-CLAMP_LIMIT);
+  uint32_t i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    float32x4_t x = vmaxq_f32(vminq_f32(vld1q_f32(data + i), hi), lo);
+    float32x4_t y = vmulq_f32(x, x);
+    float32x4_t num = vmulq_f32(x, vaddq_f32(c1, y));
+    float32x4_t den = vmlaq_n_f32(c1, y, CLAMP_C2);
+#if defined(__aarch64__)
+    float32x4_t out = vdivq_f32(num, den);
+#else
+    // no divide on armv7, refine the reciprocal estimate twice
+    float32x4_t rcp = vrecpeq_f32(den);
+    rcp = vmulq_f32(vrecpsq_f32(den, rcp), rcp);
+    rcp = vmulq_f32(vrecpsq_f32(den, rcp), rcp);
+    float32x4_t out = vmulq_f32(num, rcp);
+#endif
+    vst1q_f32(data + i, out);
+  }
+  ClampC(data + i, count - i);
+}
+
+float PeakNEON(const float *data, uint32_t count)
+{
+  float32x4_t peak = vdupq_n_f32(0.0f);
+  uint32_t i = 0;
+  for (; i + 4 <= count; i += 4)
+    peak = vmaxq_f32(peak, vabsq_f32(vld1q_f32(data + i)));
+  return std::max(HorizontalMax(peak), PeakC(data + i, count - i));
+}
+
+void Swap16NEON(uint16_t *dst, const uint16_t *src, uint32_t count)
+{
+  uint32_t i = 0;
+  for (; i + 8 <= count; i += 8)
+    vst1q_u8((uint8_t*)(dst + i), vrev16q_u8(vld1q_u8((const uint8_t*)(src + i))));
+  Swap16C(dst + i, src + i, count - i);
+}
+
+inline bool AnySet(uint8x16_t v)
+{
+#if defined(__aarch64__)
+  return vmaxvq_u8(v) != 0;
+#else
+  uint32x2_t m = vreinterpret_u32_u8(vorr_u8(vget_low_u8(v), vget_high_u8(v)));
+  return (vget_lane_u32(m, 0) | vget_lane_u32(m, 1)) != 0;
+#endif
+}
+
+uint32_t FindSyncNEON(const uint8_t *data, uint32_t count, const uint16_t *syncs, uint32_t numSyncs)
+{
+  if (numSyncs > CAEKernels::MAX_SYNCS)
+    numSyncs = CAEKernels::MAX_SYNCS;
+
+  uint8x16_t hi[CAEKernels::MAX_SYNCS];
+  uint8x16_t lo[CAEKernels::MAX_SYNCS];
+  for (uint32_t s = 0; s < numSyncs; s++)
+  {
+    hi[s] = vdupq_n_u8(syncs[s] >> 8);
+    lo[s] = vdupq_n_u8(syncs[s] & 0xFF);
+  }
+
+  // there is no movemask, locate the match within the block in C
+  uint32_t i = 0;
+  for (; i + 16 <= count; i += 16)
+  {
+    uint8x16_t a = vld1q_u8(data + i);
+    uint8x16_t b = vld1q_u8(data + i + 1);
+    uint8x16_t match = vdupq_n_u8(0);
+    for (uint32_t s = 0; s < numSyncs; s++)
+      match = vorrq_u8(match, vandq_u8(vceqq_u8(a, hi[s]), vceqq_u8(b, lo[s])));
+    if (AnySet(match))
+      return i + FindSyncC(data + i, 16, syncs, numSyncs);
+  }
+  return i + FindSyncC(data + i, count - i, syncs, numSyncs);
+}
+#endif
+
+CAEKernels::EKernelSet Detect()
+{
+  CAEKernels::EKernelSet set = CAEKernels::KERNELS_C;
+  if (CAEKernels::IsSupported(CAEKernels::KERNELS_AVX2))
+    set = CAEKernels::KERNELS_AVX2;
+  else if (CAEKernels::IsSupported(CAEKernels::KERNELS_NEON))
+    set = CAEKernels::KERNELS_NEON;
+  else if (CAEKernels::IsSupported(CAEKernels::KERNELS_SSE))
+    set = CAEKernels::KERNELS_SSE;
+
+  CLog::Log(LOGNOTICE, "CAEKernels - using %s kernels", CAEKernels::GetName(set));
+  return set;
+}
+
+}
+
+CAEKernels::SKernels CAEKernels::Create(EKernelSet set)
+{
+  SKernels kernels = { KERNELS_C, MulC, MulAddC, ClampC, PeakC, Swap16C, FindSyncC };
+  switch (set)
+  {
+#ifdef AE_KERNELS_SSE
+    case KERNELS_SSE:
+    {
+      SKernels sse = { KERNELS_SSE, MulSSE, MulAddSSE, ClampSSE, PeakSSE, Swap16SSE, FindSyncSSE };
+      kernels = sse;
+      break;
+    }
+#endif
+#ifdef AE_KERNELS_AVX2
+    case KERNELS_AVX2:
+    {
+      SKernels avx2 = { KERNELS_AVX2, MulAVX2, MulAddAVX2, ClampAVX2, PeakAVX2, Swap16AVX2, FindSyncAVX2 };
+      kernels = avx2;
+      break;
+    }
+#endif
+#ifdef AE_KERNELS_NEON
+    case KERNELS_NEON:
+    {
+      SKernels neon = { KERNELS_NEON, MulNEON, MulAddNEON, ClampNEON, PeakNEON, Swap16NEON, FindSyncNEON };
+      kernels = neon;
+      break;
+    }
+#endif
+    default:
+      break;
+  }
+  return kernels;
+}
+
+CAEKernels::SKernels& CAEKernels::Get()
+{
+  static SKernels kernels = Create(Detect());
+  return kernels;
+}
+
+bool CAEKernels::IsSupported(EKernelSet set)
+{
+  switch (set)
+  {
+    case KERNELS_C:
+      return true;
+#ifdef AE_KERNELS_SSE
+    case KERNELS_SSE:
+      // the compiler already relies on it
+      return true;
+#endif
+#ifdef AE_KERNELS_AVX2
+    case KERNELS_AVX2:
+      // CCPUInfo only reports AVX and AVX2 if the OS saves the ymm registers
+      return (g_cpuInfo.GetCPUFeatures() & (CPU_FEATURE_AVX | CPU_FEATURE_AVX2)) == (CPU_FEATURE_AVX | CPU_FEATURE_AVX2);
+#endif
+#ifdef AE_KERNELS_NEON
+    case KERNELS_NEON:
+#if defined(__aarch64__)
+      return true;
+#else
+      return (g_cpuInfo.GetCPUFeatures() & CPU_FEATURE_NEON) != 0;
+#endif
+#endif
+    default:
+      return false;
+  }
+}
+
+bool CAEKernels::Select(EKernelSet set)
+{
+  if (!IsSupported(set))
+    return false;
+
+  Get() = Create(set);
+  CLog::Log(LOGDEBUG, "CAEKernels::%s - using %s kernels", __FUNCTION__, GetName(set));
+  return true;
+}
+
+const char* CAEKernels::GetName(EKernelSet set)
+{
+  switch (set)
+  {
+    case KERNELS_C:    return "C";
+    case KERNELS_SSE:  return "SSE";
+    case KERNELS_AVX2: return "AVX2";
+    case KERNELS_NEON: return "NEON";
+    default:           return "unknown";
+  }
+}
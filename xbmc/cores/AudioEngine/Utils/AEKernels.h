@@ -0,0 +1,113 @@
+#pragma once
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdint.h>
+
+/*!
+ * \brief Float sample and bitstream kernels of the audio engine.
+ *
+ * Every kernel exists as plain C and, depending on the target, as SSE, AVX2
+ * or NEON version. The fastest set supported by the cpu is picked the first
+ * time a kernel is used, based on CCPUInfo. None of the kernels require
+ * aligned buffers.
+ */
+class CAEKernels
+{
+public:
+  enum EKernelSet
+  {
+    KERNELS_C = 0,
+    KERNELS_SSE,
+    KERNELS_AVX2,
+    KERNELS_NEON,
+    KERNELS_MAX
+  };
+
+  /*!
+   * \brief data[i] *= mul
+   */
+  static void Mul(float *data, float mul, uint32_t count) { Get().mul(data, mul, count); }
+
+  /*!
+   * \brief data[i] += add[i] * mul
+   * \return the highest absolute value of the result, to decide on clamping
+   */
+  static float MulAdd(float *data, const float *add, float mul, uint32_t count) { return Get().muladd(data, add, mul, count); }
+
+  /*!
+   * \brief Soft clamp of all samples to [-1, 1], see CAEUtil::SoftClamp
+   */
+  static void Clamp(float *data, uint32_t count) { Get().clamp(data, count); }
+
+  /*!
+   * \brief Highest absolute value of count samples
+   */
+  static float Peak(const float *data, uint32_t count) { return Get().peak(data, count); }
+
+  /*!
+   * \brief Swaps the bytes of count 16 bit words, dst may be equal to src
+   */
+  static void Swap16(uint16_t *dst, const uint16_t *src, uint32_t count) { Get().swap16(dst, src, count); }
+
+  /*!
+   * \brief Finds the first offset at which a sync word starts
+   * \param data bitstream, count + 1 bytes are read
+   * \param count number of offsets to search
+   * \param syncs big endian 16 bit sync words, at most MAX_SYNCS
+   * \return offset of the first match or count if none was found
+   */
+  static uint32_t FindSync(const uint8_t *data, uint32_t count, const uint16_t *syncs, uint32_t numSyncs)
+  {
+    return Get().findsync(data, count, syncs, numSyncs);
+  }
+
+  static const uint32_t MAX_SYNCS = 8;
+
+  /*!
+   * \brief Whether the kernel set is compiled in and supported by the cpu
+   */
+  static bool IsSupported(EKernelSet set);
+
+  /*!
+   * \brief Use the given kernel set, for tests and benchmarks only.
+   * Must not be called while audio is processed.
+   * \return false if the set is not supported, the selection is unchanged
+   */
+  static bool Select(EKernelSet set);
+
+  static EKernelSet GetSelected() { return Get().set; }
+  static const char* GetName(EKernelSet set);
+
+private:
+  struct SKernels
+  {
+    EKernelSet set;
+    void  (*mul)   (float *data, float mul, uint32_t count);
+    float (*muladd)(float *data, const float *add, float mul, uint32_t count);
+    void  (*clamp) (float *data, uint32_t count);
+    float (*peak)  (const float *data, uint32_t count);
+    void  (*swap16)(uint16_t *dst, const uint16_t *src, uint32_t count);
+    uint32_t (*findsync)(const uint8_t *data, uint32_t count, const uint16_t *syncs, uint32_t numSyncs);
+  };
+
+  static SKernels& Get();
+  static SKernels Create(EKernelSet set);
+};
@@ -20,6 +20,7 @@
 
 #include "system.h"
 #include "AELimiter.h"
+#include "AEKernels.h"
 #include "settings/AdvancedSettings.h"
 #include "utils/MathUtils.h"
 #include <algorithm>
@@ -39,10 +40,7 @@ float CAELimiter::Run(float* frame[AE_CH_MAX], int channels, int offset /*= 0*/,
   float highest = 0.0f;
   if (!planar)
   {
-    for(int i=0; i<channels; i++)
-    {
-      highest = std::max(highest, fabsf(*(frame[0]+offset+i)));
-    }
+    highest = CAEKernels::Peak(frame[0]+offset, channels);
   }
   else
   {
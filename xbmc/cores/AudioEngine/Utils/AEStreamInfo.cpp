@@ -19,6 +19,8 @@
  */
 
 #include "AEStreamInfo.h"
+#include "AEKernels.h"
+#include "Util.h"
 #include "utils/log.h"
 #include <algorithm>
 #include <string.h>
@@ -30,6 +32,8 @@
 #define DTS_PREAMBLE_HD    0x64582025
 #define DTS_SFREQ_COUNT    16
 #define MAX_EAC3_BLOCKS    6
+#define AC3_SYNC           0x0B77
+#define TRUEHD_SYNC        0xF872
 
 static const uint16_t AC3Bitrates   [] = {32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, 448, 512, 576, 640};
 static const uint16_t AC3FSCod      [] = {48000, 44100, 32000, 0};
@@ -38,6 +42,12 @@ static const uint8_t  AC3Channels   [] = {2, 1, 2, 3, 3, 4, 4, 5};
 static const uint8_t  DTSChannels   [] = {1, 2, 2, 2, 2, 3, 3, 4, 4, 5, 6, 6, 6, 7, 8, 8};
 static const uint8_t  THDChanMap    [] = {2, 1, 1, 2, 2, 2, 2, 1, 1, 2, 2, 1, 1};
 
+/* leading 16 bits of the sync words, used to skip ahead to the next candidate */
+static const uint16_t AC3Syncs      [] = {AC3_SYNC};
+static const uint16_t DTSSyncs      [] = {DTS_PREAMBLE_14BE >> 16, DTS_PREAMBLE_14LE >> 16, DTS_PREAMBLE_16BE >> 16, DTS_PREAMBLE_16LE >> 16};
+static const uint16_t TrueHDSyncs   [] = {TRUEHD_SYNC};
+static const uint16_t DetectSyncs   [] = {DTS_PREAMBLE_14BE >> 16, DTS_PREAMBLE_14LE >> 16, DTS_PREAMBLE_16BE >> 16, DTS_PREAMBLE_16LE >> 16, AC3_SYNC, TRUEHD_SYNC};
+
 static const uint32_t DTSSampleRates[DTS_SFREQ_COUNT] =
 {
   0     ,
@@ -291,6 +301,18 @@ unsigned int CAEStreamParser::DetectType(uint8_t *data, unsigned int size)
 
   while (size > 8)
   {
+    /* jump close to the next sync word, the TrueHD one sits 4 bytes in */
+    unsigned int next = CAEKernels::FindSync(data, size - 1, DetectSyncs, ARRAY_SIZE(DetectSyncs));
+    if (next > 4)
+    {
+      unsigned int jump = std::min(next - 4, size - 8);
+      size    -= jump;
+      skipped += jump;
+      data    += jump;
+      if (size <= 8)
+        break;
+    }
+
     /* if it could be DTS */
     unsigned int header = data[0] << 24 | data[1] << 16 | data[2] << 8 | data[3];
     if (header == DTS_PREAMBLE_14LE ||
@@ -347,8 +369,11 @@ unsigned int CAEStreamParser::SyncAC3(uint8_t *data, unsigned int size)
   for (; size - skip > 7; ++skip, ++data)
   {
     /* search for an ac3 sync word */
-    if (data[0] != 0x0b || data[1] != 0x77)
-      continue;
+    unsigned int next = CAEKernels::FindSync(data, size - skip - 7, AC3Syncs, ARRAY_SIZE(AC3Syncs));
+    skip += next;
+    data += next;
+    if (size - skip <= 7)
+      break;
 
     uint8_t bsid  = data[5] >> 3;
     uint8_t acmod = data[6] >> 5;
@@ -496,6 +521,12 @@ unsigned int CAEStreamParser::SyncDTS(uint8_t *data, unsigned int size)
   unsigned int skip = 0;
   for (; size - skip > 13; ++skip, ++data)
   {
+    unsigned int next = CAEKernels::FindSync(data, size - skip - 13, DTSSyncs, ARRAY_SIZE(DTSSyncs));
+    skip += next;
+    data += next;
+    if (size - skip <= 13)
+      break;
+
     unsigned int header = data[0] << 24 | data[1] << 16 | data[2] << 8 | data[3];
     unsigned int hd_sync = 0;
     bool match = true;
@@ -690,6 +721,15 @@ unsigned int CAEStreamParser::SyncTrueHD(uint8_t *data, unsigned int size)
   /* if MLP */
   for (; left; ++skip, ++data, --left)
   {
+    /* without sync only a major audio unit will do, jump to the next one */
+    if (!m_hasSync && left >= 8)
+    {
+      unsigned int next = CAEKernels::FindSync(data + 4, left - 7, TrueHDSyncs, ARRAY_SIZE(TrueHDSyncs));
+      skip += next;
+      data += next;
+      left -= next;
+    }
+
     /* if we dont have sync and there is less the 8 bytes, then break out */
     if (!m_hasSync && left < 8)
       return size;
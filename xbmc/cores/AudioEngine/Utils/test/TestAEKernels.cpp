@@ -0,0 +1,257 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/AudioEngine/Utils/AEKernels.h"
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+
+// one period of 7.1 at 192 kHz as the engine mixes it, odd so every
+// kernel also runs its tail
+const uint32_t CHANNELS = 8;
+const uint32_t RATE = 192000;
+const uint32_t PERIOD = RATE / 100 * CHANNELS + 3;
+
+// one IEC 61937 burst of TrueHD, the largest the passthrough path handles
+const uint32_t BURST = 61440 + 3;
+const uint16_t SYNCS[] = { 0x7FFE, 0xFE7F, 0x1FFF, 0xFF1F, 0x0B77, 0xF872 };
+const uint32_t NUM_SYNCS = sizeof(SYNCS) / sizeof(SYNCS[0]);
+
+std::vector<float> Noise(uint32_t count, uint32_t seed)
+{
+  // deterministic, in [-1.5, 1.5] so clamping has work to do
+  std::vector<float> noise(count);
+  for (uint32_t i = 0; i < count; i++)
+  {
+    seed = seed * 1664525 + 1013904223;
+    noise[i] = (float)(seed >> 8) / (float)(1 << 24) * 3.0f - 1.5f;
+  }
+  return noise;
+}
+
+std::vector<uint8_t> Bytes(uint32_t count, uint32_t seed)
+{
+  std::vector<uint8_t> bytes(count);
+  for (uint32_t i = 0; i < count; i++)
+  {
+    seed = seed * 1664525 + 1013904223;
+    bytes[i] = (uint8_t)(seed >> 24);
+  }
+  return bytes;
+}
+
+class CKernelSelection
+{
+public:
+  CKernelSelection() : m_previous(CAEKernels::GetSelected()) {}
+  ~CKernelSelection() { CAEKernels::Select(m_previous); }
+
+private:
+  CAEKernels::EKernelSet m_previous;
+};
+
+struct SResult
+{
+  std::vector<float> mul;
+  std::vector<float> muladd;
+  std::vector<float> clamp;
+  float muladdPeak;
+  float peak;
+  std::vector<uint16_t> swap16;
+  std::vector<uint32_t> syncs;
+};
+
+SResult RunKernels(CAEKernels::EKernelSet set)
+{
+  CAEKernels::Select(set);
+
+  std::vector<float> in = Noise(PERIOD + 1, 1);
+  std::vector<float> add = Noise(PERIOD + 1, 2);
+  SResult result;
+
+  // start at an odd offset, kernels must not rely on alignment
+  result.mul.assign(in.begin() + 1, in.end());
+  CAEKernels::Mul(result.mul.data(), 0.7f, PERIOD);
+
+  result.muladd.assign(in.begin() + 1, in.end());
+  result.muladdPeak = CAEKernels::MulAdd(result.muladd.data(), add.data() + 1, 0.5f, PERIOD);
+
+  result.clamp.assign(in.begin() + 1, in.end());
+  for (uint32_t i = 0; i < PERIOD; i++)
+    result.clamp[i] *= 3.0f;
+  CAEKernels::Clamp(result.clamp.data(), PERIOD);
+
+  result.peak = CAEKernels::Peak(in.data() + 1, PERIOD);
+
+  std::vector<uint8_t> bytes = Bytes(BURST * 2 + 1, 3);
+  std::vector<uint16_t> words(BURST + 1);
+  memcpy(words.data(), bytes.data(), BURST * 2);
+  result.swap16.resize(BURST);
+  CAEKernels::Swap16(result.swap16.data(), words.data() + 1, BURST);
+  CAEKernels::Swap16(words.data(), words.data(), BURST);
+  result.swap16.insert(result.swap16.end(), words.begin(), words.begin() + BURST);
+
+  // plant a sync word at the very start and end besides the ones in the noise
+  bytes[0] = 0x0B; bytes[1] = 0x77;
+  bytes[BURST * 2 - 1] = 0xF8; bytes[BURST * 2] = 0x72;
+  uint32_t found = 0;
+  for (uint32_t i = 0; found < BURST * 2; i = found + 1)
+  {
+    found = i + CAEKernels::FindSync(bytes.data() + i, BURST * 2 - i, SYNCS, NUM_SYNCS);
+    result.syncs.push_back(found);
+  }
+  return result;
+}
+
+template<typename F>
+double PerSecond(F kernel, uint32_t count = PERIOD)
+{
+  const int iterations = 100;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++)
+    kernel();
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return (double)count * iterations / elapsed.count();
+}
+
+}
+
+TEST(TestAEKernels, MatchC)
+{
+  CKernelSelection selection;
+  SResult reference = RunKernels(CAEKernels::KERNELS_C);
+
+  for (int set = CAEKernels::KERNELS_C + 1; set < CAEKernels::KERNELS_MAX; set++)
+  {
+    if (!CAEKernels::IsSupported((CAEKernels::EKernelSet)set))
+      continue;
+
+    SCOPED_TRACE(CAEKernels::GetName((CAEKernels::EKernelSet)set));
+    SResult result = RunKernels((CAEKernels::EKernelSet)set);
+
+    for (uint32_t i = 0; i < PERIOD; i++)
+    {
+      ASSERT_FLOAT_EQ(reference.mul[i], result.mul[i]);
+      ASSERT_FLOAT_EQ(reference.muladd[i], result.muladd[i]);
+      // reciprocal estimate on armv7 is not exact
+      ASSERT_NEAR(reference.clamp[i], result.clamp[i], 1e-5f);
+      ASSERT_LE(fabsf(result.clamp[i]), 1.0f + 1e-6f);
+    }
+    EXPECT_FLOAT_EQ(reference.muladdPeak, result.muladdPeak);
+    EXPECT_FLOAT_EQ(reference.peak, result.peak);
+    EXPECT_EQ(reference.swap16, result.swap16);
+    EXPECT_EQ(reference.syncs, result.syncs);
+  }
+}
+
+TEST(TestAEKernels, FindSync)
+{
+  CKernelSelection selection;
+  SResult reference = RunKernels(CAEKernels::KERNELS_C);
+
+  ASSERT_GE(reference.syncs.size(), 3u);
+  EXPECT_EQ(0u, reference.syncs.front());
+  EXPECT_EQ(BURST * 2, reference.syncs.back());
+  EXPECT_EQ(BURST * 2 - 1, reference.syncs[reference.syncs.size() - 2]);
+
+  // a sync word must start within count, its second byte may be past it
+  const uint8_t stream[] = { 0x00, 0x7F, 0x7F, 0xFE, 0x80 };
+  EXPECT_EQ(2u, CAEKernels::FindSync(stream, 4, SYNCS, NUM_SYNCS));
+  EXPECT_EQ(2u, CAEKernels::FindSync(stream, 3, SYNCS, NUM_SYNCS));
+  EXPECT_EQ(2u, CAEKernels::FindSync(stream, 2, SYNCS, NUM_SYNCS));
+  EXPECT_EQ(0u, CAEKernels::FindSync(stream, 0, SYNCS, NUM_SYNCS));
+}
+
+// prints throughput only, run with --gtest_also_run_disabled_tests
+TEST(TestAEKernels, DISABLED_Benchmark)
+{
+  CKernelSelection selection;
+  std::vector<float> data = Noise(PERIOD, 1);
+  std::vector<float> add = Noise(PERIOD, 2);
+
+  std::cout << "samples/s for 7.1 at " << RATE << " Hz, " << PERIOD << " samples per call" << std::endl;
+  for (int set = CAEKernels::KERNELS_C; set < CAEKernels::KERNELS_MAX; set++)
+  {
+    if (!CAEKernels::Select((CAEKernels::EKernelSet)set))
+      continue;
+
+    // gains close to one keep the data from running off to inf or zero
+    double mul = PerSecond([&]() { CAEKernels::Mul(data.data(), 0.9999f, PERIOD); });
+    double muladd = PerSecond([&]() { CAEKernels::MulAdd(data.data(), add.data(), 1e-6f, PERIOD); });
+    double clamp = PerSecond([&]() { CAEKernels::Clamp(data.data(), PERIOD); });
+    double peak = PerSecond([&]() { CAEKernels::Peak(data.data(), PERIOD); });
+
+    std::cout << std::left << std::setw(6) << CAEKernels::GetName((CAEKernels::EKernelSet)set)
+              << std::fixed << std::setprecision(1)
+              << " mul: " << mul / 1e6 << "M"
+              << " muladd: " << muladd / 1e6 << "M"
+              << " clamp: " << clamp / 1e6 << "M"
+              << " peak: " << peak / 1e6 << "M" << std::endl;
+    EXPECT_GT(mul, 0.0);
+  }
+}
+
+// prints throughput only, run with --gtest_also_run_disabled_tests
+TEST(TestAEKernels, DISABLED_BenchmarkBitstream)
+{
+  CKernelSelection selection;
+  std::vector<uint8_t> bytes = Bytes(BURST * 2 + 1, 3);
+  std::vector<uint16_t> words(BURST);
+
+  // the worst case for sync search, no sync word at all
+  const uint16_t sync = SYNCS[0];
+  for (uint32_t i = 0; i + 1 < bytes.size(); i++)
+  {
+    for (uint32_t s = 0; s < NUM_SYNCS; s++)
+    {
+      if (bytes[i] == SYNCS[s] >> 8 && bytes[i + 1] == (SYNCS[s] & 0xFF))
+        bytes[i + 1] = 0;
+    }
+  }
+
+  std::cout << "bytes/s for a " << BURST * 2 << " byte burst" << std::endl;
+  for (int set = CAEKernels::KERNELS_C; set < CAEKernels::KERNELS_MAX; set++)
+  {
+    if (!CAEKernels::Select((CAEKernels::EKernelSet)set))
+      continue;
+
+    uint32_t found = 0;
+    double swap = PerSecond([&]() { CAEKernels::Swap16(words.data(), (const uint16_t*)bytes.data(), BURST); }, BURST * 2);
+    double search = PerSecond([&]() { found = CAEKernels::FindSync(bytes.data(), BURST * 2, &sync, 1); }, BURST * 2);
+    double searchAll = PerSecond([&]() { CAEKernels::FindSync(bytes.data(), BURST * 2, SYNCS, NUM_SYNCS); }, BURST * 2);
+
+    std::cout << std::left << std::setw(6) << CAEKernels::GetName((CAEKernels::EKernelSet)set)
+              << std::fixed << std::setprecision(1)
+              << " swap16: " << swap / 1e6 << "M"
+              << " findsync: " << search / 1e6 << "M"
+              << " findsync x" << NUM_SYNCS << ": " << searchAll / 1e6 << "M" << std::endl;
+    EXPECT_EQ(BURST * 2, found);
+    EXPECT_EQ(BURST * 2, CAEKernels::FindSync(bytes.data(), BURST * 2, SYNCS, NUM_SYNCS));
+  }
+}
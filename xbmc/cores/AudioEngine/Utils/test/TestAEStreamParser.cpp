@@ -0,0 +1,143 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "cores/AudioEngine/Utils/AEKernels.h"
+#include "cores/AudioEngine/Utils/AEStreamInfo.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+
+// DTS core, 16 bit big endian, 512 samples at 48 kHz in 1024 byte frames
+const unsigned int FRAME_SIZE = 1024;
+const uint8_t DTS_HEADER[] = { 0x7F, 0xFE, 0x80, 0x01, 0xFC, 0x3C, 0x3F, 0xF2, 0x74, 0x00, 0x00 };
+
+void Noise(std::vector<uint8_t> &data, size_t offset, size_t count, uint32_t &seed)
+{
+  for (size_t i = offset; i < offset + count; i++)
+  {
+    seed = seed * 1664525 + 1013904223;
+    data[i] = (uint8_t)(seed >> 24);
+  }
+}
+
+std::vector<uint8_t> Bitstream(unsigned int junk, unsigned int frames)
+{
+  std::vector<uint8_t> data(junk + frames * FRAME_SIZE);
+  uint32_t seed = 1;
+  Noise(data, 0, data.size(), seed);
+  for (unsigned int i = 0; i < frames; i++)
+    std::copy(DTS_HEADER, DTS_HEADER + sizeof(DTS_HEADER), data.begin() + junk + i * FRAME_SIZE);
+  return data;
+}
+
+// feeds the stream one demuxer packet at a time like the passthrough codec
+unsigned int Parse(CAEStreamParser &parser, std::vector<uint8_t> &data)
+{
+  // the parser (re)allocates the packet buffer, it belongs to the caller
+  uint8_t *buffer = NULL;
+  unsigned int allocated = 0;
+  unsigned int packets = 0;
+  size_t pos = 0;
+  while (pos < data.size())
+  {
+    unsigned int size = std::min((size_t)FRAME_SIZE, data.size() - pos);
+    unsigned int bufferSize = allocated;
+    pos += parser.AddData(data.data() + pos, size, &buffer, &bufferSize);
+    allocated = std::max(allocated, bufferSize);
+    if (bufferSize == FRAME_SIZE)
+      packets++;
+  }
+  delete[] buffer;
+  return packets;
+}
+
+class CKernelSelection
+{
+public:
+  CKernelSelection() : m_previous(CAEKernels::GetSelected()) {}
+  ~CKernelSelection() { CAEKernels::Select(m_previous); }
+
+private:
+  CAEKernels::EKernelSet m_previous;
+};
+
+}
+
+TEST(TestAEStreamParser, SyncDTS)
+{
+  CKernelSelection selection;
+  std::vector<uint8_t> data = Bitstream(FRAME_SIZE * 3 + 5, 100);
+
+  for (int set = CAEKernels::KERNELS_C; set < CAEKernels::KERNELS_MAX; set++)
+  {
+    if (!CAEKernels::Select((CAEKernels::EKernelSet)set))
+      continue;
+
+    SCOPED_TRACE(CAEKernels::GetName((CAEKernels::EKernelSet)set));
+    CAEStreamParser parser;
+    unsigned int packets = Parse(parser, data);
+
+    EXPECT_TRUE(parser.IsValid());
+    EXPECT_EQ(CAEStreamInfo::STREAM_TYPE_DTS_512, parser.GetDataType());
+    EXPECT_EQ(48000u, parser.GetSampleRate());
+    EXPECT_EQ(100u, packets);
+  }
+}
+
+// prints throughput only, run with --gtest_also_run_disabled_tests
+TEST(TestAEStreamParser, DISABLED_Benchmark)
+{
+  CKernelSelection selection;
+  std::vector<uint8_t> junk = Bitstream(4 << 20, 0);
+  std::vector<uint8_t> dts = Bitstream(0, 4096);
+
+  std::cout << "bytes/s parsed, junk without sync and a DTS stream" << std::endl;
+  for (int set = CAEKernels::KERNELS_C; set < CAEKernels::KERNELS_MAX; set++)
+  {
+    if (!CAEKernels::Select((CAEKernels::EKernelSet)set))
+      continue;
+
+    double rate[2];
+    std::vector<uint8_t> *streams[2] = { &junk, &dts };
+    for (int i = 0; i < 2; i++)
+    {
+      CAEStreamParser parser;
+      auto start = std::chrono::steady_clock::now();
+      Parse(parser, *streams[i]);
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      rate[i] = streams[i]->size() / elapsed.count();
+    }
+
+    std::cout << std::left << std::setw(6) << CAEKernels::GetName((CAEKernels::EKernelSet)set)
+              << std::fixed << std::setprecision(1)
+              << " junk: " << rate[0] / 1e6 << "M"
+              << " dts: " << rate[1] / 1e6 << "M" << std::endl;
+    EXPECT_GT(rate[0], 0.0);
+  }
+}
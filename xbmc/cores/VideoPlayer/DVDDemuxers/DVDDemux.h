@@ -301,6 +301,11 @@ public:
    */
   virtual int GetStreamLength() = 0;
 
+  /*
+   * returns the number of input bytes consumed per second of playback, 0 if unknown
+   */
+  virtual unsigned int GetReadRate() { return 0; }
+
   /*
    * returns the stream or NULL on error
    */
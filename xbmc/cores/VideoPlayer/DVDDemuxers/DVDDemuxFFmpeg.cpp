@@ -27,6 +27,8 @@
 #include "cores/FFmpeg.h"
 #include "DVDClock.h" // for DVD_TIME_BASE
 #include "DVDDemuxUtils.h"
+#include "DVDDemuxProbeCache.h"
+#include "DemuxPacketPool.h"
 #include "DVDInputStreams/DVDInputStream.h"
 #include "DVDInputStreams/DVDInputStreamFFmpeg.h"
 #include "filesystem/CurlFile.h"
@@ -161,6 +163,9 @@ CDVDDemuxFFmpeg::CDVDDemuxFFmpeg() : CDVDDemux()
   m_pInput = NULL;
   m_ioContext = NULL;
   m_currentPts = DVD_NOPTS_VALUE;
+  m_rateDts = DVD_NOPTS_VALUE;
+  m_ratePos = 0;
+  m_readRate = 0;
   m_bMatroska = false;
   m_bAVI = false;
   m_speed = DVD_PLAYSPEED_NORMAL;
@@ -169,6 +174,7 @@ CDVDDemuxFFmpeg::CDVDDemuxFFmpeg() : CDVDDemux()
   memset(&m_pkt.pkt, 0, sizeof(AVPacket));
   m_streaminfo = true; /* set to true if we want to look for streams before playback */
   m_checkvideo = false;
+  m_zeroCopy = false;
 }
 
 CDVDDemuxFFmpeg::~CDVDDemuxFFmpeg()
@@ -195,8 +201,11 @@ bool CDVDDemuxFFmpeg::Open(CDVDInputStream* pInput, bool streaminfo, bool filein
   std::string strFile;
   m_streaminfo = streaminfo;
   m_currentPts = DVD_NOPTS_VALUE;
+  m_rateDts = DVD_NOPTS_VALUE;
+  m_readRate = 0;
   m_speed = DVD_PLAYSPEED_NORMAL;
   m_program = UINT_MAX;
+  m_zeroCopy = g_advancedSettings.m_videoZeroCopyDemux;
 
   const AVIOInterruptCB int_cb = { interrupt_cb, this };
 
@@ -448,25 +457,43 @@ bool CDVDDemuxFFmpeg::Open(CDVDInputStream* pInput, bool streaminfo, bool filein
     if(m_pInput->IsStreamType(DVDSTREAM_TYPE_DVD))
       av_opt_set_int(m_pFormatContext, "analyzeduration", 500000, 0);
 
-    CLog::Log(LOGDEBUG, "%s - avformat_find_stream_info starting", __FUNCTION__);
-    int iErr = avformat_find_stream_info(m_pFormatContext, NULL);
-    if (iErr < 0)
+    // files with a global header that were probed before can skip probing
+    bool probeCache = false;
+    struct __stat64 fileStat;
+    if (g_advancedSettings.m_videoProbeCache
+    &&  m_pInput->IsStreamType(DVDSTREAM_TYPE_FILE)
+    &&  (m_bMatroska || m_bAVI || strncmp(m_pFormatContext->iformat->name, "mov,", 4) == 0)
+    &&  XFILE::CFile::Stat(strFile, &fileStat) == 0 && fileStat.st_size > 0)
+      probeCache = true;
+
+    if (probeCache && CDVDDemuxProbeCache::Restore(strFile, fileStat.st_size, fileStat.st_mtime, m_pFormatContext))
     {
-      CLog::Log(LOGWARNING,"could not find codec parameters for %s", CURL::GetRedacted(strFile).c_str());
-      if (m_pInput->IsStreamType(DVDSTREAM_TYPE_DVD)
-      ||  m_pInput->IsStreamType(DVDSTREAM_TYPE_BLURAY)
-      || (m_pFormatContext->nb_streams == 1 && m_pFormatContext->streams[0]->codec->codec_id == AV_CODEC_ID_AC3)
-      || m_checkvideo)
-      {
-        // special case, our codecs can still handle it.
-      }
-      else
+      CLog::Log(LOGDEBUG, "%s - restored stream info from probe cache", __FUNCTION__);
+    }
+    else
+    {
+      CLog::Log(LOGDEBUG, "%s - avformat_find_stream_info starting", __FUNCTION__);
+      int iErr = avformat_find_stream_info(m_pFormatContext, NULL);
+      if (iErr < 0)
       {
-        Dispose();
-        return false;
+        CLog::Log(LOGWARNING,"could not find codec parameters for %s", CURL::GetRedacted(strFile).c_str());
+        if (m_pInput->IsStreamType(DVDSTREAM_TYPE_DVD)
+        ||  m_pInput->IsStreamType(DVDSTREAM_TYPE_BLURAY)
+        || (m_pFormatContext->nb_streams == 1 && m_pFormatContext->streams[0]->codec->codec_id == AV_CODEC_ID_AC3)
+        || m_checkvideo)
+        {
+          // special case, our codecs can still handle it.
+        }
+        else
+        {
+          Dispose();
+          return false;
+        }
       }
+      else if (probeCache)
+        CDVDDemuxProbeCache::Store(strFile, fileStat.st_size, fileStat.st_mtime, m_pFormatContext);
+      CLog::Log(LOGDEBUG, "%s - av_find_stream_info finished", __FUNCTION__);
     }
-    CLog::Log(LOGDEBUG, "%s - av_find_stream_info finished", __FUNCTION__);
 
     if (m_checkvideo)
     {
@@ -577,6 +604,7 @@ void CDVDDemuxFFmpeg::Flush()
     avformat_flush(m_pFormatContext);
 
   m_currentPts = DVD_NOPTS_VALUE;
+  m_rateDts = DVD_NOPTS_VALUE;
 
   m_pkt.result = -1;
   av_packet_unref(&m_pkt.pkt);
@@ -803,7 +831,7 @@ DemuxPacket* CDVDDemuxFFmpeg::Read()
           {
             if(m_pkt.pkt.stream_index == (int)m_pFormatContext->programs[m_program]->stream_index[i])
             {
-              pPacket = CDVDDemuxUtils::AllocateDemuxPacket(m_pkt.pkt.size);
+              pPacket = AllocatePacket(&m_pkt.pkt);
               break;
             }
           }
@@ -812,7 +840,7 @@ DemuxPacket* CDVDDemuxFFmpeg::Read()
             bReturnEmpty = true;
         }
         else
-          pPacket = CDVDDemuxUtils::AllocateDemuxPacket(m_pkt.pkt.size);
+          pPacket = AllocatePacket(&m_pkt.pkt);
       }
       else
         bReturnEmpty = true;
@@ -839,13 +867,6 @@ DemuxPacket* CDVDDemuxFFmpeg::Read()
           m_pkt.pkt.pts = AV_NOPTS_VALUE;
         }
 
-        // copy contents into our own packet
-        pPacket->iSize = m_pkt.pkt.size;
-
-        // maybe we can avoid a memcpy here by detecting where pkt.destruct is pointing too?
-        if (m_pkt.pkt.data)
-          memcpy(pPacket->pData, m_pkt.pkt.data, pPacket->iSize);
-
         pPacket->pts = ConvertTimestamp(m_pkt.pkt.pts, stream->time_base.den, stream->time_base.num);
         pPacket->dts = ConvertTimestamp(m_pkt.pkt.dts, stream->time_base.den, stream->time_base.num);
         pPacket->duration =  DVD_SEC_TO_TIME((double)m_pkt.pkt.duration * stream->time_base.num / stream->time_base.den);
@@ -873,6 +894,8 @@ DemuxPacket* CDVDDemuxFFmpeg::Read()
         if (pPacket->dts != DVD_NOPTS_VALUE && (pPacket->dts > m_currentPts || m_currentPts == DVD_NOPTS_VALUE))
           m_currentPts = pPacket->dts;
 
+        UpdateReadRate();
+
 
         // check if stream has passed full duration, needed for live streams
         bool bAllowDurationExt = (stream->codec && (stream->codec->codec_type == AVMEDIA_TYPE_VIDEO || stream->codec->codec_type == AVMEDIA_TYPE_AUDIO));
@@ -1035,6 +1058,7 @@ bool CDVDDemuxFFmpeg::SeekByte(int64_t pos)
 void CDVDDemuxFFmpeg::UpdateCurrentPTS()
 {
   m_currentPts = DVD_NOPTS_VALUE;
+  m_rateDts = DVD_NOPTS_VALUE;
   
   int idx = av_find_default_stream_index(m_pFormatContext);
   if (idx >= 0)
@@ -1048,6 +1072,47 @@ void CDVDDemuxFFmpeg::UpdateCurrentPTS()
   }
 }
 
+/* Measures input bytes against playback time over windows of a few seconds.
+ * The window restarts on any discontinuity, the estimate itself is kept.
+ */
+void CDVDDemuxFFmpeg::UpdateReadRate()
+{
+  if (!m_pFormatContext->pb || m_currentPts == DVD_NOPTS_VALUE)
+    return;
+
+  int64_t pos = avio_tell(m_pFormatContext->pb);
+  if (m_rateDts == DVD_NOPTS_VALUE || pos < m_ratePos || m_currentPts < m_rateDts)
+  {
+    m_rateDts = m_currentPts;
+    m_ratePos = pos;
+    return;
+  }
+
+  double elapsed = m_currentPts - m_rateDts;
+  if (elapsed < DVD_SEC_TO_TIME(5))
+    return;
+
+  double rate = (double)(pos - m_ratePos) * DVD_TIME_BASE / elapsed;
+
+  // a jump way beyond anything plausible is a timestamp discontinuity
+  if (elapsed < DVD_SEC_TO_TIME(60))
+  {
+    // the bitrate of single scenes varies a lot, smooth over a few windows
+    if (m_readRate)
+      m_readRate = (unsigned int)(0.7 * m_readRate + 0.3 * rate);
+    else
+      m_readRate = (unsigned int)rate;
+  }
+
+  m_rateDts = m_currentPts;
+  m_ratePos = pos;
+}
+
+unsigned int CDVDDemuxFFmpeg::GetReadRate()
+{
+  return m_readRate;
+}
+
 int CDVDDemuxFFmpeg::GetStreamLength()
 {
   if (!m_pFormatContext)
@@ -1656,6 +1721,35 @@ std::string CDVDDemuxFFmpeg::ConvertCodecToInternalStereoMode(const std::string
   return "";
 }
 
+DemuxPacket* CDVDDemuxFFmpeg::AllocatePacket(AVPacket *pkt)
+{
+  // reference the payload if ffmpeg handed us a buffer we may modify, some
+  // codecs move data within the packet. The padding is within the buffer
+  // but not necessarily zeroed by every demuxer
+  if (m_zeroCopy && pkt->buf && pkt->data && pkt->size > 0 &&
+      av_buffer_is_writable(pkt->buf) &&
+      pkt->data >= pkt->buf->data &&
+      pkt->data + pkt->size + FF_INPUT_BUFFER_PADDING_SIZE <= pkt->buf->data + pkt->buf->size)
+  {
+    DemuxPacket* pPacket = CDemuxPacketPool::GetInstance().AllocateReference(pkt->buf, pkt->data, pkt->size);
+    if (pPacket)
+    {
+      memset(pPacket->pData + pPacket->iSize, 0, FF_INPUT_BUFFER_PADDING_SIZE);
+      return pPacket;
+    }
+  }
+
+  // copy contents into our own packet
+  DemuxPacket* pPacket = CDVDDemuxUtils::AllocateDemuxPacket(pkt->size);
+  if (pPacket)
+  {
+    pPacket->iSize = pkt->size;
+    if (pkt->data)
+      memcpy(pPacket->pData, pkt->data, pPacket->iSize);
+  }
+  return pPacket;
+}
+
 void CDVDDemuxFFmpeg::ParsePacket(AVPacket *pkt)
 {
   AVStream *st = m_pFormatContext->streams[pkt->stream_index];
@@ -103,6 +103,7 @@ public:
   bool SeekTime(int time, bool backwords = false, double* startpts = NULL);
   bool SeekByte(int64_t pos);
   int GetStreamLength();
+  unsigned int GetReadRate() override;
   CDemuxStream* GetStream(int iStreamId) const override;
   std::vector<CDemuxStream*> GetStreams() const override;
   int GetNrOfStreams() const override;
@@ -130,12 +131,14 @@ protected:
   void CreateStreams(unsigned int program = UINT_MAX);
   void DisposeStreams();
   void ParsePacket(AVPacket *pkt);
+  DemuxPacket* AllocatePacket(AVPacket *pkt);
   bool IsVideoReady();
   void ResetVideoStreams();
 
   AVDictionary *GetFFMpegOptionsFromInput();
   double ConvertTimestamp(int64_t pts, int den, int num);
   void UpdateCurrentPTS();
+  void UpdateReadRate();
   bool IsProgramChange();
 
   std::string GetStereoModeFromMetadata(AVDictionary *pMetadata);
@@ -150,6 +153,9 @@ protected:
   AVIOContext* m_ioContext;
 
   double   m_currentPts; // used for stream length estimation
+  double   m_rateDts;    // start of the current read rate window
+  int64_t  m_ratePos;    // input position at m_rateDts
+  unsigned int m_readRate;
   bool     m_bMatroska;
   bool     m_bAVI;
   int      m_speed;
@@ -167,6 +173,7 @@ protected:
 
   bool m_streaminfo;
   bool m_checkvideo;
+  bool m_zeroCopy;
   int m_displayTime;
   double m_dtsAtDisplayTime;
 };
@@ -0,0 +1,529 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DVDDemuxProbeCache.h"
+#include "cores/FFmpeg.h"
+#include "filesystem/Directory.h"
+#include "filesystem/File.h"
+#include "FileItem.h"
+#include "URL.h"
+#include "XBDateTime.h"
+#include "utils/Crc32.h"
+#include "utils/log.h"
+#include "utils/StringUtils.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// bump whenever the layout of the cache files changes
+#define PROBE_CACHE_VERSION 2
+#define PROBE_CACHE_MAGIC 0x4350524b // "KPRC"
+#define PROBE_CACHE_HEADER_SIZE 16
+#define PROBE_CACHE_MAX_SIZE (16 * 1024 * 1024)
+#define PROBE_CACHE_MAX_STREAMS 256
+#define PROBE_CACHE_MAX_FILES 500
+#define PROBE_CACHE_MAX_AGE 30
+#define PROBE_CACHE_PATH "special://temp/probecache/"
+
+namespace
+{
+
+struct ProbedStream
+{
+  int32_t codecType;
+  int32_t codecId;
+  uint32_t codecTag;
+  std::string extraData;
+  int32_t width;
+  int32_t height;
+  int32_t pixFmt;
+  int32_t sampleRate;
+  int32_t channels;
+  uint64_t channelLayout;
+  int32_t sampleFmt;
+  int32_t blockAlign;
+  int32_t frameSize;
+  int32_t bitsPerCodedSample;
+  int32_t bitsPerRawSample;
+  int64_t bitRate;
+  int32_t profile;
+  int32_t level;
+  int32_t hasBFrames;
+  int32_t fieldOrder;
+  int32_t colorRange;
+  int32_t colorPrimaries;
+  int32_t colorTrc;
+  int32_t colorSpace;
+  int32_t chromaLocation;
+  int32_t ticksPerFrame;
+  AVRational codecTimeBase;
+  AVRational codecAspect;
+  AVRational streamAspect;
+  AVRational rFrameRate;
+  AVRational avgFrameRate;
+  int64_t duration;
+  int64_t startTime;
+  int64_t nbFrames;
+  int32_t codecInfoFrames;
+};
+
+/*!
+ * \brief Appends fixed size fields to a buffer in host byte order
+ */
+class CProbeWriter
+{
+public:
+  template<typename T>
+  void Write(T value)
+  {
+    m_data.append((const char*)&value, sizeof(T));
+  }
+
+  void Write(const AVRational& value)
+  {
+    Write<int32_t>(value.num);
+    Write<int32_t>(value.den);
+  }
+
+  void Write(const std::string& value)
+  {
+    Write<uint32_t>((uint32_t)value.size());
+    m_data.append(value);
+  }
+
+  const std::string& GetData() const { return m_data; }
+
+private:
+  std::string m_data;
+};
+
+/*!
+ * \brief Reads back what CProbeWriter wrote, failing instead of reading
+ * past the end of the buffer
+ */
+class CProbeReader
+{
+public:
+  CProbeReader(const std::string& data) : m_data(data), m_pos(0) {}
+
+  template<typename T>
+  bool Read(T& value)
+  {
+    if (m_data.size() - m_pos < sizeof(T))
+      return false;
+    memcpy(&value, m_data.data() + m_pos, sizeof(T));
+    m_pos += sizeof(T);
+    return true;
+  }
+
+  bool Read(AVRational& value)
+  {
+    int32_t num, den;
+    if (!Read(num) || !Read(den))
+      return false;
+    value.num = num;
+    value.den = den;
+    return true;
+  }
+
+  bool Read(std::string& value)
+  {
+    uint32_t size;
+    if (!Read(size) || size > m_data.size() - m_pos)
+      return false;
+    value.assign(m_data, m_pos, size);
+    m_pos += size;
+    return true;
+  }
+
+  bool AtEnd() const { return m_pos == m_data.size(); }
+
+private:
+  const std::string& m_data;
+  size_t m_pos;
+};
+
+uint32_t GetChecksum(const std::string& data)
+{
+  Crc32 crc;
+  crc.Compute(data.data(), data.size());
+  return crc;
+}
+
+bool InRange(int value, int min, int max)
+{
+  return value >= min && value < max;
+}
+
+bool IsValid(const AVRational& value)
+{
+  return value.num >= 0 && value.den >= 0;
+}
+
+void StoreStream(CProbeWriter& writer, const AVStream* st)
+{
+  const AVCodecContext* codec = st->codec;
+#if defined(AVFORMAT_HAS_STREAM_GET_R_FRAME_RATE)
+  AVRational rFrameRate = av_stream_get_r_frame_rate(st);
+#else
+  AVRational rFrameRate = st->r_frame_rate;
+#endif
+
+  writer.Write<int32_t>(codec->codec_type);
+  writer.Write<int32_t>(codec->codec_id);
+  writer.Write<uint32_t>(codec->codec_tag);
+  if (codec->extradata && codec->extradata_size > 0)
+    writer.Write(std::string((const char*)codec->extradata, codec->extradata_size));
+  else
+    writer.Write(std::string());
+  writer.Write<int32_t>(codec->width);
+  writer.Write<int32_t>(codec->height);
+  writer.Write<int32_t>(codec->pix_fmt);
+  writer.Write<int32_t>(codec->sample_rate);
+  writer.Write<int32_t>(codec->channels);
+  writer.Write<uint64_t>(codec->channel_layout);
+  writer.Write<int32_t>(codec->sample_fmt);
+  writer.Write<int32_t>(codec->block_align);
+  writer.Write<int32_t>(codec->frame_size);
+  writer.Write<int32_t>(codec->bits_per_coded_sample);
+  writer.Write<int32_t>(codec->bits_per_raw_sample);
+  writer.Write<int64_t>(codec->bit_rate);
+  writer.Write<int32_t>(codec->profile);
+  writer.Write<int32_t>(codec->level);
+  writer.Write<int32_t>(codec->has_b_frames);
+  writer.Write<int32_t>(codec->field_order);
+  writer.Write<int32_t>(codec->color_range);
+  writer.Write<int32_t>(codec->color_primaries);
+  writer.Write<int32_t>(codec->color_trc);
+  writer.Write<int32_t>(codec->colorspace);
+  writer.Write<int32_t>(codec->chroma_sample_location);
+  writer.Write<int32_t>(codec->ticks_per_frame);
+  writer.Write(codec->time_base);
+  writer.Write(codec->sample_aspect_ratio);
+  writer.Write(st->sample_aspect_ratio);
+  writer.Write(rFrameRate);
+  writer.Write(st->avg_frame_rate);
+  writer.Write<int64_t>(st->duration);
+  writer.Write<int64_t>(st->start_time);
+  writer.Write<int64_t>(st->nb_frames);
+  writer.Write<int32_t>(st->codec_info_nb_frames);
+}
+
+bool LoadStream(CProbeReader& reader, ProbedStream& ps)
+{
+  return reader.Read(ps.codecType) &&
+         reader.Read(ps.codecId) &&
+         reader.Read(ps.codecTag) &&
+         reader.Read(ps.extraData) &&
+         reader.Read(ps.width) &&
+         reader.Read(ps.height) &&
+         reader.Read(ps.pixFmt) &&
+         reader.Read(ps.sampleRate) &&
+         reader.Read(ps.channels) &&
+         reader.Read(ps.channelLayout) &&
+         reader.Read(ps.sampleFmt) &&
+         reader.Read(ps.blockAlign) &&
+         reader.Read(ps.frameSize) &&
+         reader.Read(ps.bitsPerCodedSample) &&
+         reader.Read(ps.bitsPerRawSample) &&
+         reader.Read(ps.bitRate) &&
+         reader.Read(ps.profile) &&
+         reader.Read(ps.level) &&
+         reader.Read(ps.hasBFrames) &&
+         reader.Read(ps.fieldOrder) &&
+         reader.Read(ps.colorRange) &&
+         reader.Read(ps.colorPrimaries) &&
+         reader.Read(ps.colorTrc) &&
+         reader.Read(ps.colorSpace) &&
+         reader.Read(ps.chromaLocation) &&
+         reader.Read(ps.ticksPerFrame) &&
+         reader.Read(ps.codecTimeBase) &&
+         reader.Read(ps.codecAspect) &&
+         reader.Read(ps.streamAspect) &&
+         reader.Read(ps.rFrameRate) &&
+         reader.Read(ps.avgFrameRate) &&
+         reader.Read(ps.duration) &&
+         reader.Read(ps.startTime) &&
+         reader.Read(ps.nbFrames) &&
+         reader.Read(ps.codecInfoFrames);
+}
+
+bool ValidateStream(const ProbedStream& ps)
+{
+  return InRange(ps.codecType, AVMEDIA_TYPE_UNKNOWN, AVMEDIA_TYPE_NB) &&
+         ps.width >= 0 && ps.height >= 0 &&
+         InRange(ps.pixFmt, AV_PIX_FMT_NONE, AV_PIX_FMT_NB) &&
+         ps.sampleRate >= 0 &&
+         ps.channels >= 0 && ps.channels <= FF_SANE_NB_CHANNELS &&
+         InRange(ps.sampleFmt, AV_SAMPLE_FMT_NONE, AV_SAMPLE_FMT_NB) &&
+         ps.blockAlign >= 0 &&
+         ps.frameSize >= 0 &&
+         ps.bitsPerCodedSample >= 0 &&
+         ps.bitsPerRawSample >= 0 &&
+         ps.bitRate >= 0 &&
+         ps.hasBFrames >= 0 &&
+         InRange(ps.fieldOrder, AV_FIELD_UNKNOWN, AV_FIELD_BT + 1) &&
+         InRange(ps.colorRange, AVCOL_RANGE_UNSPECIFIED, AVCOL_RANGE_NB) &&
+         InRange(ps.colorPrimaries, AVCOL_PRI_RESERVED0, AVCOL_PRI_NB) &&
+         InRange(ps.colorTrc, AVCOL_TRC_RESERVED0, AVCOL_TRC_NB) &&
+         InRange(ps.colorSpace, AVCOL_SPC_RGB, AVCOL_SPC_NB) &&
+         InRange(ps.chromaLocation, AVCHROMA_LOC_UNSPECIFIED, AVCHROMA_LOC_NB) &&
+         ps.ticksPerFrame >= 0 &&
+         IsValid(ps.codecTimeBase) &&
+         IsValid(ps.codecAspect) &&
+         IsValid(ps.streamAspect) &&
+         IsValid(ps.rFrameRate) &&
+         IsValid(ps.avgFrameRate) &&
+         ps.nbFrames >= 0 &&
+         ps.codecInfoFrames >= 0;
+}
+
+bool ApplyStream(AVStream* st, const ProbedStream& ps)
+{
+  AVCodecContext* codec = st->codec;
+
+  if (!ps.extraData.empty() && codec->extradata_size <= 0)
+  {
+    uint8_t* extraData = (uint8_t*)av_mallocz(ps.extraData.size() + FF_INPUT_BUFFER_PADDING_SIZE);
+    if (!extraData)
+      return false;
+    memcpy(extraData, ps.extraData.data(), ps.extraData.size());
+    av_freep(&codec->extradata);
+    codec->extradata = extraData;
+    codec->extradata_size = (int)ps.extraData.size();
+  }
+
+  codec->codec_tag = ps.codecTag;
+  codec->width = ps.width;
+  codec->height = ps.height;
+  codec->pix_fmt = (AVPixelFormat)ps.pixFmt;
+  codec->sample_rate = ps.sampleRate;
+  codec->channels = ps.channels;
+  codec->channel_layout = ps.channelLayout;
+  codec->sample_fmt = (AVSampleFormat)ps.sampleFmt;
+  codec->block_align = ps.blockAlign;
+  codec->frame_size = ps.frameSize;
+  codec->bits_per_coded_sample = ps.bitsPerCodedSample;
+  codec->bits_per_raw_sample = ps.bitsPerRawSample;
+  codec->bit_rate = ps.bitRate;
+  codec->profile = ps.profile;
+  codec->level = ps.level;
+  codec->has_b_frames = ps.hasBFrames;
+  codec->field_order = (AVFieldOrder)ps.fieldOrder;
+  codec->color_range = (AVColorRange)ps.colorRange;
+  codec->color_primaries = (AVColorPrimaries)ps.colorPrimaries;
+  codec->color_trc = (AVColorTransferCharacteristic)ps.colorTrc;
+  codec->colorspace = (AVColorSpace)ps.colorSpace;
+  codec->chroma_sample_location = (AVChromaLocation)ps.chromaLocation;
+  codec->ticks_per_frame = ps.ticksPerFrame;
+  codec->time_base = ps.codecTimeBase;
+  codec->sample_aspect_ratio = ps.codecAspect;
+  st->sample_aspect_ratio = ps.streamAspect;
+#if defined(AVFORMAT_HAS_STREAM_GET_R_FRAME_RATE)
+  av_stream_set_r_frame_rate(st, ps.rFrameRate);
+#else
+  st->r_frame_rate = ps.rFrameRate;
+#endif
+  st->avg_frame_rate = ps.avgFrameRate;
+  st->duration = ps.duration;
+  st->start_time = ps.startTime;
+  st->nb_frames = ps.nbFrames;
+  st->codec_info_nb_frames = ps.codecInfoFrames;
+  return true;
+}
+
+/*!
+ * \brief Read a cache file and return its payload if the header checks out
+ */
+bool ReadCacheFile(const std::string& cacheFile, std::string& payload)
+{
+  XFILE::CFile file;
+  if (!XFILE::CFile::Exists(cacheFile) || !file.Open(cacheFile))
+    return false;
+
+  int64_t length = file.GetLength();
+  if (length < PROBE_CACHE_HEADER_SIZE || length > PROBE_CACHE_MAX_SIZE)
+    return false;
+
+  std::string data((size_t)length, '\0');
+  if (file.Read(&data[0], data.size()) != (ssize_t)data.size())
+    return false;
+  file.Close();
+
+  CProbeReader reader(data);
+  uint32_t magic, version, size, checksum;
+  if (!reader.Read(magic) || magic != PROBE_CACHE_MAGIC ||
+      !reader.Read(version) || version != PROBE_CACHE_VERSION ||
+      !reader.Read(size) || size != data.size() - PROBE_CACHE_HEADER_SIZE ||
+      !reader.Read(checksum))
+    return false;
+
+  payload = data.substr(PROBE_CACHE_HEADER_SIZE);
+  return GetChecksum(payload) == checksum;
+}
+
+}
+
+std::string CDVDDemuxProbeCache::GetCacheFile(const std::string& path)
+{
+  Crc32 crc;
+  crc.ComputeFromLowerCase(path);
+  return StringUtils::Format(PROBE_CACHE_PATH "probe-%08x.fi", (unsigned int)crc);
+}
+
+bool CDVDDemuxProbeCache::Restore(const std::string& path, int64_t size, int64_t mtime, AVFormatContext* context)
+{
+  std::string payload;
+  if (!ReadCacheFile(GetCacheFile(path), payload))
+    return false;
+
+  CProbeReader reader(payload);
+
+  std::string cachedPath;
+  int64_t cachedSize = 0;
+  int64_t cachedTime = 0;
+  if (!reader.Read(cachedPath) || !reader.Read(cachedSize) || !reader.Read(cachedTime))
+    return false;
+
+  if (cachedPath != path || cachedSize != size || cachedTime != mtime)
+  {
+    CLog::Log(LOGDEBUG, "CDVDDemuxProbeCache::%s - %s has changed, probing again", __FUNCTION__, CURL::GetRedacted(path).c_str());
+    return false;
+  }
+
+  uint32_t streams = 0;
+  int64_t duration = 0;
+  int64_t startTime = 0;
+  int64_t bitRate = 0;
+  if (!reader.Read(streams) || !reader.Read(duration) || !reader.Read(startTime) || !reader.Read(bitRate))
+    return false;
+  if (streams != context->nb_streams || streams > PROBE_CACHE_MAX_STREAMS || bitRate < 0)
+    return false;
+
+  // read and validate everything before touching the context
+  std::vector<ProbedStream> probed(streams);
+  for (unsigned int i = 0; i < streams; i++)
+  {
+    const AVCodecContext* codec = context->streams[i]->codec;
+    if (!LoadStream(reader, probed[i]) || !ValidateStream(probed[i]) ||
+        probed[i].codecType != codec->codec_type || probed[i].codecId != codec->codec_id)
+    {
+      CLog::Log(LOGDEBUG, "CDVDDemuxProbeCache::%s - stream %u of %s does not match, probing again", __FUNCTION__, i, CURL::GetRedacted(path).c_str());
+      return false;
+    }
+  }
+  if (!reader.AtEnd())
+    return false;
+
+  for (unsigned int i = 0; i < streams; i++)
+  {
+    if (!ApplyStream(context->streams[i], probed[i]))
+      return false;
+  }
+
+  context->duration = duration;
+  context->start_time = startTime;
+  context->bit_rate = bitRate;
+  return true;
+}
+
+void CDVDDemuxProbeCache::Store(const std::string& path, int64_t size, int64_t mtime, const AVFormatContext* context)
+{
+  if (context->nb_streams == 0 || context->nb_streams > PROBE_CACHE_MAX_STREAMS)
+    return;
+
+  CProbeWriter payload;
+  payload.Write(path);
+  payload.Write<int64_t>(size);
+  payload.Write<int64_t>(mtime);
+  payload.Write<uint32_t>(context->nb_streams);
+  payload.Write<int64_t>(context->duration);
+  payload.Write<int64_t>(context->start_time);
+  payload.Write<int64_t>(context->bit_rate);
+  for (unsigned int i = 0; i < context->nb_streams; i++)
+    StoreStream(payload, context->streams[i]);
+
+  const std::string& data = payload.GetData();
+  if (data.size() > PROBE_CACHE_MAX_SIZE - PROBE_CACHE_HEADER_SIZE)
+    return;
+
+  CProbeWriter header;
+  header.Write<uint32_t>(PROBE_CACHE_MAGIC);
+  header.Write<uint32_t>(PROBE_CACHE_VERSION);
+  header.Write<uint32_t>((uint32_t)data.size());
+  header.Write<uint32_t>(GetChecksum(data));
+  const std::string& headerData = header.GetData();
+
+  if (!XFILE::CDirectory::Exists(PROBE_CACHE_PATH))
+    XFILE::CDirectory::Create(PROBE_CACHE_PATH);
+  else
+    Prune(PROBE_CACHE_MAX_FILES - 1, PROBE_CACHE_MAX_AGE);
+
+  // write to a temporary file first, a crash must not leave a partial cache file behind
+  std::string cacheFile = GetCacheFile(path);
+  std::string tempFile = cacheFile + ".tmp";
+  XFILE::CFile file;
+  if (!file.OpenForWrite(tempFile, true) ||
+      file.Write(headerData.data(), headerData.size()) != (ssize_t)headerData.size() ||
+      file.Write(data.data(), data.size()) != (ssize_t)data.size())
+  {
+    CLog::Log(LOGWARNING, "CDVDDemuxProbeCache::%s - unable to write probe cache of %s", __FUNCTION__, CURL::GetRedacted(path).c_str());
+    file.Close();
+    XFILE::CFile::Delete(tempFile);
+    return;
+  }
+  file.Close();
+
+  if (XFILE::CFile::Exists(cacheFile))
+    XFILE::CFile::Delete(cacheFile);
+  if (!XFILE::CFile::Rename(tempFile, cacheFile))
+    XFILE::CFile::Delete(tempFile);
+}
+
+void CDVDDemuxProbeCache::Prune(unsigned int maxFiles, unsigned int maxAgeDays)
+{
+  CFileItemList items;
+  if (!XFILE::CDirectory::GetDirectory(PROBE_CACHE_PATH, items, "", XFILE::DIR_FLAG_NO_FILE_DIRS | XFILE::DIR_FLAG_BYPASS_CACHE))
+    return;
+
+  CDateTime oldest = CDateTime::GetCurrentDateTime() - CDateTimeSpan(maxAgeDays, 0, 0, 0);
+  std::vector<CFileItemPtr> files;
+  for (int i = 0; i < items.Size(); i++)
+  {
+    CFileItemPtr item = items[i];
+    if (item->m_bIsFolder)
+      continue;
+    if (item->m_dateTime.IsValid() && item->m_dateTime <= oldest)
+      XFILE::CFile::Delete(item->GetPath());
+    else
+      files.push_back(item);
+  }
+
+  if (files.size() <= maxFiles)
+    return;
+
+  std::sort(files.begin(), files.end(), [](const CFileItemPtr& a, const CFileItemPtr& b)
+  {
+    return a->m_dateTime < b->m_dateTime;
+  });
+  for (size_t i = 0; i < files.size() - maxFiles; i++)
+    XFILE::CFile::Delete(files[i]->GetPath());
+}
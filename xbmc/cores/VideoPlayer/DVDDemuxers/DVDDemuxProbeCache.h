@@ -0,0 +1,66 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdint.h>
+#include <string>
+
+struct AVFormatContext;
+
+/*!
+ * \brief Persistent store for the results of avformat_find_stream_info.
+ *
+ * The codec parameters, extradata, frame rates and durations found while
+ * probing a file are kept on disk, keyed by path, size and modification time.
+ * Reopening the same file can restore them instead of reading and decoding
+ * the start of every stream again.
+ *
+ * Each cache file starts with a header holding the format version, payload
+ * length and a checksum of the payload. Anything that fails to validate is
+ * ignored, so the caller falls back to a real probe.
+ */
+class CDVDDemuxProbeCache
+{
+public:
+  /*!
+   * \brief Apply cached stream info of a file to a freshly opened context.
+   * The stream layout found by avformat_open_input has to match the cached
+   * one, otherwise the context is left untouched.
+   * \return true if the context is ready to use without probing
+   */
+  static bool Restore(const std::string& path, int64_t size, int64_t mtime, AVFormatContext* context);
+
+  /*!
+   * \brief Store the stream info of a probed context
+   */
+  static void Store(const std::string& path, int64_t size, int64_t mtime, const AVFormatContext* context);
+
+  /*!
+   * \brief Remove cache files not modified within maxAgeDays, then the oldest ones
+   * until no more than maxFiles are left
+   */
+  static void Prune(unsigned int maxFiles, unsigned int maxAgeDays);
+
+  /*!
+   * \brief Get the cache file used for a path
+   */
+  static std::string GetCacheFile(const std::string& path);
+};
@@ -0,0 +1,300 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DemuxPacketPool.h"
+#include "DVDClock.h"
+#include "threads/SingleLock.h"
+#include "utils/log.h"
+#include "system.h"
+
+#ifdef TARGET_POSIX
+#include "linux/XMemUtils.h"
+#endif
+
+#include <cstring>
+#include <new>
+
+extern "C" {
+#include "libavcodec/avcodec.h"
+#include "libavutil/buffer.h"
+}
+
+CDemuxPacketPool& CDemuxPacketPool::GetInstance()
+{
+  static CDemuxPacketPool instance;
+  return instance;
+}
+
+CDemuxPacketPool::CDemuxPacketPool()
+  : m_freeNoPayload(nullptr)
+{
+  for (int i = 0; i < NUM_SIZE_CLASSES; i++)
+    m_freeLists[i] = nullptr;
+  for (int i = 0; i <= NUM_SIZE_CLASSES; i++)
+    m_freeCount[i] = 0;
+  memset(&m_stats, 0, sizeof(m_stats));
+}
+
+CDemuxPacketPool::~CDemuxPacketPool()
+{
+  // no logging here, the logger may already be gone during static destruction
+  while (m_freeNoPayload)
+  {
+    PoolEntry* next = m_freeNoPayload->next;
+    DestroyEntry(m_freeNoPayload);
+    m_freeNoPayload = next;
+  }
+  for (int i = 0; i < NUM_SIZE_CLASSES; i++)
+  {
+    while (m_freeLists[i])
+    {
+      PoolEntry* next = m_freeLists[i]->next;
+      DestroyEntry(m_freeLists[i]);
+      m_freeLists[i] = next;
+    }
+  }
+}
+
+int CDemuxPacketPool::GetSizeClass(size_t size)
+{
+  int sizeClass = 0;
+  size_t capacity = static_cast<size_t>(1) << MIN_CLASS_SHIFT;
+  while (capacity < size)
+  {
+    if (++sizeClass >= NUM_SIZE_CLASSES)
+      return SIZE_CLASS_OVERSIZED;
+    capacity <<= 1;
+  }
+  return sizeClass;
+}
+
+CDemuxPacketPool::PoolEntry* CDemuxPacketPool::CreateEntry(int sizeClass, size_t capacity)
+{
+  PoolEntry* entry = new (std::nothrow) PoolEntry;
+  if (!entry)
+    return nullptr;
+
+  memset(entry, 0, sizeof(PoolEntry));
+  entry->sizeClass = sizeClass;
+  entry->capacity = capacity;
+
+  if (capacity > 0)
+  {
+    entry->packet.pData = static_cast<uint8_t*>(_aligned_malloc(capacity, PAYLOAD_ALIGNMENT));
+    if (!entry->packet.pData)
+    {
+      delete entry;
+      return nullptr;
+    }
+  }
+  return entry;
+}
+
+void CDemuxPacketPool::DestroyEntry(PoolEntry* entry)
+{
+  if (entry->buffer)
+    av_buffer_unref(&entry->buffer);
+  else if (entry->packet.pData)
+    _aligned_free(entry->packet.pData);
+  delete entry;
+}
+
+void CDemuxPacketPool::ResetPacket(PoolEntry* entry, int iDataSize)
+{
+  uint8_t* pData = entry->packet.pData;
+  memset(&entry->packet, 0, sizeof(DemuxPacket));
+  entry->packet.pData = pData;
+  entry->next = nullptr;
+
+  // some optimized bitstream readers read 32 or 64 bit at once and could read
+  // over the end, the padding following the payload has to be zero
+  if (pData)
+    memset(pData + iDataSize, 0, FF_INPUT_BUFFER_PADDING_SIZE);
+
+  entry->packet.dts = DVD_NOPTS_VALUE;
+  entry->packet.pts = DVD_NOPTS_VALUE;
+  entry->packet.iStreamId = -1;
+  entry->packet.dispTime = 0;
+}
+
+CDemuxPacketPool::PoolEntry* CDemuxPacketPool::GetEntry(int sizeClass, size_t needed)
+{
+  PoolEntry* entry = nullptr;
+  {
+    CSingleLock lock(m_critSection);
+    m_stats.allocations++;
+
+    PoolEntry** freeList = nullptr;
+    if (sizeClass == SIZE_CLASS_NONE)
+      freeList = &m_freeNoPayload;
+    else if (sizeClass >= 0)
+      freeList = &m_freeLists[sizeClass];
+    else
+      m_stats.oversized++;
+
+    if (freeList && *freeList)
+    {
+      entry = *freeList;
+      *freeList = entry->next;
+      m_freeCount[sizeClass + 1]--;
+      m_stats.recycled++;
+      m_stats.cachedPackets--;
+      m_stats.cachedBytes -= entry->capacity;
+    }
+  }
+
+  if (!entry)
+  {
+    size_t capacity = needed;
+    if (sizeClass >= 0)
+      capacity = static_cast<size_t>(1) << (MIN_CLASS_SHIFT + sizeClass);
+
+    entry = CreateEntry(sizeClass, capacity);
+  }
+  return entry;
+}
+
+DemuxPacket* CDemuxPacketPool::Allocate(int iDataSize)
+{
+  if (iDataSize < 0)
+    iDataSize = 0;
+
+  size_t needed = 0;
+  int sizeClass = SIZE_CLASS_NONE;
+  if (iDataSize > 0)
+  {
+    needed = iDataSize + FF_INPUT_BUFFER_PADDING_SIZE;
+    sizeClass = GetSizeClass(needed);
+  }
+
+  PoolEntry* entry = GetEntry(sizeClass, needed);
+  if (!entry)
+  {
+    CLog::Log(LOGERROR, "CDemuxPacketPool::%s - failed to allocate packet of %d bytes", __FUNCTION__, iDataSize);
+    return nullptr;
+  }
+
+  ResetPacket(entry, iDataSize);
+  return &entry->packet;
+}
+
+DemuxPacket* CDemuxPacketPool::AllocateReference(AVBufferRef* buffer, uint8_t* pData, int iDataSize)
+{
+  PoolEntry* entry = GetEntry(SIZE_CLASS_NONE, 0);
+  if (!entry)
+  {
+    CLog::Log(LOGERROR, "CDemuxPacketPool::%s - failed to allocate packet", __FUNCTION__);
+    return nullptr;
+  }
+
+  ResetPacket(entry, 0);
+
+  entry->buffer = av_buffer_ref(buffer);
+  if (!entry->buffer)
+  {
+    Release(&entry->packet);
+    return nullptr;
+  }
+  entry->packet.pData = pData;
+  entry->packet.iSize = iDataSize;
+
+  CSingleLock lock(m_critSection);
+  m_stats.references++;
+  return &entry->packet;
+}
+
+void CDemuxPacketPool::Release(DemuxPacket* pPacket)
+{
+  if (!pPacket)
+    return;
+
+  PoolEntry* entry = reinterpret_cast<PoolEntry*>(pPacket);
+
+  // referencing packets never own a payload, drop the reference and recycle
+  // them as packets without payload
+  if (entry->buffer)
+  {
+    av_buffer_unref(&entry->buffer);
+    entry->packet.pData = nullptr;
+  }
+
+  if (entry->sizeClass != SIZE_CLASS_OVERSIZED)
+  {
+    CSingleLock lock(m_critSection);
+    size_t& count = m_freeCount[entry->sizeClass + 1];
+    if (count < MAX_CACHED_PER_CLASS &&
+        m_stats.cachedBytes + entry->capacity <= MAX_CACHED_BYTES)
+    {
+      PoolEntry** freeList = entry->sizeClass == SIZE_CLASS_NONE ? &m_freeNoPayload : &m_freeLists[entry->sizeClass];
+      entry->next = *freeList;
+      *freeList = entry;
+      count++;
+      m_stats.cachedPackets++;
+      m_stats.cachedBytes += entry->capacity;
+      return;
+    }
+    m_stats.discarded++;
+  }
+
+  DestroyEntry(entry);
+}
+
+void CDemuxPacketPool::Purge()
+{
+  PoolEntry* lists[NUM_SIZE_CLASSES + 1];
+  Stats stats;
+  {
+    CSingleLock lock(m_critSection);
+    lists[0] = m_freeNoPayload;
+    m_freeNoPayload = nullptr;
+    for (int i = 0; i < NUM_SIZE_CLASSES; i++)
+    {
+      lists[i + 1] = m_freeLists[i];
+      m_freeLists[i] = nullptr;
+    }
+    for (int i = 0; i <= NUM_SIZE_CLASSES; i++)
+      m_freeCount[i] = 0;
+
+    stats = m_stats;
+    m_stats.cachedPackets = 0;
+    m_stats.cachedBytes = 0;
+  }
+
+  for (int i = 0; i <= NUM_SIZE_CLASSES; i++)
+  {
+    while (lists[i])
+    {
+      PoolEntry* next = lists[i]->next;
+      DestroyEntry(lists[i]);
+      lists[i] = next;
+    }
+  }
+
+  if (stats.allocations > 0)
+    CLog::Log(LOGDEBUG, "CDemuxPacketPool::%s - allocations: %" PRIu64 ", recycled: %" PRIu64 ", oversized: %" PRIu64 ", references: %" PRIu64 ", discarded: %" PRIu64 ", freed %" PRIuS " packets (%" PRIuS " bytes)",
+              __FUNCTION__, stats.allocations, stats.recycled, stats.oversized, stats.references, stats.discarded,
+              stats.cachedPackets, stats.cachedBytes);
+}
+
+CDemuxPacketPool::Stats CDemuxPacketPool::GetStats() const
+{
+  CSingleLock lock(m_critSection);
+  return m_stats;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DVDDemuxPacket.h"
+#include "threads/CriticalSection.h"
+
+#include <cstddef>
+#include <cstdint>
+
+struct AVBufferRef;
+
+/*!
+ * \brief Thread safe recycler for DemuxPacket structures and their payloads.
+ *
+ * Packets are handed out from a set of power-of-two size classes. The payload
+ * capacity of a class always includes the input padding required by ffmpeg,
+ * so a recycled buffer can be reused for any packet that fits into it without
+ * reallocation. Payloads larger than the biggest class are allocated directly
+ * and freed on release.
+ *
+ * Packets still have to be released via CDVDDemuxUtils::FreeDemuxPacket, which
+ * forwards to this pool.
+ */
+class CDemuxPacketPool
+{
+public:
+  struct Stats
+  {
+    uint64_t allocations;   //!< total number of packets handed out
+    uint64_t recycled;      //!< packets served from a free list
+    uint64_t oversized;     //!< payloads too big for any size class
+    uint64_t references;    //!< packets referencing an ffmpeg buffer instead of owning a payload
+    uint64_t discarded;     //!< released packets freed because the pool was full
+    size_t cachedPackets;   //!< packets currently waiting in the free lists
+    size_t cachedBytes;     //!< payload bytes currently held by the free lists
+  };
+
+  static CDemuxPacketPool& GetInstance();
+
+  /*!
+   * \brief Get a cleared packet with room for iDataSize bytes of payload
+   * plus zeroed input padding. A size of 0 returns a packet without payload.
+   */
+  DemuxPacket* Allocate(int iDataSize);
+
+  /*!
+   * \brief Get a cleared packet whose payload points into a refcounted ffmpeg
+   * buffer. The packet takes a new reference on buffer which is dropped on
+   * release. pData must lie within buffer and be followed by zeroed input
+   * padding.
+   */
+  DemuxPacket* AllocateReference(AVBufferRef* buffer, uint8_t* pData, int iDataSize);
+
+  /*!
+   * \brief Hand a packet obtained from Allocate back to the pool
+   */
+  void Release(DemuxPacket* pPacket);
+
+  /*!
+   * \brief Free all cached packets, packets in flight are not affected
+   */
+  void Purge();
+
+  Stats GetStats() const;
+
+private:
+  CDemuxPacketPool();
+  ~CDemuxPacketPool();
+  CDemuxPacketPool(const CDemuxPacketPool&) = delete;
+  CDemuxPacketPool& operator=(const CDemuxPacketPool&) = delete;
+
+  /*!
+   * DemuxPacket is part of the add-on ABI and must not grow, so our
+   * bookkeeping lives in a wrapper. The packet has to stay the first member.
+   */
+  struct PoolEntry
+  {
+    DemuxPacket packet;
+    int sizeClass;
+    size_t capacity;
+    AVBufferRef* buffer;
+    PoolEntry* next;
+  };
+
+  static const int SIZE_CLASS_NONE = -1;
+  static const int SIZE_CLASS_OVERSIZED = -2;
+  static const unsigned int MIN_CLASS_SHIFT = 8;   // 256 bytes
+  static const unsigned int MAX_CLASS_SHIFT = 23;  // 8 MiB
+  static const int NUM_SIZE_CLASSES = MAX_CLASS_SHIFT - MIN_CLASS_SHIFT + 1;
+  static const size_t MAX_CACHED_BYTES = 64 * 1024 * 1024;
+  static const size_t MAX_CACHED_PER_CLASS = 256;
+  static const size_t PAYLOAD_ALIGNMENT = 64;
+
+  static int GetSizeClass(size_t size);
+  static PoolEntry* CreateEntry(int sizeClass, size_t capacity);
+  static void DestroyEntry(PoolEntry* entry);
+  static void ResetPacket(PoolEntry* entry, int iDataSize);
+  PoolEntry* GetEntry(int sizeClass, size_t needed);
+
+  mutable CCriticalSection m_critSection;
+  PoolEntry* m_freeNoPayload;
+  PoolEntry* m_freeLists[NUM_SIZE_CLASSES];
+  size_t m_freeCount[NUM_SIZE_CLASSES + 1];
+  Stats m_stats;
+};
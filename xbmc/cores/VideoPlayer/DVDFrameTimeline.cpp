@@ -0,0 +1,313 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DVDFrameTimeline.h"
+#include "DVDClock.h"
+#include "filesystem/File.h"
+#include "utils/JSONVariantWriter.h"
+#include "utils/log.h"
+#include "utils/TimeUtils.h"
+#include "utils/Variant.h"
+
+#include <algorithm>
+#include <cmath>
+
+// frames arrive in pts order give or take reordering, don't look further back
+#define TIMELINE_SEARCH 64
+// pts of the same frame only differ by rounding
+#define TIMELINE_PTS_TOLERANCE 1.0
+
+namespace
+{
+
+/*!
+ * \brief Puts the recorded events back together into frames
+ */
+class CFrameRing
+{
+public:
+  CFrameRing() : m_frames(CDVDFrameTimeline::FRAMES), m_next(0), m_count(0) {}
+
+  CDVDFrameTimeline::SFrame* Find(double pts)
+  {
+    unsigned int search = std::min<unsigned int>(m_count, TIMELINE_SEARCH);
+    for (unsigned int i = 1; i <= search; i++)
+    {
+      CDVDFrameTimeline::SFrame& frame = m_frames[(m_next + CDVDFrameTimeline::FRAMES - i) % CDVDFrameTimeline::FRAMES];
+      if (std::abs(frame.pts - pts) < TIMELINE_PTS_TOLERANCE)
+        return &frame;
+    }
+    return nullptr;
+  }
+
+  CDVDFrameTimeline::SFrame* Get(double pts)
+  {
+    CDVDFrameTimeline::SFrame* frame = Find(pts);
+    if (frame)
+      return frame;
+
+    frame = &m_frames[m_next];
+    m_next = (m_next + 1) % CDVDFrameTimeline::FRAMES;
+    if (m_count < CDVDFrameTimeline::FRAMES)
+      m_count++;
+
+    frame->pts = pts;
+    frame->drop = CDVDFrameTimeline::DROP_NONE;
+    for (int i = 0; i < CDVDFrameTimeline::STAGE_MAX; i++)
+      frame->time[i] = 0;
+    return frame;
+  }
+
+  std::vector<CDVDFrameTimeline::SFrame> GetFrames() const
+  {
+    std::vector<CDVDFrameTimeline::SFrame> frames;
+    frames.reserve(m_count);
+    unsigned int first = (m_next + CDVDFrameTimeline::FRAMES - m_count) % CDVDFrameTimeline::FRAMES;
+    for (unsigned int i = 0; i < m_count; i++)
+      frames.push_back(m_frames[(first + i) % CDVDFrameTimeline::FRAMES]);
+    return frames;
+  }
+
+private:
+  std::vector<CDVDFrameTimeline::SFrame> m_frames;
+  unsigned int m_next;
+  unsigned int m_count;
+};
+
+}
+
+CDVDFrameTimeline::CDVDFrameTimeline()
+  : m_enabled(false)
+  , m_write(0)
+  , m_first(0)
+  , m_start(0)
+{
+}
+
+void CDVDFrameTimeline::SetEnabled(bool enabled)
+{
+  // the ring is allocated once and kept, writers may still be looking at it
+  if (enabled && !m_events)
+  {
+    m_events.reset(new SEvent[EVENTS]);
+    for (int i = 0; i < EVENTS; i++)
+      m_events[i].seq.store(0, std::memory_order_relaxed);
+    Reset();
+  }
+  m_enabled.store(enabled, std::memory_order_release);
+}
+
+void CDVDFrameTimeline::Reset()
+{
+  m_start.store(CurrentHostCounter(), std::memory_order_relaxed);
+  m_first.store(m_write.load(std::memory_order_relaxed), std::memory_order_release);
+}
+
+void CDVDFrameTimeline::Push(EEvent type, double pts, double value, int64_t time)
+{
+  uint64_t index = m_write.fetch_add(1, std::memory_order_relaxed);
+  SEvent& event = m_events[index % EVENTS];
+
+  // readers skip the slot until seq matches the index again
+  event.seq.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  event.time.store(time, std::memory_order_relaxed);
+  event.pts.store(pts, std::memory_order_relaxed);
+  event.value.store(value, std::memory_order_relaxed);
+  event.type.store(type, std::memory_order_relaxed);
+  event.seq.store(index + 1, std::memory_order_release);
+}
+
+void CDVDFrameTimeline::Mark(double pts, EStage stage)
+{
+  if (!m_enabled.load(std::memory_order_acquire) || pts == DVD_NOPTS_VALUE)
+    return;
+
+  Push(EVENT_MARK, pts, stage, CurrentHostCounter());
+}
+
+void CDVDFrameTimeline::Drop(double pts, EDrop reason)
+{
+  if (!m_enabled.load(std::memory_order_acquire) || pts == DVD_NOPTS_VALUE)
+    return;
+
+  Push(EVENT_DROP, pts, reason, 0);
+}
+
+void CDVDFrameTimeline::Rekey(double pts, double newPts)
+{
+  if (!m_enabled.load(std::memory_order_acquire) || pts == DVD_NOPTS_VALUE || newPts == DVD_NOPTS_VALUE)
+    return;
+
+  Push(EVENT_REKEY, pts, newPts, 0);
+}
+
+std::vector<CDVDFrameTimeline::SFrame> CDVDFrameTimeline::GetFrames() const
+{
+  CFrameRing ring;
+  if (!m_events)
+    return ring.GetFrames();
+
+  uint64_t write = m_write.load(std::memory_order_acquire);
+  uint64_t first = std::max(m_first.load(std::memory_order_acquire), write > EVENTS ? write - EVENTS : 0);
+
+  for (uint64_t index = first; index < write; index++)
+  {
+    const SEvent& event = m_events[index % EVENTS];
+    uint64_t seq = event.seq.load(std::memory_order_acquire);
+    int64_t time = event.time.load(std::memory_order_relaxed);
+    double pts = event.pts.load(std::memory_order_relaxed);
+    double value = event.value.load(std::memory_order_relaxed);
+    int type = event.type.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    // still being written, or overwritten by a writer that lapped us
+    if (seq != index + 1 || event.seq.load(std::memory_order_relaxed) != seq)
+      continue;
+
+    if (type == EVENT_MARK)
+    {
+      SFrame* frame = ring.Get(pts);
+      int stage = (int)value;
+      // a frame shown for several vsyncs or fields keeps its first time
+      if (stage >= 0 && stage < STAGE_MAX && frame->time[stage] == 0)
+        frame->time[stage] = time;
+    }
+    else if (type == EVENT_DROP)
+    {
+      SFrame* frame = ring.Get(pts);
+      if (frame->drop == DROP_NONE)
+        frame->drop = (EDrop)(int)value;
+    }
+    else if (type == EVENT_REKEY)
+    {
+      SFrame* frame = ring.Find(pts);
+      if (frame)
+        frame->pts = value;
+    }
+  }
+  return ring.GetFrames();
+}
+
+bool CDVDFrameTimeline::Export(const std::string& file) const
+{
+  CVariant events(CVariant::VariantTypeArray);
+
+  // name the rows of the trace after the stages
+  for (int i = 0; i < STAGE_MAX; i++)
+  {
+    CVariant meta(CVariant::VariantTypeObject);
+    meta["name"] = "thread_name";
+    meta["ph"] = "M";
+    meta["pid"] = 1;
+    meta["tid"] = i;
+    meta["args"]["name"] = GetStageName((EStage)i);
+    events.push_back(meta);
+  }
+
+  std::vector<SFrame> frames = GetFrames();
+  double frequency = (double)CurrentHostFrequency();
+  int64_t start = m_start.load(std::memory_order_relaxed);
+
+  for (const SFrame& frame : frames)
+  {
+    int64_t previous = 0;
+    int64_t last = 0;
+
+    // one slice per stage, spanning the time since the previous stage
+    for (int stage = 0; stage < STAGE_MAX; stage++)
+    {
+      if (frame.time[stage] == 0)
+        continue;
+
+      if (previous != 0)
+      {
+        CVariant slice(CVariant::VariantTypeObject);
+        slice["name"] = GetStageName((EStage)stage);
+        slice["ph"] = "X";
+        slice["pid"] = 1;
+        slice["tid"] = stage;
+        slice["ts"] = (double)(previous - start) * 1000000.0 / frequency;
+        slice["dur"] = (double)(frame.time[stage] - previous) * 1000000.0 / frequency;
+        slice["args"]["pts"] = DVD_TIME_TO_MSEC(frame.pts);
+        events.push_back(slice);
+      }
+      previous = frame.time[stage];
+      last = std::max(last, frame.time[stage]);
+    }
+
+    if (frame.drop != DROP_NONE && last != 0)
+    {
+      CVariant drop(CVariant::VariantTypeObject);
+      drop["name"] = std::string("drop: ") + GetDropName(frame.drop);
+      drop["ph"] = "i";
+      drop["s"] = "g";
+      drop["pid"] = 1;
+      drop["tid"] = 0;
+      drop["ts"] = (double)(last - start) * 1000000.0 / frequency;
+      drop["args"]["pts"] = DVD_TIME_TO_MSEC(frame.pts);
+      events.push_back(drop);
+    }
+  }
+
+  CVariant trace(CVariant::VariantTypeObject);
+  trace["traceEvents"] = events;
+  trace["displayTimeUnit"] = "ms";
+  std::string json = CJSONVariantWriter::Write(trace, true);
+
+  XFILE::CFile out;
+  if (!out.OpenForWrite(file, true) || out.Write(json.c_str(), json.size()) != (ssize_t)json.size())
+  {
+    CLog::Log(LOGERROR, "CDVDFrameTimeline::%s - unable to write %s", __FUNCTION__, file.c_str());
+    return false;
+  }
+  out.Close();
+
+  CLog::Log(LOGNOTICE, "CDVDFrameTimeline::%s - wrote %u frames to %s", __FUNCTION__, (unsigned int)frames.size(), file.c_str());
+  return true;
+}
+
+const char* CDVDFrameTimeline::GetStageName(EStage stage)
+{
+  switch (stage)
+  {
+    case STAGE_DEMUX:   return "demux";
+    case STAGE_DECODE:  return "decode";
+    case STAGE_QUEUE:   return "queue";
+    case STAGE_RENDER:  return "render";
+    case STAGE_PRESENT: return "present";
+    default:            return "unknown";
+  }
+}
+
+const char* CDVDFrameTimeline::GetDropName(EDrop reason)
+{
+  switch (reason)
+  {
+    case DROP_NONE:     return "none";
+    case DROP_PLAYER:   return "player";
+    case DROP_DECODER:  return "decoder";
+    case DROP_LATE:     return "late";
+    case DROP_NOBUFFER: return "no buffer";
+    case DROP_SKIPPED:  return "skipped";
+    case DROP_FLUSHED:  return "flushed";
+    default:            return "unknown";
+  }
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/*!
+ * \brief Ring buffer of per frame timestamps through the video pipeline.
+ *
+ * Every stage a video frame passes, from the demuxer to the first time it
+ * is on screen, stamps the frame with the host clock. Frames are identified
+ * by their pts, a frame that is dropped records the stage that dropped it.
+ * The last frames can be written out as a Chrome trace (load it in
+ * chrome://tracing) to see whether stutter was caused by reading, decoding
+ * or presenting.
+ *
+ * Recording is off unless enabled. The player, video and render threads
+ * append events to a shared ring without taking a lock, events are only
+ * put together into frames when the timeline is read.
+ */
+class CDVDFrameTimeline
+{
+public:
+  enum EStage
+  {
+    STAGE_DEMUX = 0,  //!< packet handed to the video thread
+    STAGE_DECODE,     //!< picture returned by the decoder
+    STAGE_QUEUE,      //!< picture queued in the render manager
+    STAGE_RENDER,     //!< picture picked for the next render
+    STAGE_PRESENT,    //!< picture rendered the first time
+    STAGE_MAX
+  };
+
+  enum EDrop
+  {
+    DROP_NONE = 0,
+    DROP_PLAYER,      //!< skipped by the player, e.g. after a seek
+    DROP_DECODER,     //!< dropped in the decoder to catch up
+    DROP_LATE,        //!< too late to output at the current speed
+    DROP_NOBUFFER,    //!< no render buffer became free in time
+    DROP_SKIPPED,     //!< render manager skipped it for a later frame
+    DROP_FLUSHED      //!< queued but discarded by a flush
+  };
+
+  struct SFrame
+  {
+    double pts;
+    int64_t time[STAGE_MAX];
+    EDrop drop;
+  };
+
+  static const int FRAMES = 2048;
+  static const int EVENTS = FRAMES * 4;
+
+  CDVDFrameTimeline();
+
+  /*!
+   * \brief Turn recording on or off, nothing is recorded while disabled
+   */
+  void SetEnabled(bool enabled);
+  bool IsEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+  /*!
+   * \brief Stamp the frame with the given pts with the current time
+   */
+  void Mark(double pts, EStage stage);
+
+  /*!
+   * \brief Record that the frame was dropped, the first reason is kept
+   */
+  void Drop(double pts, EDrop reason);
+
+  /*!
+   * \brief The frame formerly known by pts is now known by newPts
+   */
+  void Rekey(double pts, double newPts);
+
+  /*!
+   * \brief Forget all frames recorded so far, e.g. after a flush or seek
+   */
+  void Reset();
+
+  /*!
+   * \brief Get the recorded frames, oldest first
+   */
+  std::vector<SFrame> GetFrames() const;
+
+  /*!
+   * \brief Write the recorded frames as Chrome trace JSON
+   * \return false if the file could not be written
+   */
+  bool Export(const std::string& file) const;
+
+  static const char* GetStageName(EStage stage);
+  static const char* GetDropName(EDrop reason);
+
+private:
+  enum EEvent
+  {
+    EVENT_MARK = 0,
+    EVENT_DROP,
+    EVENT_REKEY
+  };
+
+  /*!
+   * \brief A slot of the event ring. seq is the index the slot was last
+   * written for plus one, 0 while a writer is filling it.
+   */
+  struct SEvent
+  {
+    std::atomic<uint64_t> seq;
+    std::atomic<int64_t> time;
+    std::atomic<double> pts;
+    std::atomic<double> value;
+    std::atomic<int> type;
+  };
+
+  void Push(EEvent type, double pts, double value, int64_t time);
+
+  std::atomic<bool> m_enabled;
+  std::unique_ptr<SEvent[]> m_events;
+  std::atomic<uint64_t> m_write;
+  std::atomic<uint64_t> m_first;
+  std::atomic<int64_t> m_start;
+};
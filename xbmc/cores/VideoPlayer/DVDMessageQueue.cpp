@@ -25,7 +25,16 @@
 #include "DVDClock.h"
 #include "utils/MathUtils.h"
 
-CDVDMessageQueue::CDVDMessageQueue(const std::string &owner) : m_hEvent(true), m_owner(owner)
+#define RING_INITIAL_SIZE 256
+
+CDVDMessageQueue::CDVDMessageQueue(const std::string &owner, bool ring)
+  : m_hEvent(true)
+  , m_owner(owner)
+  , m_ring(ring)
+  , m_ringHead(0)
+  , m_ringTail(0)
+  , m_lockedCount(0)
+  , m_waiting(false)
 {
   m_iDataSize     = 0;
   m_bAbortRequest = false;
@@ -35,6 +44,9 @@ CDVDMessageQueue::CDVDMessageQueue(const std::string &owner) : m_hEvent(true), m
   m_TimeFront = DVD_NOPTS_VALUE;
   m_TimeSize = 1.0 / 4.0; /* 4 seconds */
   m_iMaxDataSize = 0;
+
+  if (m_ring)
+    m_ringSlots.resize(RING_INITIAL_SIZE, nullptr);
 }
 
 CDVDMessageQueue::~CDVDMessageQueue()
@@ -54,8 +66,14 @@ void CDVDMessageQueue::Init()
 
 void CDVDMessageQueue::Flush(CDVDMsg::Message type)
 {
+  // the ring is only touched from outside while both sides are locked
+  CSingleLock producerLock(m_producerSection);
+  CSingleLock consumerLock(m_consumerSection);
   CSingleLock lock(m_section);
 
+  if (m_ring)
+    FlushRing(type);
+
   m_messages.remove_if([type](const DVDMessageListItem &item){
     return type == CDVDMsg::NONE || item.message->IsType(type);
   });
@@ -64,6 +82,8 @@ void CDVDMessageQueue::Flush(CDVDMsg::Message type)
     return type == CDVDMsg::NONE || item.message->IsType(type);
   });
 
+  m_lockedCount = (int)(m_messages.size() + m_prioMessages.size());
+
   if (type == CDVDMsg::DEMUXER_PACKET ||  type == CDVDMsg::NONE)
   {
     m_iDataSize = 0;
@@ -84,6 +104,8 @@ void CDVDMessageQueue::Abort()
 
 void CDVDMessageQueue::End()
 {
+  CSingleLock producerLock(m_producerSection);
+  CSingleLock consumerLock(m_consumerSection);
   CSingleLock lock(m_section);
 
   Flush(CDVDMsg::NONE);
@@ -95,6 +117,10 @@ void CDVDMessageQueue::End()
 
 MsgQueueReturnCode CDVDMessageQueue::Put(CDVDMsg* pMsg, int priority, bool front)
 {
+  // the ring refuses messages once the queue has ended, the locked path reports it
+  if (m_ring && priority == 0 && front && pMsg && PutRing(pMsg))
+    return MSGQ_OK;
+
   CSingleLock lock(m_section);
 
   if (!m_bInitialized)
@@ -128,8 +154,22 @@ MsgQueueReturnCode CDVDMessageQueue::Put(CDVDMsg* pMsg, int priority, bool front
     else
       m_messages.emplace_back(pMsg, priority);
   }
+  m_lockedCount++;
+
+  if (priority == 0)
+    AddDataSize(pMsg);
+
+  pMsg->Release();
 
-  if (pMsg->IsType(CDVDMsg::DEMUXER_PACKET) && priority == 0)
+  // inform waiter for new packet
+  m_hEvent.Set();
+
+  return MSGQ_OK;
+}
+
+void CDVDMessageQueue::AddDataSize(CDVDMsg* pMsg)
+{
+  if (pMsg->IsType(CDVDMsg::DEMUXER_PACKET))
   {
     DemuxPacket* packet = ((CDVDMsgDemuxerPacket*)pMsg)->GetPacket();
     if (packet)
@@ -140,21 +180,33 @@ MsgQueueReturnCode CDVDMessageQueue::Put(CDVDMsg* pMsg, int priority, bool front
       else if (packet->pts != DVD_NOPTS_VALUE)
         m_TimeFront = packet->pts;
 
-      if (m_TimeBack == DVD_NOPTS_VALUE)
-        m_TimeBack = m_TimeFront;
+      double back = DVD_NOPTS_VALUE;
+      m_TimeBack.compare_exchange_strong(back, m_TimeFront);
     }
   }
+}
 
-  pMsg->Release();
-
-  // inform waiter for new packet
-  m_hEvent.Set();
-
-  return MSGQ_OK;
+void CDVDMessageQueue::RemoveDataSize(CDVDMsg* pMsg)
+{
+  if (pMsg->IsType(CDVDMsg::DEMUXER_PACKET))
+  {
+    DemuxPacket* packet = ((CDVDMsgDemuxerPacket*)pMsg)->GetPacket();
+    if (packet)
+    {
+      m_iDataSize -= packet->iSize;
+      if (packet->dts != DVD_NOPTS_VALUE)
+        m_TimeBack = packet->dts;
+      else if (packet->pts != DVD_NOPTS_VALUE)
+        m_TimeBack = packet->pts;
+    }
+  }
 }
 
 MsgQueueReturnCode CDVDMessageQueue::Get(CDVDMsg** pMsg, unsigned int iTimeoutInMilliSeconds, int &priority)
 {
+  if (m_ring)
+    return GetRing(pMsg, iTimeoutInMilliSeconds, priority);
+
   CSingleLock lock(m_section);
 
   *pMsg = NULL;
@@ -176,21 +228,12 @@ MsgQueueReturnCode CDVDMessageQueue::Get(CDVDMsg** pMsg, unsigned int iTimeoutIn
       DVDMessageListItem& item(msgs.back());
       priority = item.priority;
 
-      if (item.message->IsType(CDVDMsg::DEMUXER_PACKET) && item.priority == 0)
-      {
-        DemuxPacket* packet = ((CDVDMsgDemuxerPacket*)item.message)->GetPacket();
-        if (packet)
-        {
-          m_iDataSize -= packet->iSize;
-          if (packet->dts != DVD_NOPTS_VALUE)
-            m_TimeBack = packet->dts;
-          else if (packet->pts != DVD_NOPTS_VALUE)
-            m_TimeBack = packet->pts;
-        }
-      }
+      if (item.priority == 0)
+        RemoveDataSize(item.message);
 
       *pMsg = item.message->Acquire();
       msgs.pop_back();
+      m_lockedCount--;
 
       ret = MSGQ_OK;
       break;
@@ -221,12 +264,23 @@ MsgQueueReturnCode CDVDMessageQueue::Get(CDVDMsg** pMsg, unsigned int iTimeoutIn
 
 unsigned CDVDMessageQueue::GetPacketCount(CDVDMsg::Message type)
 {
+  CSingleLock producerLock(m_producerSection);
+  CSingleLock consumerLock(m_consumerSection);
   CSingleLock lock(m_section);
 
   if (!m_bInitialized)
     return 0;
 
   unsigned count = 0;
+  if (m_ring)
+  {
+    const size_t mask = m_ringSlots.size() - 1;
+    for (size_t i = m_ringHead; i != m_ringTail; i++)
+    {
+      if (m_ringSlots[i & mask]->IsType(type))
+        count++;
+    }
+  }
   for (const auto &item : m_messages)
   {
     if(item.message->IsType(type))
@@ -290,3 +344,171 @@ bool CDVDMessageQueue::IsDataBased() const
           m_TimeFront == DVD_NOPTS_VALUE ||
           m_TimeFront <= m_TimeBack);
 }
+
+bool CDVDMessageQueue::PutRing(CDVDMsg* pMsg)
+{
+  CSingleLock lock(m_producerSection);
+
+  // End() holds the producer lock while it tears the queue down
+  if (!m_bInitialized)
+    return false;
+
+  AddDataSize(pMsg);
+
+  size_t tail = m_ringTail.load(std::memory_order_relaxed);
+  if (tail - m_ringHead.load(std::memory_order_acquire) == m_ringSlots.size())
+  {
+    GrowRing();
+    tail = m_ringTail.load(std::memory_order_relaxed);
+  }
+
+  m_ringSlots[tail & (m_ringSlots.size() - 1)] = pMsg;
+  m_ringTail.store(tail + 1);
+
+  // only wake up the consumer if it is waiting, see GetRing
+  if (m_waiting.exchange(false))
+    m_hEvent.Set();
+
+  return true;
+}
+
+void CDVDMessageQueue::GrowRing()
+{
+  // called with the producer lock held, the consumer must not touch the slots
+  // while they are being moved
+  CSingleLock consumerLock(m_consumerSection);
+
+  size_t head = m_ringHead.load();
+  size_t tail = m_ringTail.load();
+  const size_t mask = m_ringSlots.size() - 1;
+
+  std::vector<CDVDMsg*> slots(m_ringSlots.size() * 2, nullptr);
+  for (size_t i = head; i != tail; i++)
+    slots[i - head] = m_ringSlots[i & mask];
+
+  m_ringSlots.swap(slots);
+  m_ringHead = 0;
+  m_ringTail = tail - head;
+
+  CLog::Log(LOGDEBUG, "CDVDMessageQueue(%s)::GrowRing - new size %d", m_owner.c_str(), (int)m_ringSlots.size());
+}
+
+CDVDMsg* CDVDMessageQueue::PopRing()
+{
+  // called with the consumer lock held
+  size_t head = m_ringHead.load(std::memory_order_relaxed);
+  if (head == m_ringTail.load(std::memory_order_acquire))
+    return nullptr;
+
+  CDVDMsg* pMsg = m_ringSlots[head & (m_ringSlots.size() - 1)];
+  m_ringHead.store(head + 1, std::memory_order_release);
+
+  RemoveDataSize(pMsg);
+  return pMsg;
+}
+
+bool CDVDMessageQueue::IsRingEmpty() const
+{
+  return m_ringHead.load() == m_ringTail.load();
+}
+
+void CDVDMessageQueue::FlushRing(CDVDMsg::Message type)
+{
+  // called with all locks held, compact the remaining messages in place
+  const size_t mask = m_ringSlots.size() - 1;
+  size_t head = m_ringHead;
+  size_t tail = m_ringTail;
+  size_t keep = head;
+
+  for (size_t i = head; i != tail; i++)
+  {
+    CDVDMsg* pMsg = m_ringSlots[i & mask];
+    if (type == CDVDMsg::NONE || pMsg->IsType(type))
+      pMsg->Release();
+    else
+      m_ringSlots[keep++ & mask] = pMsg;
+  }
+  m_ringTail = keep;
+}
+
+MsgQueueReturnCode CDVDMessageQueue::GetRing(CDVDMsg** pMsg, unsigned int iTimeoutInMilliSeconds, int &priority)
+{
+  CSingleLock consumerLock(m_consumerSection);
+
+  *pMsg = NULL;
+
+  if (!m_bInitialized)
+  {
+    CLog::Log(LOGFATAL, "CDVDMessageQueue(%s)::Get MSGQ_NOT_INITIALIZED", m_owner.c_str());
+    return MSGQ_NOT_INITIALIZED;
+  }
+
+  while (!m_bAbortRequest)
+  {
+    // messages put back by the consumer are older than anything in the ring,
+    // priority messages take precedence over both
+    if (priority > 0 || m_lockedCount > 0)
+    {
+      CSingleLock lock(m_section);
+
+      std::list<DVDMessageListItem> *msgs = nullptr;
+      if (priority > 0 || !m_prioMessages.empty())
+        msgs = &m_prioMessages;
+      else if (!m_messages.empty())
+        msgs = &m_messages;
+
+      if (msgs && !msgs->empty() && msgs->back().priority >= priority)
+      {
+        DVDMessageListItem& item(msgs->back());
+        priority = item.priority;
+
+        if (item.priority == 0)
+          RemoveDataSize(item.message);
+
+        *pMsg = item.message->Acquire();
+        msgs->pop_back();
+        m_lockedCount--;
+        return MSGQ_OK;
+      }
+    }
+
+    if (priority == 0)
+    {
+      *pMsg = PopRing();
+      if (*pMsg)
+        return MSGQ_OK;
+    }
+
+    if (!iTimeoutInMilliSeconds)
+      return MSGQ_TIMEOUT;
+
+    {
+      // a put to the locked lists is serialized by m_section, a put to the ring
+      // either sees m_waiting or is seen by the check below
+      CSingleLock lock(m_section);
+      m_hEvent.Reset();
+      m_waiting = true;
+
+      bool available;
+      if (priority > 0 || !m_prioMessages.empty())
+        available = !m_prioMessages.empty() && m_prioMessages.back().priority >= priority;
+      else
+        available = !m_messages.empty() || !IsRingEmpty();
+
+      if (available || m_bAbortRequest)
+      {
+        m_waiting = false;
+        continue;
+      }
+    }
+
+    consumerLock.Leave();
+    bool signaled = m_hEvent.WaitMSec(iTimeoutInMilliSeconds);
+    m_waiting = false;
+    if (!signaled)
+      return MSGQ_TIMEOUT;
+    consumerLock.Enter();
+  }
+
+  return MSGQ_ABORT;
+}
@@ -21,8 +21,10 @@
  */
 
 #include "DVDMessage.h"
+#include <atomic>
 #include <string>
 #include <list>
+#include <vector>
 #include <algorithm>
 #include "threads/CriticalSection.h"
 #include "threads/Event.h"
@@ -64,10 +66,21 @@ enum MsgQueueReturnCode
 
 #define MSGQ_IS_ERROR(c)    (c < 0)
 
+/**
+ * Queue for passing messages to a stream player thread.
+ *
+ * In ring mode normal (priority 0) messages put to the front are stored in a
+ * ring buffer instead of a list. Producer and consumer synchronize through the
+ * ring indices only, each side takes its own lock which is uncontended unless
+ * several threads produce or the queue is flushed. The ring grows on demand,
+ * once it reached its working size no memory is allocated per message and the
+ * consumer is only signalled if it is actually waiting. Priority messages and
+ * messages put back by the consumer still go through the locked lists.
+ */
 class CDVDMessageQueue
 {
 public:
-  CDVDMessageQueue(const std::string &owner);
+  CDVDMessageQueue(const std::string &owner, bool ring = false);
   virtual ~CDVDMessageQueue();
 
   void Init();
@@ -90,6 +103,7 @@ public:
   }
 
   int GetDataSize() const { return m_iDataSize; }
+  bool IsRing() const { return m_ring; }
   int GetTimeSize() const;
   unsigned GetPacketCount(CDVDMsg::Message type);
   bool ReceivedAbortRequest() { return m_bAbortRequest; }
@@ -108,15 +122,26 @@ public:
 
 private:
 
+  void AddDataSize(CDVDMsg* pMsg);
+  void RemoveDataSize(CDVDMsg* pMsg);
+
+  // ring mode
+  MsgQueueReturnCode GetRing(CDVDMsg** pMsg, unsigned int iTimeoutInMilliSeconds, int &priority);
+  bool PutRing(CDVDMsg* pMsg);
+  CDVDMsg* PopRing();
+  bool IsRingEmpty() const;
+  void GrowRing();
+  void FlushRing(CDVDMsg::Message type);
+
   CEvent m_hEvent;
   mutable CCriticalSection m_section;
 
   bool m_bAbortRequest;
-  bool m_bInitialized;
+  std::atomic<bool> m_bInitialized;   // End() clears it with all locks held, see PutRing
 
-  int m_iDataSize;
-  double m_TimeFront;
-  double m_TimeBack;
+  std::atomic<int> m_iDataSize;
+  std::atomic<double> m_TimeFront;
+  std::atomic<double> m_TimeBack;
   double m_TimeSize;
 
   int m_iMaxDataSize;
@@ -124,5 +149,14 @@ private:
 
   std::list<DVDMessageListItem> m_messages;
   std::list<DVDMessageListItem> m_prioMessages;
+
+  const bool m_ring;
+  mutable CCriticalSection m_producerSection;
+  mutable CCriticalSection m_consumerSection;
+  std::vector<CDVDMsg*> m_ringSlots;
+  std::atomic<size_t> m_ringHead;     // next slot to read, owned by the consumer
+  std::atomic<size_t> m_ringTail;     // next slot to write, owned by the producer
+  std::atomic<int> m_lockedCount;     // messages in m_messages and m_prioMessages
+  std::atomic<bool> m_waiting;        // consumer is about to wait for the event
 };
 
@@ -0,0 +1,213 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DVDPrefetch.h"
+#include "system.h"
+
+#include "DVDInputStreams/DVDFactoryInputStream.h"
+#include "DVDInputStreams/DVDInputStream.h"
+#include "DVDDemuxers/DVDDemux.h"
+#include "DVDDemuxers/DVDFactoryDemuxer.h"
+#include "FileItem.h"
+#include "URL.h"
+#include "threads/SingleLock.h"
+#include "utils/Job.h"
+#include "utils/JobManager.h"
+#include "utils/log.h"
+
+class CDVDPrefetchJob : public CJob
+{
+public:
+  CDVDPrefetchJob(const CFileItem& item, unsigned int generation)
+    : m_item(item), m_generation(generation) {}
+
+  virtual bool DoWork()
+  {
+    CDVDPrefetch::GetInstance().Open(m_item, m_generation);
+    return true;
+  }
+
+private:
+  CFileItem m_item;
+  unsigned int m_generation;
+};
+
+CDVDPrefetch& CDVDPrefetch::GetInstance()
+{
+  static CDVDPrefetch instance;
+  return instance;
+}
+
+CDVDPrefetch::CDVDPrefetch()
+  : m_done(true, true)
+  , m_generation(0)
+  , m_pending(false)
+  , m_inputStream(nullptr)
+  , m_demuxer(nullptr)
+{
+}
+
+CDVDPrefetch::~CDVDPrefetch()
+{
+  delete m_demuxer;
+  delete m_inputStream;
+}
+
+void CDVDPrefetch::Prefetch(const CFileItem& item)
+{
+  CDVDInputStream* inputStream;
+  CDVDDemux* demuxer;
+  {
+    CSingleLock lock(m_critSection);
+    if (m_path == item.GetPath())
+      return;
+
+    inputStream = m_inputStream;
+    demuxer = m_demuxer;
+    Release();
+
+    m_path = item.GetPath();
+    m_pending = true;
+    m_done.Reset();
+    CLog::Log(LOGDEBUG, "CDVDPrefetch::%s - prefetching %s", __FUNCTION__, CURL::GetRedacted(m_path).c_str());
+    CJobManager::GetInstance().AddJob(new CDVDPrefetchJob(item, m_generation), nullptr, CJob::PRIORITY_NORMAL);
+  }
+
+  delete demuxer;
+  delete inputStream;
+}
+
+bool CDVDPrefetch::Take(const CFileItem& item, CDVDInputStream*& inputStream, CDVDDemux*& demuxer)
+{
+  CSingleLock lock(m_critSection);
+  if (m_path.empty())
+    return false;
+
+  if (m_path != item.GetPath())
+  {
+    lock.Leave();
+    Clear();
+    return false;
+  }
+
+  unsigned int generation = m_generation;
+  if (m_pending)
+  {
+    CLog::Log(LOGDEBUG, "CDVDPrefetch::%s - waiting for prefetch of %s", __FUNCTION__, CURL::GetRedacted(m_path).c_str());
+    CSingleExit exit(m_critSection);
+    m_done.Wait();
+  }
+
+  if (generation != m_generation)
+    return false;
+
+  if (!m_inputStream)
+  {
+    Release();
+    return false;
+  }
+
+  inputStream = m_inputStream;
+  demuxer = m_demuxer;
+  m_inputStream = nullptr;
+  m_demuxer = nullptr;
+  Release();
+
+  CLog::Log(LOGNOTICE, "CDVDPrefetch::%s - using prefetched input of %s", __FUNCTION__, CURL::GetRedacted(item.GetPath()).c_str());
+  return true;
+}
+
+void CDVDPrefetch::Clear()
+{
+  CDVDInputStream* inputStream;
+  CDVDDemux* demuxer;
+  {
+    CSingleLock lock(m_critSection);
+    if (m_path.empty())
+      return;
+
+    inputStream = m_inputStream;
+    demuxer = m_demuxer;
+    Release();
+  }
+
+  // closing can block on network shares, don't hold the lock
+  delete demuxer;
+  delete inputStream;
+}
+
+void CDVDPrefetch::Release()
+{
+  // the caller takes care of deleting input stream and demuxer
+  m_inputStream = nullptr;
+  m_demuxer = nullptr;
+  m_path.clear();
+  m_pending = false;
+  m_generation++;
+  m_done.Set();
+}
+
+void CDVDPrefetch::Open(const CFileItem& item, unsigned int generation)
+{
+  {
+    CSingleLock lock(m_critSection);
+    if (generation != m_generation)
+      return;
+  }
+
+  CDVDDemux* demuxer = nullptr;
+  CDVDInputStream* inputStream = CDVDFactoryInputStream::CreateInputStream(nullptr, item, true);
+  if (inputStream && !inputStream->IsStreamType(DVDSTREAM_TYPE_FILE))
+  {
+    // anything but a plain file may need the player, leave it to VideoPlayer
+    CLog::Log(LOGDEBUG, "CDVDPrefetch::%s - not prefetching %s", __FUNCTION__, CURL::GetRedacted(item.GetPath()).c_str());
+    SAFE_DELETE(inputStream);
+  }
+  else if (inputStream && !inputStream->Open())
+  {
+    CLog::Log(LOGERROR, "CDVDPrefetch::%s - error opening %s", __FUNCTION__, CURL::GetRedacted(item.GetPath()).c_str());
+    SAFE_DELETE(inputStream);
+  }
+  else if (inputStream)
+  {
+    demuxer = CDVDFactoryDemuxer::CreateDemuxer(inputStream);
+    if (!demuxer)
+    {
+      CLog::Log(LOGERROR, "CDVDPrefetch::%s - error creating demuxer for %s", __FUNCTION__, CURL::GetRedacted(item.GetPath()).c_str());
+      SAFE_DELETE(inputStream);
+    }
+  }
+
+  {
+    CSingleLock lock(m_critSection);
+    if (generation == m_generation)
+    {
+      m_inputStream = inputStream;
+      m_demuxer = demuxer;
+      m_pending = false;
+      m_done.Set();
+      return;
+    }
+  }
+
+  // discarded while we were opening
+  delete demuxer;
+  delete inputStream;
+}
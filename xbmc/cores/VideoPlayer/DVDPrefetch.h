@@ -0,0 +1,84 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "threads/CriticalSection.h"
+#include "threads/Event.h"
+
+#include <string>
+
+class CFileItem;
+class CDVDInputStream;
+class CDVDDemux;
+
+/*!
+ * \brief Opens the input stream and demuxer of an upcoming item in the background.
+ *
+ * While the current item is playing, the next playlist entry can be pre-opened
+ * so its input stream is connected, the demuxer has probed the streams and the
+ * file cache has started filling by the time VideoPlayer needs it. Only plain
+ * file input streams are prefetched; everything that needs a player to be opened
+ * (menus, pvr, addons, external audio) is left to VideoPlayer.
+ *
+ * At most one item is held at a time, prefetching another item discards it.
+ */
+class CDVDPrefetch
+{
+public:
+  static CDVDPrefetch& GetInstance();
+
+  /*!
+   * \brief Start opening item in the background, does nothing if item is
+   * already being prefetched
+   */
+  void Prefetch(const CFileItem& item);
+
+  /*!
+   * \brief Hand over the prefetched input stream and demuxer of item.
+   * Waits for a prefetch of item which is still in progress. On success the
+   * caller owns both objects.
+   * \return false if item was not prefetched or could not be opened
+   */
+  bool Take(const CFileItem& item, CDVDInputStream*& inputStream, CDVDDemux*& demuxer);
+
+  /*!
+   * \brief Drop a prefetched item, a prefetch in progress is discarded once done
+   */
+  void Clear();
+
+private:
+  CDVDPrefetch();
+  ~CDVDPrefetch();
+  CDVDPrefetch(const CDVDPrefetch&) = delete;
+  CDVDPrefetch& operator=(const CDVDPrefetch&) = delete;
+
+  friend class CDVDPrefetchJob;
+  void Open(const CFileItem& item, unsigned int generation);
+  void Release();
+
+  CCriticalSection m_critSection;
+  CEvent m_done;
+  std::string m_path;
+  unsigned int m_generation;
+  bool m_pending;
+  CDVDInputStream* m_inputStream;
+  CDVDDemux* m_demuxer;
+};
@@ -61,6 +61,9 @@ struct SPlayerState
     cache_level   = 0.0;
     cache_delay   = 0.0;
     cache_offset  = 0.0;
+    cache_target  = 0;
+    cache_readrate = 0;
+    cache_srcrate = 0;
   }
 
   int    player;            // source of this data
@@ -89,6 +92,9 @@ struct SPlayerState
   double  cache_level;   // current estimated required cache level
   double  cache_delay;   // time until cache is expected to reach estimated level
   double  cache_offset;  // percentage of file ahead of current position
+  int64_t cache_target;  // number of bytes the cache tries to keep ahead
+  unsigned int cache_readrate; // bytes per second the cache is filled for
+  unsigned int cache_srcrate;  // bytes per second the source delivers
 };
 
 struct SStartMsg
@@ -29,11 +29,13 @@
 
 #include "DVDDemuxers/DVDDemux.h"
 #include "DVDDemuxers/DVDDemuxUtils.h"
+#include "DVDDemuxers/DemuxPacketPool.h"
 #include "DVDDemuxers/DVDDemuxVobsub.h"
 #include "DVDDemuxers/DVDFactoryDemuxer.h"
 #include "DVDDemuxers/DVDDemuxFFmpeg.h"
 
 #include "DVDFileInfo.h"
+#include "DVDPrefetch.h"
 
 #include "utils/LangCodeExpander.h"
 #include "input/Key.h"
@@ -74,6 +76,7 @@
 #include "Util.h"
 #include "LangInfo.h"
 #include "URL.h"
+#include "XBDateTime.h"
 
 #ifdef HAS_OMXPLAYER
 #include "cores/omxplayer/OMXPlayerAudio.h"
@@ -623,6 +626,7 @@ CVideoPlayer::CVideoPlayer(IPlayerCallback& callback)
 {
   m_players_created = false;
   m_pDemuxer = NULL;
+  m_pPrefetchDemuxer = NULL;
   m_pSubtitleDemuxer = NULL;
   m_pCCDemuxer = NULL;
   m_pInputStream = NULL;
@@ -631,6 +635,7 @@ CVideoPlayer::CVideoPlayer(IPlayerCallback& callback)
   m_State.Clear();
   m_EdlAutoSkipMarkers.Clear();
   m_UpdateApplication = 0;
+  m_readRate = 0;
 
   m_bAbortRequest = false;
   m_errorCount = 0;
@@ -702,6 +707,8 @@ bool CVideoPlayer::OpenFile(const CFileItem& file, const CPlayerOptions &options
   m_ready.Reset();
 
   m_renderManager.PreInit();
+  m_renderManager.GetFrameTimeline().SetEnabled(g_advancedSettings.m_videoFrameTimeline);
+  m_renderManager.GetFrameTimeline().Reset();
 
   Create();
 
@@ -783,17 +790,22 @@ bool CVideoPlayer::OpenInputStream()
     m_item.SetPath(g_mediaManager.TranslateDevicePath(""));
   }
 
-  m_pInputStream = CDVDFactoryInputStream::CreateInputStream(this, m_item, true);
-  if(m_pInputStream == NULL)
+  // the next item of a playlist may have been opened while the previous one was playing
+  SAFE_DELETE(m_pPrefetchDemuxer);
+  if (!CDVDPrefetch::GetInstance().Take(m_item, m_pInputStream, m_pPrefetchDemuxer))
   {
-    CLog::Log(LOGERROR, "CVideoPlayer::OpenInputStream - unable to create input stream for [%s]", m_item.GetPath().c_str());
-    return false;
-  }
+    m_pInputStream = CDVDFactoryInputStream::CreateInputStream(this, m_item, true);
+    if(m_pInputStream == NULL)
+    {
+      CLog::Log(LOGERROR, "CVideoPlayer::OpenInputStream - unable to create input stream for [%s]", m_item.GetPath().c_str());
+      return false;
+    }
 
-  if (!m_pInputStream->Open())
-  {
-    CLog::Log(LOGERROR, "CVideoPlayer::OpenInputStream - error opening [%s]", m_item.GetPath().c_str());
-    return false;
+    if (!m_pInputStream->Open())
+    {
+      CLog::Log(LOGERROR, "CVideoPlayer::OpenInputStream - error opening [%s]", m_item.GetPath().c_str());
+      return false;
+    }
   }
 
   // find any available external subtitles for non dvd files
@@ -848,8 +860,12 @@ bool CVideoPlayer::OpenDemuxStream()
 
   CLog::Log(LOGNOTICE, "Creating Demuxer");
 
+  // a prefetched demuxer has already probed the streams
+  m_pDemuxer = m_pPrefetchDemuxer;
+  m_pPrefetchDemuxer = NULL;
+
   int attempts = 10;
-  while(!m_bStop && attempts-- > 0)
+  while(!m_pDemuxer && !m_bStop && attempts-- > 0)
   {
     m_pDemuxer = CDVDFactoryDemuxer::CreateDemuxer(m_pInputStream);
     if(!m_pDemuxer && m_pInputStream->IsStreamType(DVDSTREAM_TYPE_PVRMANAGER))
@@ -876,8 +892,12 @@ bool CVideoPlayer::OpenDemuxStream()
 
   int64_t len = m_pInputStream->GetLength();
   int64_t tim = m_pDemuxer->GetStreamLength();
+  m_readRate = 0;
   if(len > 0 && tim > 0)
-    m_pInputStream->SetReadRate((unsigned int) (len * 1000 / tim));
+  {
+    m_readRate = (unsigned int) (len * 1000 / tim);
+    m_pInputStream->SetReadRate(m_readRate);
+  }
 
   m_offset_pts = 0;
 
@@ -1393,6 +1413,9 @@ void CVideoPlayer::Process()
     // update player state
     UpdatePlayState(200);
 
+    // let the cache follow the bitrate we actually consume
+    UpdateReadRate();
+
     // update application with our state
     UpdateApplication(1000);
 
@@ -1726,6 +1749,11 @@ void CVideoPlayer::ProcessVideoData(CDemuxStream* pStream, DemuxPacket* pPacket)
   if (CheckSceneSkip(m_CurrentVideo))
     drop = true;
 
+  CDVDFrameTimeline& timeline = m_renderManager.GetFrameTimeline();
+  timeline.Mark(pPacket->pts, CDVDFrameTimeline::STAGE_DEMUX);
+  if (drop)
+    timeline.Drop(pPacket->pts, CDVDFrameTimeline::DROP_PLAYER);
+
   m_VideoPlayerVideo->SendMessage(new CDVDMsgDemuxerPacket(pPacket, drop));
   m_CurrentVideo.packets++;
 }
@@ -2423,6 +2451,7 @@ void CVideoPlayer::OnExit()
 
     // destroy objects
     SAFE_DELETE(m_pDemuxer);
+    SAFE_DELETE(m_pPrefetchDemuxer);
     SAFE_DELETE(m_pSubtitleDemuxer);
     SAFE_DELETE(m_pCCDemuxer);
     SAFE_DELETE(m_pInputStream);
@@ -2432,6 +2461,9 @@ void CVideoPlayer::OnExit()
 
     m_messenger.End();
 
+    // all queues are empty now, give back the memory of recycled packets
+    CDemuxPacketPool::GetInstance().Purge();
+
     if (m_omxplayer_mode)
     {
       m_OmxPlayerState.av_clock.OMXStop();
@@ -3183,6 +3215,11 @@ void CVideoPlayer::GetGeneralInfo(std::string& strGeneralInfo)
                                       , m_State.cache_level * 100);
         if(m_playSpeed == 0 || m_caching == CACHESTATE_FULL)
           strBuf += StringUtils::Format(" %d msec", DVD_TIME_TO_MSEC(m_State.cache_delay));
+        if(m_State.cache_target > 0)
+          strBuf += StringUtils::Format(", target:%s, source:%.1f need:%.1f Mbit/s"
+                                        , StringUtils::SizeToString(m_State.cache_target).c_str()
+                                        , m_State.cache_srcrate * 8.0 / 1000000
+                                        , m_State.cache_readrate * 8.0 / 1000000);
       }
 
       strGeneralInfo = StringUtils::Format("Player: a/v:% 6.3f, %s"
@@ -3835,6 +3872,8 @@ void CVideoPlayer::FlushBuffers(bool queued, double pts, bool accurate, bool syn
 {
   CLog::Log(LOGDEBUG, "CVideoPlayer::FlushBuffers - flushing buffers");
 
+  m_renderManager.GetFrameTimeline().Reset();
+
   double startpts;
   if (accurate && !m_omxplayer_mode)
     startpts = pts;
@@ -4432,6 +4471,18 @@ bool CVideoPlayer::OnAction(const CAction &action)
     case ACTION_SHOW_CODEC:
       m_renderManager.ToggleDebug();
       break;
+    case ACTION_EXPORT_FRAMETRACE:
+    {
+      if (!m_renderManager.GetFrameTimeline().IsEnabled())
+      {
+        CLog::Log(LOGWARNING, "CVideoPlayer::OnAction - enable <video><frametimeline> in advancedsettings.xml to export a frame trace");
+        return true;
+      }
+      std::string file = StringUtils::Format("special://temp/frametrace-%s.json",
+                                             CDateTime::GetCurrentDateTime().GetAsSaveString().c_str());
+      m_renderManager.GetFrameTimeline().Export(file);
+      return true;
+    }
   }
 
   // return false to inform the caller we didn't handle the message
@@ -4795,9 +4846,17 @@ void CVideoPlayer::UpdatePlayState(double timeout)
     state.cache_bytes = status.forward;
     if(state.time_total)
       state.cache_bytes += m_pInputStream->GetLength() * (int64_t) (GetQueueTime() / state.time_total);
+    state.cache_target  = status.target;
+    state.cache_readrate = status.maxrate;
+    state.cache_srcrate = status.srcrate;
   }
   else
+  {
     state.cache_bytes = 0;
+    state.cache_target = 0;
+    state.cache_readrate = 0;
+    state.cache_srcrate = 0;
+  }
 
   state.timestamp = m_clock.GetAbsoluteClock();
 
@@ -4805,6 +4864,23 @@ void CVideoPlayer::UpdatePlayState(double timeout)
   m_State = state;
 }
 
+void CVideoPlayer::UpdateReadRate()
+{
+  if (!m_pDemuxer || !m_pInputStream)
+    return;
+
+  unsigned int rate = m_pDemuxer->GetReadRate();
+  if (rate == 0)
+    return;
+
+  // ignore small changes, every update is passed down to the cache
+  if (rate > m_readRate * 1.1 || rate < m_readRate * 0.9)
+  {
+    m_readRate = rate;
+    m_pInputStream->SetReadRate(rate);
+  }
+}
+
 void CVideoPlayer::UpdateApplication(double timeout)
 {
   if(m_UpdateApplication != 0
@@ -435,10 +435,12 @@ protected:
 
   void UpdateApplication(double timeout);
   void UpdatePlayState(double timeout);
+  void UpdateReadRate();
   void UpdateStreamInfos();
   void GetGeneralInfo(std::string& strVideoInfo);
 
   double m_UpdateApplication;
+  unsigned int m_readRate;
 
   bool m_players_created;
   bool m_bAbortRequest;
@@ -483,6 +485,7 @@ protected:
 
   CDVDInputStream* m_pInputStream;  // input stream for current playing file
   CDVDDemux* m_pDemuxer;            // demuxer for current playing file
+  CDVDDemux* m_pPrefetchDemuxer;    // demuxer handed over by CDVDPrefetch, used by OpenDemuxStream
   CDVDDemux* m_pSubtitleDemuxer;
   CDVDDemuxCC* m_pCCDemuxer;
 
@@ -58,7 +58,7 @@ public:
 
 CVideoPlayerAudio::CVideoPlayerAudio(CDVDClock* pClock, CDVDMessageQueue& parent, CProcessInfo &processInfo)
 : CThread("VideoPlayerAudio"), IDVDStreamPlayerAudio(processInfo)
-, m_messageQueue("audio")
+, m_messageQueue("audio", true)
 , m_messageParent(parent)
 , m_dvdAudio(pClock)
 {
@@ -65,7 +65,7 @@ CVideoPlayerVideo::CVideoPlayerVideo(CDVDClock* pClock
                                 ,CProcessInfo &processInfo)
 : CThread("VideoPlayerVideo")
 , IDVDStreamPlayerVideo(processInfo)
-, m_messageQueue("video")
+, m_messageQueue("video", true)
 , m_messageParent(parent)
 , m_renderManager(renderManager)
 {
@@ -601,11 +601,15 @@ bool CVideoPlayerVideo::ProcessDecoderOutput(int &decoderState, double &frametim
         pts = m_picture.pts;
       }
 
+      CDVDFrameTimeline& timeline = m_renderManager.GetFrameTimeline();
+      timeline.Mark(pts, CDVDFrameTimeline::STAGE_DECODE);
+
       double extraDelay = 0.0;
       if (m_picture.iRepeatPicture)
       {
         extraDelay = m_picture.iRepeatPicture * m_picture.iDuration;
         m_picture.iDuration += extraDelay;
+        timeline.Rekey(pts, pts + extraDelay);
       }
 
       int iResult = OutputPicture(&m_picture, pts + extraDelay);
@@ -743,6 +747,7 @@ std::string CVideoPlayerVideo::GetStereoMode()
 int CVideoPlayerVideo::OutputPicture(const DVDVideoPicture* src, double pts)
 {
   m_bAbortOutput = false;
+  CDVDFrameTimeline& timeline = m_renderManager.GetFrameTimeline();
 
   /* picture buffer is not allowed to be modified in this call */
   DVDVideoPicture picture(*src);
@@ -795,7 +800,10 @@ int CVideoPlayerVideo::OutputPicture(const DVDVideoPicture* src, double pts)
   if (picture.format != RENDER_FMT_BYPASS)
   {
     m_pullupCorrection.Add(pts);
-    pts += m_pullupCorrection.GetCorrection();
+    double correction = m_pullupCorrection.GetCorrection();
+    if (correction != 0.0)
+      timeline.Rekey(pts, pts + correction);
+    pts += correction;
   }
 
   //try to calculate the framerate
@@ -824,10 +832,12 @@ int CVideoPlayerVideo::OutputPicture(const DVDVideoPicture* src, double pts)
       {
         Sleep(50);
       }
+      timeline.Drop(pts, CDVDFrameTimeline::DROP_LATE);
       return result | EOS_DROPPED;
     }
     else if (pts < iPlayingClock)
     {
+      timeline.Drop(pts, CDVDFrameTimeline::DROP_LATE);
       return result | EOS_DROPPED;
     }
   }
@@ -846,6 +856,7 @@ int CVideoPlayerVideo::OutputPicture(const DVDVideoPicture* src, double pts)
     if (diff < mindiff)
     {
       m_droppingStats.AddOutputDropGain(pts, 1);
+      timeline.Drop(pts, CDVDFrameTimeline::DROP_LATE);
       return result | EOS_DROPPED;
     }
   }
@@ -853,6 +864,7 @@ int CVideoPlayerVideo::OutputPicture(const DVDVideoPicture* src, double pts)
   if ((pPicture->iFlags & DVP_FLAG_DROPPED))
   {
     m_droppingStats.AddOutputDropGain(pts, 1);
+    timeline.Drop(pts, CDVDFrameTimeline::DROP_DECODER);
     CLog::Log(LOGDEBUG,"%s - dropped in output", __FUNCTION__);
     return result | EOS_DROPPED;
   }
@@ -877,6 +889,7 @@ int CVideoPlayerVideo::OutputPicture(const DVDVideoPicture* src, double pts)
   if (buffer < 0)
   {
     m_droppingStats.AddOutputDropGain(pts, 1);
+    timeline.Drop(pts, CDVDFrameTimeline::DROP_NOBUFFER);
     return EOS_DROPPED;
   }
 
@@ -895,6 +908,7 @@ int CVideoPlayerVideo::OutputPicture(const DVDVideoPicture* src, double pts)
   if (index < 0)
   {
     m_droppingStats.AddOutputDropGain(pts, 1);
+    timeline.Drop(pts, CDVDFrameTimeline::DROP_NOBUFFER);
     return EOS_DROPPED;
   }
 
@@ -27,7 +27,7 @@ using namespace OVERLAY;
 
 CDebugRenderer::CDebugRenderer()
 {
-  for (int i=0; i<4; i++)
+  for (int i=0; i<NUM_LINES; i++)
   {
     m_overlay[i] = nullptr;
     m_strDebug[i] = " ";
@@ -36,54 +36,37 @@ CDebugRenderer::CDebugRenderer()
 
 CDebugRenderer::~CDebugRenderer()
 {
-  for (int i=0; i<4; i++)
+  for (int i=0; i<NUM_LINES; i++)
   {
     if (m_overlay[i])
       m_overlay[i]->Release();
   }
 }
 
-void CDebugRenderer::SetInfo(std::string &info1, std::string &info2, std::string &info3, std::string &info4)
+void CDebugRenderer::SetInfo(std::string &info1, std::string &info2, std::string &info3, std::string &info4, std::string &info5)
 {
   m_overlayRenderer.Release(0);
 
-  if (info1 != m_strDebug[0])
-  {
-    m_strDebug[0] = info1;
-    if (m_overlay[0])
-      m_overlay[0]->Release();
-    m_overlay[0] = new CDVDOverlayText();
-    m_overlay[0]->AddElement(new CDVDOverlayText::CElementText(m_strDebug[0]));
-  }
-  if (info2 != m_strDebug[1])
-  {
-    m_strDebug[1] = info2;
-    if (m_overlay[1])
-      m_overlay[1]->Release();
-    m_overlay[1] = new CDVDOverlayText();
-    m_overlay[1]->AddElement(new CDVDOverlayText::CElementText(m_strDebug[1]));
-  }
-  if (info3 != m_strDebug[2])
-  {
-    m_strDebug[2] = info3;
-    if (m_overlay[2])
-      m_overlay[2]->Release();
-    m_overlay[2] = new CDVDOverlayText();
-    m_overlay[2]->AddElement(new CDVDOverlayText::CElementText(m_strDebug[2]));
-  }
-  if (info4 != m_strDebug[3])
-  {
-    m_strDebug[3] = info4;
-    if (m_overlay[3])
-      m_overlay[3]->Release();
-    m_overlay[3] = new CDVDOverlayText();
-    m_overlay[3]->AddElement(new CDVDOverlayText::CElementText(m_strDebug[3]));
-  }
+  SetLine(0, info1);
+  SetLine(1, info2);
+  SetLine(2, info3);
+  SetLine(3, info4);
+  SetLine(4, info5);
 
-  m_overlayRenderer.AddOverlay(m_overlay[0], 0, 0);
-  m_overlayRenderer.AddOverlay(m_overlay[1], 0, 0);
-  m_overlayRenderer.AddOverlay(m_overlay[2], 0, 0);
-  m_overlayRenderer.AddOverlay(m_overlay[3], 0, 0);
+  for (int i=0; i<NUM_LINES; i++)
+    m_overlayRenderer.AddOverlay(m_overlay[i], 0, 0);
+}
+
+void CDebugRenderer::SetLine(int line, std::string &info)
+{
+  if (info == m_strDebug[line])
+    return;
+
+  m_strDebug[line] = info;
+  if (m_overlay[line])
+    m_overlay[line]->Release();
+  m_overlay[line] = new CDVDOverlayText();
+  m_overlay[line]->AddElement(new CDVDOverlayText::CElementText(m_strDebug[line]));
 }
 
 void CDebugRenderer::Render(CRect &src, CRect &dst, CRect &view)
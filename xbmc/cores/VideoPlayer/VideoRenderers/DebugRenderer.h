@@ -30,7 +30,7 @@ class CDebugRenderer
 public:
   CDebugRenderer();
   virtual ~CDebugRenderer();
-  void SetInfo(std::string &info1, std::string &info2, std::string &info3, std::string &info4);
+  void SetInfo(std::string &info1, std::string &info2, std::string &info3, std::string &info4, std::string &info5);
   void Render(CRect &src, CRect &dst, CRect &view);
   void Flush();
 
@@ -43,7 +43,10 @@ protected:
     void Render(int idx) override;
   };
 
-  std::string m_strDebug[4];
-  CDVDOverlayText *m_overlay[4];
+  void SetLine(int line, std::string &info);
+
+  static const int NUM_LINES = 5;
+  std::string m_strDebug[NUM_LINES];
+  CDVDOverlayText *m_overlay[NUM_LINES];
   CRenderer m_overlayRenderer;
 };
\ No newline at end of file
@@ -0,0 +1,122 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RenderBufferQueue.h"
+
+CRenderBufferQueue::CRenderBufferQueue()
+  : m_sequence(0)
+  , m_size(0)
+{
+  for (int i = 0; i < MAX_BUFFERS; i++)
+    m_buffers[i] = Pack(0, STATE_UNUSED);
+  for (int i = 0; i <= STATE_DISCARD; i++)
+    m_count[i] = 0;
+}
+
+void CRenderBufferQueue::Reset(int size)
+{
+  if (size > MAX_BUFFERS)
+    size = MAX_BUFFERS;
+  m_size = size;
+
+  for (int i = 0; i <= STATE_DISCARD; i++)
+    m_count[i] = 0;
+
+  for (int i = 0; i < MAX_BUFFERS; i++)
+  {
+    EState state = STATE_UNUSED;
+    if (i == 0 && size > 0)
+      state = STATE_PRESENT;
+    else if (i < size)
+      state = STATE_FREE;
+
+    m_buffers[i] = Pack(++m_sequence, state);
+    m_count[state]++;
+  }
+}
+
+CRenderBufferQueue::EState CRenderBufferQueue::GetState(int idx) const
+{
+  if (idx < 0 || idx >= m_size)
+    return STATE_UNUSED;
+  return StateOf(m_buffers[idx]);
+}
+
+int CRenderBufferQueue::Front(EState state) const
+{
+  int front = -1;
+  uint64_t sequence = 0;
+  for (int i = 0; i < m_size; i++)
+  {
+    uint64_t value = m_buffers[i];
+    if (StateOf(value) != state)
+      continue;
+    if (front < 0 || SequenceOf(value) < sequence)
+    {
+      front = i;
+      sequence = SequenceOf(value);
+    }
+  }
+  return front;
+}
+
+int CRenderBufferQueue::Next(EState state, int idx) const
+{
+  if (idx < 0 || idx >= m_size)
+    return -1;
+
+  uint64_t after = SequenceOf(m_buffers[idx]);
+  int next = -1;
+  uint64_t sequence = 0;
+  for (int i = 0; i < m_size; i++)
+  {
+    uint64_t value = m_buffers[i];
+    if (StateOf(value) != state || SequenceOf(value) <= after)
+      continue;
+    if (next < 0 || SequenceOf(value) < sequence)
+    {
+      next = i;
+      sequence = SequenceOf(value);
+    }
+  }
+  return next;
+}
+
+int CRenderBufferQueue::Count(EState state) const
+{
+  return m_count[state];
+}
+
+bool CRenderBufferQueue::Move(int idx, EState from, EState to)
+{
+  if (idx < 0 || idx >= m_size)
+    return false;
+
+  uint64_t value = m_buffers[idx];
+  do
+  {
+    if (StateOf(value) != from)
+      return false;
+  } while (!m_buffers[idx].compare_exchange_weak(value, Pack(++m_sequence, to)));
+
+  m_count[from]--;
+  m_count[to]++;
+  return true;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <atomic>
+#include <stdint.h>
+
+/*!
+ * \brief State of the render buffers shared by the decoder and render thread.
+ *
+ * Every buffer index is in exactly one state. A buffer moves
+ * free -> queued -> present -> discard -> free, queued buffers may also be
+ * discarded directly. Transitions are atomic, so the decoder can pick a free
+ * buffer and queue it without taking the present lock of the render manager.
+ * Each transition stamps the buffer with a sequence number, buffers in the
+ * same state are handed out in the order they entered it.
+ *
+ * Reset must not run concurrently with any other call.
+ */
+class CRenderBufferQueue
+{
+public:
+  enum EState
+  {
+    STATE_UNUSED = 0,
+    STATE_FREE,
+    STATE_QUEUED,
+    STATE_PRESENT,
+    STATE_DISCARD
+  };
+
+  static const int MAX_BUFFERS = 16;
+
+  CRenderBufferQueue();
+
+  /*!
+   * \brief Use size buffers, buffer 0 is presented and all others are free
+   */
+  void Reset(int size);
+
+  EState GetState(int idx) const;
+
+  /*!
+   * \brief Oldest buffer in the given state, -1 if there is none
+   */
+  int Front(EState state) const;
+
+  /*!
+   * \brief Buffer in the given state that entered it right after idx, -1 if
+   * there is none
+   */
+  int Next(EState state, int idx) const;
+
+  int Count(EState state) const;
+
+  /*!
+   * \brief Atomically move buffer idx from state from to state to
+   * \return false if the buffer was not in state from
+   */
+  bool Move(int idx, EState from, EState to);
+
+  int Size() const { return m_size; }
+
+private:
+  // state in the low byte, sequence number above, so both change together
+  static uint64_t Pack(uint64_t sequence, EState state) { return (sequence << 8) | state; }
+  static EState StateOf(uint64_t value) { return static_cast<EState>(value & 0xff); }
+  static uint64_t SequenceOf(uint64_t value) { return value >> 8; }
+
+  std::atomic<uint64_t> m_buffers[MAX_BUFFERS];
+  std::atomic<int> m_count[STATE_DISCARD + 1];
+  std::atomic<uint64_t> m_sequence;
+  int m_size;
+};
@@ -26,6 +26,7 @@
 #include "threads/SingleLock.h"
 #include "utils/log.h"
 #include "utils/StringUtils.h"
+#include "utils/TimeUtils.h"
 #include "windowing/WindowingFactory.h"
 
 #include "Application.h"
@@ -82,11 +83,10 @@
 
 using namespace KODI::MESSAGING;
 
-static void requeue(std::deque<int> &trg, std::deque<int> &src)
-{
-  trg.push_back(src.front());
-  src.pop_front();
-}
+static_assert(NUM_BUFFERS <= CRenderBufferQueue::MAX_BUFFERS, "render buffer queue too small");
+
+// upper bounds in ms of the FlipPage to present latency histogram, last bin is open
+static const double latencyBounds[] = { 10.0, 20.0, 40.0, 80.0, 160.0 };
 
 static std::string GetRenderFormatName(ERenderFormat format)
 {
@@ -139,6 +139,9 @@ CRenderManager::CRenderManager(CDVDClock &clock, IRenderMsg *player) :
   m_videoDelay(0),
   m_QueueSize(2),
   m_QueueSkip(0),
+  m_latencyCount(0),
+  m_latencySum(0.0),
+  m_latencyMax(0.0),
   m_format(RENDER_FMT_NONE),
   m_width(0),
   m_height(0),
@@ -298,19 +301,22 @@ bool CRenderManager::Configure()
     m_pRenderer->SetBufferSize(m_QueueSize);
     m_pRenderer->Update();
 
-    m_queued.clear();
-    m_discard.clear();
-    m_free.clear();
+    m_buffers.Reset(m_QueueSize);
     m_presentsource = 0;
-    for (int i=1; i < m_QueueSize; i++)
-      m_free.push_back(i);
+    for (int i = 0; i < m_QueueSize; i++)
+      m_Queue[i].fliptime = 0;
+    for (int i = 0; i < LATENCY_BINS; i++)
+      m_latencyBins[i] = 0;
+    m_latencyCount = 0;
+    m_latencySum = 0.0;
+    m_latencyMax = 0.0;
 
     m_bRenderGUI = true;
     m_waitForBufferCount = 0;
     m_bTriggerUpdateResolution = true;
     m_presentstep = PRESENT_IDLE;
     m_presentpts = DVD_NOPTS_VALUE;
-    m_lateframes = -1.0;
+    m_lateframes = -1;
     m_presentevent.notifyAll();
     m_renderedOverlay = false;
     m_renderDebug = false;
@@ -380,7 +386,7 @@ void CRenderManager::FrameMove()
 
     if (m_presentstep == PRESENT_FRAME2)
     {
-      if (!m_queued.empty())
+      if (m_buffers.Count(CRenderBufferQueue::STATE_QUEUED) > 0)
       {
         m_presentstep = PRESENT_READY;
         m_presentevent.notifyAll();
@@ -398,18 +404,18 @@ void CRenderManager::FrameMove()
     }
 
     /* release all previous */
-    for (std::deque<int>::iterator it = m_discard.begin(); it != m_discard.end(); )
+    int idx = m_buffers.Front(CRenderBufferQueue::STATE_DISCARD);
+    while (idx >= 0)
     {
+      int next = m_buffers.Next(CRenderBufferQueue::STATE_DISCARD, idx);
       // renderer may want to keep the frame for postprocessing
-      if (!m_pRenderer->NeedBufferForRef(*it) || !m_bRenderGUI)
+      if (!m_pRenderer->NeedBufferForRef(idx) || !m_bRenderGUI)
       {
-        m_pRenderer->ReleaseBuffer(*it);
-        m_overlays.Release(*it);
-        m_free.push_back(*it);
-        it = m_discard.erase(it);
+        m_pRenderer->ReleaseBuffer(idx);
+        m_overlays.Release(idx);
+        m_buffers.Move(idx, CRenderBufferQueue::STATE_DISCARD, CRenderBufferQueue::STATE_FREE);
       }
-      else
-        ++it;
+      idx = next;
     }
     
     m_bRenderGUI = true;
@@ -483,13 +489,9 @@ bool CRenderManager::Flush()
       m_overlays.Flush();
       m_debugRenderer.Flush();
 
-      m_queued.clear();
-      m_discard.clear();
-      m_free.clear();
+      m_buffers.Reset(m_QueueSize);
       m_presentsource = 0;
       m_presentstep = PRESENT_IDLE;
-      for (int i = 1; i < m_QueueSize; i++)
-        m_free.push_back(i);
 
       m_flushEvent.Set();
     }
@@ -850,25 +852,31 @@ void CRenderManager::FlipPage(volatile std::atomic_bool& bStop, double pts /* =
     }
   }
 
-  CSingleLock lock(m_presentlock);
+  // only the decoder takes free buffers, the front can't change under us
+  if(source < 0)
+    source = m_buffers.Front(CRenderBufferQueue::STATE_FREE);
 
-  if(m_free.empty())
+  if(m_buffers.GetState(source) != CRenderBufferQueue::STATE_FREE)
     return;
 
-  if(source < 0)
-    source = m_free.front();
-
   SPresent& m = m_Queue[source];
   m.presentfield  = sync;
   m.presentmethod = presentmethod;
   m.pts           = pts;
-  requeue(m_queued, m_free);
+  m.fliptime      = CurrentHostCounter();
+  m_buffers.Move(source, CRenderBufferQueue::STATE_FREE, CRenderBufferQueue::STATE_QUEUED);
+  m_frameTimeline.Mark(pts, CDVDFrameTimeline::STAGE_QUEUE);
 
-  /* signal to any waiters to check state */
+  /* signal to any waiters to check state, the render thread re-checks
+   * the queue after going idle so we only need the lock to wake it */
   if(m_presentstep == PRESENT_IDLE)
   {
-    m_presentstep = PRESENT_READY;
-    m_presentevent.notifyAll();
+    CSingleLock lock(m_presentlock);
+    if(m_presentstep == PRESENT_IDLE)
+    {
+      m_presentstep = PRESENT_READY;
+      m_presentevent.notifyAll();
+    }
   }
 }
 
@@ -941,7 +949,8 @@ void CRenderManager::Render(bool clear, DWORD flags, DWORD alpha, bool gui)
                                      clockspeed - 100.0);
       }
 
-      m_debugRenderer.SetInfo(audio, video, player, vsync);
+      std::string latency = GetPresentLatencyInfo();
+      m_debugRenderer.SetInfo(audio, video, player, vsync, latency);
       m_debugRenderer.Render(src, dst, view);
 
       m_debugTimer.Set(1000);
@@ -956,6 +965,9 @@ void CRenderManager::Render(bool clear, DWORD flags, DWORD alpha, bool gui)
 
     if(m_presentstep == PRESENT_FRAME)
     {
+      UpdatePresentLatency();
+      m_frameTimeline.Mark(m.pts, CDVDFrameTimeline::STAGE_PRESENT);
+
       if( m.presentmethod == PRESENT_METHOD_BOB
          ||  m.presentmethod == PRESENT_METHOD_WEAVE)
         m_presentstep = PRESENT_FRAME2;
@@ -967,7 +979,7 @@ void CRenderManager::Render(bool clear, DWORD flags, DWORD alpha, bool gui)
 
     if(m_presentstep == PRESENT_IDLE)
     {
-      if(!m_queued.empty())
+      if(m_buffers.Count(CRenderBufferQueue::STATE_QUEUED) > 0)
         m_presentstep = PRESENT_READY;
     }
 
@@ -1120,13 +1132,9 @@ CRenderInfo CRenderManager::GetRenderInfo()
 
 int CRenderManager::AddVideoPicture(DVDVideoPicture& pic)
 {
-  int index;
-  {
-    CSingleLock lock(m_presentlock);
-    if (m_free.empty())
-      return -1;
-    index = m_free.front();
-  }
+  int index = m_buffers.Front(CRenderBufferQueue::STATE_FREE);
+  if (index < 0)
+    return -1;
 
   CSingleLock lock(m_datalock);
   if (!m_pRenderer)
@@ -1174,12 +1182,10 @@ int CRenderManager::AddVideoPicture(DVDVideoPicture& pic)
 
 void CRenderManager::AddOverlay(CDVDOverlay* o, double pts)
 {
-  int idx;
-  { CSingleLock lock(m_presentlock);
-    if (m_free.empty())
-      return;
-    idx = m_free.front();
-  }
+  int idx = m_buffers.Front(CRenderBufferQueue::STATE_FREE);
+  if (idx < 0)
+    return;
+
   CSingleLock lock(m_datalock);
   m_overlays.AddOverlay(o, pts, idx);
 }
@@ -1242,6 +1248,18 @@ EINTERLACEMETHOD CRenderManager::AutoInterlaceMethodInternal(EINTERLACEMETHOD mI
 
 int CRenderManager::WaitForBuffer(volatile std::atomic_bool&bStop, int timeout)
 {
+  // fast path, a buffer is free and the gui renders
+  if (m_bRenderGUI && g_application.GetRenderGUI())
+  {
+    int idx = m_buffers.Front(CRenderBufferQueue::STATE_FREE);
+    if (idx >= 0)
+    {
+      m_waitForBufferCount = 0;
+      m_overlays.Release(idx);
+      return m_buffers.Count(CRenderBufferQueue::STATE_QUEUED) + m_buffers.Count(CRenderBufferQueue::STATE_DISCARD);
+    }
+  }
+
   CSingleLock lock(m_presentlock);
 
   // check if gui is active and discard buffer if not
@@ -1251,11 +1269,9 @@ int CRenderManager::WaitForBuffer(volatile std::atomic_bool&bStop, int timeout)
     m_bRenderGUI = false;
     double presenttime = 0;
     double clock = m_dvdClock.GetClock();
-    if (!m_queued.empty())
-    {
-      int idx = m_queued.front();
+    int idx = m_buffers.Front(CRenderBufferQueue::STATE_QUEUED);
+    if (idx >= 0)
       presenttime = m_Queue[idx].pts;
-    }
     else
       presenttime = clock + 0.02;
 
@@ -1269,7 +1285,7 @@ int CRenderManager::WaitForBuffer(volatile std::atomic_bool&bStop, int timeout)
   }
 
   XbmcThreads::EndTime endtime(timeout);
-  while(m_free.empty())
+  while(m_buffers.Front(CRenderBufferQueue::STATE_FREE) < 0)
   {
     m_presentevent.wait(lock, std::min(50, timeout));
     if(endtime.IsTimePast() || bStop)
@@ -1290,15 +1306,16 @@ int CRenderManager::WaitForBuffer(volatile std::atomic_bool&bStop, int timeout)
   m_waitForBufferCount = 0;
 
   // make sure overlay buffer is released, this won't happen on AddOverlay
-  m_overlays.Release(m_free.front());
+  m_overlays.Release(m_buffers.Front(CRenderBufferQueue::STATE_FREE));
 
   // return buffer level
-  return m_queued.size() + m_discard.size();
+  return m_buffers.Count(CRenderBufferQueue::STATE_QUEUED) + m_buffers.Count(CRenderBufferQueue::STATE_DISCARD);
 }
 
 void CRenderManager::PrepareNextRender()
 {
-  if (m_queued.empty())
+  int front = m_buffers.Front(CRenderBufferQueue::STATE_QUEUED);
+  if (front < 0)
   {
     CLog::Log(LOGERROR, "CRenderManager::PrepareNextRender - asked to prepare with nothing available");
     m_presentstep = PRESENT_IDLE;
@@ -1315,7 +1332,7 @@ void CRenderManager::PrepareNextRender()
 
   double renderPts = frameOnScreen + totalLatency;
 
-  double nextFramePts = m_Queue[m_queued.front()].pts;
+  double nextFramePts = m_Queue[front].pts;
 
   if (m_clockSync.m_enabled)
   {
@@ -1341,27 +1358,28 @@ void CRenderManager::PrepareNextRender()
   if (renderPts >= nextFramePts)
   {
     // see if any future queued frames are already due
-    auto iter = m_queued.begin();
-    int idx = *iter;
-    ++iter;
-    while (iter != m_queued.end())
+    int idx = front;
+    int next = m_buffers.Next(CRenderBufferQueue::STATE_QUEUED, idx);
+    while (next >= 0)
     {
       // the slot for rendering in time is [pts .. (pts +  x * frametime)]
       // renderer/drivers have internal queues, being slightliy late here does not mean that
       // we are really late. The likelihood that we recover decreases the greater m_lateframes
       // get. Skipping a frame is easier than having decoder dropping one (lateframes > 10)
       double x = (m_lateframes <= 6) ? 0.98 : 0;
-      if (renderPts < m_Queue[*iter].pts + x * frametime)
+      if (renderPts < m_Queue[next].pts + x * frametime)
         break;
-      idx = *iter;
-      ++iter;
+      idx = next;
+      next = m_buffers.Next(CRenderBufferQueue::STATE_QUEUED, idx);
     }
 
     // skip late frames
-    while (m_queued.front() != idx)
+    while (front != idx)
     {
-      requeue(m_discard, m_queued);
+      m_frameTimeline.Drop(m_Queue[front].pts, CDVDFrameTimeline::DROP_SKIPPED);
+      m_buffers.Move(front, CRenderBufferQueue::STATE_QUEUED, CRenderBufferQueue::STATE_DISCARD);
       m_QueueSkip++;
+      front = m_buffers.Front(CRenderBufferQueue::STATE_QUEUED);
     }
 
     int lateframes = (renderPts - m_Queue[idx].pts) / frametime;
@@ -1370,10 +1388,11 @@ void CRenderManager::PrepareNextRender()
     else
       m_lateframes = 0;
     
+    m_frameTimeline.Mark(m_Queue[idx].pts, CDVDFrameTimeline::STAGE_RENDER);
     m_presentstep = PRESENT_FLIP;
-    m_discard.push_back(m_presentsource);
+    m_buffers.Move(m_presentsource, CRenderBufferQueue::STATE_PRESENT, CRenderBufferQueue::STATE_DISCARD);
+    m_buffers.Move(idx, CRenderBufferQueue::STATE_QUEUED, CRenderBufferQueue::STATE_PRESENT);
     m_presentsource = idx;
-    m_queued.pop_front();
     m_presentpts = m_Queue[idx].pts - totalLatency;
     m_presentevent.notifyAll();
   }
@@ -1383,8 +1402,12 @@ void CRenderManager::DiscardBuffer()
 {
   CSingleLock lock2(m_presentlock);
 
-  while(!m_queued.empty())
-    requeue(m_discard, m_queued);
+  int idx;
+  while((idx = m_buffers.Front(CRenderBufferQueue::STATE_QUEUED)) >= 0)
+  {
+    m_frameTimeline.Drop(m_Queue[idx].pts, CDVDFrameTimeline::DROP_FLUSHED);
+    m_buffers.Move(idx, CRenderBufferQueue::STATE_QUEUED, CRenderBufferQueue::STATE_DISCARD);
+  }
 
   if(m_presentstep == PRESENT_READY)
     m_presentstep = PRESENT_IDLE;
@@ -1393,14 +1416,49 @@ void CRenderManager::DiscardBuffer()
 
 bool CRenderManager::GetStats(int &lateframes, double &pts, int &queued, int &discard)
 {
-  CSingleLock lock(m_presentlock);
   lateframes = m_lateframes / 10;
   pts = m_presentpts;
-  queued = m_queued.size();
-  discard  = m_discard.size();
+  queued = m_buffers.Count(CRenderBufferQueue::STATE_QUEUED);
+  discard  = m_buffers.Count(CRenderBufferQueue::STATE_DISCARD);
   return true;
 }
 
+void CRenderManager::UpdatePresentLatency()
+{
+  SPresent& m = m_Queue[m_presentsource];
+  if (m.fliptime == 0)
+    return;
+
+  double latency = (double)(CurrentHostCounter() - m.fliptime) * 1000.0 / CurrentHostFrequency();
+  m.fliptime = 0;
+
+  int bin = 0;
+  while (bin < LATENCY_BINS - 1 && latency >= latencyBounds[bin])
+    bin++;
+  m_latencyBins[bin]++;
+  m_latencyCount++;
+  m_latencySum += latency;
+  m_latencyMax = std::max(m_latencyMax, latency);
+}
+
+std::string CRenderManager::GetPresentLatencyInfo()
+{
+  if (m_latencyCount == 0)
+    return "FlipLat: -";
+
+  std::string info = StringUtils::Format("FlipLat: avg:%.1fms max:%.1fms",
+                                         m_latencySum / m_latencyCount, m_latencyMax);
+  for (int i = 0; i < LATENCY_BINS; i++)
+  {
+    if (i < LATENCY_BINS - 1)
+      info += StringUtils::Format(" <%.0f:", latencyBounds[i]);
+    else
+      info += StringUtils::Format(" >%.0f:", latencyBounds[i - 1]);
+    info += StringUtils::Format("%.0f%%", 100.0 * m_latencyBins[i] / m_latencyCount);
+  }
+  return info;
+}
+
 void CRenderManager::CheckEnableClockSync()
 {
   // refresh rate can be a multiple of video fps
@@ -30,12 +30,13 @@
 #include "settings/VideoSettings.h"
 #include "OverlayRenderer.h"
 #include "DebugRenderer.h"
-#include <deque>
+#include "RenderBufferQueue.h"
 #include <map>
 #include <atomic>
 #include "PlatformDefs.h"
 #include "threads/Event.h"
 #include "DVDClock.h"
+#include "cores/VideoPlayer/DVDFrameTimeline.h"
 
 class CRenderCapture;
 
@@ -97,6 +98,7 @@ public:
   EINTERLACEMETHOD AutoInterlaceMethod(EINTERLACEMETHOD mInt);
 
   int GetSkippedFrames()  { return m_QueueSkip; }
+  CDVDFrameTimeline& GetFrameTimeline() { return m_frameTimeline; }
 
   // Functions called from mplayer
   /**
@@ -172,6 +174,8 @@ protected:
 
   void UpdateDisplayLatency();
   void CheckEnableClockSync();
+  void UpdatePresentLatency();
+  std::string GetPresentLatencyInfo();
 
   CBaseRenderer *m_pRenderer;
   OVERLAY::CRenderer m_overlays;
@@ -180,7 +184,7 @@ protected:
   CCriticalSection m_presentlock;
   CCriticalSection m_datalock;
   bool m_bTriggerUpdateResolution;
-  bool m_bRenderGUI;
+  std::atomic_bool m_bRenderGUI;
   int m_waitForBufferCount;
   int m_rendermethod;
   bool m_renderedOverlay;
@@ -225,11 +229,21 @@ protected:
     double         pts;
     EFIELDSYNC     presentfield;
     EPRESENTMETHOD presentmethod;
+    int64_t        fliptime;  // host counter at FlipPage, 0 once presented
   } m_Queue[NUM_BUFFERS];
 
-  std::deque<int> m_free;
-  std::deque<int> m_queued;
-  std::deque<int> m_discard;
+  // decoder picks and queues buffers without taking m_presentlock, moving
+  // queued buffers on is done by the render thread holding it
+  CRenderBufferQueue m_buffers;
+
+  // FlipPage to first present latency, only touched by the render thread
+  static const int LATENCY_BINS = 6;
+  unsigned int m_latencyBins[LATENCY_BINS];
+  unsigned int m_latencyCount;
+  double m_latencySum;
+  double m_latencyMax;
+
+  CDVDFrameTimeline m_frameTimeline;
 
   ERenderFormat m_format;
   unsigned int m_width, m_height, m_dwidth, m_dheight;
@@ -239,9 +253,9 @@ protected:
   unsigned int m_orientation;
   int m_NumberBuffers;
 
-  int m_lateframes;
-  double m_presentpts;
-  EPRESENTSTEP m_presentstep;
+  std::atomic_int m_lateframes;
+  std::atomic<double> m_presentpts;
+  std::atomic<EPRESENTSTEP> m_presentstep;
   int m_presentsource;
   XbmcThreads::ConditionVariable  m_presentevent;
   CEvent m_flushEvent;
@@ -0,0 +1,210 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/FFmpeg.h"
+#include "cores/VideoPlayer/DVDDemuxers/DVDDemuxProbeCache.h"
+#include "filesystem/Directory.h"
+#include "filesystem/File.h"
+#include "FileItem.h"
+#include "utils/StringUtils.h"
+#include "utils/URIUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <cstring>
+
+namespace
+{
+
+const char* TEST_PATH = "smb://server/share/movie.mkv";
+const int64_t TEST_SIZE = 1234567890;
+const int64_t TEST_TIME = 1466000000;
+const uint8_t TEST_EXTRADATA[] = { 0x01, 0x64, 0x00, 0x29, 0xff, 0xe1, 0x00, 0x10 };
+
+AVFormatContext* CreateContext()
+{
+  AVFormatContext* context = avformat_alloc_context();
+
+  AVStream* video = avformat_new_stream(context, NULL);
+  video->codec->codec_type = AVMEDIA_TYPE_VIDEO;
+  video->codec->codec_id = AV_CODEC_ID_H264;
+
+  AVStream* audio = avformat_new_stream(context, NULL);
+  audio->codec->codec_type = AVMEDIA_TYPE_AUDIO;
+  audio->codec->codec_id = AV_CODEC_ID_AAC;
+  return context;
+}
+
+AVFormatContext* CreateProbedContext()
+{
+  AVFormatContext* context = CreateContext();
+  context->duration = (int64_t)5400 * AV_TIME_BASE;
+  context->bit_rate = 8000000;
+
+  AVCodecContext* video = context->streams[0]->codec;
+  video->width = 1920;
+  video->height = 1080;
+  video->pix_fmt = AV_PIX_FMT_YUV420P;
+  video->extradata = (uint8_t*)av_mallocz(sizeof(TEST_EXTRADATA) + FF_INPUT_BUFFER_PADDING_SIZE);
+  memcpy(video->extradata, TEST_EXTRADATA, sizeof(TEST_EXTRADATA));
+  video->extradata_size = sizeof(TEST_EXTRADATA);
+  context->streams[0]->avg_frame_rate = av_make_q(24000, 1001);
+
+  AVCodecContext* audio = context->streams[1]->codec;
+  audio->sample_rate = 48000;
+  audio->channels = 6;
+  audio->sample_fmt = AV_SAMPLE_FMT_FLTP;
+  audio->frame_size = 1024;
+  return context;
+}
+
+std::string ReadCacheFile()
+{
+  XFILE::CFile file;
+  std::string data;
+  if (file.Open(CDVDDemuxProbeCache::GetCacheFile(TEST_PATH)))
+  {
+    data.resize((size_t)file.GetLength());
+    file.Read(&data[0], data.size());
+  }
+  return data;
+}
+
+void WriteCacheFile(const std::string& data)
+{
+  XFILE::CFile file;
+  ASSERT_TRUE(file.OpenForWrite(CDVDDemuxProbeCache::GetCacheFile(TEST_PATH), true));
+  file.Write(data.data(), data.size());
+}
+
+int CountCacheFiles()
+{
+  CFileItemList items;
+  XFILE::CDirectory::GetDirectory(URIUtils::GetDirectory(CDVDDemuxProbeCache::GetCacheFile(TEST_PATH)), items, "", XFILE::DIR_FLAG_NO_FILE_DIRS | XFILE::DIR_FLAG_BYPASS_CACHE);
+  return items.Size();
+}
+
+}
+
+class TestDVDDemuxProbeCache : public testing::Test
+{
+protected:
+  TestDVDDemuxProbeCache()
+  {
+    AVFormatContext* probed = CreateProbedContext();
+    CDVDDemuxProbeCache::Store(TEST_PATH, TEST_SIZE, TEST_TIME, probed);
+    avformat_free_context(probed);
+    m_context = CreateContext();
+  }
+
+  ~TestDVDDemuxProbeCache()
+  {
+    avformat_free_context(m_context);
+    CDVDDemuxProbeCache::Prune(0, 0);
+  }
+
+  AVFormatContext* m_context;
+};
+
+TEST_F(TestDVDDemuxProbeCache, Restore)
+{
+  ASSERT_TRUE(CDVDDemuxProbeCache::Restore(TEST_PATH, TEST_SIZE, TEST_TIME, m_context));
+  EXPECT_EQ((int64_t)5400 * AV_TIME_BASE, m_context->duration);
+
+  const AVCodecContext* video = m_context->streams[0]->codec;
+  EXPECT_EQ(1920, video->width);
+  EXPECT_EQ(1080, video->height);
+  EXPECT_EQ(AV_PIX_FMT_YUV420P, video->pix_fmt);
+  ASSERT_EQ((int)sizeof(TEST_EXTRADATA), video->extradata_size);
+  EXPECT_EQ(0, memcmp(TEST_EXTRADATA, video->extradata, sizeof(TEST_EXTRADATA)));
+  EXPECT_EQ(24000, m_context->streams[0]->avg_frame_rate.num);
+  EXPECT_EQ(1001, m_context->streams[0]->avg_frame_rate.den);
+
+  const AVCodecContext* audio = m_context->streams[1]->codec;
+  EXPECT_EQ(48000, audio->sample_rate);
+  EXPECT_EQ(6, audio->channels);
+  EXPECT_EQ(AV_SAMPLE_FMT_FLTP, audio->sample_fmt);
+  EXPECT_EQ(1024, audio->frame_size);
+}
+
+TEST_F(TestDVDDemuxProbeCache, ChangedFile)
+{
+  EXPECT_FALSE(CDVDDemuxProbeCache::Restore(TEST_PATH, TEST_SIZE + 1, TEST_TIME, m_context));
+  EXPECT_FALSE(CDVDDemuxProbeCache::Restore(TEST_PATH, TEST_SIZE, TEST_TIME + 1, m_context));
+  EXPECT_EQ(0, m_context->streams[0]->codec->width);
+}
+
+TEST_F(TestDVDDemuxProbeCache, ChangedStreams)
+{
+  m_context->streams[1]->codec->codec_id = AV_CODEC_ID_AC3;
+  EXPECT_FALSE(CDVDDemuxProbeCache::Restore(TEST_PATH, TEST_SIZE, TEST_TIME, m_context));
+  EXPECT_EQ(0, m_context->streams[0]->codec->width);
+}
+
+TEST_F(TestDVDDemuxProbeCache, Truncated)
+{
+  std::string data = ReadCacheFile();
+  ASSERT_FALSE(data.empty());
+  for (size_t size = 0; size < data.size(); size++)
+  {
+    WriteCacheFile(data.substr(0, size));
+    EXPECT_FALSE(CDVDDemuxProbeCache::Restore(TEST_PATH, TEST_SIZE, TEST_TIME, m_context)) << "size " << size;
+  }
+  EXPECT_EQ(0, m_context->streams[0]->codec->width);
+}
+
+TEST_F(TestDVDDemuxProbeCache, Corrupt)
+{
+  std::string data = ReadCacheFile();
+  ASSERT_FALSE(data.empty());
+  for (size_t pos = 0; pos < data.size(); pos++)
+  {
+    std::string corrupt = data;
+    corrupt[pos] ^= 0x40;
+    WriteCacheFile(corrupt);
+    EXPECT_FALSE(CDVDDemuxProbeCache::Restore(TEST_PATH, TEST_SIZE, TEST_TIME, m_context)) << "offset " << pos;
+  }
+  EXPECT_EQ(0, m_context->streams[0]->codec->width);
+}
+
+TEST_F(TestDVDDemuxProbeCache, Version)
+{
+  std::string data = ReadCacheFile();
+  ASSERT_GT(data.size(), 8u);
+  // the version follows the 4 byte magic
+  data[4]++;
+  WriteCacheFile(data);
+  EXPECT_FALSE(CDVDDemuxProbeCache::Restore(TEST_PATH, TEST_SIZE, TEST_TIME, m_context));
+}
+
+TEST_F(TestDVDDemuxProbeCache, Prune)
+{
+  AVFormatContext* probed = CreateProbedContext();
+  for (int i = 0; i < 10; i++)
+    CDVDDemuxProbeCache::Store(StringUtils::Format("smb://server/share/movie%d.mkv", i), TEST_SIZE, TEST_TIME, probed);
+  avformat_free_context(probed);
+  EXPECT_EQ(11, CountCacheFiles());
+
+  CDVDDemuxProbeCache::Prune(4, 30);
+  EXPECT_EQ(4, CountCacheFiles());
+
+  CDVDDemuxProbeCache::Prune(4, 0);
+  EXPECT_EQ(0, CountCacheFiles());
+}
@@ -0,0 +1,174 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/VideoPlayer/DVDFrameTimeline.h"
+#include "cores/VideoPlayer/DVDClock.h"
+
+#include "gtest/gtest.h"
+
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+// 24p in the DVD_TIME_BASE units the player uses
+const double FRAME_DURATION = DVD_TIME_BASE / 24.0;
+
+}
+
+TEST(TestDVDFrameTimeline, Disabled)
+{
+  CDVDFrameTimeline timeline;
+  EXPECT_FALSE(timeline.IsEnabled());
+  timeline.Mark(0.0, CDVDFrameTimeline::STAGE_DEMUX);
+  timeline.Drop(0.0, CDVDFrameTimeline::DROP_LATE);
+  EXPECT_TRUE(timeline.GetFrames().empty());
+
+  timeline.SetEnabled(true);
+  timeline.Mark(0.0, CDVDFrameTimeline::STAGE_DEMUX);
+  timeline.SetEnabled(false);
+  timeline.Mark(FRAME_DURATION, CDVDFrameTimeline::STAGE_DEMUX);
+  EXPECT_EQ(1u, timeline.GetFrames().size());
+}
+
+TEST(TestDVDFrameTimeline, Stages)
+{
+  CDVDFrameTimeline timeline;
+  timeline.SetEnabled(true);
+
+  for (int i = 0; i < CDVDFrameTimeline::STAGE_MAX; i++)
+  {
+    timeline.Mark(0.0, (CDVDFrameTimeline::EStage)i);
+    timeline.Mark(FRAME_DURATION, (CDVDFrameTimeline::EStage)i);
+  }
+  // a frame presented again keeps its first time
+  timeline.Mark(0.0, CDVDFrameTimeline::STAGE_PRESENT);
+  timeline.Mark(DVD_NOPTS_VALUE, CDVDFrameTimeline::STAGE_DEMUX);
+
+  std::vector<CDVDFrameTimeline::SFrame> frames = timeline.GetFrames();
+  ASSERT_EQ(2u, frames.size());
+  EXPECT_EQ(0.0, frames[0].pts);
+  EXPECT_EQ(FRAME_DURATION, frames[1].pts);
+  for (int i = 0; i < CDVDFrameTimeline::STAGE_MAX; i++)
+  {
+    EXPECT_NE(0, frames[0].time[i]);
+    if (i > 0)
+      EXPECT_LE(frames[0].time[i - 1], frames[0].time[i]);
+    EXPECT_LE(frames[0].time[i], frames[1].time[i]);
+  }
+  EXPECT_EQ(CDVDFrameTimeline::DROP_NONE, frames[0].drop);
+}
+
+TEST(TestDVDFrameTimeline, Drop)
+{
+  CDVDFrameTimeline timeline;
+  timeline.SetEnabled(true);
+
+  timeline.Mark(0.0, CDVDFrameTimeline::STAGE_DECODE);
+  timeline.Drop(0.0, CDVDFrameTimeline::DROP_LATE);
+  timeline.Drop(0.0, CDVDFrameTimeline::DROP_FLUSHED);
+
+  std::vector<CDVDFrameTimeline::SFrame> frames = timeline.GetFrames();
+  ASSERT_EQ(1u, frames.size());
+  EXPECT_EQ(CDVDFrameTimeline::DROP_LATE, frames[0].drop);
+}
+
+TEST(TestDVDFrameTimeline, Rekey)
+{
+  CDVDFrameTimeline timeline;
+  timeline.SetEnabled(true);
+
+  timeline.Mark(0.0, CDVDFrameTimeline::STAGE_DECODE);
+  timeline.Rekey(0.0, FRAME_DURATION);
+  timeline.Mark(FRAME_DURATION, CDVDFrameTimeline::STAGE_QUEUE);
+
+  std::vector<CDVDFrameTimeline::SFrame> frames = timeline.GetFrames();
+  ASSERT_EQ(1u, frames.size());
+  EXPECT_EQ(FRAME_DURATION, frames[0].pts);
+  EXPECT_NE(0, frames[0].time[CDVDFrameTimeline::STAGE_DECODE]);
+  EXPECT_NE(0, frames[0].time[CDVDFrameTimeline::STAGE_QUEUE]);
+}
+
+TEST(TestDVDFrameTimeline, Reset)
+{
+  CDVDFrameTimeline timeline;
+  timeline.SetEnabled(true);
+
+  timeline.Mark(0.0, CDVDFrameTimeline::STAGE_DEMUX);
+  timeline.Reset();
+  EXPECT_TRUE(timeline.GetFrames().empty());
+
+  timeline.Mark(FRAME_DURATION, CDVDFrameTimeline::STAGE_DEMUX);
+  std::vector<CDVDFrameTimeline::SFrame> frames = timeline.GetFrames();
+  ASSERT_EQ(1u, frames.size());
+  EXPECT_EQ(FRAME_DURATION, frames[0].pts);
+}
+
+TEST(TestDVDFrameTimeline, Wrap)
+{
+  CDVDFrameTimeline timeline;
+  timeline.SetEnabled(true);
+
+  int count = CDVDFrameTimeline::EVENTS + 100;
+  for (int i = 0; i < count; i++)
+    timeline.Mark(i * FRAME_DURATION, CDVDFrameTimeline::STAGE_DEMUX);
+
+  std::vector<CDVDFrameTimeline::SFrame> frames = timeline.GetFrames();
+  ASSERT_EQ((size_t)CDVDFrameTimeline::FRAMES, frames.size());
+  EXPECT_EQ((count - 1) * FRAME_DURATION, frames.back().pts);
+}
+
+TEST(TestDVDFrameTimeline, Threads)
+{
+  CDVDFrameTimeline timeline;
+  timeline.SetEnabled(true);
+
+  // the player, video and render threads each record their own stages
+  const int frameCount = 300;
+  std::vector<std::thread> threads;
+  for (int stage = 0; stage < CDVDFrameTimeline::STAGE_MAX; stage++)
+  {
+    threads.push_back(std::thread([&timeline, stage, frameCount]()
+    {
+      for (int i = 0; i < frameCount; i++)
+        timeline.Mark(i * FRAME_DURATION, (CDVDFrameTimeline::EStage)stage);
+    }));
+  }
+  std::vector<CDVDFrameTimeline::SFrame> frames;
+  while (frames.size() < (size_t)frameCount)
+    frames = timeline.GetFrames();
+  for (std::thread& thread : threads)
+    thread.join();
+
+  // no event is lost, racing threads may only split a frame in two
+  frames = timeline.GetFrames();
+  EXPECT_GE(frames.size(), (size_t)frameCount);
+  int marks = 0;
+  for (const CDVDFrameTimeline::SFrame& frame : frames)
+  {
+    for (int stage = 0; stage < CDVDFrameTimeline::STAGE_MAX; stage++)
+    {
+      if (frame.time[stage] != 0)
+        marks++;
+    }
+  }
+  EXPECT_EQ(frameCount * CDVDFrameTimeline::STAGE_MAX, marks);
+}
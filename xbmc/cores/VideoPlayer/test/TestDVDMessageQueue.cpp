@@ -0,0 +1,240 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/VideoPlayer/DVDMessageQueue.h"
+#include "cores/VideoPlayer/DVDDemuxers/DVDDemuxUtils.h"
+#include "threads/SystemClock.h"
+#include "threads/test/TestHelpers.h"
+
+#include <iostream>
+
+namespace
+{
+
+DemuxPacket* CreatePacket(int size, double dts)
+{
+  DemuxPacket* packet = CDVDDemuxUtils::AllocateDemuxPacket(size);
+  packet->iSize = size;
+  packet->dts = dts;
+  packet->pts = dts;
+  return packet;
+}
+
+class CPacketProducer : public IRunnable
+{
+public:
+  CPacketProducer(CDVDMessageQueue& queue, int count)
+    : m_queue(queue), m_count(count) {}
+
+  void Run()
+  {
+    for (int i = 0; i < m_count; i++)
+    {
+      m_queue.Put(new CDVDMsgDemuxerPacket(CreatePacket(188, i)));
+      if (i % 1000 == 0)
+        m_queue.Put(new CDVDMsgInt(CDVDMsg::PLAYER_SETSPEED, i), 1);
+    }
+    m_queue.Put(new CDVDMsg(CDVDMsg::GENERAL_EOF));
+  }
+
+private:
+  CDVDMessageQueue& m_queue;
+  int m_count;
+};
+
+// returns number of packets consumed in order, -1 on error
+int ConsumePackets(CDVDMessageQueue& queue)
+{
+  int expected = 0;
+  while (true)
+  {
+    CDVDMsg* pMsg;
+    int priority = 0;
+    if (queue.Get(&pMsg, 5000, priority) != MSGQ_OK)
+      return -1;
+
+    if (pMsg->IsType(CDVDMsg::GENERAL_EOF))
+    {
+      pMsg->Release();
+      return expected;
+    }
+
+    if (pMsg->IsType(CDVDMsg::DEMUXER_PACKET))
+    {
+      DemuxPacket* packet = static_cast<CDVDMsgDemuxerPacket*>(pMsg)->GetPacket();
+      if (packet->dts != expected)
+      {
+        pMsg->Release();
+        return -1;
+      }
+      expected++;
+    }
+    pMsg->Release();
+  }
+}
+
+// returns the time taken in ms
+unsigned int RunProducerConsumer(bool ring, int count)
+{
+  CDVDMessageQueue queue("test", ring);
+  queue.Init();
+
+  CPacketProducer producer(queue, count);
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  thread producerThread(producer);
+  EXPECT_EQ(count, ConsumePackets(queue));
+  producerThread.join();
+  unsigned int elapsed = XbmcThreads::SystemClockMillis() - start;
+
+  EXPECT_EQ(0, queue.GetDataSize());
+  queue.End();
+  return elapsed;
+}
+
+void CheckOrder(bool ring)
+{
+  CDVDMessageQueue queue("test", ring);
+  queue.Init();
+
+  for (int i = 0; i < 1000; i++)
+    queue.Put(new CDVDMsgDemuxerPacket(CreatePacket(10, i)));
+  queue.Put(new CDVDMsgInt(CDVDMsg::PLAYER_SETSPEED, 1), 1);
+  EXPECT_EQ(10000, queue.GetDataSize());
+  EXPECT_EQ(1000U, queue.GetPacketCount(CDVDMsg::DEMUXER_PACKET));
+
+  // priority messages come first
+  CDVDMsg* pMsg;
+  int priority = 0;
+  ASSERT_EQ(MSGQ_OK, queue.Get(&pMsg, 0, priority));
+  EXPECT_TRUE(pMsg->IsType(CDVDMsg::PLAYER_SETSPEED));
+  EXPECT_EQ(1, priority);
+  pMsg->Release();
+
+  // only priority messages requested
+  priority = 1;
+  EXPECT_EQ(MSGQ_TIMEOUT, queue.Get(&pMsg, 0, priority));
+
+  priority = 0;
+  ASSERT_EQ(MSGQ_OK, queue.Get(&pMsg, 0, priority));
+  EXPECT_EQ(0.0, static_cast<CDVDMsgDemuxerPacket*>(pMsg)->GetPacket()->dts);
+  EXPECT_EQ(9990, queue.GetDataSize());
+
+  // a message put back is returned next
+  queue.Put(pMsg, 0, false);
+  ASSERT_EQ(MSGQ_OK, queue.Get(&pMsg, 0, priority));
+  EXPECT_EQ(0.0, static_cast<CDVDMsgDemuxerPacket*>(pMsg)->GetPacket()->dts);
+  pMsg->Release();
+
+  for (int i = 1; i < 1000; i++)
+  {
+    ASSERT_EQ(MSGQ_OK, queue.Get(&pMsg, 0, priority));
+    EXPECT_EQ(i, static_cast<CDVDMsgDemuxerPacket*>(pMsg)->GetPacket()->dts);
+    pMsg->Release();
+  }
+  EXPECT_EQ(0, queue.GetDataSize());
+  EXPECT_EQ(MSGQ_TIMEOUT, queue.Get(&pMsg, 0, priority));
+  queue.End();
+}
+
+void CheckFlush(bool ring)
+{
+  CDVDMessageQueue queue("test", ring);
+  queue.Init();
+
+  for (int i = 0; i < 500; i++)
+    queue.Put(new CDVDMsgDemuxerPacket(CreatePacket(10, i)));
+  queue.Put(new CDVDMsg(CDVDMsg::GENERAL_EOF));
+  queue.Flush();
+  EXPECT_EQ(0, queue.GetDataSize());
+  EXPECT_EQ(0U, queue.GetPacketCount(CDVDMsg::DEMUXER_PACKET));
+  EXPECT_EQ(1U, queue.GetPacketCount(CDVDMsg::GENERAL_EOF));
+
+  CDVDMsg* pMsg;
+  ASSERT_EQ(MSGQ_OK, queue.Get(&pMsg, 0));
+  EXPECT_TRUE(pMsg->IsType(CDVDMsg::GENERAL_EOF));
+  pMsg->Release();
+  queue.End();
+}
+
+void CheckAbort(bool ring)
+{
+  CDVDMessageQueue queue("test", ring);
+  queue.Init();
+  queue.Abort();
+
+  CDVDMsg* pMsg;
+  EXPECT_EQ(MSGQ_ABORT, queue.Get(&pMsg, 1000));
+  EXPECT_TRUE(queue.ReceivedAbortRequest());
+  queue.End();
+}
+
+void CheckEnd(bool ring)
+{
+  CDVDMessageQueue queue("test", ring);
+  queue.Init();
+  queue.Put(new CDVDMsgDemuxerPacket(CreatePacket(10, 0)));
+  queue.End();
+
+  // nothing is queued once the queue has ended
+  EXPECT_EQ(MSGQ_NOT_INITIALIZED, queue.Put(new CDVDMsgDemuxerPacket(CreatePacket(10, 1))));
+  EXPECT_EQ(0, queue.GetDataSize());
+  EXPECT_EQ(0U, queue.GetPacketCount(CDVDMsg::DEMUXER_PACKET));
+}
+
+}
+
+TEST(TestDVDMessageQueue, Order)
+{
+  CheckOrder(false);
+  CheckOrder(true);
+}
+
+TEST(TestDVDMessageQueue, Flush)
+{
+  CheckFlush(false);
+  CheckFlush(true);
+}
+
+TEST(TestDVDMessageQueue, Abort)
+{
+  CheckAbort(false);
+  CheckAbort(true);
+}
+
+TEST(TestDVDMessageQueue, End)
+{
+  CheckEnd(false);
+  CheckEnd(true);
+}
+
+TEST(TestDVDMessageQueue, ProducerConsumer)
+{
+  RunProducerConsumer(false, 5000);
+  RunProducerConsumer(true, 5000);
+}
+
+// prints timings only, run with --gtest_also_run_disabled_tests
+TEST(TestDVDMessageQueue, DISABLED_Benchmark)
+{
+  const int count = 100000;
+  unsigned int list = RunProducerConsumer(false, count);
+  unsigned int ring = RunProducerConsumer(true, count);
+  std::cout << count << " packets, list queue: " << list << " ms, ring queue: " << ring << " ms" << std::endl;
+}
@@ -0,0 +1,131 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/VideoPlayer/VideoRenderers/RenderBufferQueue.h"
+#include "threads/test/TestHelpers.h"
+
+#include <atomic>
+#include <thread>
+
+namespace
+{
+
+typedef CRenderBufferQueue Q;
+
+// plays the decoder: queue every free buffer in order
+class CDecoder : public IRunnable
+{
+public:
+  CDecoder(CRenderBufferQueue& queue, int frames, std::atomic<bool>& error)
+    : m_queue(queue), m_frames(frames), m_error(error) {}
+
+  void Run()
+  {
+    int queued = 0;
+    while (queued < m_frames)
+    {
+      int idx = m_queue.Front(Q::STATE_FREE);
+      if (idx < 0)
+      {
+        std::this_thread::yield();
+        continue;
+      }
+      if (!m_queue.Move(idx, Q::STATE_FREE, Q::STATE_QUEUED))
+        m_error = true;
+      queued++;
+    }
+  }
+
+private:
+  CRenderBufferQueue& m_queue;
+  int m_frames;
+  std::atomic<bool>& m_error;
+};
+
+}
+
+TEST(TestRenderBufferQueue, Reset)
+{
+  CRenderBufferQueue queue;
+  queue.Reset(4);
+
+  EXPECT_EQ(4, queue.Size());
+  EXPECT_EQ(Q::STATE_PRESENT, queue.GetState(0));
+  EXPECT_EQ(3, queue.Count(Q::STATE_FREE));
+  EXPECT_EQ(0, queue.Count(Q::STATE_QUEUED));
+  EXPECT_EQ(1, queue.Front(Q::STATE_FREE));
+  EXPECT_EQ(Q::STATE_UNUSED, queue.GetState(4));
+}
+
+TEST(TestRenderBufferQueue, Order)
+{
+  CRenderBufferQueue queue;
+  queue.Reset(4);
+
+  EXPECT_TRUE(queue.Move(3, Q::STATE_FREE, Q::STATE_QUEUED));
+  EXPECT_TRUE(queue.Move(1, Q::STATE_FREE, Q::STATE_QUEUED));
+  EXPECT_FALSE(queue.Move(1, Q::STATE_FREE, Q::STATE_QUEUED));
+
+  EXPECT_EQ(3, queue.Front(Q::STATE_QUEUED));
+  EXPECT_EQ(1, queue.Next(Q::STATE_QUEUED, 3));
+  EXPECT_EQ(-1, queue.Next(Q::STATE_QUEUED, 1));
+  EXPECT_EQ(2, queue.Count(Q::STATE_QUEUED));
+
+  // a buffer becoming free again goes to the back
+  EXPECT_TRUE(queue.Move(0, Q::STATE_PRESENT, Q::STATE_DISCARD));
+  EXPECT_TRUE(queue.Move(0, Q::STATE_DISCARD, Q::STATE_FREE));
+  EXPECT_EQ(2, queue.Front(Q::STATE_FREE));
+  EXPECT_EQ(0, queue.Next(Q::STATE_FREE, 2));
+}
+
+TEST(TestRenderBufferQueue, Threaded)
+{
+  const int frames = 10000;
+  CRenderBufferQueue queue;
+  queue.Reset(4);
+
+  std::atomic<bool> error(false);
+  CDecoder decoder(queue, frames, error);
+  thread decoderThread(decoder);
+
+  // plays the render thread: present the oldest queued buffer and recycle
+  // the previous one
+  int present = 0;
+  int presented = 0;
+  while (presented < frames)
+  {
+    int idx = queue.Front(Q::STATE_QUEUED);
+    if (idx < 0)
+    {
+      std::this_thread::yield();
+      continue;
+    }
+    EXPECT_TRUE(queue.Move(present, Q::STATE_PRESENT, Q::STATE_DISCARD));
+    EXPECT_TRUE(queue.Move(idx, Q::STATE_QUEUED, Q::STATE_PRESENT));
+    EXPECT_TRUE(queue.Move(present, Q::STATE_DISCARD, Q::STATE_FREE));
+    present = idx;
+    presented++;
+  }
+
+  decoderThread.join();
+  EXPECT_FALSE(error);
+  EXPECT_EQ(1, queue.Count(Q::STATE_PRESENT));
+  EXPECT_EQ(3, queue.Count(Q::STATE_FREE));
+}
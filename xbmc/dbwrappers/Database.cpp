@@ -28,6 +28,7 @@
 #include "utils/StringUtils.h"
 #include "sqlitedataset.h"
 #include "DatabaseManager.h"
+#include "DatabasePool.h"
 #include "DbUrl.h"
 
 #ifdef HAS_MYSQL
@@ -42,6 +43,15 @@ using namespace dbiplus;
 
 #define MAX_COMPRESS_COUNT 20
 
+// limits for a single multi-row INSERT of a batch, well below the default
+// statement limit of SQLite (1MB) and max_allowed_packet of MySQL (4MB)
+#define MAX_BATCH_ROWS  200
+#define MAX_BATCH_BYTES (256 * 1024)
+
+// how long a transaction waits for the writer of another thread, in ms. Writers
+// only hold the pool for their own database writes, never while scraping.
+#define WRITE_LOCK_TIMEOUT 20000
+
 void CDatabase::Filter::AppendField(const std::string &strField)
 {
   if (strField.empty())
@@ -107,6 +117,10 @@ CDatabase::CDatabase(void)
   m_sqlite = true;
   m_bMultiWrite = false;
   m_multipleExecute = false;
+  m_batchDepth = 0;
+  m_batchSavepoints = 0;
+  m_batchFailed = false;
+  m_writing = false;
 }
 
 CDatabase::~CDatabase(void)
@@ -300,6 +314,121 @@ bool CDatabase::CommitInsertQueries()
   return bReturn;
 }
 
+void CDatabase::BeginBatch()
+{
+  if (m_batchDepth > 0)
+  {
+    m_batchDepth++;
+    return;
+  }
+
+  m_batchInserts.clear();
+  m_batchSavepoints = 0;
+  m_batchFailed = false;
+  BeginTransaction();
+  m_batchDepth = 1;
+}
+
+bool CDatabase::CommitBatch()
+{
+  if (m_batchDepth == 0)
+    return false;
+
+  if (--m_batchDepth > 0)
+    return true;
+
+  if (!FlushBatch())
+  {
+    CLog::Log(LOGERROR, "%s - batch failed, rolling back", __FUNCTION__);
+    m_batchInserts.clear();
+    RollbackTransaction();
+    return false;
+  }
+  return CommitTransaction();
+}
+
+void CDatabase::RollbackBatch()
+{
+  if (m_batchDepth == 0)
+    return;
+
+  m_batchDepth = 0;
+  m_batchInserts.clear();
+  RollbackTransaction();
+}
+
+bool CDatabase::QueueBatchInsert(const std::string &strInsert, const std::string &strValues, const std::string &strKey /* = "" */)
+{
+  if (!InBatch())
+    return ExecuteQuery(strInsert + " VALUES " + strValues);
+
+  std::vector<BatchInsert>::iterator insert = m_batchInserts.begin();
+  while (insert != m_batchInserts.end() && insert->insert != strInsert)
+    ++insert;
+  if (insert == m_batchInserts.end())
+  {
+    m_batchInserts.push_back(BatchInsert());
+    insert = m_batchInserts.end() - 1;
+    insert->insert = strInsert;
+  }
+
+  if (!strKey.empty())
+  {
+    std::map<std::string, size_t>::const_iterator key = insert->keys.find(strKey);
+    if (key != insert->keys.end())
+    {
+      insert->rows[key->second] = strValues;
+      return true;
+    }
+    insert->keys[strKey] = insert->rows.size();
+  }
+  insert->rows.push_back(strValues);
+  return true;
+}
+
+bool CDatabase::FlushBatch()
+{
+  if (m_batchInserts.empty())
+    return !m_batchFailed;
+
+  std::vector<BatchInsert> inserts;
+  inserts.swap(m_batchInserts);
+
+  if (NULL == m_pDB.get() || NULL == m_pDS.get())
+  {
+    m_batchFailed = true;
+    return false;
+  }
+
+  for (std::vector<BatchInsert>::const_iterator insert = inserts.begin(); insert != inserts.end(); ++insert)
+  {
+    try
+    {
+      size_t row = 0;
+      while (row < insert->rows.size())
+      {
+        std::string strSQL = insert->insert + " VALUES " + insert->rows[row++];
+        for (size_t count = 1; row < insert->rows.size() && count < MAX_BATCH_ROWS; ++row, ++count)
+        {
+          if (strSQL.size() + insert->rows[row].size() >= MAX_BATCH_BYTES)
+            break;
+          strSQL += "," + insert->rows[row];
+        }
+        m_pDS->exec(strSQL);
+      }
+    }
+    catch (...)
+    {
+      CLog::Log(LOGERROR, "%s - failed to execute '%s' for %u rows",
+          __FUNCTION__, insert->insert.c_str(), (unsigned int)insert->rows.size());
+      m_batchFailed = true;
+      return false;
+    }
+  }
+
+  return !m_batchFailed;
+}
+
 bool CDatabase::Open()
 {
   DatabaseSettings db_fallback;
@@ -323,7 +452,34 @@ bool CDatabase::Open(const DatabaseSettings &settings)
 
   std::string dbName = dbSettings.name;
   dbName += StringUtils::Format("%d", GetSchemaVersion());
-  return Connect(dbName, dbSettings, false);
+
+  // pick up a connection a previous instance left behind
+  std::string key = StringUtils::Format("%s:%s:%s:%s:%s", dbSettings.type.c_str(), dbSettings.host.c_str(),
+                                        dbSettings.port.c_str(), dbSettings.user.c_str(), dbName.c_str());
+  m_pool = CDatabaseManager::GetInstance().GetConnectionPool(key, dbName, m_sqlite);
+  if (m_pool)
+  {
+    m_pDB = m_pool->Acquire();
+    if (NULL != m_pDB.get())
+    {
+      m_pDS.reset(m_pDB->CreateDataset());
+      m_pDS2.reset(m_pDB->CreateDataset());
+      m_openCount = 1;
+      return true;
+    }
+  }
+
+  if (Connect(dbName, dbSettings, false))
+    return true;
+
+  if (m_pool)
+  {
+    m_pDS.reset();
+    m_pDS2.reset();
+    m_pool->Release(m_pDB);
+    m_pool.reset();
+  }
+  return false;
 }
 
 void CDatabase::InitSettings(DatabaseSettings &dbSettings)
@@ -498,6 +654,8 @@ bool CDatabase::Connect(const std::string &dbName, const DatabaseSettings &dbSet
       m_pDS->exec("PRAGMA cache_size=4096\n");
       m_pDS->exec("PRAGMA synchronous='NORMAL'\n");
       m_pDS->exec("PRAGMA count_changes='OFF'\n");
+      // readers don't block the writer and see the last commit
+      m_pDS->exec(g_advancedSettings.m_databaseWAL ? "PRAGMA journal_mode=WAL\n" : "PRAGMA journal_mode=DELETE\n");
     }
   }
   catch (DbErrors &error)
@@ -589,13 +747,24 @@ void CDatabase::Close()
 
   m_openCount = 0;
   m_multipleExecute = false;
+  m_batchDepth = 0;
+  m_batchInserts.clear();
 
   if (NULL == m_pDB.get() ) return ;
   if (NULL != m_pDS.get()) m_pDS->close();
-  m_pDB->disconnect();
-  m_pDB.reset();
   m_pDS.reset();
   m_pDS2.reset();
+  if (m_pool)
+  { // an open transaction is rolled back before another writer may start
+    m_pool->Release(m_pDB);
+    EndWrite();
+    m_pool.reset();
+  }
+  else
+  {
+    m_pDB->disconnect();
+    m_pDB.reset();
+  }
 }
 
 bool CDatabase::Compress(bool bForce /* =true */)
@@ -643,8 +812,28 @@ void CDatabase::BeginTransaction()
 {
   try
   {
-    if (NULL != m_pDB.get())
+    if (InBatch())
+    { // rolling back the savepoint must not drop rows queued before it
+      FlushBatch();
+      if (NULL != m_pDS.get())
+      {
+        m_pDS->exec(PrepareSQL("SAVEPOINT batch%i", m_batchSavepoints + 1));
+        m_batchSavepoints++;
+      }
+    }
+    else if (NULL != m_pDB.get())
+    {
+      if (m_pool && !m_writing)
+      {
+        if (!m_pool->BeginWrite(WRITE_LOCK_TIMEOUT))
+        {
+          CLog::Log(LOGERROR, "database:begintransaction failed, another writer didn't finish within %i ms", WRITE_LOCK_TIMEOUT);
+          return;
+        }
+        m_writing = true;
+      }
       m_pDB->start_transaction();
+    }
   }
   catch (...)
   {
@@ -656,8 +845,19 @@ bool CDatabase::CommitTransaction()
 {
   try
   {
-    if (NULL != m_pDB.get())
+    if (InBatch())
+    { // the batch commits, see CommitBatch()
+      if (m_batchSavepoints > 0 && NULL != m_pDS.get())
+      {
+        m_pDS->exec(PrepareSQL("RELEASE SAVEPOINT batch%i", m_batchSavepoints));
+        m_batchSavepoints--;
+      }
+    }
+    else if (NULL != m_pDB.get())
+    {
       m_pDB->commit_transaction();
+      EndWrite();
+    }
   }
   catch (...)
   {
@@ -671,8 +871,23 @@ void CDatabase::RollbackTransaction()
 {
   try
   {
-    if (NULL != m_pDB.get())
+    if (InBatch())
+    { // everything queued since the savepoint belongs to it, see BeginTransaction()
+      m_batchInserts.clear();
+      if (m_batchSavepoints == 0)
+        m_batchFailed = true;
+      else if (NULL != m_pDS.get())
+      {
+        m_pDS->exec(PrepareSQL("ROLLBACK TO SAVEPOINT batch%i", m_batchSavepoints));
+        m_pDS->exec(PrepareSQL("RELEASE SAVEPOINT batch%i", m_batchSavepoints));
+        m_batchSavepoints--;
+      }
+    }
+    else if (NULL != m_pDB.get())
+    {
       m_pDB->rollback_transaction();
+      EndWrite();
+    }
   }
   catch (...)
   {
@@ -680,9 +895,18 @@ void CDatabase::RollbackTransaction()
   }
 }
 
+void CDatabase::EndWrite()
+{
+  if (m_writing)
+  {
+    m_pool->EndWrite();
+    m_writing = false;
+  }
+}
+
 bool CDatabase::InTransaction()
 {
-  if (NULL != m_pDB.get()) return false;
+  if (NULL == m_pDB.get()) return false;
   return m_pDB->in_transaction();
 }
 
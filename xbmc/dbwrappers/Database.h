@@ -25,11 +25,13 @@ namespace dbiplus {
   class Dataset;
 }
 
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
 
 class DatabaseSettings; // forward
+class CDatabaseConnectionPool;
 class CDbUrl;
 struct SortDescription;
 
@@ -157,6 +159,62 @@ public:
    */
   bool CommitInsertQueries();
 
+  /*!
+   * @brief Start a write batch. Everything written until the matching
+   *        CommitBatch() goes into a single transaction, and rows handed to
+   *        QueueBatchInsert() are written as multi-row INSERTs. Batches nest,
+   *        only the outermost CommitBatch() writes and commits.
+   *        Transactions started inside a batch become savepoints, so rolling
+   *        one back only drops its own changes.
+   *          NOTE: Queued rows are not visible to queries until they are
+   *                flushed. Code that reads or deletes rows of a table that
+   *                may have rows queued must call FlushBatch() first.
+   * @sa QueueBatchInsert, FlushBatch, CommitBatch, RollbackBatch
+   */
+  void BeginBatch();
+
+  /*!
+   * @brief Write all queued rows and commit the batch if it is the
+   *        outermost one.
+   * @return True if the batch was written and committed, false otherwise.
+   *         A failed batch is rolled back as a whole.
+   * @sa BeginBatch
+   */
+  bool CommitBatch();
+
+  /*!
+   * @brief Drop all queued rows and roll back the outermost batch.
+   * @sa BeginBatch
+   */
+  void RollbackBatch();
+
+  /*!
+   * @brief Whether a batch was started with BeginBatch() and not yet
+   *        committed or rolled back.
+   */
+  bool InBatch() const { return m_batchDepth > 0; }
+
+  /*!
+   * @brief Queue a row for a multi-row INSERT or REPLACE. Outside of a batch
+   *        the row is written straight away.
+   * @param strInsert The statement up to the VALUES keyword, e.g.
+   *        "REPLACE INTO song_genre (idGenre, idSong, iOrder)". Rows with the
+   *        same statement are written together.
+   * @param strValues The PrepareSQL'ed row including its parentheses.
+   * @param strKey If set, a row queued earlier for the same statement and key
+   *        is replaced rather than written as well.
+   * @return True if the row was queued or written, false otherwise.
+   * @sa BeginBatch, FlushBatch
+   */
+  bool QueueBatchInsert(const std::string &strInsert, const std::string &strValues, const std::string &strKey = "");
+
+  /*!
+   * @brief Write the rows queued so far without ending the batch.
+   * @return True if the rows were written successfully, false otherwise.
+   * @sa QueueBatchInsert
+   */
+  bool FlushBatch();
+
   virtual bool GetFilter(CDbUrl &dbUrl, Filter &filter, SortDescription &sorting) { return true; }
   virtual bool BuildSQL(const std::string &strBaseDir, const std::string &strQuery, Filter &filter, std::string &strSQL, CDbUrl &dbUrl);
   virtual bool BuildSQL(const std::string &strBaseDir, const std::string &strQuery, Filter &filter, std::string &strSQL, CDbUrl &dbUrl, SortDescription &sorting);
@@ -204,6 +262,10 @@ protected:
 
   bool BuildSQL(const std::string &strQuery, const Filter &filter, std::string &strSQL);
 
+  /*! \brief INSERT that skips rows violating a unique index, in the dialect of the database.
+   */
+  std::string GetInsertIgnore() const { return m_sqlite ? "INSERT OR IGNORE" : "INSERT IGNORE"; }
+
   bool m_sqlite; ///< \brief whether we use sqlite (defaults to true)
 
   std::unique_ptr<dbiplus::Database> m_pDB;
@@ -213,6 +275,7 @@ protected:
 private:
   void InitSettings(DatabaseSettings &dbSettings);
   bool Connect(const std::string &dbName, const DatabaseSettings &db, bool create);
+  void EndWrite();
   void UpdateVersionNumber();
 
   bool m_bMultiWrite; /*!< True if there are any queries in the queue, false otherwise */
@@ -220,4 +283,18 @@ private:
 
   bool m_multipleExecute;
   std::vector<std::string> m_multipleQueries;
+
+  struct BatchInsert
+  {
+    std::string insert;
+    std::vector<std::string> rows;
+    std::map<std::string, size_t> keys; ///< \brief index into rows by key
+  };
+  std::vector<BatchInsert> m_batchInserts;
+  unsigned int m_batchDepth;
+  int m_batchSavepoints;
+  bool m_batchFailed;
+
+  std::shared_ptr<CDatabaseConnectionPool> m_pool; ///< \brief pool the connection goes back to on Close(), if any
+  bool m_writing; ///< \brief whether we hold the write lock of the pool
 };
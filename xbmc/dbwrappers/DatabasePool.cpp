@@ -0,0 +1,173 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DatabasePool.h"
+#include "dataset.h"
+#include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include "utils/TimeUtils.h"
+
+// how long a connection may sit in the pool before it is closed
+#define POOL_IDLE_TIMEOUT (5 * 60 * 1000)
+
+CDatabaseConnectionPool::CDatabaseConnectionPool(const std::string &name, unsigned int size, bool singleWriter)
+  : m_writeDepth(0),
+    m_size(size),
+    m_singleWriter(singleWriter)
+{
+  m_stats = DatabasePoolStats();
+  m_stats.name = name;
+}
+
+CDatabaseConnectionPool::~CDatabaseConnectionPool()
+{
+}
+
+std::unique_ptr<dbiplus::Database> CDatabaseConnectionPool::Acquire()
+{
+  std::vector<IdleConnection> expired;
+  CSingleLock lock(m_section);
+  TakeExpired(expired);
+  if (!expired.empty())
+  {
+    // disconnect outside of the lock, other threads may want a connection meanwhile
+    lock.Leave();
+    for (std::vector<IdleConnection>::iterator idle = expired.begin(); idle != expired.end(); ++idle)
+      idle->db->disconnect();
+    expired.clear();
+    lock.Enter();
+  }
+
+  m_stats.inUse++;
+  if (m_stats.inUse > m_stats.maxInUse)
+    m_stats.maxInUse = m_stats.inUse;
+
+  if (m_idle.empty())
+  {
+    m_stats.opened++;
+    return std::unique_ptr<dbiplus::Database>();
+  }
+
+  // the most recently used connection has the warmest caches
+  std::unique_ptr<dbiplus::Database> db(std::move(m_idle.back().db));
+  m_idle.pop_back();
+  m_stats.idle = m_idle.size();
+  m_stats.reused++;
+  return db;
+}
+
+void CDatabaseConnectionPool::Release(std::unique_ptr<dbiplus::Database> &db)
+{
+  std::unique_ptr<dbiplus::Database> closing;
+  {
+    CSingleLock lock(m_section);
+    if (m_stats.inUse > 0)
+      m_stats.inUse--;
+
+    if (db && db->isActive() && !db->in_transaction() && m_idle.size() < m_size)
+    {
+      IdleConnection idle;
+      idle.db = std::move(db);
+      idle.since = XbmcThreads::SystemClockMillis();
+      m_idle.push_back(std::move(idle));
+      m_stats.idle = m_idle.size();
+      return;
+    }
+    closing = std::move(db);
+  }
+
+  // disconnect outside of the lock, it rolls back what's left
+  if (closing)
+    closing->disconnect();
+}
+
+void CDatabaseConnectionPool::TakeExpired(std::vector<IdleConnection> &expired)
+{
+  unsigned int now = XbmcThreads::SystemClockMillis();
+  std::vector<IdleConnection>::iterator idle = m_idle.begin();
+  while (idle != m_idle.end())
+  {
+    if (now - idle->since > POOL_IDLE_TIMEOUT)
+    {
+      expired.push_back(std::move(*idle));
+      idle = m_idle.erase(idle);
+    }
+    else
+      ++idle;
+  }
+  m_stats.idle = m_idle.size();
+}
+
+bool CDatabaseConnectionPool::BeginWrite(unsigned int timeout)
+{
+  CSingleLock lock(m_section);
+  if (!m_singleWriter)
+  {
+    m_stats.writes++;
+    return true;
+  }
+
+  std::thread::id self = std::this_thread::get_id();
+  if (m_writeDepth > 0 && m_writer != self)
+  {
+    int64_t start = CurrentHostCounter();
+    XbmcThreads::EndTime endTime(timeout);
+    m_stats.writersWaiting++;
+    while (m_writeDepth > 0 && !endTime.IsTimePast())
+      m_writeDone.wait(lock, endTime.MillisLeft());
+    m_stats.writersWaiting--;
+    int64_t wait = (CurrentHostCounter() - start) * 1000000 / CurrentHostFrequency();
+
+    m_stats.writeWaits++;
+    m_stats.writeWaitTime += wait;
+    if (wait > m_stats.writeWaitTimeMax)
+      m_stats.writeWaitTimeMax = wait;
+
+    if (m_writeDepth > 0)
+    {
+      m_stats.writeTimeouts++;
+      return false;
+    }
+  }
+
+  m_writer = self;
+  m_writeDepth++;
+  m_stats.writes++;
+  return true;
+}
+
+void CDatabaseConnectionPool::EndWrite()
+{
+  if (!m_singleWriter)
+    return;
+
+  CSingleLock lock(m_section);
+  if (m_writeDepth > 0 && --m_writeDepth == 0)
+  {
+    m_writer = std::thread::id();
+    m_writeDone.notifyAll();
+  }
+}
+
+void CDatabaseConnectionPool::GetStats(DatabasePoolStats &stats)
+{
+  CSingleLock lock(m_section);
+  stats = m_stats;
+}
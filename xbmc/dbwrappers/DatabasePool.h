@@ -0,0 +1,124 @@
+#pragma once
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "threads/Condition.h"
+#include "threads/CriticalSection.h"
+
+namespace dbiplus {
+  class Database;
+}
+
+/*!
+ \ingroup database
+ \brief Statistics of a connection pool, see CDatabaseConnectionPool::GetStats()
+ */
+struct DatabasePoolStats
+{
+  std::string name;          ///< database the pool is for, e.g. MyVideos107
+  unsigned int opened;       ///< connections that had to be opened
+  unsigned int reused;       ///< connections taken from the pool
+  unsigned int inUse;        ///< connections handed out right now
+  unsigned int maxInUse;     ///< most connections handed out at once
+  unsigned int idle;         ///< connections waiting in the pool
+  unsigned int writes;       ///< write transactions started, not counting timeouts
+  unsigned int writeWaits;   ///< write transactions that waited for another writer
+  unsigned int writeTimeouts; ///< write transactions that gave up waiting
+  unsigned int writersWaiting; ///< writers waiting right now
+  int64_t writeWaitTime;     ///< total time waited for another writer, in microseconds
+  int64_t writeWaitTimeMax;  ///< longest wait for another writer, in microseconds
+};
+
+/*!
+ \ingroup database
+ \brief Keeps connections to one database open between uses.
+
+ CDatabase instances hand their connection back on Close() and pick an idle
+ one up again on Open(), so short lived readers (thumb loaders, JSON-RPC,
+ widgets) don't pay for connecting, setting up the connection and warming the
+ statement cache every time. Idle connections are closed after a while.
+
+ For SQLite the pool also lets only one connection write at a time, so a
+ writer waits for the other one to commit instead of polling the busy handler.
+ Readers are not held up, they read the last commit in WAL mode.
+ */
+class CDatabaseConnectionPool
+{
+public:
+  /*!
+   \param name the database name, for the statistics.
+   \param size the number of idle connections to keep.
+   \param singleWriter whether writers have to wait for each other.
+   */
+  CDatabaseConnectionPool(const std::string &name, unsigned int size, bool singleWriter);
+  ~CDatabaseConnectionPool();
+
+  /*! \brief Take an idle connection from the pool.
+   \return the connection, or NULL if a new one has to be opened. Either way
+   the caller has to call Release() once it's done.
+   */
+  std::unique_ptr<dbiplus::Database> Acquire();
+
+  /*! \brief Hand a connection back. Connections that are no longer active,
+   still in a transaction or beyond the pool size are closed.
+   \param db the connection, reset on return. May be empty if opening failed.
+   */
+  void Release(std::unique_ptr<dbiplus::Database> &db);
+
+  /*! \brief Wait until no other thread writes. Writes of the same thread
+   nest. Must be followed by EndWrite() on the same thread if it succeeds.
+   \param timeout how long to wait for the other writer, in milliseconds.
+   \return true if the caller may write, false if the other writer didn't
+   finish in time.
+   */
+  bool BeginWrite(unsigned int timeout);
+  void EndWrite();
+
+  void GetStats(DatabasePoolStats &stats);
+
+private:
+  CDatabaseConnectionPool(const CDatabaseConnectionPool&);
+  CDatabaseConnectionPool const& operator=(CDatabaseConnectionPool const&);
+
+  struct IdleConnection
+  {
+    std::unique_ptr<dbiplus::Database> db;
+    unsigned int since;
+  };
+
+  /*! \brief Move connections idle for too long to expired, the caller
+   disconnects them once m_section is left. */
+  void TakeExpired(std::vector<IdleConnection> &expired);
+
+  CCriticalSection m_section;   ///< protects the idle connections, the writer and statistics
+  XbmcThreads::ConditionVariable m_writeDone;
+  std::thread::id m_writer;     ///< thread writing right now
+  unsigned int m_writeDepth;    ///< nested writes of that thread
+  std::vector<IdleConnection> m_idle;
+  unsigned int m_size;
+  bool m_singleWriter;
+  DatabasePoolStats m_stats;
+};
@@ -28,6 +28,7 @@
 
 #include "dataset.h"
 #include "utils/log.h"
+#include <cstdio>
 #include <cstring>
 #include <algorithm>
 
@@ -82,6 +83,55 @@ std::string Database::prepare(const char *format, ...)
   return result;
 }
 
+std::string Database::bind_params(const std::string &sql, const ParamValues &params)
+{
+  std::string result;
+  result.reserve(sql.size());
+  size_t param = 0;
+  char quote = 0;
+
+  for (size_t i = 0; i < sql.size(); i++)
+  {
+    const char c = sql[i];
+    if (quote)
+    {
+      if (c == quote)
+        quote = 0;
+    }
+    else if (c == '\'' || c == '"')
+      quote = c;
+    else if (c == '?')
+    {
+      if (param >= params.size())
+        throw DbErrors("Missing parameter %u for query: %s", (unsigned int)param + 1, sql.c_str());
+
+      const field_value &value = params[param++];
+      if (value.get_isNull())
+        result += "NULL";
+      else if (value.get_fType() == ft_String || value.get_fType() == ft_Char)
+        result += prepare("'%s'", value.get_asString().c_str());
+      else if (value.get_fType() == ft_Boolean)
+        result += value.get_asBool() ? "1" : "0";
+      else if (value.get_fType() == ft_Float || value.get_fType() == ft_Double)
+      {
+        // enough digits for the value to read back unchanged
+        char number[32];
+        snprintf(number, sizeof(number), "%.17g", value.get_asDouble());
+        result += number;
+      }
+      else
+        result += value.get_asString();
+      continue;
+    }
+    result += c;
+  }
+
+  if (param != params.size())
+    throw DbErrors("Too many parameters for query: %s", sql.c_str());
+
+  return result;
+}
+
 //************* Dataset implementation ***************
 
 Dataset::Dataset():
@@ -91,6 +141,7 @@ Dataset::Dataset():
   db = NULL;
   haveError = active = false;
   frecno = 0;
+  sql_record_row = -1;
   fbof = feof = true;
   autocommit = true;
   fieldIndexMapID = ~0;
@@ -109,6 +160,7 @@ Dataset::Dataset(Database *newDb):
   db = newDb;
   haveError = active = false;
   frecno = 0;
+  sql_record_row = -1;
   fbof = feof = true;
   autocommit = true;
   fieldIndexMapID = ~0;
@@ -202,9 +254,18 @@ void Dataset::parse_sql(std::string &sql) {
 }
 
 
+bool Dataset::query_prepared(const std::string &sql, const ParamValues &params) {
+  return query(db->bind_params(sql, params));
+}
+
+int Dataset::exec_prepared(const std::string &sql, const ParamValues &params) {
+  return exec(db->bind_params(sql, params));
+}
+
 void Dataset::close(void) {
   haveError  = false;
   frecno = 0;
+  sql_record_row = -1;
   fbof = feof = true;
   active = false;
 
@@ -409,10 +470,14 @@ const field_value Dataset::get_field_value(int index) {
 
 const sql_record* const Dataset::get_sql_record()
 {
-  if (result.records.empty() || frecno >= (int)result.records.size())
+  if (frecno < 0)
     return NULL;
 
-  return result.records[frecno];
+  // rows walked through are only decoded once, don't keep them all
+  if (sql_record_row >= 0 && sql_record_row != frecno)
+    result.release_decoded(sql_record_row);
+  sql_record_row = frecno;
+  return result.record(frecno);
 }
 
 const field_value Dataset::f_old(const char *f_name) {
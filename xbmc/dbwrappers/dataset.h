@@ -38,10 +38,13 @@
 namespace dbiplus {
 class Dataset;		// forward declaration of class Dataset
 
+typedef std::vector<field_value> ParamValues;
+
 
 #define S_NO_CONNECTION "No active connection";
 
 #define DB_BUFF_MAX           8*1024    // Maximum buffer's capacity
+#define DB_STATEMENT_CACHE    64        // Prepared statements kept per connection
 
 #define DB_CONNECTION_NONE	0
 #define DB_CONNECTION_OK	1
@@ -162,6 +165,14 @@ public:
    */
   virtual std::string vprepare(const char *format, va_list args) = 0;
 
+  /*! \brief Substitute the '?' placeholders of a SQL statement with the escaped values of params.
+   Used by drivers that don't keep prepared statements of their own.
+   \param sql - SQL statement with one '?' per parameter, outside of quoted literals.
+   \param params - values for the placeholders, in order.
+   \return statement ready for execution or querying.
+   */
+  virtual std::string bind_params(const std::string &sql, const ParamValues &params);
+
   virtual bool in_transaction() {return false;};
 
 };
@@ -205,6 +216,7 @@ protected:
   bool active;			// Is Query Opened?
   bool haveError;
   int frecno; 			// number of current row bei bewegung
+  int sql_record_row;		// row last returned by get_sql_record, -1 for none
   std::string sql;
 
   ParamList plist;              // Paramlist for locate
@@ -307,6 +319,11 @@ public:
   virtual const void* getExecRes()=0;
 /* as open, but with our query exept Sql */
   virtual bool query(const std::string &sql) = 0;
+/* as query and exec, with the '?' placeholders of sql bound to params. SQLite
+   prepares sql once and keeps the statement with the connection, MySQL only
+   substitutes the escaped values client side through Database::bind_params */
+  virtual bool query_prepared(const std::string &sql, const ParamValues &params);
+  virtual int exec_prepared(const std::string &sql, const ParamValues &params);
 /* Close SQL Query*/
   virtual void close();
 /* This function looks for field Field_name with value equal Field_value
@@ -401,6 +418,8 @@ public:
 
 /* --------------- for fast access ---------------- */
   const result_set& get_result_set() { return result; }
+/* current row, valid until it is called for another row or the dataset is
+   closed, see result_set::record */
   const sql_record* const get_sql_record();
 
  private:
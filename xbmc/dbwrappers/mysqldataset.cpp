@@ -1416,7 +1416,7 @@ void MysqlDataset::make_deletion() {
 }
 
 void MysqlDataset::fill_fields() {
-  if ((db == NULL) || (result.record_header.empty()) || (result.records.size() < (unsigned int)frecno)) return;
+  if ((db == NULL) || (result.record_header.empty()) || (result.size() < (unsigned int)frecno)) return;
 
   if (fields_object->size() == 0) // Filling columns name
   {
@@ -1426,23 +1426,14 @@ void MysqlDataset::fill_fields() {
       (*fields_object)[i].props = result.record_header[i];
   }
 
-  //Filling result
-  if (result.records.size() != 0)
-  {
-    const sql_record *row = result.records[frecno];
-    if (row)
-    {
-      const unsigned int ncols = row->size();
-      fields_object->resize(ncols);
-      for (unsigned int i = 0; i < ncols; i++)
-        (*fields_object)[i].val = row->at(i);
-      return;
-    }
-  }
+  //Filling result, decoding only the current row
   const unsigned int ncols = result.record_header.size();
   fields_object->resize(ncols);
   for (unsigned int i = 0; i < ncols; i++)
-    (*fields_object)[i].val = "";
+  {
+    if (!result.get_field(frecno, i, (*fields_object)[i].val))
+      (*fields_object)[i].val = "";
+  }
 }
 
 //------------- public functions implementation -----------------//
@@ -1567,14 +1558,12 @@ bool MysqlDataset::query(const std::string &query) {
   for (unsigned int i = 0; i < numColumns; i++)
     result.record_header[i].name = fields[i].name;
 
-  // returned rows
+  // returned rows, kept in columns of the result set
   while ((row = mysql_fetch_row(stmt)))
   { // have a row of data
-    sql_record *res = new sql_record;
-    res->resize(numColumns);
+    result.add_row();
     for (unsigned int i = 0; i < numColumns; i++)
     {
-      field_value &v = res->at(i);
       switch (fields[i].type)
       {
         case MYSQL_TYPE_LONGLONG:
@@ -1584,46 +1573,31 @@ bool MysqlDataset::query(const std::string &query) {
         case MYSQL_TYPE_SHORT:
         case MYSQL_TYPE_INT24:
         case MYSQL_TYPE_LONG:
-          if (row[i] != NULL)
-          {
-            v.set_asInt(atoi(row[i]));
-          }
-          else
-          {
-            v.set_asInt(0);
-          }
+          result.add_int(row[i] != NULL ? atoi(row[i]) : 0);
           break;
         case MYSQL_TYPE_FLOAT:
         case MYSQL_TYPE_DOUBLE:
-          if (row[i] != NULL)
-          {
-            v.set_asDouble(atof(row[i]));
-          }
-          else
-          {
-            v.set_asDouble(0);
-          }
+          result.add_double(row[i] != NULL ? atof(row[i]) : 0);
           break;
         case MYSQL_TYPE_STRING:
         case MYSQL_TYPE_VAR_STRING:
         case MYSQL_TYPE_VARCHAR:
-          if (row[i] != NULL) v.set_asString((const char *)row[i] );
-          break;
         case MYSQL_TYPE_TINY_BLOB:
         case MYSQL_TYPE_MEDIUM_BLOB:
         case MYSQL_TYPE_LONG_BLOB:
         case MYSQL_TYPE_BLOB:
-          if (row[i] != NULL) v.set_asString((const char *)row[i]);
+          if (row[i] != NULL)
+            result.add_string(row[i], strlen(row[i]));
+          else
+            result.add_string("", 0);
           break;
         case MYSQL_TYPE_NULL:
         default:
           CLog::Log(LOGDEBUG,"MYSQL: Unknown field type: %u", fields[i].type);
-          v.set_asString("");
-          v.set_isNull();
+          result.add_null();
           break;
       }
     }
-    result.records.push_back(res);
   }
   mysql_free_result(stmt);
   active = true;
@@ -1668,7 +1642,7 @@ void MysqlDataset::cancel() {
 }
 
 int MysqlDataset::num_rows() {
-  return result.records.size();
+  return result.size();
 }
 
 bool MysqlDataset::eof() {
@@ -1702,15 +1676,8 @@ void MysqlDataset::next(void) {
 
 void MysqlDataset::free_row(void)
 {
-  if (frecno < 0 || (unsigned int)frecno >= result.records.size())
-    return;
-
-  sql_record *row = result.records[frecno];
-  if (row)
-  {
-    delete row;
-    result.records[frecno] = NULL;
-  }
+  if (frecno >= 0)
+    result.release(frecno);
 }
 
 bool MysqlDataset::seek(int pos) {
@@ -106,6 +106,11 @@ private:
 
        class 'MysqlDataset' does a query to MySQL-server
 
+       query_prepared and exec_prepared are not implemented with
+       mysql_stmt_*: the parameters are escaped and substituted into
+       the SQL on the client (Database::bind_params), so the server
+       still parses every statement.
+
 ******************************************************************/
 
 class MysqlDataset : public Dataset {
@@ -31,6 +31,7 @@
  **********************************************************************/
 
 #include "qry_dat.h"
+#include "dataset.h"
 #include "system.h" // for PRId64
 
 #include <stdio.h>
@@ -57,6 +58,13 @@ field_value::field_value(const char *s):
   is_null = false;
 }
   
+field_value::field_value(const std::string &s):
+  str_value(s)
+{
+  field_type = ft_String;
+  is_null = false;
+}
+
 field_value::field_value(const bool b) {
   bool_value = b; 
   field_type = ft_Boolean;
@@ -653,6 +661,10 @@ void field_value::set_asString(const char *s) {
   str_value = s;
   field_type = ft_String;}
 
+void field_value::set_asString(const char *s, size_t len) {
+  str_value.assign(s, len);
+  field_type = ft_String;}
+
 void field_value::set_asString(const std::string & s) {
   str_value = s;
   field_type = ft_String;}
@@ -742,4 +754,125 @@ std::string field_value::gft() {
   return tmp;
   }
 
+
+//************* result_set implementation ***************
+
+const sql_record *result_set::record(unsigned int row) const {
+  if (!records.empty())
+    return row < records.size() ? records[row] : NULL;
+  if (row >= rows)
+    return NULL;
+
+  if (decoded.size() < rows)
+    decoded.resize(rows);
+  if (!decoded[row])
+  {
+    decoded[row].reset(new sql_record(columns.size()));
+    for (unsigned int i = 0; i < columns.size(); i++)
+      get_field(row, i, (*decoded[row])[i]);
+  }
+  return decoded[row].get();
+}
+
+void result_set::release(unsigned int row) {
+  if (!records.empty())
+  {
+    if (row < records.size())
+    {
+      delete records[row];
+      records[row] = NULL;
+    }
+  }
+  else
+    release_decoded(row);
+}
+
+void result_set::release_decoded(unsigned int row) const {
+  if (row < decoded.size())
+    decoded[row].reset();
+}
+
+bool result_set::get_field(unsigned int row, unsigned int col, field_value &value) const {
+  if (!records.empty())
+  {
+    if (row >= records.size() || !records[row] || col >= records[row]->size())
+      return false;
+    value = records[row]->at(col);
+    return true;
+  }
+  if (row >= rows || col >= columns.size())
+    return false;
+
+  const cell &c = columns[col].cells[row];
+  switch (columns[col].types[row])
+  {
+  case ft_Int:
+    value.set_asInt((int)c.int64_value);
+    break;
+  case ft_Int64:
+    value.set_asInt64(c.int64_value);
+    break;
+  case ft_Double:
+    value.set_asDouble(c.double_value);
+    break;
+  case ft_String:
+    value.set_asString(text.data() + c.string_value.offset, c.string_value.length);
+    break;
+  default:
+    value.set_asString("");
+    value.set_isNull();
+    return true;
+  }
+  value.set_isNull(false);
+  return true;
+}
+
+void result_set::add_row() {
+  if (columns.size() != record_header.size())
+    columns.resize(record_header.size());
+  fill_column = 0;
+  rows++;
+}
+
+void result_set::add_cell(uint8_t type, const cell &value) {
+  if (fill_column >= columns.size())
+    throw DbErrors("Too many fields in row %u", rows);
+  column &c = columns[fill_column++];
+  c.types.push_back(type);
+  c.cells.push_back(value);
+}
+
+void result_set::add_null() {
+  cell c;
+  c.int64_value = 0;
+  add_cell(NULL_TYPE, c);
+}
+
+void result_set::add_int(int value) {
+  cell c;
+  c.int64_value = value;
+  add_cell(ft_Int, c);
+}
+
+void result_set::add_int64(int64_t value) {
+  cell c;
+  c.int64_value = value;
+  add_cell(ft_Int64, c);
+}
+
+void result_set::add_double(double value) {
+  cell c;
+  c.double_value = value;
+  add_cell(ft_Double, c);
+}
+
+void result_set::add_string(const char *value, size_t len) {
+  cell c;
+  c.string_value.offset = text.size();
+  c.string_value.length = len;
+  if (len)
+    text.append(value, len);
+  add_cell(ft_String, c);
+}
+
 } //namespace 
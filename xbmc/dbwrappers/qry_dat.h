@@ -29,6 +29,7 @@
  **********************************************************************/
 
 #include <map>
+#include <memory>
 #include <vector>
 #include <iostream>
 #include <string>
@@ -77,6 +78,7 @@ private:
 public:
   field_value();
   field_value(const char *s);
+  field_value(const std::string &s);
   field_value(const bool b);
   field_value(const char c);
   field_value(const short s);
@@ -174,8 +176,9 @@ public:
   }
   }
 
-  void set_isNull(){is_null=true;}
+  void set_isNull(bool null = true){is_null=null;}
   void set_asString(const char *s);
+  void set_asString(const char *s, size_t len);
   void set_asString(const std::string & s);
   void set_asBool(const bool b);
   void set_asChar(const char c);
@@ -218,10 +221,14 @@ typedef sql_record::iterator rec_itor;
 typedef record_prop::iterator recprop_itor;
 typedef query_data::iterator qry_itor;
 
+/* Rows of a query result. Drivers either add sql_records to records or,
+   to save the allocation of every field, add rows field by field with
+   add_row()/add_*(), which keeps them in typed columns with all strings in
+   one buffer. Such rows are only decoded into field_values when accessed. */
 class result_set
 {
 public:
-  result_set()
+  result_set() : rows(0), fill_column(0)
   {
   };
   ~result_set()
@@ -235,10 +242,63 @@ public:
         delete records[i];
     records.clear();
     record_header.clear();
+    columns.clear();
+    text.clear();
+    decoded.clear();
+    rows = 0;
   };
 
+/* number of rows, in records or in columns */
+  unsigned int size() const { return records.empty() ? rows : records.size(); }
+  bool empty() const { return size() == 0; }
+/* row as record, NULL if the row doesn't exist. Rows kept in columns are
+   decoded on first access; the record stays valid until the row is released
+   or the result set is cleared */
+  const sql_record *record(unsigned int row) const;
+/* frees the record of a row, a later record() decodes it again */
+  void release(unsigned int row);
+/* frees only the record decoded by record() for a row kept in columns, the
+   row itself stays. Callers walking a result call it once a row is consumed */
+  void release_decoded(unsigned int row) const;
+/* decodes a single field, false if the row or column doesn't exist */
+  bool get_field(unsigned int row, unsigned int col, field_value &value) const;
+
+/* start a new row kept in columns, then add one value per column of
+   record_header in order */
+  void add_row();
+  void add_null();
+  void add_int(int value);
+  void add_int64(int64_t value);
+  void add_double(double value);
+  void add_string(const char *value, size_t len);
+
   record_prop record_header;
   query_data records;
+
+private:
+  union cell
+  {
+    int64_t int64_value;
+    double double_value;
+    struct
+    {
+      uint32_t offset;
+      uint32_t length;
+    } string_value;
+  };
+  struct column
+  {
+    std::vector<uint8_t> types; // fType, or NULL_TYPE
+    std::vector<cell> cells;
+  };
+  static const uint8_t NULL_TYPE = 0xFF;
+  void add_cell(uint8_t type, const cell &value);
+
+  std::vector<column> columns;
+  std::string text;
+  unsigned int rows;
+  unsigned int fill_column;
+  mutable std::vector<std::unique_ptr<sql_record> > decoded;
 };
 
 } // namespace
@@ -100,6 +100,7 @@ SqliteDatabase::SqliteDatabase() {
   db = "sqlite.db";
   login = "root";
   passwd = "";
+  statement_cache_size = DB_STATEMENT_CACHE;
 }
 
 SqliteDatabase::~SqliteDatabase() {
@@ -261,6 +262,7 @@ bool SqliteDatabase::exists(void)
 
 void SqliteDatabase::disconnect(void) {
   if (active == false) return;
+  clear_statements();
   sqlite3_close(conn);
   active = false;
 }
@@ -416,6 +418,54 @@ void SqliteDatabase::rollback_transaction() {
 }
 
 
+// methods for prepared statements
+// ---------------------------------------------
+sqlite3_stmt *SqliteDatabase::get_statement(const std::string &sql) {
+  if (!active) throw DbErrors("No Database Connection");
+
+  std::unordered_map<std::string, StatementList::iterator>::iterator it = statement_index.find(sql);
+  if (it != statement_index.end())
+  {
+    statements.splice(statements.begin(), statements, it->second);
+    return it->second->second;
+  }
+
+  sqlite3_stmt *stmt = NULL;
+  if (setErr(sqlite3_prepare_v2(conn, sql.c_str(), -1, &stmt, NULL), sql.c_str()) != SQLITE_OK)
+    throw DbErrors(getErrorMsg());
+
+  statements.push_front(std::make_pair(sql, stmt));
+  statement_index[sql] = statements.begin();
+
+  while (statements.size() > statement_cache_size)
+  {
+    sqlite3_finalize(statements.back().second);
+    statement_index.erase(statements.back().first);
+    statements.pop_back();
+  }
+
+  return stmt;
+}
+
+void SqliteDatabase::clear_statements() {
+  for (StatementList::iterator it = statements.begin(); it != statements.end(); ++it)
+    sqlite3_finalize(it->second);
+  statements.clear();
+  statement_index.clear();
+}
+
+void SqliteDatabase::set_statement_cache_size(unsigned int size) {
+  // the statement in use has to survive its own insertion
+  statement_cache_size = size > 0 ? size : 1;
+  while (statements.size() > statement_cache_size)
+  {
+    sqlite3_finalize(statements.back().second);
+    statement_index.erase(statements.back().first);
+    statements.pop_back();
+  }
+}
+
+
 // methods for formatting
 // ---------------------------------------------
 std::string SqliteDatabase::vprepare(const char *format, va_list args)
@@ -538,7 +588,7 @@ void SqliteDataset::make_deletion() {
 
 void SqliteDataset::fill_fields() {
   //cout <<"rr "<<result.records.size()<<"|" << frecno <<"\n";
-  if ((db == NULL) || (result.record_header.empty()) || (result.records.size() < (unsigned int)frecno)) return;
+  if ((db == NULL) || (result.record_header.empty()) || (result.size() < (unsigned int)frecno)) return;
 
   if (fields_object->size() == 0) // Filling columns name
   {
@@ -548,23 +598,108 @@ void SqliteDataset::fill_fields() {
       (*fields_object)[i].props = result.record_header[i];
   }
 
-  //Filling result
-  if (result.records.size() != 0)
+  //Filling result, decoding only the current row
+  const unsigned int ncols = result.record_header.size();
+  fields_object->resize(ncols);
+  for (unsigned int i = 0; i < ncols; i++)
   {
-    const sql_record *row = result.records[frecno];
-    if (row)
+    if (!result.get_field(frecno, i, (*fields_object)[i].val))
+      (*fields_object)[i].val = "";
+  }
+}
+
+
+void SqliteDataset::fetch_rows(sqlite3_stmt *stmt) {
+  // column headers
+  const unsigned int numColumns = sqlite3_column_count(stmt);
+  result.record_header.resize(numColumns);
+  for (unsigned int i = 0; i < numColumns; i++)
+    result.record_header[i].name = sqlite3_column_name(stmt, i);
+
+  // returned rows, kept in columns of the result set
+  while (sqlite3_step(stmt) == SQLITE_ROW)
+  { // have a row of data
+    result.add_row();
+    for (unsigned int i = 0; i < numColumns; i++)
     {
-      const unsigned int ncols = row->size();
-      fields_object->resize(ncols);
-      for (unsigned int i = 0; i < ncols; i++)
-        (*fields_object)[i].val = row->at(i);
-      return;
+      switch (sqlite3_column_type(stmt, i))
+      {
+      case SQLITE_INTEGER:
+        result.add_int64(sqlite3_column_int64(stmt, i));
+        break;
+      case SQLITE_FLOAT:
+        result.add_double(sqlite3_column_double(stmt, i));
+        break;
+      case SQLITE_TEXT:
+      {
+        const char *text = (const char *)sqlite3_column_text(stmt, i);
+        result.add_string(text, sqlite3_column_bytes(stmt, i));
+        break;
+      }
+      case SQLITE_BLOB:
+      {
+        // as text up to the first NUL, like it was always read
+        const char *text = (const char *)sqlite3_column_text(stmt, i);
+        result.add_string(text, text ? strlen(text) : 0);
+        break;
+      }
+      case SQLITE_NULL:
+      default:
+        result.add_null();
+        break;
+      }
+    }
+  }
+}
+
+
+void SqliteDataset::bind_statement(sqlite3_stmt *stmt, const std::string &sql, const ParamValues &params) {
+  // the statement stays in the cache, leave it ready for the next caller
+  if ((unsigned int)sqlite3_bind_parameter_count(stmt) != params.size())
+  {
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+    throw DbErrors("Parameter count mismatch for query: %s", sql.c_str());
+  }
+
+  for (unsigned int i = 0; i < params.size(); i++)
+  {
+    const field_value &value = params[i];
+    int res;
+    if (value.get_isNull())
+      res = sqlite3_bind_null(stmt, i + 1);
+    else
+    {
+      switch (value.get_fType())
+      {
+      case ft_Boolean:
+      case ft_Short:
+      case ft_UShort:
+      case ft_Int:
+      case ft_UInt:
+      case ft_Int64:
+        res = sqlite3_bind_int64(stmt, i + 1, value.get_asInt64());
+        break;
+      case ft_Float:
+      case ft_Double:
+      case ft_LongDouble:
+        res = sqlite3_bind_double(stmt, i + 1, value.get_asDouble());
+        break;
+      default:
+      {
+        std::string str = value.get_asString();
+        res = sqlite3_bind_text(stmt, i + 1, str.c_str(), str.size(), SQLITE_TRANSIENT);
+        break;
+      }
+      }
+    }
+    if (db->setErr(res, sql.c_str()) != SQLITE_OK)
+    {
+      sqlite3_reset(stmt);
+      sqlite3_clear_bindings(stmt);
+      throw DbErrors(db->getErrorMsg());
     }
   }
-  const unsigned int ncols = result.record_header.size();
-  fields_object->resize(ncols);
-  for (unsigned int i = 0; i < ncols; i++)
-    (*fields_object)[i].val = "";
 }
 
 
@@ -654,43 +789,8 @@ bool SqliteDataset::query(const std::string &query) {
   if (db->setErr(sqlite3_prepare_v2(handle(),query.c_str(),-1,&stmt, NULL),query.c_str()) != SQLITE_OK)
     throw DbErrors(db->getErrorMsg());
 
-  // column headers
-  const unsigned int numColumns = sqlite3_column_count(stmt);
-  result.record_header.resize(numColumns);
-  for (unsigned int i = 0; i < numColumns; i++)
-    result.record_header[i].name = sqlite3_column_name(stmt, i);
+  fetch_rows(stmt);
 
-  // returned rows
-  while (sqlite3_step(stmt) == SQLITE_ROW)
-  { // have a row of data
-    sql_record *res = new sql_record;
-    res->resize(numColumns);
-    for (unsigned int i = 0; i < numColumns; i++)
-    {
-      field_value &v = res->at(i);
-      switch (sqlite3_column_type(stmt, i))
-      {
-      case SQLITE_INTEGER:
-        v.set_asInt64(sqlite3_column_int64(stmt, i));
-        break;
-      case SQLITE_FLOAT:
-        v.set_asDouble(sqlite3_column_double(stmt, i));
-        break;
-      case SQLITE_TEXT:
-        v.set_asString((const char *)sqlite3_column_text(stmt, i));
-        break;
-      case SQLITE_BLOB:
-        v.set_asString((const char *)sqlite3_column_text(stmt, i));
-        break;
-      case SQLITE_NULL:
-      default:
-        v.set_asString("");
-        v.set_isNull();
-        break;
-      }
-    }
-    result.records.push_back(res);
-  }
   if (db->setErr(sqlite3_finalize(stmt),query.c_str()) == SQLITE_OK)
   {
     active = true;
@@ -704,6 +804,44 @@ bool SqliteDataset::query(const std::string &query) {
   }  
 }
 
+bool SqliteDataset::query_prepared(const std::string &sql, const ParamValues &params) {
+  if(!handle()) throw DbErrors("No Database Connection");
+
+  close();
+
+  sqlite3_stmt *stmt = static_cast<SqliteDatabase*>(db)->get_statement(sql);
+  bind_statement(stmt, sql, params);
+  fetch_rows(stmt);
+
+  // reset returns the error of the last step, bound strings are freed
+  int res = sqlite3_reset(stmt);
+  sqlite3_clear_bindings(stmt);
+  if (db->setErr(res, sql.c_str()) != SQLITE_OK)
+    throw DbErrors(db->getErrorMsg());
+
+  active = true;
+  ds_state = dsSelect;
+  this->first();
+  return true;
+}
+
+int SqliteDataset::exec_prepared(const std::string &sql, const ParamValues &params) {
+  if (!handle()) throw DbErrors("No Database Connection");
+  exec_res.clear();
+
+  sqlite3_stmt *stmt = static_cast<SqliteDatabase*>(db)->get_statement(sql);
+  bind_statement(stmt, sql, params);
+  while (sqlite3_step(stmt) == SQLITE_ROW)
+    ;
+
+  int res = sqlite3_reset(stmt);
+  sqlite3_clear_bindings(stmt);
+  if (db->setErr(res, sql.c_str()) != SQLITE_OK)
+    throw DbErrors(db->getErrorMsg());
+
+  return res;
+}
+
 void SqliteDataset::open(const std::string &sql) {
   set_select_sql(sql);
   open();
@@ -740,7 +878,7 @@ void SqliteDataset::cancel() {
 
 
 int SqliteDataset::num_rows() {
-  return result.records.size();
+  return result.size();
 }
 
 
@@ -777,15 +915,8 @@ void SqliteDataset::next(void) {
 
 void SqliteDataset::free_row(void)
 {
-  if (frecno < 0 || (unsigned int)frecno >= result.records.size())
-    return;
-
-  sql_record *row = result.records[frecno];
-  if (row)
-  {
-    delete row;
-    result.records[frecno] = NULL;
-  }
+  if (frecno >= 0)
+    result.release(frecno);
 }
 
 bool SqliteDataset::seek(int pos) {
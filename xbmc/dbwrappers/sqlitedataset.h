@@ -29,6 +29,8 @@
  **********************************************************************/
 
 #include <stdio.h>
+#include <list>
+#include <unordered_map>
 #include "dataset.h"
 #include <sqlite3.h>
 
@@ -45,6 +47,12 @@ protected:
   bool _in_transaction;
   int last_err;
 
+/* prepared statements of this connection, most recently used first */
+  typedef std::list<std::pair<std::string, sqlite3_stmt*> > StatementList;
+  StatementList statements;
+  std::unordered_map<std::string, StatementList::iterator> statement_index;
+  unsigned int statement_cache_size;
+
 public:
 /* default constructor */
   SqliteDatabase();
@@ -96,6 +104,15 @@ public:
 
   bool in_transaction() {return _in_transaction;}; 	
 
+/* prepared statements */
+
+/* func. returns the prepared statement for sql, from the cache if possible.
+   The statement is reset and stays owned by the connection */
+  sqlite3_stmt *get_statement(const std::string &sql);
+/* func. finalizes all cached statements */
+  void clear_statements();
+/* sets the number of statements kept, least recently used go first */
+  void set_statement_cache_size(unsigned int size);
 };
 
 
@@ -121,6 +138,11 @@ protected:
 
   //static int sqlite_callback(void* res_ptr,int ncol, char** reslt, char** cols);
 
+/* Fills the result set from a prepared statement */
+  void fetch_rows(sqlite3_stmt *stmt);
+/* Binds params to the placeholders of a cached statement */
+  void bind_statement(sqlite3_stmt *stmt, const std::string &sql, const ParamValues &params);
+
 /* This function works only with MySQL database
   Filling the fields information from select statement */
   virtual void fill_fields();
@@ -148,6 +170,9 @@ or insert() operations default = false) */
   virtual const void* getExecRes();
 /* as open, but with our query exept Sql */
   virtual bool query(const std::string &query);
+/* as query and exec, using a statement from the cache of the connection */
+  virtual bool query_prepared(const std::string &sql, const ParamValues &params);
+  virtual int exec_prepared(const std::string &sql, const ParamValues &params);
 /* func. closes a query */
   virtual void close(void);
 /* Cancel changes, made in insert or edit states of dataset */
@@ -0,0 +1,225 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "dbwrappers/Database.h"
+#include "dbwrappers/sqlitedataset.h"
+#include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
+#include "utils/StringUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <iostream>
+
+using namespace dbiplus;
+
+namespace
+{
+
+const int SCAN_ALBUMS = 50;
+const int SCAN_SONGS = 12;
+const int SCAN_LINKS = 4;
+
+class CTestDatabase : public CDatabase
+{
+public:
+  CTestDatabase(const std::string &path)
+  {
+    m_pDB.reset(new SqliteDatabase());
+    m_pDB->setHostName(path.c_str());
+    m_pDB->setDatabase("TestDatabase");
+    m_pDB->connect(true);
+    m_pDS.reset(m_pDB->CreateDataset());
+    m_pDS2.reset(m_pDB->CreateDataset());
+  }
+
+  int Count(const std::string &where = "1")
+  {
+    return (int)strtol(GetSingleValue("SELECT COUNT(*) FROM link WHERE " + where).c_str(), NULL, 10);
+  }
+
+  void QueueLink(int idItem, int idValue)
+  {
+    QueueBatchInsert(GetInsertIgnore() + " INTO link (idItem, idValue)", PrepareSQL("(%i,%i)", idItem, idValue));
+  }
+
+  using CDatabase::GetInsertIgnore;
+
+protected:
+  virtual void CreateTables() {}
+  virtual void CreateAnalytics() {}
+  virtual int GetSchemaVersion() const { return 1; }
+  virtual const char *GetBaseDBName() const { return "TestDatabase"; }
+};
+
+class TestDatabase : public testing::Test
+{
+protected:
+  TestDatabase()
+  {
+    m_path = CSpecialProtocol::TranslatePath("special://temp/");
+    XFILE::CFile::Delete(m_path + "TestDatabase.db");
+    m_db.reset(new CTestDatabase(m_path));
+    m_db->ExecuteQuery("CREATE TABLE item (idItem integer primary key, strName text)");
+    m_db->ExecuteQuery("CREATE TABLE link (idItem integer, idValue integer)");
+    m_db->ExecuteQuery("CREATE UNIQUE INDEX ix_link ON link (idItem, idValue)");
+    m_db->ExecuteQuery("CREATE TABLE art (idItem integer, type text, url text)");
+  }
+
+  ~TestDatabase()
+  {
+    m_db.reset();
+    XFILE::CFile::Delete(m_path + "TestDatabase.db");
+  }
+
+  // what the scanners did for every album: one transaction, one statement per row
+  void AddAlbum(int album, bool batch)
+  {
+    if (batch)
+      m_db->BeginBatch();
+    else
+      m_db->BeginTransaction();
+    for (int song = 0; song < SCAN_SONGS; song++)
+    {
+      int idItem = album * SCAN_SONGS + song;
+      m_db->ExecuteQuery(m_db->PrepareSQL("INSERT INTO item (idItem, strName) VALUES (%i, 'song %i')", idItem, idItem));
+      for (int value = 0; value < SCAN_LINKS; value++)
+      {
+        if (batch)
+          m_db->QueueLink(idItem, value);
+        else if (m_db->GetSingleValue(m_db->PrepareSQL("SELECT 1 FROM link WHERE idItem=%i AND idValue=%i", idItem, value)).empty())
+          m_db->ExecuteQuery(m_db->PrepareSQL("INSERT INTO link (idItem, idValue) VALUES (%i, %i)", idItem, value));
+      }
+    }
+    if (batch)
+      m_db->CommitBatch();
+    else
+      m_db->CommitTransaction();
+  }
+
+  double Scan(bool batch)
+  {
+    auto start = std::chrono::steady_clock::now();
+    for (int album = 0; album < SCAN_ALBUMS; album++)
+      AddAlbum(album + (batch ? SCAN_ALBUMS : 0), batch);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+  }
+
+  std::string m_path;
+  std::unique_ptr<CTestDatabase> m_db;
+};
+
+}
+
+TEST_F(TestDatabase, Batch)
+{
+  m_db->BeginBatch();
+  EXPECT_TRUE(m_db->InBatch());
+  m_db->QueueLink(1, 1);
+  m_db->QueueLink(1, 2);
+  m_db->QueueLink(1, 1);
+  EXPECT_EQ(0, m_db->Count());
+
+  // nested batches commit with the outermost one
+  m_db->BeginBatch();
+  m_db->QueueLink(2, 1);
+  EXPECT_TRUE(m_db->CommitBatch());
+  EXPECT_EQ(0, m_db->Count());
+
+  EXPECT_TRUE(m_db->FlushBatch());
+  EXPECT_EQ(3, m_db->Count());
+  EXPECT_TRUE(m_db->CommitBatch());
+  EXPECT_FALSE(m_db->InBatch());
+  EXPECT_EQ(3, m_db->Count());
+
+  // outside of a batch rows are written straight away
+  m_db->QueueLink(3, 1);
+  EXPECT_EQ(4, m_db->Count());
+}
+
+TEST_F(TestDatabase, BatchKey)
+{
+  m_db->BeginBatch();
+  m_db->QueueBatchInsert("INSERT INTO art (idItem, type, url)", "(1, 'thumb', 'a.jpg')", "1/thumb");
+  m_db->QueueBatchInsert("INSERT INTO art (idItem, type, url)", "(1, 'fanart', 'b.jpg')", "1/fanart");
+  m_db->QueueBatchInsert("INSERT INTO art (idItem, type, url)", "(1, 'thumb', 'c.jpg')", "1/thumb");
+  EXPECT_TRUE(m_db->CommitBatch());
+
+  EXPECT_EQ("2", m_db->GetSingleValue("SELECT COUNT(*) FROM art"));
+  EXPECT_EQ("c.jpg", m_db->GetSingleValue("SELECT url FROM art WHERE type='thumb'"));
+}
+
+TEST_F(TestDatabase, BatchRows)
+{
+  // more rows than go into a single statement
+  m_db->BeginBatch();
+  for (int i = 0; i < 1000; i++)
+    m_db->QueueLink(i / 10, i % 10);
+  EXPECT_TRUE(m_db->CommitBatch());
+  EXPECT_EQ(1000, m_db->Count());
+}
+
+TEST_F(TestDatabase, BatchRollback)
+{
+  m_db->BeginBatch();
+  m_db->QueueLink(1, 1);
+
+  // a failing item only takes its own changes along
+  m_db->BeginTransaction();
+  m_db->QueueLink(2, 1);
+  m_db->ExecuteQuery("INSERT INTO item (idItem, strName) VALUES (2, 'two')");
+  m_db->RollbackTransaction();
+
+  m_db->BeginTransaction();
+  m_db->QueueLink(3, 1);
+  m_db->ExecuteQuery("INSERT INTO item (idItem, strName) VALUES (3, 'three')");
+  EXPECT_TRUE(m_db->CommitTransaction());
+
+  EXPECT_TRUE(m_db->CommitBatch());
+  EXPECT_EQ(2, m_db->Count());
+  EXPECT_EQ(0, m_db->Count("idItem = 2"));
+  EXPECT_EQ("three", m_db->GetSingleValue("SELECT strName FROM item"));
+
+  // a failing row fails the whole batch
+  m_db->BeginBatch();
+  m_db->QueueLink(4, 1);
+  m_db->QueueBatchInsert("INSERT INTO link (idItem, idValue)", "(1, 1)");
+  EXPECT_FALSE(m_db->CommitBatch());
+  EXPECT_EQ(0, m_db->Count("idItem = 4"));
+
+  m_db->BeginBatch();
+  m_db->QueueLink(5, 1);
+  m_db->RollbackBatch();
+  EXPECT_FALSE(m_db->InBatch());
+  EXPECT_EQ(0, m_db->Count("idItem = 5"));
+}
+
+// prints timings only, run with --gtest_also_run_disabled_tests
+TEST_F(TestDatabase, DISABLED_BenchmarkBatch)
+{
+  double single = Scan(false);
+  double batch = Scan(true);
+  EXPECT_EQ(SCAN_ALBUMS * SCAN_SONGS * SCAN_LINKS * 2, m_db->Count());
+
+  std::cout << SCAN_ALBUMS << " albums of " << SCAN_SONGS << " songs with " << SCAN_LINKS << " links each: "
+            << "row by row " << single * 1000 << " ms, batched " << batch * 1000 << " ms" << std::endl;
+}
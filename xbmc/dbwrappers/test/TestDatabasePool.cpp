@@ -0,0 +1,284 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "dbwrappers/DatabasePool.h"
+#include "dbwrappers/sqlitedataset.h"
+#include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
+#include "threads/Event.h"
+#include "threads/SystemClock.h"
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+using namespace dbiplus;
+
+namespace
+{
+
+const int BENCHMARK_QUERIES = 200;
+
+class TestDatabasePool : public testing::Test
+{
+protected:
+  TestDatabasePool()
+  {
+    m_path = CSpecialProtocol::TranslatePath("special://temp/");
+    Delete();
+
+    std::unique_ptr<Database> db(Connect());
+    std::unique_ptr<Dataset> ds(db->CreateDataset());
+    ds->exec("CREATE TABLE item (idItem integer primary key, strName text)");
+    ds->exec("INSERT INTO item (strName) VALUES ('one')");
+  }
+
+  ~TestDatabasePool()
+  {
+    Delete();
+  }
+
+  void Delete()
+  {
+    XFILE::CFile::Delete(m_path + "TestDatabasePool.db");
+    XFILE::CFile::Delete(m_path + "TestDatabasePool.db-wal");
+    XFILE::CFile::Delete(m_path + "TestDatabasePool.db-shm");
+  }
+
+  // what CDatabase::Connect() does for sqlite
+  Database *Connect()
+  {
+    Database *db = new SqliteDatabase();
+    db->setHostName(m_path.c_str());
+    db->setDatabase("TestDatabasePool");
+    db->connect(true);
+    std::unique_ptr<Dataset> ds(db->CreateDataset());
+    ds->exec("PRAGMA cache_size=4096\n");
+    ds->exec("PRAGMA synchronous='NORMAL'\n");
+    ds->exec("PRAGMA count_changes='OFF'\n");
+    ds->exec("PRAGMA journal_mode=WAL\n");
+    return db;
+  }
+
+  void Open(CDatabaseConnectionPool &pool, std::unique_ptr<Database> &db)
+  {
+    db = pool.Acquire();
+    if (!db)
+      db.reset(Connect());
+  }
+
+  int Count(Database *db)
+  {
+    std::unique_ptr<Dataset> ds(db->CreateDataset());
+    ds->query("SELECT COUNT(*) FROM item");
+    return ds->fv(0).get_asInt();
+  }
+
+  // whether another thread blocks in BeginWrite() within the timeout
+  bool WaitForWriter(CDatabaseConnectionPool &pool, unsigned int timeout)
+  {
+    XbmcThreads::EndTime endTime(timeout);
+    DatabasePoolStats stats;
+    for (pool.GetStats(stats); stats.writersWaiting == 0; pool.GetStats(stats))
+    {
+      if (endTime.IsTimePast())
+        return false;
+      std::this_thread::yield();
+    }
+    return true;
+  }
+
+  std::string m_path;
+};
+
+}
+
+TEST_F(TestDatabasePool, Reuse)
+{
+  CDatabaseConnectionPool pool("TestDatabasePool", 2, true);
+  std::unique_ptr<Database> db = pool.Acquire();
+  EXPECT_FALSE(db);
+  db.reset(Connect());
+  Database *first = db.get();
+  pool.Release(db);
+  EXPECT_FALSE(db);
+
+  Open(pool, db);
+  EXPECT_EQ(first, db.get());
+  EXPECT_EQ(1, Count(db.get()));
+
+  DatabasePoolStats stats;
+  pool.GetStats(stats);
+  EXPECT_EQ("TestDatabasePool", stats.name);
+  EXPECT_EQ(1u, stats.opened);
+  EXPECT_EQ(1u, stats.reused);
+  EXPECT_EQ(1u, stats.inUse);
+  EXPECT_EQ(0u, stats.idle);
+  pool.Release(db);
+}
+
+TEST_F(TestDatabasePool, Size)
+{
+  CDatabaseConnectionPool pool("TestDatabasePool", 2, true);
+  std::unique_ptr<Database> db[3];
+  for (int i = 0; i < 3; i++)
+    Open(pool, db[i]);
+  for (int i = 0; i < 3; i++)
+    pool.Release(db[i]);
+
+  DatabasePoolStats stats;
+  pool.GetStats(stats);
+  EXPECT_EQ(3u, stats.opened);
+  EXPECT_EQ(3u, stats.maxInUse);
+  EXPECT_EQ(0u, stats.inUse);
+  EXPECT_EQ(2u, stats.idle);
+}
+
+TEST_F(TestDatabasePool, Transaction)
+{
+  CDatabaseConnectionPool pool("TestDatabasePool", 2, true);
+  std::unique_ptr<Database> db;
+  Open(pool, db);
+  db->start_transaction();
+  std::unique_ptr<Dataset> ds(db->CreateDataset());
+  ds->exec("INSERT INTO item (strName) VALUES ('two')");
+  ds.reset();
+
+  // a connection left in a transaction is rolled back and closed
+  pool.Release(db);
+  DatabasePoolStats stats;
+  pool.GetStats(stats);
+  EXPECT_EQ(0u, stats.idle);
+
+  Open(pool, db);
+  EXPECT_EQ(1, Count(db.get()));
+  pool.Release(db);
+}
+
+TEST_F(TestDatabasePool, SingleWriter)
+{
+  CDatabaseConnectionPool pool("TestDatabasePool", 2, true);
+  std::unique_ptr<Database> writer, reader;
+  Open(pool, writer);
+  Open(pool, reader);
+
+  ASSERT_TRUE(pool.BeginWrite(1000));
+  writer->start_transaction();
+  std::unique_ptr<Dataset> ds(writer->CreateDataset());
+  ds->exec("INSERT INTO item (strName) VALUES ('two')");
+
+  CEvent written;
+  std::thread other([&pool, &written]()
+  {
+    if (pool.BeginWrite(10000))
+    {
+      written.Set();
+      pool.EndWrite();
+    }
+  });
+
+  // readers are not held up by the writer and see the last commit
+  EXPECT_EQ(1, Count(reader.get()));
+  ASSERT_TRUE(WaitForWriter(pool, 10000));
+  EXPECT_FALSE(written.WaitMSec(0));
+  writer->commit_transaction();
+  pool.EndWrite();
+  EXPECT_TRUE(written.WaitMSec(10000));
+  other.join();
+  EXPECT_EQ(2, Count(reader.get()));
+
+  DatabasePoolStats stats;
+  pool.GetStats(stats);
+  EXPECT_EQ(2u, stats.writes);
+  EXPECT_EQ(1u, stats.writeWaits);
+  EXPECT_EQ(0u, stats.writeTimeouts);
+  EXPECT_EQ(0u, stats.writersWaiting);
+  EXPECT_GT(stats.writeWaitTime, 0);
+  EXPECT_EQ(stats.writeWaitTime, stats.writeWaitTimeMax);
+
+  ds.reset();
+  pool.Release(writer);
+  pool.Release(reader);
+}
+
+TEST_F(TestDatabasePool, WriteTimeout)
+{
+  CDatabaseConnectionPool pool("TestDatabasePool", 2, true);
+
+  // writes of the same thread nest
+  ASSERT_TRUE(pool.BeginWrite(0));
+  ASSERT_TRUE(pool.BeginWrite(0));
+  pool.EndWrite();
+
+  bool began = true;
+  std::thread other([&pool, &began]()
+  {
+    began = pool.BeginWrite(10);
+  });
+  other.join();
+  EXPECT_FALSE(began);
+
+  pool.EndWrite();
+  other = std::thread([&pool, &began]()
+  {
+    began = pool.BeginWrite(0);
+    if (began)
+      pool.EndWrite();
+  });
+  other.join();
+  EXPECT_TRUE(began);
+
+  DatabasePoolStats stats;
+  pool.GetStats(stats);
+  EXPECT_EQ(3u, stats.writes);
+  EXPECT_EQ(1u, stats.writeTimeouts);
+  EXPECT_EQ(0u, stats.writersWaiting);
+}
+
+// prints timings only, run with --gtest_also_run_disabled_tests
+TEST_F(TestDatabasePool, DISABLED_BenchmarkOpen)
+{
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < BENCHMARK_QUERIES; i++)
+  {
+    std::unique_ptr<Database> db(Connect());
+    Count(db.get());
+  }
+  std::chrono::duration<double> connect = std::chrono::steady_clock::now() - start;
+
+  CDatabaseConnectionPool pool("TestDatabasePool", 2, true);
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < BENCHMARK_QUERIES; i++)
+  {
+    std::unique_ptr<Database> db;
+    Open(pool, db);
+    Count(db.get());
+    pool.Release(db);
+  }
+  std::chrono::duration<double> pooled = std::chrono::steady_clock::now() - start;
+
+  DatabasePoolStats stats;
+  pool.GetStats(stats);
+  EXPECT_EQ(1u, stats.opened);
+  std::cout << BENCHMARK_QUERIES << " open, query, close: connecting " << connect.count() * 1000
+            << " ms, pooled " << pooled.count() * 1000 << " ms" << std::endl;
+}
@@ -0,0 +1,310 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "dbwrappers/sqlitedataset.h"
+#include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
+#include "utils/StringUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+
+using namespace dbiplus;
+
+namespace
+{
+
+const int SCAN_FOLDERS = 100;
+const int SCAN_FILES = 20;
+
+class TestSqliteDataset : public testing::Test
+{
+protected:
+  TestSqliteDataset()
+  {
+    m_path = CSpecialProtocol::TranslatePath("special://temp/");
+    XFILE::CFile::Delete(m_path + "TestSqliteDataset.db");
+    m_db.setHostName(m_path.c_str());
+    m_db.setDatabase("TestSqliteDataset");
+    m_db.connect(true);
+    m_ds.reset(m_db.CreateDataset());
+    m_ds->exec("CREATE TABLE path ( idPath integer primary key, strPath text, dateAdded text, idParentPath integer)");
+    m_ds->exec("CREATE UNIQUE INDEX ix_path ON path ( strPath )");
+    m_ds->exec("CREATE TABLE files ( idFile integer primary key, idPath integer, strFilename text)");
+    m_ds->exec("CREATE INDEX ix_files ON files ( idPath, strFilename )");
+  }
+
+  ~TestSqliteDataset()
+  {
+    m_ds.reset();
+    m_db.disconnect();
+    XFILE::CFile::Delete(m_path + "TestSqliteDataset.db");
+  }
+
+  // the lookups a library scan does for every file, as CVideoDatabase::AddFile
+  int AddFile(const std::string &path, const std::string &file, bool prepared)
+  {
+    int idPath;
+    if (prepared)
+      m_ds->query_prepared("select idPath from path where strPath=?", { path });
+    else
+      m_ds->query(m_db.prepare("select idPath from path where strPath='%s'", path.c_str()));
+    if (m_ds->eof())
+    {
+      if (prepared)
+        m_ds->exec_prepared("insert into path (idPath, strPath) values (NULL, ?)", { path });
+      else
+        m_ds->exec(m_db.prepare("insert into path (idPath, strPath) values (NULL, '%s')", path.c_str()));
+      idPath = (int)m_ds->lastinsertid();
+    }
+    else
+      idPath = m_ds->fv("idPath").get_asInt();
+    m_ds->close();
+
+    if (prepared)
+      m_ds->query_prepared("select idFile from files where strFileName=? and idPath=?", { file, idPath });
+    else
+      m_ds->query(m_db.prepare("select idFile from files where strFileName='%s' and idPath=%i", file.c_str(), idPath));
+    if (!m_ds->eof())
+    {
+      int idFile = m_ds->fv("idFile").get_asInt();
+      m_ds->close();
+      return idFile;
+    }
+    m_ds->close();
+
+    if (prepared)
+      m_ds->exec_prepared("insert into files (idFile, idPath, strFileName) values(NULL, ?, ?)", { idPath, file });
+    else
+      m_ds->exec(m_db.prepare("insert into files (idFile, idPath, strFileName) values(NULL, %i, '%s')", idPath, file.c_str()));
+    return (int)m_ds->lastinsertid();
+  }
+
+  double Scan(bool prepared)
+  {
+    auto start = std::chrono::steady_clock::now();
+    m_db.start_transaction();
+    for (int folder = 0; folder < SCAN_FOLDERS; folder++)
+    {
+      std::string path = StringUtils::Format("smb://server/movies/%s %d/", prepared ? "b" : "a", folder);
+      for (int file = 0; file < SCAN_FILES; file++)
+        AddFile(path, StringUtils::Format("movie's part %d.mkv", file), prepared);
+    }
+    m_db.commit_transaction();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+  }
+
+  std::string m_path;
+  SqliteDatabase m_db;
+  std::unique_ptr<Dataset> m_ds;
+};
+
+}
+
+TEST_F(TestSqliteDataset, Prepared)
+{
+  int first = AddFile("/movies/it's here/", "a.mkv", true);
+  EXPECT_EQ(first, AddFile("/movies/it's here/", "a.mkv", false));
+  EXPECT_EQ(first, AddFile("/movies/it's here/", "a.mkv", true));
+  EXPECT_NE(first, AddFile("/movies/it's here/", "b.mkv", true));
+
+  field_value parent;
+  parent.set_isNull();
+  m_ds->exec_prepared("insert into path (idPath, strPath, dateAdded, idParentPath) values (NULL, ?, ?, ?)",
+                      { "/music/", 2.5, parent });
+  m_ds->query_prepared("select * from path where strPath=?", { "/music/" });
+  ASSERT_EQ(1, m_ds->num_rows());
+  EXPECT_DOUBLE_EQ(2.5, m_ds->fv("dateAdded").get_asDouble());
+  EXPECT_TRUE(m_ds->fv("idParentPath").get_isNull());
+  m_ds->close();
+
+  EXPECT_THROW(m_ds->query_prepared("select * from path where strPath=?", {}), DbErrors);
+  EXPECT_THROW(m_ds->query_prepared("select * from nothing where strPath=?", { "/" }), DbErrors);
+
+  // the cached statement is still usable after a failed bind
+  m_ds->query_prepared("select * from path where strPath=?", { "/music/" });
+  EXPECT_EQ(1, m_ds->num_rows());
+  m_ds->close();
+}
+
+TEST_F(TestSqliteDataset, StatementCache)
+{
+  m_db.set_statement_cache_size(2);
+  for (int i = 0; i < 3; i++)
+  {
+    // three statements through a cache of two, each evicts the oldest
+    AddFile("/tv/", "a.mkv", true);
+    m_ds->query_prepared("select count(*) from files where idPath=?", { 1 });
+    EXPECT_EQ(1, m_ds->fv(0).get_asInt());
+    m_ds->close();
+  }
+  m_db.clear_statements();
+  EXPECT_EQ(1, AddFile("/tv/", "a.mkv", true));
+}
+
+TEST_F(TestSqliteDataset, BindParams)
+{
+  field_value null;
+  null.set_isNull();
+  EXPECT_EQ("select * from path where strPath='it''s' and x='?' and idPath=3 and y=NULL and z=1",
+            m_db.bind_params("select * from path where strPath=? and x='?' and idPath=? and y=? and z=?",
+                             { "it's", 3, null, true }));
+  // doubles keep all their digits
+  double third = 1.0 / 3.0;
+  std::string sql = m_db.bind_params("select ?", { third });
+  EXPECT_EQ(third, strtod(sql.c_str() + 7, NULL));
+  EXPECT_THROW(m_db.bind_params("select ?", {}), DbErrors);
+  EXPECT_THROW(m_db.bind_params("select 1", { 1 }), DbErrors);
+}
+
+// prints timings only, run with --gtest_also_run_disabled_tests
+TEST_F(TestSqliteDataset, DISABLED_Benchmark)
+{
+  double formatted = Scan(false);
+  double prepared = Scan(true);
+
+  std::cout << "scan of " << SCAN_FOLDERS * SCAN_FILES << " files, formatted: "
+            << formatted * 1000 << " ms, prepared: " << prepared * 1000 << " ms" << std::endl;
+
+  m_ds->query("select count(*) from files");
+  EXPECT_EQ(2 * SCAN_FOLDERS * SCAN_FILES, m_ds->fv(0).get_asInt());
+  m_ds->close();
+}
+
+TEST_F(TestSqliteDataset, ResultSet)
+{
+  m_ds->exec("CREATE TABLE value ( i integer, d double, t text, b blob, n integer )");
+  m_ds->exec("INSERT INTO value VALUES ( 5000000000, 0.5, 'it''s', 'blob', NULL )");
+  m_ds->exec("INSERT INTO value VALUES ( 2, -1.0, '', NULL, 7 )");
+
+  m_ds->query("select * from value order by i desc");
+  const result_set &data = m_ds->get_result_set();
+  ASSERT_EQ(2u, data.size());
+  ASSERT_EQ(2, m_ds->num_rows());
+
+  const sql_record *record = data.record(0);
+  ASSERT_TRUE(record != NULL);
+  EXPECT_EQ(5000000000LL, record->at(0).get_asInt64());
+  EXPECT_DOUBLE_EQ(0.5, record->at(1).get_asDouble());
+  EXPECT_EQ("it's", record->at(2).get_asString());
+  EXPECT_EQ("blob", record->at(3).get_asString());
+  EXPECT_TRUE(record->at(4).get_isNull());
+  EXPECT_FALSE(record->at(2).get_isNull());
+
+  record = data.record(1);
+  ASSERT_TRUE(record != NULL);
+  EXPECT_EQ(2, record->at(0).get_asInt());
+  EXPECT_EQ("", record->at(2).get_asString());
+  EXPECT_FALSE(record->at(2).get_isNull());
+  EXPECT_TRUE(record->at(3).get_isNull());
+  EXPECT_EQ(7, record->at(4).get_asInt());
+  EXPECT_TRUE(data.record(2) == NULL);
+
+  // records stay valid while other rows are read, and are decoded once
+  const sql_record *first = data.record(0);
+  EXPECT_EQ(first, data.record(0));
+  EXPECT_NE(first, record);
+  EXPECT_EQ(5000000000LL, first->at(0).get_asInt64());
+  EXPECT_EQ(2, record->at(0).get_asInt());
+
+  field_value value;
+  EXPECT_TRUE(data.get_field(0, 2, value));
+  EXPECT_EQ("it's", value.get_asString());
+  EXPECT_FALSE(data.get_field(0, 5, value));
+  EXPECT_FALSE(data.get_field(2, 0, value));
+
+  // the cursor decodes the same rows
+  EXPECT_EQ("it's", m_ds->fv("t").get_asString());
+  EXPECT_TRUE(m_ds->fv("n").get_isNull());
+  m_ds->next();
+  EXPECT_EQ(7, m_ds->fv("n").get_asInt());
+  EXPECT_EQ(2, m_ds->get_sql_record()->at(0).get_asInt());
+  m_ds->next();
+  EXPECT_TRUE(m_ds->eof());
+  m_ds->close();
+
+  // a released row is decoded again on the next access
+  result_set rows;
+  rows.record_header.resize(1);
+  rows.add_row();
+  rows.add_int(1);
+  rows.add_row();
+  rows.add_string("two", 3);
+  EXPECT_EQ(1, rows.record(0)->at(0).get_asInt());
+  rows.release(0);
+  EXPECT_EQ(1, rows.record(0)->at(0).get_asInt());
+  EXPECT_EQ("two", rows.record(1)->at(0).get_asString());
+  rows.release_decoded(1);
+  EXPECT_EQ("two", rows.record(1)->at(0).get_asString());
+  EXPECT_EQ(2u, rows.size());
+
+  // walking the cursor keeps only the current row decoded
+  m_ds->query("select i from value order by i");
+  EXPECT_EQ(2, m_ds->get_sql_record()->at(0).get_asInt());
+  m_ds->next();
+  EXPECT_EQ(5000000000LL, m_ds->get_sql_record()->at(0).get_asInt64());
+  EXPECT_EQ(2, m_ds->get_result_set().record(0)->at(0).get_asInt());
+  m_ds->close();
+}
+
+// prints timings only, run with --gtest_also_run_disabled_tests
+TEST_F(TestSqliteDataset, DISABLED_BenchmarkResultSet)
+{
+  Scan(false);
+  Scan(true);
+  const std::string sql = "select files.idFile, files.strFilename, path.strPath, path.idPath "
+                          "from files join path on files.idPath = path.idPath";
+  const int rounds = 10;
+
+  // rows as a record of field_values each, as the exec callback stores them
+  auto start = std::chrono::steady_clock::now();
+  size_t length = 0;
+  for (int i = 0; i < rounds; i++)
+  {
+    m_ds->exec(sql);
+    const result_set *res = (const result_set *)m_ds->getExecRes();
+    for (unsigned int row = 0; row < res->size(); row++)
+      length += res->record(row)->at(1).get_asString().size();
+  }
+  std::chrono::duration<double> records = std::chrono::steady_clock::now() - start;
+
+  // rows kept in columns, as query stores them
+  start = std::chrono::steady_clock::now();
+  size_t columnLength = 0;
+  for (int i = 0; i < rounds; i++)
+  {
+    m_ds->query(sql);
+    const result_set &res = m_ds->get_result_set();
+    for (unsigned int row = 0; row < res.size(); row++)
+      columnLength += res.record(row)->at(1).get_asString().size();
+    m_ds->close();
+  }
+  std::chrono::duration<double> columns = std::chrono::steady_clock::now() - start;
+
+  std::cout << rounds << " x " << 2 * SCAN_FOLDERS * SCAN_FILES << " rows, records: "
+            << records.count() * 1000 << " ms, columns: " << columns.count() * 1000 << " ms" << std::endl;
+  EXPECT_EQ(length, columnLength);
+  EXPECT_GT(length, 0u);
+}
@@ -21,6 +21,7 @@
 #include "threads/SystemClock.h"
 #include "CacheStrategy.h"
 #include "IFile.h"
+#include "IFileTypes.h"
 #ifdef TARGET_POSIX
 #include "PlatformInclude.h"
 #include "ConvUtils.h"
@@ -412,3 +413,8 @@ CCacheStrategy *CDoubleCache::CreateNew()
   return new CDoubleCache(m_pCache->CreateNew());
 }
 
+bool CDoubleCache::GetStats(SCacheStats &stats)
+{
+  return m_pCache->GetStats(stats);
+}
+
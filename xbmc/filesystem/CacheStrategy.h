@@ -34,6 +34,7 @@ namespace XFILE {
 #define CACHE_RC_TIMEOUT -3
 
 class IFile; // forward declaration
+struct SCacheStats;
 
 class CCacheStrategy{
 public:
@@ -69,6 +70,12 @@ public:
 
   virtual CCacheStrategy *CreateNew() = 0;
 
+  /*!
+   \brief Get seek statistics of the cache
+   \return false if the strategy does not keep statistics
+   */
+  virtual bool GetStats(SCacheStats &stats) { return false; }
+
   CEvent m_space;
 protected:
   bool  m_bEndOfInput;
@@ -135,6 +142,7 @@ public:
   virtual bool IsCachedPosition(int64_t iFilePosition);
 
   virtual CCacheStrategy *CreateNew();
+  virtual bool GetStats(SCacheStats &stats);
 
 protected:
   CCacheStrategy *m_pCache;
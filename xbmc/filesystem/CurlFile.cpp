@@ -28,6 +28,7 @@
 #include "threads/SystemClock.h"
 #include "utils/Base64.h"
 
+#include <algorithm>
 #include <vector>
 #include <climits>
 #include <cassert>
@@ -65,6 +66,8 @@ curl_proxytype proxyType2CUrlProxyType[] = {
 #define FILLBUFFER_NO_DATA    1
 #define FILLBUFFER_FAIL       2
 
+#define READ_AHEAD_SEGMENT_SIZE (2 * 1024 * 1024)
+
 // curl calls this routine to debug
 extern "C" int debug_callback(CURL_HANDLE *handle, curl_infotype info, char *output, size_t size, void *data)
 {
@@ -257,6 +260,7 @@ CCurlFile::CReadState::CReadState()
   m_stillRunning = 0;
   m_filePos = 0;
   m_fileSize = 0;
+  m_rangeEnd = 0;
   m_bufferSize = 0;
   m_cancelled = false;
   m_bFirstLoop = true;
@@ -319,6 +323,15 @@ bool CCurlFile::CReadState::Seek(int64_t pos)
 
 void CCurlFile::CReadState::SetResume(void)
 {
+  if (m_rangeEnd > 0)
+  {
+    // request exactly the remaining part of the range
+    std::string range = StringUtils::Format("%" PRId64 "-%" PRId64, m_filePos, m_rangeEnd - 1);
+    g_curlInterface.easy_setopt(m_easyHandle, CURLOPT_RANGE, range.c_str());
+    g_curlInterface.easy_setopt(m_easyHandle, CURLOPT_RESUME_FROM_LARGE, (int64_t)0);
+    return;
+  }
+
   /*
    * Explicitly set RANGE header when filepos=0 as some http servers require us to always send the range
    * request header. If we don't the server may provide different content causing seeking to fail.
@@ -389,6 +402,7 @@ void CCurlFile::CReadState::Disconnect()
   m_overflowSize = 0;
   m_filePos = 0;
   m_fileSize = 0;
+  m_rangeEnd = 0;
   m_bufferSize = 0;
   m_readBuffer = 0;
 
@@ -443,6 +457,8 @@ CCurlFile::CCurlFile()
   m_httpresponse = -1;
   m_acceptCharset = "UTF-8,*;q=0.8"; /* prefer UTF-8 if available */
   m_allowRetry = true;
+  m_readAheadCount = 0;
+  m_readAheadPos = 0;
 }
 
 //Has to be called before Open()
@@ -456,6 +472,9 @@ void CCurlFile::Close()
   if (m_opened && m_forWrite && !m_inError)
       Write(NULL, 0);
 
+  StopReadAhead();
+  m_readAheadCount = 0;
+
   m_state->Disconnect();
   delete m_oldState;
   m_oldState = NULL;
@@ -541,8 +560,8 @@ void CCurlFile::SetCommonOptions(CReadState* state)
   g_curlInterface.easy_setopt(h, CURLOPT_SSL_VERIFYPEER, 0);
   g_curlInterface.easy_setopt(h, CURLOPT_SSL_VERIFYHOST, 0);
 
-  g_curlInterface.easy_setopt(m_state->m_easyHandle, CURLOPT_URL, m_url.c_str());
-  g_curlInterface.easy_setopt(m_state->m_easyHandle, CURLOPT_TRANSFERTEXT, FALSE);
+  g_curlInterface.easy_setopt(h, CURLOPT_URL, m_url.c_str());
+  g_curlInterface.easy_setopt(h, CURLOPT_TRANSFERTEXT, FALSE);
 
   // setup POST data if it is set (and it may be empty)
   if (m_postdataset)
@@ -1254,6 +1273,26 @@ int64_t CCurlFile::Seek(int64_t iFilePosition, int iWhence)
   // We can't seek beyond EOF
   if (m_state->m_fileSize && nextPos > m_state->m_fileSize) return -1;
 
+  if (m_readAheadCount > 1)
+  {
+    if (!m_segments.empty())
+    {
+      // stay within what the first request has buffered
+      CReadState* front = m_segments.front();
+      if (FITS_INT(nextPos - front->m_filePos) && front->m_buffer.SkipBytes((int)(nextPos - front->m_filePos)))
+      {
+        front->m_filePos = nextPos;
+        m_state->m_filePos = nextPos;
+        return nextPos;
+      }
+      StopReadAhead();
+    }
+
+    // requests for the new position are started on the next read
+    m_state->m_filePos = nextPos;
+    return nextPos;
+  }
+
   if(m_state->Seek(nextPos))
     return nextPos;
 
@@ -1323,6 +1362,270 @@ int64_t CCurlFile::Seek(int64_t iFilePosition, int iWhence)
   return m_state->m_filePos;
 }
 
+bool CCurlFile::Reconnect(int64_t pos)
+{
+  SetCommonOptions(m_state);
+  SetRequestHeaders(m_state);
+
+  m_state->m_filePos = pos;
+  m_state->m_sendRange = true;
+
+  long response = m_state->Connect(m_bufferSize);
+  if (response < 0 && (m_state->m_fileSize == 0 || m_state->m_fileSize != m_state->m_filePos))
+    return false;
+
+  SetCorrectHeaders(m_state);
+  return true;
+}
+
+ssize_t CCurlFile::Read(void* lpBuf, size_t uiBufSize)
+{
+  if (m_readAheadCount > 1)
+  {
+    if (m_state->m_filePos >= m_state->m_fileSize)
+      return 0;
+
+    int8_t result = FILLBUFFER_FAIL;
+    if (!m_segments.empty() || StartReadAhead())
+      result = FillReadAhead();
+
+    if (result == FILLBUFFER_OK)
+      return ReadAhead(lpBuf, uiBufSize);
+
+    if (result == FILLBUFFER_NO_DATA)
+      return 0;
+
+    CLog::Log(LOGWARNING, "CCurlFile::Read - parallel read-ahead failed, continuing with a single connection");
+    int64_t pos = m_state->m_filePos;
+    StopReadAhead();
+    m_readAheadCount = 0;
+    if (!Reconnect(pos))
+      return -1;
+  }
+
+  return m_state->Read(lpBuf, uiBufSize);
+}
+
+/* Replaces the sequential connection by m_readAheadCount requests for
+ * consecutive ranges following the current position. Data is handed out in
+ * order from the first request, once that is drained it is reused for the
+ * range following the last one.
+ */
+bool CCurlFile::StartReadAhead()
+{
+  CURL url(m_url);
+  int64_t pos = m_state->m_filePos;
+  int64_t size = m_state->m_fileSize;
+
+  m_state->Disconnect();
+  m_state->m_filePos = pos;
+  m_state->m_fileSize = size;
+
+  m_readAheadPos = pos;
+  while (m_segments.size() < m_readAheadCount && m_readAheadPos < size)
+  {
+    CReadState* segment = new CReadState();
+    g_curlInterface.easy_aquire(url.GetProtocol().c_str(),
+                                url.GetHostName().c_str(),
+                                &segment->m_easyHandle,
+                                &segment->m_multiHandle);
+    if (!StartSegment(segment, m_readAheadPos))
+    {
+      delete segment;
+      break;
+    }
+    m_segments.push_back(segment);
+    m_readAheadPos = segment->m_rangeEnd;
+  }
+
+  return !m_segments.empty();
+}
+
+void CCurlFile::StopReadAhead()
+{
+  while (!m_segments.empty())
+  {
+    delete m_segments.front();
+    m_segments.pop_front();
+  }
+}
+
+bool CCurlFile::StartSegment(CReadState* segment, int64_t start)
+{
+  segment->Disconnect();
+
+  SetCommonOptions(segment);
+  SetRequestHeaders(segment);
+
+  segment->m_filePos = start;
+  segment->m_fileSize = m_state->m_fileSize;
+  segment->m_rangeEnd = std::min(start + READ_AHEAD_SEGMENT_SIZE, m_state->m_fileSize);
+  segment->m_bFirstLoop = true;
+  segment->m_bLastError = false;
+  segment->m_httpheader.Clear();
+
+  // the buffer holds the whole range, so the transfer never has to pause
+  if (segment->m_buffer.getSize() < READ_AHEAD_SEGMENT_SIZE)
+  {
+    segment->m_buffer.Destroy();
+    if (!segment->m_buffer.Create(READ_AHEAD_SEGMENT_SIZE))
+      return false;
+  }
+  segment->m_bufferSize = READ_AHEAD_SEGMENT_SIZE;
+
+  segment->SetResume();
+  g_curlInterface.multi_add_handle(segment->m_multiHandle, segment->m_easyHandle);
+  segment->m_stillRunning = 1;
+
+  return true;
+}
+
+/* drive all range requests, at least once and until the first one has data.
+ * every read passes here, so the ranges behind the first one keep loading
+ * while data is handed out from the first.
+ */
+int8_t CCurlFile::FillReadAhead()
+{
+  CReadState* front = m_segments.front();
+  fd_set fdread;
+  fd_set fdwrite;
+  fd_set fdexcep;
+
+  for (;;)
+  {
+    int maxfd = -1;
+    long timeout = 200;
+    FD_ZERO(&fdread);
+    FD_ZERO(&fdwrite);
+    FD_ZERO(&fdexcep);
+
+    for (std::deque<CReadState*>::iterator it = m_segments.begin(); it != m_segments.end(); ++it)
+    {
+      CReadState* segment = *it;
+      if (!segment->m_stillRunning)
+        continue;
+
+      CURLMcode result = g_curlInterface.multi_perform(segment->m_multiHandle, &segment->m_stillRunning);
+      if (result != CURLM_OK && result != CURLM_CALL_MULTI_PERFORM)
+      {
+        CLog::Log(LOGERROR, "CCurlFile::FillReadAhead - Multi perform failed with code %d", result);
+        return FILLBUFFER_FAIL;
+      }
+
+      // a server not honouring the range sends the whole file, the status
+      // is final once the body arrives
+      if (segment->m_bFirstLoop && (segment->m_buffer.getMaxReadSize() > 0 || segment->m_overflowSize > 0))
+      {
+        long response = 0;
+        g_curlInterface.easy_getinfo(segment->m_easyHandle, CURLINFO_RESPONSE_CODE, &response);
+        if (response != 206)
+        {
+          CLog::Log(LOGWARNING, "CCurlFile::FillReadAhead - Range request answered with code %ld", response);
+          return FILLBUFFER_FAIL;
+        }
+        segment->m_bFirstLoop = false;
+      }
+
+      if (!segment->m_stillRunning)
+      {
+        int msgs;
+        CURLMsg* msg;
+        while ((msg = g_curlInterface.multi_info_read(segment->m_multiHandle, &msgs)))
+        {
+          if (msg->msg == CURLMSG_DONE && msg->data.result != CURLE_OK)
+          {
+            CLog::Log(LOGERROR, "CCurlFile::FillReadAhead - Failed: %s(%d)", g_curlInterface.easy_strerror(msg->data.result), msg->data.result);
+            return FILLBUFFER_FAIL;
+          }
+        }
+        continue;
+      }
+
+      int fd = -1;
+      g_curlInterface.multi_fdset(segment->m_multiHandle, &fdread, &fdwrite, &fdexcep, &fd);
+      maxfd = std::max(maxfd, fd);
+
+      long segmentTimeout = -1;
+      if (CURLM_OK == g_curlInterface.multi_timeout(segment->m_multiHandle, &segmentTimeout) && segmentTimeout >= 0)
+        timeout = std::min(timeout, segmentTimeout);
+    }
+
+    if (front->m_buffer.getMaxReadSize() > 0)
+      break;
+
+    if (m_state->m_cancelled)
+      return FILLBUFFER_NO_DATA;
+
+    if (!front->m_stillRunning)
+    {
+      CLog::Log(LOGWARNING, "CCurlFile::FillReadAhead - Range request ended early at %" PRId64 " of %" PRId64, front->m_filePos, front->m_rangeEnd);
+      return FILLBUFFER_FAIL;
+    }
+
+    if (timeout == 0)
+      continue;
+
+    int rc;
+    do
+    {
+      if (maxfd == -1)
+      {
+#ifdef TARGET_WINDOWS
+        Sleep(std::min(timeout, 100L));
+        rc = 0;
+#else
+        struct timeval wait = { 0, std::min(timeout, 100L) * 1000 };
+        rc = select(0, NULL, NULL, NULL, &wait);
+#endif
+      }
+      else
+      {
+        struct timeval wait = { (int)timeout / 1000, ((int)timeout % 1000) * 1000 };
+        rc = select(maxfd + 1, &fdread, &fdwrite, &fdexcep, &wait);
+      }
+#ifdef TARGET_WINDOWS
+    } while(rc == SOCKET_ERROR && WSAGetLastError() == WSAEINTR);
+#else
+    } while(rc == SOCKET_ERROR && errno == EINTR);
+#endif
+
+    if (rc == SOCKET_ERROR)
+    {
+      CLog::Log(LOGERROR, "CCurlFile::FillReadAhead - Failed with socket error");
+      return FILLBUFFER_FAIL;
+    }
+  }
+
+  return FILLBUFFER_OK;
+}
+
+ssize_t CCurlFile::ReadAhead(void* lpBuf, size_t uiBufSize)
+{
+  CReadState* front = m_segments.front();
+
+  unsigned int want = (unsigned int)XMIN(front->m_buffer.getMaxReadSize(), uiBufSize);
+  if (!front->m_buffer.ReadData((char *)lpBuf, want))
+    return -1;
+
+  front->m_filePos += want;
+  m_state->m_filePos = front->m_filePos;
+
+  // range drained, reuse the request for the next one
+  if (front->m_filePos >= front->m_rangeEnd)
+  {
+    m_segments.pop_front();
+    if (m_readAheadPos < m_state->m_fileSize && StartSegment(front, m_readAheadPos))
+    {
+      m_segments.push_back(front);
+      m_readAheadPos = front->m_rangeEnd;
+    }
+    else
+      delete front;
+  }
+
+  return want;
+}
+
 int64_t CCurlFile::GetLength()
 {
   if (!m_opened) return 0;
@@ -1888,6 +2191,22 @@ int CCurlFile::IoControl(EIoControl request, void* param)
     return 0;
   }
 
+  if (request == IOCTRL_SET_READAHEAD)
+  {
+    // needs a http server honouring ranges on a file of known size
+    if (!m_seekable || !m_multisession || m_state->m_fileSize <= 0)
+      return -1;
+
+    m_readAheadCount = *(unsigned int*) param;
+    if (m_readAheadCount <= 1 && !m_segments.empty())
+    {
+      int64_t pos = m_state->m_filePos;
+      StopReadAhead();
+      Reconnect(pos);
+    }
+    return 0;
+  }
+
   return -1;
 }
 
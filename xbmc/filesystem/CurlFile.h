@@ -21,6 +21,7 @@
 
 #include "IFile.h"
 #include "utils/RingBuffer.h"
+#include <deque>
 #include <map>
 #include <string>
 #include "utils/HttpHeader.h"
@@ -58,7 +59,7 @@ namespace XFILE
       virtual int  Stat(const CURL& url, struct __stat64* buffer);
       virtual void Close();
       virtual bool ReadString(char *szLine, int iLineLength)     { return m_state->ReadString(szLine, iLineLength); }
-      virtual ssize_t Read(void* lpBuf, size_t uiBufSize)        { return m_state->Read(lpBuf, uiBufSize); }
+      virtual ssize_t Read(void* lpBuf, size_t uiBufSize);
       virtual ssize_t Write(const void* lpBuf, size_t uiBufSize);
       virtual std::string GetMimeType()                          { return m_state->m_httpheader.GetMimeType(); }
       virtual std::string GetContent()                           { return m_state->m_httpheader.GetValue("content-type"); }
@@ -120,6 +121,7 @@ namespace XFILE
           bool            m_cancelled;
           int64_t         m_fileSize;
           int64_t         m_filePos;
+          int64_t         m_rangeEnd;         // end of the requested byte range, 0 if open ended
           bool            m_bFirstLoop;
           bool            m_isPaused;
           bool            m_sendRange;
@@ -157,6 +159,14 @@ namespace XFILE
       void SetRequestHeaders(CReadState* state);
       void SetCorrectHeaders(CReadState* state);
       bool Service(const std::string& strURL, std::string& strHTML);
+      bool Reconnect(int64_t pos);
+
+      /* parallel range requests ahead of the read position */
+      bool StartReadAhead();
+      void StopReadAhead();
+      bool StartSegment(CReadState* segment, int64_t start);
+      int8_t FillReadAhead();
+      ssize_t ReadAhead(void* lpBuf, size_t uiBufSize);
 
     protected:
       CReadState*     m_state;
@@ -207,5 +217,9 @@ namespace XFILE
       MAPHTTPHEADERS m_requestheaders;
 
       long            m_httpresponse;
+
+      std::deque<CReadState*> m_segments; // read-ahead requests, ordered by position
+      unsigned int    m_readAheadCount;   // number of concurrent range requests, 0 or 1 to disable
+      int64_t         m_readAheadPos;     // start of the next range to request
   };
 }
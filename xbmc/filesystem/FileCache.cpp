@@ -25,6 +25,9 @@
 #include "URL.h"
 
 #include "CircularCache.h"
+#ifdef TARGET_POSIX
+#include "posix/SparseFileCache.h"
+#endif
 #include "threads/SingleLock.h"
 #include "utils/log.h"
 #include "settings/AdvancedSettings.h"
@@ -90,6 +93,75 @@ private:
   int64_t  m_size;
 };
 
+/* Throughput of the source in wall clock time while we are fetching from it,
+ * including the time between reads. Time spent throttled or waiting for space
+ * in the cache is left out, the source can't do anything about it.
+ */
+class CSourceRate
+{
+public:
+  CSourceRate()
+  {
+    m_stamp = 0;
+    m_size = 0;
+    m_time = 0;
+    m_rate = 0;
+    m_running = false;
+  }
+
+  void Start()
+  {
+    if (!m_running)
+    {
+      m_stamp = XbmcThreads::SystemClockMillis();
+      m_running = true;
+    }
+  }
+
+  void Pause()
+  {
+    if (m_running)
+    {
+      m_time += XbmcThreads::SystemClockMillis() - m_stamp;
+      m_running = false;
+    }
+  }
+
+  void Add(int64_t size)
+  {
+    m_size += size;
+    if (m_running)
+    {
+      const unsigned ts = XbmcThreads::SystemClockMillis();
+      m_time += ts - m_stamp;
+      m_stamp = ts;
+    }
+
+    // average over at least a second of reading
+    if (m_time >= 1000)
+    {
+      unsigned rate = (unsigned)(1000 * m_size / m_time);
+      m_rate = m_rate ? m_rate / 2 + rate / 2 : rate;
+      m_size = 0;
+      m_time = 0;
+    }
+  }
+
+  unsigned Rate() const { return m_rate; }
+
+private:
+  unsigned m_stamp;
+  int64_t  m_size;
+  unsigned m_time;
+  unsigned m_rate;
+  bool     m_running;
+};
+
+// seconds of playback kept ahead of the reader on a link that is just twice
+// as fast as needed, faster links need proportionally less
+#define MAX_FORWARD_SECONDS 120.0
+#define MIN_FORWARD_SECONDS 10.0
+
 
 CFileCache::CFileCache(const unsigned int flags)
   : CThread("FileCache")
@@ -103,7 +175,10 @@ CFileCache::CFileCache(const unsigned int flags)
   , m_chunkSize(0)
   , m_writeRate(0)
   , m_writeRateActual(0)
+  , m_sourceRate(0)
   , m_forwardCacheSize(0)
+  , m_forwardTarget(0)
+  , m_fillFactor(0.0f)
   , m_fileSize(0)
   , m_flags(flags)
 {
@@ -115,7 +190,10 @@ CFileCache::CFileCache(CCacheStrategy *pCache, bool bDeleteCache /* = true */)
   , m_chunkSize(0)
   , m_writeRate(0)
   , m_writeRateActual(0)
+  , m_sourceRate(0)
   , m_forwardCacheSize(0)
+  , m_forwardTarget(0)
+  , m_fillFactor(0.0f)
 {
   m_pCache = pCache;
   m_bDeleteCache = bDeleteCache;
@@ -172,11 +250,39 @@ bool CFileCache::Open(const CURL& url)
   bool retry = false;
   m_source.IoControl(IOCTRL_SET_RETRY, &retry); // We already handle retrying ourselves
 
+  if (g_advancedSettings.m_curlReadAheadConnections > 1 && (m_flags & READ_AUDIO_VIDEO))
+  {
+    // let the source fetch several ranges ahead in parallel, it hands us the
+    // data in order
+    unsigned int connections = g_advancedSettings.m_curlReadAheadConnections;
+    m_source.IoControl(IOCTRL_SET_READAHEAD, &connections);
+  }
+
   // check if source can seek
   m_seekPossible = m_source.IoControl(IOCTRL_SEEK_POSSIBLE, NULL);
   m_chunkSize = CFile::GetChunkSize(m_source.GetChunkSize(), READ_CACHE_CHUNK_SIZE);
   m_fileSize = m_source.GetLength();
 
+  bool opened = false;
+#ifdef TARGET_POSIX
+  if (!m_pCache && g_advancedSettings.m_cacheDiskSize > 0 && m_seekPossible > 0 && (m_flags & READ_AUDIO_VIDEO))
+  {
+    // keeps everything fetched so far, so seeking back doesn't hit the source
+    // again. it can serve any position on its own, no double buffering needed
+    int64_t maxSize = (int64_t)g_advancedSettings.m_cacheDiskSize * 1024 * 1024;
+    m_pCache = new CSparseFileCache(maxSize);
+    m_forwardCacheSize = maxSize;
+    if (m_pCache->Open() == CACHE_RC_OK)
+      opened = true;
+    else
+    {
+      CLog::Log(LOGWARNING, "CFileCache::Open - disk cache not available, using the memory cache");
+      delete m_pCache;
+      m_pCache = NULL;
+    }
+  }
+#endif
+
   if (!m_pCache)
   {
     if (g_advancedSettings.m_cacheMemSize == 0)
@@ -219,7 +325,7 @@ bool CFileCache::Open(const CURL& url)
   }
 
   // open cache strategy
-  if (!m_pCache || m_pCache->Open() != CACHE_RC_OK)
+  if (!m_pCache || (!opened && m_pCache->Open() != CACHE_RC_OK))
   {
     CLog::Log(LOGERROR,"CFileCache::Open - failed to open cache");
     Close();
@@ -230,6 +336,7 @@ bool CFileCache::Open(const CURL& url)
   m_writePos = 0;
   m_writeRate = 1024 * 1024;
   m_writeRateActual = 0;
+  m_sourceRate = 0;
   m_seekEvent.Reset();
   m_seekEnded.Reset();
 
@@ -256,6 +363,7 @@ void CFileCache::Process()
 
   CWriteRate limiter;
   CWriteRate average;
+  CSourceRate source;
   bool cacheReachEOF = false;
 
   while (!m_bStop)
@@ -266,6 +374,7 @@ void CFileCache::Process()
     // check for seek events
     if (m_seekEvent.WaitMSec(0))
     {
+      source.Pause();
       m_seekEvent.Reset();
       int64_t cacheMaxPos = m_pCache->CachedDataEndPosIfSeekTo(m_seekPos);
       cacheReachEOF = (cacheMaxPos == m_fileSize);
@@ -294,17 +403,20 @@ void CFileCache::Process()
       m_seekEnded.Set();
     }
 
+    UpdateFillPolicy();
+
     while (m_writeRate)
     {
-      if (m_writePos - m_readPos < m_writeRate * g_advancedSettings.m_cacheReadFactor)
+      if (m_writePos - m_readPos < m_forwardTarget)
       {
         limiter.Reset(m_writePos);
         break;
       }
 
-      if (limiter.Rate(m_writePos) < m_writeRate * g_advancedSettings.m_cacheReadFactor)
+      if (limiter.Rate(m_writePos) < m_writeRate * m_fillFactor)
         break;
 
+      source.Pause();
       if (m_seekEvent.WaitMSec(100))
       {
         if (!m_bStop)
@@ -320,15 +432,26 @@ void CFileCache::Process()
      */
     if (maxWrite == 0 && !cacheReachEOF)
     {
+      source.Pause();
       m_pCache->m_space.WaitMSec(5);
       continue;
     }
 
     ssize_t iRead = 0;
     if (!cacheReachEOF)
+    {
+      source.Start();
       iRead = m_source.Read(buffer.get(), maxWrite);
+      if (iRead > 0)
+      {
+        source.Add(iRead);
+        m_sourceRate = source.Rate();
+      }
+    }
     if (iRead == 0)
     {
+      source.Pause();
+
       // Check for actual EOF and retry as long as we still have data in our cache
       if (m_writePos < m_fileSize && m_pCache->WaitForData(0, 0) > 0)
       {
@@ -392,6 +515,7 @@ void CFileCache::Process()
       }
       else if (iWrite == 0)
       {
+        source.Pause();
         m_pCache->m_space.WaitMSec(5);
       }
 
@@ -408,6 +532,24 @@ void CFileCache::Process()
 
     m_writePos += iTotalWrite;
 
+    // the cache may already hold what follows, e.g. a range fetched before a
+    // seek that we just caught up with. continue reading after it
+    const int64_t cacheEnd = m_pCache->CachedDataEndPos();
+    if (cacheEnd > m_writePos && !m_bStop)
+    {
+      if (m_fileSize > 0 && cacheEnd >= m_fileSize)
+        cacheReachEOF = true;
+      else if (m_source.Seek(cacheEnd, SEEK_SET) != cacheEnd)
+      {
+        CLog::Log(LOGERROR, "CFileCache::Process - Error %d seeking past cached data to %" PRId64, (int)GetLastError(), cacheEnd);
+        m_seekPossible = m_source.IoControl(IOCTRL_SEEK_POSSIBLE, NULL);
+        break; // while (!m_bStop)
+      }
+      m_writePos = cacheEnd;
+      average.Reset(m_writePos, false);
+      limiter.Reset(m_writePos);
+    }
+
     // under estimate write rate by a second, to
     // avoid uncertainty at start of caching
     m_writeRateActual = average.Rate(m_writePos, 1000);
@@ -583,6 +725,38 @@ std::string CFileCache::GetContentCharset(void)
   return impl->GetContentCharset();
 }
 
+/* Decides how much to keep ahead of the reader and how fast to fill once we
+ * got there, based on how the source keeps up with the rate the player
+ * consumes (m_writeRate).
+ */
+void CFileCache::UpdateFillPolicy()
+{
+  const unsigned rate = m_writeRate;
+  const unsigned sourceRate = m_sourceRate;
+
+  // static policy: fill freely up to readfactor seconds, then at readfactor times the rate
+  m_forwardTarget = (int64_t)(rate * g_advancedSettings.m_cacheReadFactor);
+  m_fillFactor = g_advancedSettings.m_cacheReadFactor;
+
+  if (!g_advancedSettings.m_cacheAdaptiveFill || rate == 0 || m_forwardCacheSize == 0)
+    return;
+
+  if (sourceRate < 2 * (uint64_t)rate)
+  {
+    // the source barely keeps up (or we don't know yet), buffer all we can
+    m_forwardTarget = m_forwardCacheSize;
+  }
+  else
+  {
+    // a fast source refills quickly, so there's no point holding a lot in
+    // memory. once the target is reached only keep up with playback
+    double headroom = (double)sourceRate / rate;
+    double seconds = std::max(MIN_FORWARD_SECONDS, MAX_FORWARD_SECONDS / (headroom - 1.0));
+    m_forwardTarget = std::min(m_forwardCacheSize, (int64_t)(seconds * rate));
+    m_fillFactor = 1.0f;
+  }
+}
+
 int CFileCache::IoControl(EIoControl request, void* param)
 {
   if (request == IOCTRL_CACHE_STATUS)
@@ -592,6 +766,8 @@ int CFileCache::IoControl(EIoControl request, void* param)
     status->level   = (m_forwardCacheSize == 0) ? 0.0 : (float) status->forward / m_forwardCacheSize;
     status->maxrate = m_writeRate;
     status->currate = m_writeRateActual;
+    status->srcrate = m_sourceRate;
+    status->target  = m_forwardTarget;
     return 0;
   }
 
@@ -604,5 +780,13 @@ int CFileCache::IoControl(EIoControl request, void* param)
   if (request == IOCTRL_SEEK_POSSIBLE)
     return m_seekPossible;
 
+  if (request == IOCTRL_CACHE_STATS)
+  {
+    SCacheStats* stats = (SCacheStats*)param;
+    if (!m_pCache)
+      return -1;
+    return m_pCache->GetStats(*stats) ? 0 : -1;
+  }
+
   return -1;
 }
@@ -63,6 +63,8 @@ namespace XFILE
     virtual std::string GetContentCharset(void);
 
   private:
+    void UpdateFillPolicy();
+
     CCacheStrategy *m_pCache;
     bool      m_bDeleteCache;
     int        m_seekPossible;
@@ -77,7 +79,10 @@ namespace XFILE
     unsigned     m_chunkSize;
     unsigned     m_writeRate;
     unsigned     m_writeRateActual;
+    unsigned     m_sourceRate;
     int64_t      m_forwardCacheSize;
+    int64_t      m_forwardTarget;
+    float        m_fillFactor;
     std::atomic<int64_t> m_fileSize;
     unsigned int m_flags;
     CCriticalSection m_sync;
@@ -61,6 +61,16 @@ struct SCacheStatus
   unsigned maxrate;  /**< maximum number of bytes per second cache is allowed to fill */
   unsigned currate;  /**< average read rate from source file since last position change */
   float    level;    /**< cache level (0.0 - 1.0) */
+  unsigned srcrate;  /**< rate the source delivers at while the cache is waiting for it */
+  uint64_t target;   /**< number of bytes the cache currently tries to keep ahead */
+};
+
+struct SCacheStats
+{
+  uint64_t hits;       /**< number of seeks served from data already in the cache */
+  uint64_t misses;     /**< number of seeks that required data to be fetched from the source */
+  uint64_t bytesSaved; /**< number of bytes that did not have to be fetched again after a seek */
+  uint64_t cached;     /**< number of bytes currently held by the cache */
 };
 
 typedef enum {
@@ -70,6 +80,8 @@ typedef enum {
   IOCTRL_CACHE_SETRATE = 4,  /**< unsigned int with speed limit for caching in bytes per second */
   IOCTRL_SET_CACHE     = 8,  /**< CFileCache */
   IOCTRL_SET_RETRY     = 16, /**< Enable/disable retry within the protocol handler (if supported) */
+  IOCTRL_CACHE_STATS   = 32, /**< SCacheStats structure, only supported by some cache strategies */
+  IOCTRL_SET_READAHEAD = 64, /**< unsigned int with the number of concurrent range requests used to read ahead (if supported) */
 } EIoControl;
 
 enum CURLOPTIONTYPE
@@ -0,0 +1,504 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "SparseFileCache.h"
+#include "filesystem/SpecialProtocol.h"
+#include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include "utils/log.h"
+#include "Util.h"
+#include "system.h"
+
+#include <algorithm>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace XFILE;
+
+CSparseFileCache::CSparseFileCache(int64_t maxSize)
+ : CCacheStrategy()
+ , m_fd(-1)
+ , m_rangeBeg(0)
+ , m_end(0)
+ , m_cur(0)
+ , m_maxSize(maxSize)
+ , m_cached(0)
+ , m_useCount(0)
+{
+  memset(&m_stats, 0, sizeof(m_stats));
+}
+
+CSparseFileCache::~CSparseFileCache()
+{
+  Close();
+}
+
+int CSparseFileCache::Open()
+{
+  Close();
+
+  m_filename = CSpecialProtocol::TranslatePath(CUtil::GetNextFilename("special://temp/filecache%03d.cache", 999));
+  if (m_filename.empty())
+  {
+    CLog::Log(LOGERROR, "CSparseFileCache::%s - unable to generate a new filename", __FUNCTION__);
+    return CACHE_RC_ERROR;
+  }
+
+  m_fd = open(m_filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+  if (m_fd < 0)
+  {
+    CLog::Log(LOGERROR, "CSparseFileCache::%s - failed to create \"%s\" (%s)", __FUNCTION__, m_filename.c_str(), strerror(errno));
+    return CACHE_RC_ERROR;
+  }
+
+  // the file stays accessible through the descriptor, unlinking it right away
+  // makes sure it doesn't stay around if we don't get to close it
+  unlink(m_filename.c_str());
+
+  if (!IsSparse())
+  {
+    CLog::Log(LOGWARNING, "CSparseFileCache::%s - \"%s\" is not on a file system with sparse files", __FUNCTION__, m_filename.c_str());
+    close(m_fd);
+    m_fd = -1;
+    return CACHE_RC_ERROR;
+  }
+
+  m_ranges.clear();
+  m_rangeBeg = 0;
+  m_end = 0;
+  m_cur = 0;
+  m_cached = 0;
+  memset(&m_stats, 0, sizeof(m_stats));
+  return CACHE_RC_OK;
+}
+
+void CSparseFileCache::Close()
+{
+  CSingleLock lock(m_sync);
+
+  UnmapWindows();
+  if (m_fd >= 0)
+  {
+    CLog::Log(LOGDEBUG, "CSparseFileCache::%s - hits: %" PRIu64 ", misses: %" PRIu64 ", bytes saved: %" PRIu64,
+              __FUNCTION__, m_stats.hits, m_stats.misses, m_stats.bytesSaved);
+    close(m_fd);
+    m_fd = -1;
+  }
+  m_ranges.clear();
+  m_cached = 0;
+}
+
+/**
+ * Writes a single byte well past the end of the empty cache file and checks
+ * how much space that took. File systems without sparse files (FAT, exFAT)
+ * fill the gap with zeros, which would turn every seek into writing gigabytes.
+ */
+bool CSparseFileCache::IsSparse()
+{
+  const char probe = 0;
+  struct stat st;
+  bool sparse = pwrite(m_fd, &probe, 1, SPARSE_PROBE - 1) == 1 &&
+                fstat(m_fd, &st) == 0 &&
+                (int64_t)st.st_blocks * 512 < SPARSE_PROBE / 2;
+
+  if (ftruncate(m_fd, 0) != 0)
+    sparse = false;
+  return sparse;
+}
+
+CSparseFileCache::RangeMap::iterator CSparseFileCache::FindRange(int64_t pos)
+{
+  RangeMap::iterator it = m_ranges.upper_bound(pos);
+  if (it == m_ranges.begin())
+    return m_ranges.end();
+  --it;
+  if (pos <= it->second)
+    return it;
+  return m_ranges.end();
+}
+
+int64_t CSparseFileCache::GetAvailableRead()
+{
+  if (m_cur < m_rangeBeg || m_cur > m_end)
+    return 0;
+  return m_end - m_cur;
+}
+
+size_t CSparseFileCache::GetMaxWriteSize(const size_t& iRequestSize)
+{
+  CSingleLock lock(m_sync);
+
+  // never hold more than maxSize in front of the reader
+  int64_t limit = m_maxSize - (m_end - m_cur);
+  if (limit <= 0)
+    return 0;
+
+  // stop at the next range, we join it once we get there
+  RangeMap::iterator next = m_ranges.upper_bound(m_rangeBeg);
+  if (next != m_ranges.end() && next->first > m_end)
+    limit = std::min(limit, next->first - m_end);
+
+  return (size_t)std::min((int64_t)iRequestSize, limit);
+}
+
+/**
+ * Once the range being written reaches a range fetched before a seek, the
+ * two are joined and writing continues at the end of the joined range. What
+ * the source delivered for the part that was already cached is skipped, the
+ * caller has to move the source on to CachedDataEndPos().
+ */
+int CSparseFileCache::WriteToCache(const char *buf, size_t len)
+{
+  CSingleLock lock(m_sync);
+
+  size_t consumed = 0;
+  while (consumed < len)
+  {
+    size_t size = GetMaxWriteSize(len - consumed);
+    if (size == 0)
+      break;
+
+    ssize_t written = pwrite(m_fd, buf + consumed, size, m_end);
+    if (written < 0)
+    {
+      if (errno == EINTR || consumed > 0)
+        break;
+      CLog::Log(LOGERROR, "CSparseFileCache::%s - failed to write to cache file (%s)", __FUNCTION__, strerror(errno));
+      return CACHE_RC_ERROR;
+    }
+
+    m_end += written;
+    consumed += written;
+
+    RangeMap::iterator it = m_ranges.find(m_rangeBeg);
+    if (it == m_ranges.end())
+      it = m_ranges.insert(RangeMap::value_type(m_rangeBeg, m_rangeBeg)).first;
+    if (m_end > it->second)
+    {
+      m_cached += m_end - it->second;
+      it->second = m_end;
+    }
+
+    RangeMap::iterator next = it;
+    ++next;
+    if (next != m_ranges.end() && next->first <= it->second)
+    {
+      m_cached -= std::min(it->second, next->second) - next->first;
+      it->second = std::max(it->second, next->second);
+      m_ranges.erase(next);
+
+      consumed += (size_t)std::min((int64_t)(len - consumed), it->second - m_end);
+      m_stats.bytesSaved += it->second - m_end;
+      m_end = it->second;
+    }
+  }
+
+  if (consumed > 0)
+  {
+    Evict();
+    m_written.Set();
+  }
+
+  return (int)consumed;
+}
+
+int CSparseFileCache::ReadFromCache(char *buf, size_t len)
+{
+  CSingleLock lock(m_sync);
+
+  int64_t avail = GetAvailableRead();
+  if (avail == 0)
+  {
+    if (IsEndOfInput())
+      return 0;
+    else
+      return CACHE_RC_WOULD_BLOCK;
+  }
+
+  const uint8_t *data = MapWindow(m_cur);
+  if (!data)
+    return CACHE_RC_ERROR;
+
+  // only read up to the end of the mapped window
+  int64_t window = WINDOW_SIZE - m_cur % WINDOW_SIZE;
+  len = (size_t)std::min((int64_t)len, std::min(avail, window));
+
+  memcpy(buf, data, len);
+  m_cur += len;
+
+  m_space.Set();
+
+  return (int)len;
+}
+
+int64_t CSparseFileCache::WaitForData(unsigned int minimum, unsigned int millis)
+{
+  CSingleLock lock(m_sync);
+  int64_t avail = GetAvailableRead();
+
+  if (millis == 0 || IsEndOfInput())
+    return avail;
+
+  if (minimum > m_maxSize)
+    minimum = (unsigned int)m_maxSize;
+
+  XbmcThreads::EndTime endtime(millis);
+  while (!IsEndOfInput() && avail < minimum && !endtime.IsTimePast())
+  {
+    lock.Leave();
+    m_written.WaitMSec(50);
+    lock.Enter();
+    avail = GetAvailableRead();
+  }
+
+  return avail;
+}
+
+int64_t CSparseFileCache::Seek(int64_t pos)
+{
+  CSingleLock lock(m_sync);
+  int64_t cur = m_cur;
+
+  // if seek is a bit over what we have, try to wait a few seconds for the data
+  // to be available. we try to avoid a (heavy) seek on the source
+  if (pos >= m_end && pos < m_end + 100000)
+  {
+    m_cur = m_end;
+    lock.Leave();
+    WaitForData((unsigned int)(pos - m_cur), 5000);
+    lock.Enter();
+  }
+
+  // data of other ranges can only be served once the source has been moved to
+  // the end of that range, leave that to Reset
+  if (pos >= m_rangeBeg && pos <= m_end)
+  {
+    m_stats.hits++;
+    if (pos < cur)
+      m_stats.bytesSaved += cur - pos;
+    m_cur = pos;
+    return pos;
+  }
+
+  m_cur = cur;
+  return CACHE_RC_ERROR;
+}
+
+bool CSparseFileCache::Reset(int64_t pos, bool clearAnyway)
+{
+  CSingleLock lock(m_sync);
+
+  if (clearAnyway)
+  {
+    for (RangeMap::iterator it = m_ranges.begin(); it != m_ranges.end(); ++it)
+      Discard(it->first, it->second);
+    m_ranges.clear();
+  }
+
+  m_cur = pos;
+
+  RangeMap::iterator it = FindRange(pos);
+  if (it != m_ranges.end())
+  {
+    m_rangeBeg = it->first;
+    m_end = it->second;
+    if (m_end > pos)
+    {
+      m_stats.hits++;
+      m_stats.bytesSaved += m_end - pos;
+      return false;
+    }
+  }
+  else
+  {
+    m_rangeBeg = pos;
+    m_end = pos;
+  }
+
+  m_stats.misses++;
+  return true;
+}
+
+int64_t CSparseFileCache::CachedDataEndPosIfSeekTo(int64_t iFilePosition)
+{
+  CSingleLock lock(m_sync);
+  RangeMap::iterator it = FindRange(iFilePosition);
+  if (it != m_ranges.end())
+    return it->second;
+  return iFilePosition;
+}
+
+int64_t CSparseFileCache::CachedDataEndPos()
+{
+  CSingleLock lock(m_sync);
+  return m_end;
+}
+
+bool CSparseFileCache::IsCachedPosition(int64_t iFilePosition)
+{
+  CSingleLock lock(m_sync);
+  return iFilePosition == m_end || FindRange(iFilePosition) != m_ranges.end();
+}
+
+CCacheStrategy *CSparseFileCache::CreateNew()
+{
+  return new CSparseFileCache(m_maxSize);
+}
+
+bool CSparseFileCache::GetStats(SCacheStats &stats)
+{
+  CSingleLock lock(m_sync);
+  stats = m_stats;
+  stats.cached = m_cached;
+  return true;
+}
+
+const uint8_t *CSparseFileCache::MapWindow(int64_t pos)
+{
+  int64_t offset = pos - pos % WINDOW_SIZE;
+  m_useCount++;
+
+  std::vector<MappedWindow>::iterator lru = m_windows.end();
+  for (std::vector<MappedWindow>::iterator it = m_windows.begin(); it != m_windows.end(); ++it)
+  {
+    if (it->offset == offset)
+    {
+      it->lastUse = m_useCount;
+      return it->data + (pos - offset);
+    }
+    if (lru == m_windows.end() || it->lastUse < lru->lastUse)
+      lru = it;
+  }
+
+  // the window may reach past the end of the file, we only ever touch pages
+  // holding data we have written
+  void *data = mmap(NULL, WINDOW_SIZE, PROT_READ, MAP_SHARED, m_fd, offset);
+  if (data == MAP_FAILED)
+  {
+    CLog::Log(LOGERROR, "CSparseFileCache::%s - failed to map cache file at %" PRId64 " (%s)", __FUNCTION__, offset, strerror(errno));
+    return NULL;
+  }
+
+  MappedWindow window;
+  window.offset = offset;
+  window.data = static_cast<uint8_t*>(data);
+  window.lastUse = m_useCount;
+
+  if (m_windows.size() < MAX_WINDOWS)
+    m_windows.push_back(window);
+  else
+  {
+    munmap(lru->data, WINDOW_SIZE);
+    *lru = window;
+  }
+
+  return window.data + (pos - offset);
+}
+
+void CSparseFileCache::UnmapWindows()
+{
+  for (std::vector<MappedWindow>::iterator it = m_windows.begin(); it != m_windows.end(); ++it)
+    munmap(it->data, WINDOW_SIZE);
+  m_windows.clear();
+}
+
+/**
+ * Drops cached data until we are below the size limit again. Ranges farthest
+ * away from the read position go first, from the far end. The range being
+ * read is only trimmed up to the read position.
+ */
+void CSparseFileCache::Evict()
+{
+  if (m_cached <= m_maxSize)
+    return;
+
+  // free a bit more so we don't have to come back on every write
+  int64_t excess = m_cached - m_maxSize + EVICT_CHUNK;
+
+  while (excess > 0)
+  {
+    RangeMap::iterator victim = m_ranges.end();
+    int64_t distance = -1;
+    for (RangeMap::iterator it = m_ranges.begin(); it != m_ranges.end(); ++it)
+    {
+      if (it->first == m_rangeBeg)
+        continue;
+      int64_t d = it->second <= m_cur ? m_cur - it->second : it->first - m_cur;
+      if (d > distance)
+      {
+        distance = d;
+        victim = it;
+      }
+    }
+
+    if (victim != m_ranges.end())
+    {
+      int64_t beg = victim->first;
+      int64_t end = victim->second;
+      int64_t amount = std::min(excess, end - beg);
+      excess -= amount;
+      m_ranges.erase(victim);
+      if (end <= m_cur)
+      {
+        Discard(beg, beg + amount);
+        if (beg + amount < end)
+          m_ranges[beg + amount] = end;
+      }
+      else
+      {
+        Discard(end - amount, end);
+        if (beg < end - amount)
+          m_ranges[beg] = end - amount;
+      }
+      continue;
+    }
+
+    // only the range being read is left, drop what was already read
+    RangeMap::iterator it = m_ranges.find(m_rangeBeg);
+    if (it == m_ranges.end() || m_cur <= m_rangeBeg)
+      break;
+
+    int64_t amount = std::min(excess, std::min(m_cur, it->second) - m_rangeBeg);
+    int64_t end = it->second;
+    excess -= amount;
+    m_ranges.erase(it);
+    Discard(m_rangeBeg, m_rangeBeg + amount);
+    m_rangeBeg += amount;
+    m_ranges[m_rangeBeg] = end;
+  }
+}
+
+void CSparseFileCache::Discard(int64_t start, int64_t end)
+{
+  if (end <= start)
+    return;
+
+  m_cached -= end - start;
+
+#if defined(TARGET_LINUX) && defined(FALLOC_FL_PUNCH_HOLE)
+  // give the disk space back, other platforms keep the blocks until the cache is closed
+  if (fallocate(m_fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, start, end - start) != 0)
+    CLog::Log(LOGDEBUG, "CSparseFileCache::%s - unable to release cache space (%s)", __FUNCTION__, strerror(errno));
+#endif
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "filesystem/CacheStrategy.h"
+#include "filesystem/IFileTypes.h"
+#include "threads/CriticalSection.h"
+#include "threads/Event.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace XFILE {
+
+/*!
+ * \brief Disk backed cache that remembers every byte range fetched from the source.
+ *
+ * Data is stored at its file offset in a sparse temporary file, so ranges that
+ * were fetched before a seek stay available. Seeking back into such a range is
+ * served from disk and the source only has to deliver what follows the range.
+ * Reads go through memory mapped windows of the cache file.
+ *
+ * Once more than maxSize bytes are cached, the ranges farthest away from the
+ * read position are dropped.
+ *
+ * Open() fails if the temp directory is on a file system without sparse
+ * files, CFileCache then falls back to a memory cache.
+ */
+class CSparseFileCache : public CCacheStrategy
+{
+public:
+  CSparseFileCache(int64_t maxSize);
+  virtual ~CSparseFileCache();
+
+  virtual int Open();
+  virtual void Close();
+
+  virtual size_t GetMaxWriteSize(const size_t& iRequestSize);
+  virtual int WriteToCache(const char *buf, size_t len);
+  virtual int ReadFromCache(char *buf, size_t len);
+  virtual int64_t WaitForData(unsigned int minimum, unsigned int millis);
+
+  virtual int64_t Seek(int64_t pos);
+  virtual bool Reset(int64_t pos, bool clearAnyway=true);
+
+  virtual int64_t CachedDataEndPosIfSeekTo(int64_t iFilePosition);
+  virtual int64_t CachedDataEndPos();
+  virtual bool IsCachedPosition(int64_t iFilePosition);
+
+  virtual CCacheStrategy *CreateNew();
+  virtual bool GetStats(SCacheStats &stats);
+
+protected:
+  typedef std::map<int64_t, int64_t> RangeMap; // start -> end (exclusive)
+
+  struct MappedWindow
+  {
+    int64_t offset;
+    uint8_t *data;
+    unsigned int lastUse;
+  };
+
+  static const int64_t WINDOW_SIZE = 8 * 1024 * 1024;
+  static const size_t MAX_WINDOWS = 8;
+  static const int64_t EVICT_CHUNK = 4 * 1024 * 1024;
+  static const int64_t SPARSE_PROBE = 1024 * 1024;
+
+  bool IsSparse();
+  RangeMap::iterator FindRange(int64_t pos);
+  int64_t GetAvailableRead();
+  const uint8_t *MapWindow(int64_t pos);
+  void UnmapWindows();
+  void Evict();
+  void Discard(int64_t start, int64_t end);
+
+  std::string       m_filename;
+  int               m_fd;
+  RangeMap          m_ranges;    /**< byte ranges of the source held by the cache file */
+  int64_t           m_rangeBeg;  /**< start of the range currently being written */
+  int64_t           m_end;       /**< source position of the next write */
+  int64_t           m_cur;       /**< current reading index in file */
+  int64_t           m_maxSize;   /**< maximum number of bytes kept on disk */
+  int64_t           m_cached;    /**< number of bytes currently held in m_ranges */
+  std::vector<MappedWindow> m_windows;
+  unsigned int      m_useCount;
+  SCacheStats       m_stats;
+  CCriticalSection  m_sync;
+  CEvent            m_written;
+};
+
+} // namespace XFILE
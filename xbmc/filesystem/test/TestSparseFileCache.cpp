@@ -0,0 +1,166 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#if defined(TARGET_POSIX)
+
+#include "filesystem/posix/SparseFileCache.h"
+
+#include "gtest/gtest.h"
+
+#include <iostream>
+#include <vector>
+
+using namespace XFILE;
+
+namespace
+{
+
+const int64_t MB = 1024 * 1024;
+
+std::vector<char> Data(int64_t pos, size_t size)
+{
+  std::vector<char> data(size);
+  for (size_t i = 0; i < size; i++)
+    data[i] = (char)((pos + i) * 7);
+  return data;
+}
+
+class TestSparseFileCache : public testing::Test
+{
+protected:
+  TestSparseFileCache() : m_cache(16 * MB) {}
+
+  virtual void SetUp()
+  {
+    m_open = m_cache.Open() == CACHE_RC_OK;
+    if (!m_open)
+      std::cout << "temp directory doesn't support sparse files, skipped" << std::endl;
+  }
+
+  // writes what the source delivers at the cache's write position
+  int Write(int64_t pos, size_t size)
+  {
+    std::vector<char> data = Data(pos, size);
+    return m_cache.WriteToCache(data.data(), size);
+  }
+
+  // reads size bytes at the read position and checks them
+  bool Read(int64_t pos, size_t size)
+  {
+    std::vector<char> data(size);
+    size_t done = 0;
+    while (done < size)
+    {
+      int read = m_cache.ReadFromCache(data.data() + done, size - done);
+      if (read <= 0)
+        return false;
+      done += read;
+    }
+    return data == Data(pos, size);
+  }
+
+  CSparseFileCache m_cache;
+  bool m_open;
+};
+
+}
+
+TEST_F(TestSparseFileCache, SeekBack)
+{
+  if (!m_open)
+    return;
+
+  EXPECT_EQ(1000, Write(0, 1000));
+  EXPECT_TRUE(Read(0, 1000));
+
+  // a new range after a seek ahead
+  EXPECT_TRUE(m_cache.Reset(5000, false));
+  EXPECT_EQ(500, Write(5000, 500));
+  EXPECT_TRUE(Read(5000, 500));
+
+  // seeking back is served from disk, the source moves to the end of the range
+  EXPECT_TRUE(m_cache.IsCachedPosition(100));
+  EXPECT_EQ(1000, m_cache.CachedDataEndPosIfSeekTo(100));
+  EXPECT_FALSE(m_cache.Reset(100, false));
+  EXPECT_EQ(1000, m_cache.CachedDataEndPos());
+  EXPECT_TRUE(Read(100, 900));
+
+  SCacheStats stats;
+  EXPECT_TRUE(m_cache.GetStats(stats));
+  EXPECT_EQ(1u, stats.hits);
+  EXPECT_EQ(1500u, stats.cached);
+}
+
+TEST_F(TestSparseFileCache, Join)
+{
+  if (!m_open)
+    return;
+
+  EXPECT_EQ(1000, Write(0, 1000));
+  EXPECT_TRUE(m_cache.Reset(2000, false));
+  EXPECT_EQ(1000, Write(2000, 1000));
+  EXPECT_FALSE(m_cache.Reset(0, false));
+
+  // what the source delivers for the second range is skipped, writing
+  // continues after it
+  EXPECT_EQ(1500, Write(1000, 1500));
+  EXPECT_EQ(3000, m_cache.CachedDataEndPos());
+  EXPECT_EQ(200, Write(3000, 200));
+  EXPECT_EQ(3200, m_cache.CachedDataEndPos());
+  EXPECT_TRUE(Read(0, 3200));
+
+  // the source may deliver past the end of the joined range in one go
+  EXPECT_TRUE(m_cache.Reset(5000, false));
+  EXPECT_EQ(100, Write(5000, 100));
+  EXPECT_TRUE(m_cache.Reset(4000, false));
+  EXPECT_EQ(1500, Write(4000, 1500));
+  EXPECT_EQ(5500, m_cache.CachedDataEndPos());
+  EXPECT_TRUE(Read(4000, 1500));
+
+  SCacheStats stats;
+  EXPECT_TRUE(m_cache.GetStats(stats));
+  EXPECT_EQ(3200u + 1500u, stats.cached);
+}
+
+TEST_F(TestSparseFileCache, Evict)
+{
+  if (!m_open)
+    return;
+
+  const int64_t chunk = 4 * MB;
+  for (int64_t pos = 0; pos < 12 * chunk; pos += 2 * chunk)
+  {
+    m_cache.Reset(pos, false);
+    for (int64_t done = 0; done < chunk; done += MB)
+    {
+      EXPECT_EQ(MB, Write(pos + done, MB));
+      EXPECT_TRUE(Read(pos + done, MB));
+    }
+  }
+
+  // the range farthest from the read position goes first
+  SCacheStats stats;
+  EXPECT_TRUE(m_cache.GetStats(stats));
+  EXPECT_LE(stats.cached, 16u * MB);
+  EXPECT_FALSE(m_cache.IsCachedPosition(0));
+  EXPECT_TRUE(m_cache.IsCachedPosition(10 * chunk));
+}
+
+#endif
@@ -237,6 +237,7 @@ static const ActionMapping actions[] =
     { "playpvrradio"             , ACTION_PVR_PLAY_RADIO },
     { "record"                   , ACTION_RECORD },
     { "togglecommskip"           , ACTION_TOGGLE_COMMSKIP },
+    { "exportframetrace"         , ACTION_EXPORT_FRAMETRACE },
     { "showtimerrule"            , ACTION_PVR_SHOW_TIMER_RULE },
 
     // Mouse actions
@@ -386,6 +386,7 @@
 #define ACTION_INPUT_TEXT             244
 #define ACTION_VOLUME_SET             245
 #define ACTION_TOGGLE_COMMSKIP        246
+#define ACTION_EXPORT_FRAMETRACE      247 //!< write the frame timeline of VideoPlayer to a trace file
 
 #define ACTION_TOUCH_TAP              401 //!< touch actions
 #define ACTION_TOUCH_TAP_TEN          410 //!< touch actions
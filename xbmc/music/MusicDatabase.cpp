@@ -484,7 +484,9 @@ std::string CMusicDatabase::LoadCuesheet(const std::string& fullSongPath)
 
 bool CMusicDatabase::AddAlbum(CAlbum& album)
 {
-  BeginTransaction();
+  // the album goes in with one commit, and the artist, genre and art links
+  // of all its songs with a few multi-row inserts
+  BeginBatch();
 
   album.idAlbum = AddAlbum(album.strAlbum,
                            album.strMusicBrainzAlbumID,
@@ -549,13 +551,12 @@ bool CMusicDatabase::AddAlbum(CAlbum& album)
                                                         ++albumArt)
     SetArtForItem(album.idAlbum, MediaTypeAlbum, albumArt->first, albumArt->second);
 
-  CommitTransaction();
-  return true;
+  return CommitBatch();
 }
 
 bool CMusicDatabase::UpdateAlbum(CAlbum& album, bool OverrideTagData /* = true*/)
 {
-  BeginTransaction();
+  BeginBatch();
 
   UpdateAlbum(album.idAlbum,
               album.strAlbum, album.strMusicBrainzAlbumID,
@@ -632,8 +633,7 @@ bool CMusicDatabase::UpdateAlbum(CAlbum& album, bool OverrideTagData /* = true*/
   if (!album.art.empty())
     SetArtForItem(album.idAlbum, MediaTypeAlbum, album.art);
 
-  CommitTransaction();
-  return true;
+  return CommitBatch();
 }
 
 int CMusicDatabase::AddSong(const int idAlbum,
@@ -1449,9 +1449,8 @@ bool CMusicDatabase::AddSongArtist(int idArtist, int idSong, const std::string&
 bool CMusicDatabase::AddSongArtist(int idArtist, int idSong, int idRole, const std::string& strArtist, int iOrder)
 {
   std::string strSQL;
-  strSQL = PrepareSQL("replace into song_artist (idArtist, idSong, idRole, strArtist, iOrder) values(%i,%i,%i,'%s',%i)",
-    idArtist, idSong, idRole, strArtist.c_str(), iOrder);
-  return ExecuteQuery(strSQL);
+  strSQL = PrepareSQL("(%i,%i,%i,'%s',%i)", idArtist, idSong, idRole, strArtist.c_str(), iOrder);
+  return QueueBatchInsert("replace into song_artist (idArtist, idSong, idRole, strArtist, iOrder)", strSQL);
 }
 
 int CMusicDatabase::AddSongContributor(int idSong, const std::string& strRole, const std::string& strArtist)
@@ -1468,6 +1467,7 @@ int CMusicDatabase::AddSongContributor(int idSong, const std::string& strRole, c
     int idArtist = -1;
     // Add artist. As we only have name (no MBID) first try to identify artist from song 
     // as they may have already been added with a different role (including MBID).
+    FlushBatch();
     strSQL = PrepareSQL("SELECT idArtist FROM song_artist WHERE idSong = %i AND strArtist LIKE '%s' ", idSong, strArtist.c_str());
     m_pDS->query(strSQL);
     if (m_pDS->num_rows() > 0)
@@ -1563,19 +1563,20 @@ bool CMusicDatabase::GetRolesByArtist(int idArtist, CFileItem* item)
 
 bool CMusicDatabase::DeleteSongArtistsBySong(int idSong)
 {
+  FlushBatch();
   return ExecuteQuery(PrepareSQL("DELETE FROM song_artist WHERE idSong = %i", idSong));
 }
 
 bool CMusicDatabase::AddAlbumArtist(int idArtist, int idAlbum, std::string strArtist, int iOrder)
 {
   std::string strSQL;
-  strSQL = PrepareSQL("replace into album_artist (idArtist, idAlbum, strArtist, iOrder) values(%i,%i,'%s',%i)",
-    idArtist, idAlbum, strArtist.c_str(), iOrder);
-  return ExecuteQuery(strSQL);
+  strSQL = PrepareSQL("(%i,%i,'%s',%i)", idArtist, idAlbum, strArtist.c_str(), iOrder);
+  return QueueBatchInsert("replace into album_artist (idArtist, idAlbum, strArtist, iOrder)", strSQL);
 }
 
 bool CMusicDatabase::DeleteAlbumArtistsByAlbum(int idAlbum)
 {
+  FlushBatch();
   return ExecuteQuery(PrepareSQL("DELETE FROM album_artist WHERE idAlbum = %i", idAlbum));
 }
 
@@ -1585,13 +1586,13 @@ bool CMusicDatabase::AddSongGenre(int idGenre, int idSong, int iOrder)
     return true;
 
   std::string strSQL;
-  strSQL=PrepareSQL("replace into song_genre (idGenre, idSong, iOrder) values(%i,%i,%i)",
-                    idGenre, idSong, iOrder);
-  return ExecuteQuery(strSQL);
+  strSQL=PrepareSQL("(%i,%i,%i)", idGenre, idSong, iOrder);
+  return QueueBatchInsert("replace into song_genre (idGenre, idSong, iOrder)", strSQL);
 };
 
 bool CMusicDatabase::DeleteSongGenresBySong(int idSong)
 {
+  FlushBatch();
   return ExecuteQuery(PrepareSQL("DELETE FROM song_genre WHERE idSong = %i", idSong));
 }
 
@@ -1601,13 +1602,13 @@ bool CMusicDatabase::AddAlbumGenre(int idGenre, int idAlbum, int iOrder)
     return true;
   
   std::string strSQL;
-  strSQL=PrepareSQL("replace into album_genre (idGenre, idAlbum, iOrder) values(%i,%i,%i)",
-                    idGenre, idAlbum, iOrder);
-  return ExecuteQuery(strSQL);
+  strSQL=PrepareSQL("(%i,%i,%i)", idGenre, idAlbum, iOrder);
+  return QueueBatchInsert("replace into album_genre (idGenre, idAlbum, iOrder)", strSQL);
 };
 
 bool CMusicDatabase::DeleteAlbumGenresByAlbum(int idAlbum)
 {
+  FlushBatch();
   return ExecuteQuery(PrepareSQL("DELETE FROM album_genre WHERE idAlbum = %i", idAlbum));
 }
 
@@ -1883,14 +1884,14 @@ int CMusicDatabase::AddPath(const std::string& strPath1)
     if (it != m_pathCache.end())
       return it->second;
 
-    strSQL=PrepareSQL( "select * from path where strPath='%s'", strPath.c_str());
-    m_pDS->query(strSQL);
+    strSQL = "select * from path where strPath=?";
+    m_pDS->query_prepared(strSQL, { strPath });
     if (m_pDS->num_rows() == 0)
     {
       m_pDS->close();
       // doesnt exists, add it
-      strSQL=PrepareSQL("insert into path (idPath, strPath) values( NULL, '%s' )", strPath.c_str());
-      m_pDS->exec(strSQL);
+      strSQL = "insert into path (idPath, strPath) values( NULL, ? )";
+      m_pDS->exec_prepared(strSQL, { strPath });
 
       int idPath = (int)m_pDS->lastinsertid();
       m_pathCache.insert(std::pair<std::string, int>(strPath, idPath));
@@ -3878,11 +3879,11 @@ bool CMusicDatabase::GetArtistsByWhere(const std::string& strBaseDir, const Filt
 
     // get data from returned rows
     items.Reserve(results.size());
-    const dbiplus::query_data &data = m_pDS->get_result_set().records;
+    const dbiplus::result_set &data = m_pDS->get_result_set();
     for (DatabaseResults::const_iterator it = results.begin(); it != results.end(); ++it)
     {
       unsigned int targetRow = (unsigned int)it->at(FieldRow).asInteger();
-      const dbiplus::sql_record* const record = data.at(targetRow);
+      const dbiplus::sql_record* const record = data.record(targetRow);
       
       try
       {
@@ -3905,6 +3906,7 @@ bool CMusicDatabase::GetArtistsByWhere(const std::string& strBaseDir, const Filt
         m_pDS->close();
         CLog::Log(LOGERROR, "%s - out of memory getting listing (got %i)", __FUNCTION__, items.Size());
       }
+      data.release_decoded(targetRow);
     }
 
     // cleanup
@@ -4042,11 +4044,11 @@ bool CMusicDatabase::GetAlbumsByWhere(const std::string &baseDir, const Filter &
 
     // get data from returned rows
     items.Reserve(results.size());
-    const dbiplus::query_data &data = m_pDS->get_result_set().records;
+    const dbiplus::result_set &data = m_pDS->get_result_set();
     for (DatabaseResults::const_iterator it = results.begin(); it != results.end(); ++it)
     {
       unsigned int targetRow = (unsigned int)it->at(FieldRow).asInteger();
-      const dbiplus::sql_record* const record = data.at(targetRow);
+      const dbiplus::sql_record* const record = data.record(targetRow);
       
       try
       {
@@ -4063,6 +4065,7 @@ bool CMusicDatabase::GetAlbumsByWhere(const std::string &baseDir, const Filter &
         m_pDS->close();
         CLog::Log(LOGERROR, "%s - out of memory getting listing (got %i)", __FUNCTION__, items.Size());
       }
+      data.release_decoded(targetRow);
     }
 
     // cleanup
@@ -4165,11 +4168,11 @@ bool CMusicDatabase::GetAlbumsByWhere(const std::string &baseDir, const Filter &
     int albumArtistOffset = album_enumCount;
     int albumId = -1;
 
-    const dbiplus::query_data &data = m_pDS->get_result_set().records;
+    const dbiplus::result_set &data = m_pDS->get_result_set();
     for (DatabaseResults::const_iterator it = results.begin(); it != results.end(); ++it)
     {
       unsigned int targetRow = (unsigned int)it->at(FieldRow).asInteger();
-      const dbiplus::sql_record* const record = data.at(targetRow);
+      const dbiplus::sql_record* const record = data.record(targetRow);
 
       if (albumId != record->at(album_idAlbum).get_asInt())
       { // New album
@@ -4178,6 +4181,7 @@ bool CMusicDatabase::GetAlbumsByWhere(const std::string &baseDir, const Filter &
       }
       // Get artists
       albums.back().artistCredits.emplace_back(GetArtistCreditFromDataset(record, albumArtistOffset));
+      data.release_decoded(targetRow);
     }
 
     m_pDS->close(); // cleanup recordset data
@@ -4288,12 +4292,12 @@ bool CMusicDatabase::GetSongsFullByWhere(const std::string &baseDir, const Filte
     int songArtistOffset = song_enumCount;
     int songId = -1;
     VECARTISTCREDITS artistCredits;
-    const dbiplus::query_data &data = m_pDS->get_result_set().records;
+    const dbiplus::result_set &data = m_pDS->get_result_set();
     int count = 0;
     for (DatabaseResults::const_iterator it = results.begin(); it != results.end(); ++it)
     {
       unsigned int targetRow = (unsigned int)it->at(FieldRow).asInteger();
-      const dbiplus::sql_record* const record = data.at(targetRow);
+      const dbiplus::sql_record* const record = data.record(targetRow);
       
       try
       {
@@ -4328,6 +4332,7 @@ bool CMusicDatabase::GetSongsFullByWhere(const std::string &baseDir, const Filte
         CLog::Log(LOGERROR, "%s: out of memory loading query: %s", __FUNCTION__, filter.where.c_str());
         return (items.Size() > 0);
       }
+      data.release_decoded(targetRow);
     }
     if (!artistCredits.empty())
     {
@@ -4425,12 +4430,12 @@ bool CMusicDatabase::GetSongsByWhere(const std::string &baseDir, const Filter &f
 
     // get data from returned rows
     items.Reserve(results.size());
-    const dbiplus::query_data &data = m_pDS->get_result_set().records;
+    const dbiplus::result_set &data = m_pDS->get_result_set();
     int count = 0;
     for (DatabaseResults::const_iterator it = results.begin(); it != results.end(); ++it)
     {
       unsigned int targetRow = (unsigned int)it->at(FieldRow).asInteger();
-      const dbiplus::sql_record* const record = data.at(targetRow);
+      const dbiplus::sql_record* const record = data.record(targetRow);
       
       try
       {
@@ -4446,6 +4451,7 @@ bool CMusicDatabase::GetSongsByWhere(const std::string &baseDir, const Filter &f
         CLog::Log(LOGERROR, "%s: out of memory loading query: %s", __FUNCTION__, filter.where.c_str());
         return (items.Size() > 0);
       }
+      data.release_decoded(targetRow);
     }
 
     // cleanup
@@ -5582,8 +5588,7 @@ int CMusicDatabase::GetSongIDFromPath(const std::string &filePath)
     URIUtils::Split(filePath, strPath, strFileName);
     URIUtils::AddSlashAtEnd(strPath);
 
-    std::string sql = PrepareSQL("select idSong from song join path on song.idPath = path.idPath where song.strFileName='%s' and path.strPath='%s'", strFileName.c_str(), strPath.c_str());
-    if (!m_pDS->query(sql)) return -1;
+    if (!m_pDS->query_prepared("select idSong from song join path on song.idPath = path.idPath where song.strFileName=? and path.strPath=?", { strFileName, strPath })) return -1;
 
     if (m_pDS->num_rows() == 0)
     {
@@ -5604,6 +5609,10 @@ int CMusicDatabase::GetSongIDFromPath(const std::string &filePath)
 
 bool CMusicDatabase::CommitTransaction()
 {
+  // inside a batch nothing is committed yet, see CDatabase::CommitBatch()
+  if (InBatch())
+    return CDatabase::CommitTransaction();
+
   if (CDatabase::CommitTransaction())
   { // number of items in the db has likely changed, so reset the infomanager cache
     g_infoManager.SetLibraryBool(LIBRARY_HAS_MUSIC, GetSongsCount() > 0);
@@ -6187,10 +6196,11 @@ void CMusicDatabase::SetArtForItem(int mediaId, const std::string &mediaType, co
       m_pDS->exec(sql);
     }
     else
-    { // insert
+    { // insert, replacing art of the same type queued earlier in the batch
       m_pDS->close();
-      sql = PrepareSQL("INSERT INTO art(media_id, media_type, type, url) VALUES (%d, '%s', '%s', '%s')", mediaId, mediaType.c_str(), artType.c_str(), url.c_str());
-      m_pDS->exec(sql);
+      sql = PrepareSQL("(%d, '%s', '%s', '%s')", mediaId, mediaType.c_str(), artType.c_str(), url.c_str());
+      QueueBatchInsert("INSERT INTO art(media_id, media_type, type, url)", sql,
+                       PrepareSQL("%d/%s/%s", mediaId, mediaType.c_str(), artType.c_str()));
     }
   }
   catch (...)
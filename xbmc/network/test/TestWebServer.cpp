@@ -20,12 +20,15 @@
 
 #include <errno.h>
 #include <stdlib.h>
+#include <chrono>
+#include <thread>
 
 #include <gtest/gtest.h>
 #include "system.h"
 #include "URL.h"
 #include "filesystem/CurlFile.h"
 #include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
 #include "interfaces/json-rpc/JSONRPC.h"
 #include "network/WebServer.h"
 #include "network/httprequesthandler/HTTPVfsHandler.h"
@@ -34,6 +37,7 @@
 #endif // HAS_JSONRPC
 #include "settings/MediaSourceSettings.h"
 #include "test/TestUtils.h"
+#include "threads/SystemClock.h"
 #include "utils/JSONVariantParser.h"
 #include "utils/StringUtils.h"
 #include "utils/URIUtils.h"
@@ -51,6 +55,22 @@ using namespace XFILE;
 #define TEST_FILES_HTML         TEST_FILES_DATA ".html"
 #define TEST_FILES_RANGES       TEST_FILES_DATA "-ranges.txt"
 
+// size of a read-ahead range, see CurlFile.cpp
+#define READ_AHEAD_SEGMENT_SIZE (2 * 1024 * 1024)
+
+class CReadAheadCurlFile : public CCurlFile
+{
+public:
+  // bytes held by the read-ahead requests behind the first one
+  unsigned int GetBufferedAhead() const
+  {
+    unsigned int buffered = 0;
+    for (size_t i = 1; i < m_segments.size(); i++)
+      buffered += m_segments[i]->m_buffer.getMaxReadSize();
+    return buffered;
+  }
+};
+
 class TestWebServer : public testing::Test
 {
 protected:
@@ -784,4 +804,59 @@ TEST_F(TestWebServer, CanGetCachedRangedFileWithNewerIfRange)
   curl.SetRequestHeader(MHD_HTTP_HEADER_IF_RANGE, lastModifiedNewer.GetAsRFC1123DateTime());
   ASSERT_TRUE(curl.Get(GetUrlOfTestFile(TEST_FILES_RANGES), result));
   CheckRangesTestFileResponse(curl, result, ranges);
-}
\ No newline at end of file
+}
+
+TEST_F(TestWebServer, CanReadAheadInParallel)
+{
+  // three read-ahead ranges and a bit
+  std::string content(3 * READ_AHEAD_SEGMENT_SIZE + 100, 0);
+  for (size_t i = 0; i < content.size(); i++)
+    content[i] = (char)(i * 7 + i / 4096);
+
+  const std::string tempPath = CSpecialProtocol::TranslatePath("special://temp/");
+  const std::string file = URIUtils::AddFileToFolder(tempPath, "TestWebServer-readahead.bin");
+  CFile writer;
+  ASSERT_TRUE(writer.OpenForWrite(file, true));
+  ASSERT_EQ((ssize_t)content.size(), writer.Write(content.c_str(), content.size()));
+  writer.Close();
+
+  CMediaSource source;
+  source.strName = "WebServer Temp";
+  source.strPath = tempPath;
+  source.vecPaths.push_back(tempPath);
+  source.m_allowSharing = true;
+  source.m_iDriveType = CMediaSource::SOURCE_TYPE_LOCAL;
+  source.m_iLockMode = LOCK_MODE_EVERYONE;
+  source.m_ignore = true;
+  CMediaSourceSettings::GetInstance().AddShare("videos", source);
+
+  CReadAheadCurlFile curl;
+  ASSERT_TRUE(curl.Open(CURL(GetUrl(URIUtils::AddFileToFolder("vfs", CURL::Encode(file))))));
+  unsigned int connections = 3;
+  ASSERT_EQ(0, curl.IoControl(IOCTRL_SET_READAHEAD, &connections));
+
+  // the ranges behind the first one keep loading while the first one is read
+  std::string result;
+  char buffer[4096];
+  ssize_t read = curl.Read(buffer, 16);
+  ASSERT_GT(read, 0);
+  result.append(buffer, read);
+  XbmcThreads::EndTime timeout(10000);
+  while (curl.GetBufferedAhead() < 2 * READ_AHEAD_SEGMENT_SIZE && !timeout.IsTimePast())
+  {
+    read = curl.Read(buffer, 16);
+    ASSERT_GT(read, 0);
+    result.append(buffer, read);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(2u * READ_AHEAD_SEGMENT_SIZE, curl.GetBufferedAhead());
+  EXPECT_LT(result.size(), (size_t)READ_AHEAD_SEGMENT_SIZE);
+
+  while ((read = curl.Read(buffer, sizeof(buffer))) > 0)
+    result.append(buffer, read);
+  curl.Close();
+  EXPECT_EQ(content.size(), result.size());
+  EXPECT_TRUE(content == result);
+
+  CFile::Delete(file);
+}
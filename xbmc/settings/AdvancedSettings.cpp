@@ -160,6 +160,10 @@ void CAdvancedSettings::Initialize()
   m_DXVAAllowHqScaling = true;
   m_videoFpsDetect = 1;
   m_videoBusyDialogDelay_ms = 500;
+  m_videoZeroCopyDemux = true;
+  m_videoPrefetchNextItem = 30;
+  m_videoProbeCache = true;
+  m_videoFrameTimeline = false;
 
   m_mediacodecForceSoftwareRendring = false;
 
@@ -291,6 +295,7 @@ void CAdvancedSettings::Initialize()
   m_bVideoLibraryExportAutoThumbs = false;
   m_bVideoLibraryImportWatchedState = false;
   m_bVideoLibraryImportResumePoint = false;
+  m_bVideoLibraryMemoryIndex = true;
   m_bVideoScannerIgnoreErrors = false;
   m_iVideoLibraryDateAdded = 1; // prefer mtime over ctime and current time
 
@@ -322,6 +327,7 @@ void CAdvancedSettings::Initialize()
   m_curlretries = 2;
   m_curlDisableIPV6 = false;      //Certain hardware/OS combinations have trouble
                                   //with ipv6.
+  m_curlReadAheadConnections = 0; // parallel range requests for cached audio/video, off by default
 
 #if defined(TARGET_DARWIN_IOS)
   m_startFullScreen = true;
@@ -361,6 +367,9 @@ void CAdvancedSettings::Initialize()
   // the following setting determines the readRate of a player data
   // as multiply of the default data read rate
   m_cacheReadFactor = 4.0f;
+  // size the read-ahead from the measured source and playback rates
+  m_cacheAdaptiveFill = true;
+  m_cacheDiskSize = 0;
 
   m_addonPackageFolderSize = 200;
 
@@ -381,6 +390,8 @@ void CAdvancedSettings::Initialize()
 
   m_databaseMusic.Reset();
   m_databaseVideo.Reset();
+  m_databasePoolSize = 4;
+  m_databaseWAL = true;
 
   m_pictureExtensions = ".png|.jpg|.jpeg|.bmp|.gif|.ico|.tif|.tiff|.tga|.pcx|.cbz|.zip|.cbr|.rar|.rss|.webp|.jp2|.apng";
   m_musicExtensions = ".nsv|.m4a|.flac|.aac|.strm|.pls|.rm|.rma|.mpa|.wav|.wma|.ogg|.mp3|.mp2|.m3u|.gdm|.imf|.m15|.sfx|.uni|.ac3|.dts|.cue|.aif|.aiff|.wpl|.ape|.mac|.mpc|.mp+|.mpp|.shn|.zip|.rar|.wv|.dsp|.xsp|.xwav|.waa|.wvs|.wam|.gcm|.idsp|.mpdsp|.mss|.spt|.rsd|.sap|.cmc|.cmr|.dmc|.mpt|.mpd|.rmt|.tmc|.tm8|.tm2|.oga|.url|.pxml|.tta|.rss|.wtv|.mka|.tak|.opus|.dff|.dsf";
@@ -654,6 +665,19 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     // the busy dialog is shown when starting video playback.
     XMLUtils::GetInt(pElement, "busydialogdelayms", m_videoBusyDialogDelay_ms, 0, 1000);
 
+    // hand demuxed payloads to the decoders by reference instead of copying them
+    XMLUtils::GetBoolean(pElement, "zerocopydemux", m_videoZeroCopyDemux);
+
+    // seconds before the end of a playlist item at which the next item
+    // is opened in the background, 0 disables prefetching
+    XMLUtils::GetInt(pElement, "prefetchnextitem", m_videoPrefetchNextItem, 0, 600);
+
+    // reuse the stream info of files which have been probed before
+    XMLUtils::GetBoolean(pElement, "probecache", m_videoProbeCache);
+
+    // record when each video frame passed each stage, for the exportframetrace action
+    XMLUtils::GetBoolean(pElement, "frametimeline", m_videoFrameTimeline);
+
     // Store global display latency settings
     TiXmlElement* pVideoLatency = pElement->FirstChildElement("latency");
     if (pVideoLatency)
@@ -728,6 +752,7 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     XMLUtils::GetBoolean(pElement, "exportautothumbs", m_bVideoLibraryExportAutoThumbs);
     XMLUtils::GetBoolean(pElement, "importwatchedstate", m_bVideoLibraryImportWatchedState);
     XMLUtils::GetBoolean(pElement, "importresumepoint", m_bVideoLibraryImportResumePoint);
+    XMLUtils::GetBoolean(pElement, "memoryindex", m_bVideoLibraryMemoryIndex);
     XMLUtils::GetInt(pElement, "dateadded", m_iVideoLibraryDateAdded);
   }
 
@@ -758,6 +783,7 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     XMLUtils::GetInt(pElement, "curllowspeedtime", m_curllowspeedtime, 1, 1000);
     XMLUtils::GetInt(pElement, "curlretries", m_curlretries, 0, 10);
     XMLUtils::GetBoolean(pElement,"disableipv6", m_curlDisableIPV6);
+    XMLUtils::GetInt(pElement, "curlreadaheadconnections", m_curlReadAheadConnections, 0, 16);
   }
 
   pElement = pRootElement->FirstChildElement("cache");
@@ -766,6 +792,8 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     XMLUtils::GetUInt(pElement, "memorysize", m_cacheMemSize);
     XMLUtils::GetUInt(pElement, "buffermode", m_cacheBufferMode, 0, 4);
     XMLUtils::GetFloat(pElement, "readfactor", m_cacheReadFactor);
+    XMLUtils::GetBoolean(pElement, "adaptivefill", m_cacheAdaptiveFill);
+    XMLUtils::GetUInt(pElement, "disksize", m_cacheDiskSize);
   }
 
   pElement = pRootElement->FirstChildElement("jsonrpc");
@@ -1126,6 +1154,13 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     XMLUtils::GetBoolean(pDatabase, "compression", m_databaseEpg.compression);
   }
 
+  pDatabase = pRootElement->FirstChildElement("databasepool");
+  if (pDatabase)
+  {
+    XMLUtils::GetInt(pDatabase, "connections", m_databasePoolSize, 0, 16);
+    XMLUtils::GetBoolean(pDatabase, "wal", m_databaseWAL);
+  }
+
   pElement = pRootElement->FirstChildElement("enablemultimediakeys");
   if (pElement)
   {
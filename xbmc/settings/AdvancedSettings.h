@@ -191,6 +191,10 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     bool m_DXVAAllowHqScaling;
     int  m_videoFpsDetect;
     int  m_videoBusyDialogDelay_ms;
+    bool m_videoZeroCopyDemux;
+    int  m_videoPrefetchNextItem;
+    bool m_videoProbeCache;
+    bool m_videoFrameTimeline;
     bool m_mediacodecForceSoftwareRendring;
 
     std::string m_videoDefaultPlayer;
@@ -270,6 +274,7 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     bool m_bVideoLibraryExportAutoThumbs;
     bool m_bVideoLibraryImportWatchedState;
     bool m_bVideoLibraryImportResumePoint;
+    bool m_bVideoLibraryMemoryIndex;
 
     bool m_bVideoScannerIgnoreErrors;
     int m_iVideoLibraryDateAdded;
@@ -298,6 +303,7 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     int m_curllowspeedtime;
     int m_curlretries;
     bool m_curlDisableIPV6;
+    int m_curlReadAheadConnections;
 
     bool m_fullScreen;
     bool m_startFullScreen;
@@ -336,6 +342,8 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     DatabaseSettings m_databaseTV;    // advanced tv database setup
     DatabaseSettings m_databaseEpg;   /*!< advanced EPG database setup */
     DatabaseSettings m_databaseADSP;  /*!< advanced audio dsp database setup */
+    int m_databasePoolSize;           /*!< idle connections kept per database, 0 to close them right away */
+    bool m_databaseWAL;               /*!< run sqlite databases in write-ahead log mode */
 
     bool m_guiVisualizeDirtyRegions;
     int  m_guiAlgorithmDirtyRegions;
@@ -344,6 +352,8 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     unsigned int m_cacheMemSize;
     unsigned int m_cacheBufferMode;
     float m_cacheReadFactor;
+    bool m_cacheAdaptiveFill;
+    unsigned int m_cacheDiskSize; // MB kept by the disk backed seek cache, 0 disables it
 
     bool m_jsonOutputCompact;
     unsigned int m_jsonTcpPort;
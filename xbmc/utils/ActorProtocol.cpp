@@ -19,6 +19,7 @@
  */
 
 #include "ActorProtocol.h"
+#include "utils/TimeUtils.h"
 
 using namespace Actor;
 
@@ -33,17 +34,28 @@ void Message::Release()
   if (skip)
     return;
 
-  // free data buffer
-  if (data != buffer)
-    delete [] data;
-
-  // delete event in case of sync message
-  if (event)
-    delete event;
-
+  // payload buffers and event stay with the message for its next use
   origin->ReturnMessage(this);
 }
 
+void Message::SetPayload(const void *payload, int size)
+{
+  if (size > MSG_INTERNAL_BUFFER_SIZE)
+  {
+    if (size > heapBufferSize)
+    {
+      delete [] heapBuffer;
+      heapBuffer = new uint8_t[size];
+      heapBufferSize = size;
+    }
+    data = heapBuffer;
+  }
+  else
+    data = buffer;
+  memcpy(data, payload, size);
+  payloadSize = size;
+}
+
 bool Message::Reply(int sig, void *data /* = NULL*/, int size /* = 0 */)
 {
   if (!isSync)
@@ -63,13 +75,7 @@ bool Message::Reply(int sig, void *data /* = NULL*/, int size /* = 0 */)
     msg->isOut = !isOut;
     replyMessage = msg;
     if (data)
-    {
-      if (size > MSG_INTERNAL_BUFFER_SIZE)
-        msg->data = new uint8_t[size];
-      else
-        msg->data = msg->buffer;
-      memcpy(msg->data, data, size);
-    }
+      msg->SetPayload(data, size);
   }
 
   origin->Unlock();
@@ -127,67 +133,68 @@ void Protocol::ReturnMessage(Message *msg)
 
 bool Protocol::SendOutMessage(int signal, void *data /* = NULL */, int size /* = 0 */, Message *outMsg /* = NULL */)
 {
-  Message *msg;
-  if (outMsg)
-    msg = outMsg;
-  else
-    msg = GetMessage();
-
-  msg->signal = signal;
-  msg->isOut = true;
+  return QueueMessages(true, signal, data, size, 1, outMsg);
+}
 
-  if (data)
-  {
-    if (size > MSG_INTERNAL_BUFFER_SIZE)
-      msg->data = new uint8_t[size];
-    else
-      msg->data = msg->buffer;
-    memcpy(msg->data, data, size);
-  }
+bool Protocol::SendInMessage(int signal, void *data /* = NULL */, int size /* = 0 */, Message *outMsg /* = NULL */)
+{
+  return QueueMessages(false, signal, data, size, 1, outMsg);
+}
 
-  { CSingleLock lock(criticalSection);
-    outMessages.push(msg);
-  }
-  containerOutEvent->Set();
+bool Protocol::SendOutMessages(int signal, const void *data, int size, int count)
+{
+  return QueueMessages(true, signal, data, size, count, NULL);
+}
 
-  return true;
+bool Protocol::SendInMessages(int signal, const void *data, int size, int count)
+{
+  return QueueMessages(false, signal, data, size, count, NULL);
 }
 
-bool Protocol::SendInMessage(int signal, void *data /* = NULL */, int size /* = 0 */, Message *outMsg /* = NULL */)
+bool Protocol::QueueMessages(bool out, int signal, const void *data, int size, int count, Message *outMsg)
 {
   Message *msg;
-  if (outMsg)
-    msg = outMsg;
-  else
-    msg = GetMessage();
+  const uint8_t *payload = (const uint8_t*)data;
 
-  msg->signal = signal;
-  msg->isOut = false;
+  { CSingleLock lock(criticalSection);
+    int64_t now = CurrentHostCounter();
+    for (int i = 0; i < count; i++)
+    {
+      if (outMsg)
+        msg = outMsg;
+      else
+        msg = GetMessage();
 
-  if (data)
-  {
-    if (size > MSG_INTERNAL_BUFFER_SIZE)
-      msg->data = new uint8_t[size];
-    else
-      msg->data = msg->buffer;
-    memcpy(msg->data, data, size);
-  }
+      msg->signal = signal;
+      msg->isOut = out;
+      msg->queueTime = now;
 
-  { CSingleLock lock(criticalSection);
-    inMessages.push(msg);
+      if (payload)
+        msg->SetPayload(payload + i * size, size);
+
+      if (out)
+        outMessages.push(msg);
+      else
+        inMessages.push(msg);
+    }
   }
-  containerInEvent->Set();
+
+  if (out)
+    containerOutEvent->Set();
+  else
+    containerInEvent->Set();
 
   return true;
 }
 
-
 bool Protocol::SendOutMessageSync(int signal, Message **retMsg, int timeout, void *data /* = NULL */, int size /* = 0 */)
 {
   Message *msg = GetMessage();
   msg->isOut = true;
   msg->isSync = true;
-  msg->event = new CEvent;
+  if (!msg->syncEvent)
+    msg->syncEvent = new CEvent;
+  msg->event = msg->syncEvent;
   msg->event->Reset();
   SendOutMessage(signal, data, size, msg);
 
@@ -221,8 +228,8 @@ bool Protocol::ReceiveOutMessage(Message **msg)
   if (outMessages.empty() || outDefered)
     return false;
 
-  *msg = outMessages.front();
-  outMessages.pop();
+  *msg = PopMessage(outMessages, stats.outLatency, stats.outLatencyMax);
+  stats.outMessages++;
 
   return true;
 }
@@ -234,12 +241,36 @@ bool Protocol::ReceiveInMessage(Message **msg)
   if (inMessages.empty() || inDefered)
     return false;
 
-  *msg = inMessages.front();
-  inMessages.pop();
+  *msg = PopMessage(inMessages, stats.inLatency, stats.inLatencyMax);
+  stats.inMessages++;
 
   return true;
 }
 
+Message *Protocol::PopMessage(std::queue<Message*> &queue, int64_t &latency, int64_t &latencyMax)
+{
+  Message *msg = queue.front();
+  queue.pop();
+
+  int64_t queued = CurrentHostCounter() - msg->queueTime;
+  latency += queued;
+  if (queued > latencyMax)
+    latencyMax = queued;
+
+  return msg;
+}
+
+void Protocol::GetStats(ProtocolStats &portStats)
+{
+  CSingleLock lock(criticalSection);
+  portStats = stats;
+}
+
+void Protocol::ResetStats()
+{
+  CSingleLock lock(criticalSection);
+  memset(&stats, 0, sizeof(stats));
+}
 
 void Protocol::Purge()
 {
@@ -22,6 +22,7 @@
 
 #include "threads/Thread.h"
 #include <queue>
+#include <stdint.h>
 #include "memory.h"
 
 #define MSG_INTERNAL_BUFFER_SIZE 32
@@ -31,6 +32,20 @@ namespace Actor
 
 class Protocol;
 
+/**
+ * Per port counters, directions as seen by the owner of the port.
+ * Latencies are host ticks between queueing and receiving a message.
+ */
+struct ProtocolStats
+{
+  uint64_t outMessages;
+  uint64_t inMessages;
+  int64_t outLatency;
+  int64_t outLatencyMax;
+  int64_t inLatency;
+  int64_t inLatencyMax;
+};
+
 class Message
 {
   friend class Protocol;
@@ -51,20 +66,36 @@ public:
   bool Reply(int sig, void *data = NULL, int size = 0);
 
 private:
-  Message() {isSync = false; data = NULL; event = NULL; replyMessage = NULL;};
+  Message() {isSync = false; data = NULL; event = NULL; replyMessage = NULL;
+             heapBuffer = NULL; heapBufferSize = 0; syncEvent = NULL; queueTime = 0;};
+  ~Message() {delete [] heapBuffer; delete syncEvent;};
+  void SetPayload(const void *payload, int size);
+
+  // kept with the message while it sits in the free queue of its port
+  uint8_t *heapBuffer;
+  int heapBufferSize;
+  CEvent *syncEvent;
+  int64_t queueTime;
 };
 
 class Protocol
 {
 public:
   Protocol(std::string name, CEvent* inEvent, CEvent *outEvent)
-    : portName(name), inDefered(false), outDefered(false) {containerInEvent = inEvent; containerOutEvent = outEvent;};
+    : portName(name), inDefered(false), outDefered(false) {containerInEvent = inEvent; containerOutEvent = outEvent; ResetStats();};
   virtual ~Protocol();
   Message *GetMessage();
   void ReturnMessage(Message *msg);
   bool SendOutMessage(int signal, void *data = NULL, int size = 0, Message *outMsg = NULL);
   bool SendInMessage(int signal, void *data = NULL, int size = 0, Message *outMsg = NULL);
   bool SendOutMessageSync(int signal, Message **retMsg, int timeout, void *data = NULL, int size = 0);
+  /**
+   * Queue count messages of the same signal at once, the payload of the
+   * i-th message is at data + i * size. The receiver is woken up once for
+   * the whole batch.
+   */
+  bool SendOutMessages(int signal, const void *data, int size, int count);
+  bool SendInMessages(int signal, const void *data, int size, int count);
   bool ReceiveOutMessage(Message **msg);
   bool ReceiveInMessage(Message **msg);
   void Purge();
@@ -74,15 +105,21 @@ public:
   void DeferOut(bool value) {outDefered = value;};
   void Lock() {criticalSection.lock();};
   void Unlock() {criticalSection.unlock();};
+  void GetStats(ProtocolStats &stats);
+  void ResetStats();
   std::string portName;
 
 protected:
+  bool QueueMessages(bool out, int signal, const void *data, int size, int count, Message *outMsg);
+  Message *PopMessage(std::queue<Message*> &queue, int64_t &latency, int64_t &latencyMax);
+
   CEvent *containerInEvent, *containerOutEvent;
   CCriticalSection criticalSection;
   std::queue<Message*> outMessages;
   std::queue<Message*> inMessages;
   std::queue<Message*> freeMessageQueue;
   bool inDefered, outDefered;
+  ProtocolStats stats;
 };
 
 }
@@ -54,10 +54,34 @@
 #include "platform/android/activity/AndroidFeatures.h"
 #endif
 
+// Bitmask for the xmm and ymm state in XCR0, both have to be saved by the OS for AVX
+#define XCR0_XMM_YMM 0x6
+
+#if defined(TARGET_POSIX) && (defined(__i386__) || defined(__x86_64__))
+#include <cpuid.h>
+
+// Bitmask for ecx returned by cpuid with eax=0x00000001
+#define CPUID_00000001_ECX_OSXSAVE (1<<27)
+
+// /proc/cpuinfo and sysctl report what the cpu supports, AVX is only
+// usable if the OS also saves the ymm registers on context switches
+static bool IsAVXEnabledByOS()
+{
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & CPUID_00000001_ECX_OSXSAVE))
+    return false;
+
+  // xgetbv with ecx=0 reads XCR0
+  __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (eax & XCR0_XMM_YMM) == XCR0_XMM_YMM;
+}
+#endif
+
 #ifdef TARGET_WINDOWS
 #include "utils/CharsetConverter.h"
 #include <algorithm>
 #include <intrin.h>
+#include <immintrin.h>
 #include <Pdh.h>
 #include <PdhMsg.h>
 #pragma comment(lib, "Pdh.lib")
@@ -72,11 +96,16 @@
 #define CPUID_00000001_ECX_SSSE3 (1<<9)
 #define CPUID_00000001_ECX_SSE4  (1<<19)
 #define CPUID_00000001_ECX_SSE42 (1<<20)
+#define CPUID_00000001_ECX_OSXSAVE (1<<27)
+#define CPUID_00000001_ECX_AVX   (1<<28)
 
 #define CPUID_00000001_EDX_MMX   (1<<23)
 #define CPUID_00000001_EDX_SSE   (1<<25)
 #define CPUID_00000001_EDX_SSE2  (1<<26)
 
+// Bitmasks for the values returned by a call to cpuid with eax=0x00000007, ecx=0
+#define CPUID_00000007_EBX_AVX2  (1<<5)
+
 // Extended Features
 // Bitmasks for the values returned by a call to cpuid with eax=0x80000001
 #define CPUID_80000001_EDX_MMX2     (1<<22)
@@ -406,6 +435,10 @@ CCPUInfo::CCPUInfo(void)
               m_cpuFeatures |= CPU_FEATURE_3DNOW;
             else if (0 == strcmp(tok, "3dnowext"))
               m_cpuFeatures |= CPU_FEATURE_3DNOWEXT;
+            else if (0 == strcmp(tok, "avx"))
+              m_cpuFeatures |= CPU_FEATURE_AVX;
+            else if (0 == strcmp(tok, "avx2"))
+              m_cpuFeatures |= CPU_FEATURE_AVX2;
             tok = strtok_r(NULL, " ", &save);
           }
         }
@@ -456,6 +489,11 @@ CCPUInfo::CCPUInfo(void)
 
   ReadCPUFeatures();
 
+#if defined(TARGET_POSIX) && (defined(__i386__) || defined(__x86_64__))
+  if ((m_cpuFeatures & (CPU_FEATURE_AVX | CPU_FEATURE_AVX2)) && !IsAVXEnabledByOS())
+    m_cpuFeatures &= ~(CPU_FEATURE_AVX | CPU_FEATURE_AVX2);
+#endif
+
   // Set MMX2 when SSE is present as SSE is a superset of MMX2 and Intel doesn't set the MMX2 cap
   if (m_cpuFeatures & CPU_FEATURE_SSE)
     m_cpuFeatures |= CPU_FEATURE_MMX2;
@@ -872,6 +910,18 @@ void CCPUInfo::ReadCPUFeatures()
       m_cpuFeatures |= CPU_FEATURE_SSE4;
     if (CPUInfo[CPUINFO_ECX] & CPUID_00000001_ECX_SSE42)
       m_cpuFeatures |= CPU_FEATURE_SSE42;
+    // AVX also needs the OS to save the ymm registers
+    if ((CPUInfo[CPUINFO_ECX] & CPUID_00000001_ECX_AVX) &&
+        (CPUInfo[CPUINFO_ECX] & CPUID_00000001_ECX_OSXSAVE) &&
+        (_xgetbv(0) & XCR0_XMM_YMM) == XCR0_XMM_YMM)
+      m_cpuFeatures |= CPU_FEATURE_AVX;
+  }
+
+  if (MaxStdInfoType >= 7 && (m_cpuFeatures & CPU_FEATURE_AVX))
+  {
+    __cpuidex(CPUInfo, 7, 0);
+    if (CPUInfo[CPUINFO_EBX] & CPUID_00000007_EBX_AVX2)
+      m_cpuFeatures |= CPU_FEATURE_AVX2;
   }
 
   __cpuid(CPUInfo, 0x80000000);
@@ -922,9 +972,21 @@ void CCPUInfo::ReadCPUFeatures()
         m_cpuFeatures |= CPU_FEATURE_3DNOW;
       if (strstr(buffer,"3DNOWEXT "))
        m_cpuFeatures |= CPU_FEATURE_3DNOWEXT;
+      if (strstr(buffer,"AVX1.0 "))
+        m_cpuFeatures |= CPU_FEATURE_AVX;
     }
     else
       m_cpuFeatures |= CPU_FEATURE_MMX;
+
+    len = 512 - 1;
+    memset(buffer, 0, sizeof(buffer));
+    if ((m_cpuFeatures & CPU_FEATURE_AVX) &&
+        sysctlbyname("machdep.cpu.leaf7_features", &buffer, &len, NULL, 0) == 0)
+    {
+      strcat(buffer, " ");
+      if (strstr(buffer,"AVX2 "))
+        m_cpuFeatures |= CPU_FEATURE_AVX2;
+    }
   #endif
 #elif defined(LINUX)
 // empty on purpose, the implementation is in the constructor
@@ -356,18 +356,20 @@ bool DatabaseUtils::GetFieldValue(const dbiplus::field_value &fieldValue, CVaria
   return false;
 }
 
-bool DatabaseUtils::GetDatabaseResults(const MediaType &mediaType, const FieldList &fields, const std::unique_ptr<dbiplus::Dataset> &dataset, DatabaseResults &results)
+namespace
 {
-  if (dataset->num_rows() == 0)
-    return true;
 
-  const dbiplus::result_set &resultSet = dataset->get_result_set();
+/* builds the results of rows [0, rows) of a result, reading the fields of a
+   row through getField(row, column, value) */
+template<typename GetField>
+bool GetResults(const MediaType &mediaType, const FieldList &fields, const dbiplus::record_prop &header, unsigned int rows, GetField getField, DatabaseResults &results)
+{
   unsigned int offset = results.size();
 
   if (fields.empty())
   {
     DatabaseResult result;
-    for (unsigned int index = 0; index < resultSet.records.size(); index++)
+    for (unsigned int index = 0; index < rows; index++)
     {
       result[FieldRow] = index + offset;
       results.push_back(result);
@@ -376,16 +378,17 @@ bool DatabaseUtils::GetDatabaseResults(const MediaType &mediaType, const FieldLi
     return true;
   }
 
-  if (resultSet.record_header.size() < fields.size())
+  if (header.size() < fields.size())
     return false;
 
   std::vector<int> fieldIndexLookup;
   fieldIndexLookup.reserve(fields.size());
   for (FieldList::const_iterator it = fields.begin(); it != fields.end(); ++it)
-    fieldIndexLookup.push_back(GetFieldIndex(*it, mediaType));
+    fieldIndexLookup.push_back(DatabaseUtils::GetFieldIndex(*it, mediaType));
 
-  results.reserve(resultSet.records.size() + offset);
-  for (unsigned int index = 0; index < resultSet.records.size(); index++)
+  results.reserve(rows + offset);
+  dbiplus::field_value fieldValue;
+  for (unsigned int index = 0; index < rows; index++)
   {
     DatabaseResult result;
     result[FieldRow] = index + offset;
@@ -399,8 +402,9 @@ bool DatabaseUtils::GetDatabaseResults(const MediaType &mediaType, const FieldLi
 
       std::pair<Field, CVariant> value;
       value.first = *it;
-      if (!GetFieldValue(resultSet.records[index]->at(fieldIndex), value.second))
-        CLog::Log(LOGWARNING, "GetDatabaseResults: unable to retrieve value of field %s", resultSet.record_header[fieldIndex].name.c_str());
+      if (!getField(index, fieldIndex, fieldValue) ||
+          !DatabaseUtils::GetFieldValue(fieldValue, value.second))
+        CLog::Log(LOGWARNING, "GetDatabaseResults: unable to retrieve value of field %s", header[fieldIndex].name.c_str());
 
       if (value.first == FieldYear &&
          (mediaType == MediaTypeTvShow || mediaType == MediaTypeEpisode))
@@ -448,6 +452,33 @@ bool DatabaseUtils::GetDatabaseResults(const MediaType &mediaType, const FieldLi
   return true;
 }
 
+}
+
+bool DatabaseUtils::GetDatabaseResults(const MediaType &mediaType, const FieldList &fields, const std::unique_ptr<dbiplus::Dataset> &dataset, DatabaseResults &results)
+{
+  if (dataset->num_rows() == 0)
+    return true;
+
+  const dbiplus::result_set &resultSet = dataset->get_result_set();
+  return GetResults(mediaType, fields, resultSet.record_header, resultSet.size(),
+                    [&resultSet](unsigned int row, int column, dbiplus::field_value &value)
+                    {
+                      return resultSet.get_field(row, column, value);
+                    }, results);
+}
+
+bool DatabaseUtils::GetDatabaseResults(const MediaType &mediaType, const FieldList &fields, const dbiplus::record_prop &header, const std::vector<const dbiplus::sql_record*> &records, DatabaseResults &results)
+{
+  return GetResults(mediaType, fields, header, records.size(),
+                    [&records](unsigned int row, int column, dbiplus::field_value &value)
+                    {
+                      if (column >= (int)records[row]->size())
+                        return false;
+                      value = records[row]->at(column);
+                      return true;
+                    }, results);
+}
+
 std::string DatabaseUtils::BuildLimitClause(int end, int start /* = 0 */)
 {
   std::ostringstream sql;
@@ -25,6 +25,7 @@
 #include <string>
 #include <vector>
 
+#include "dbwrappers/qry_dat.h"
 #include "media/MediaType.h"
 
 class CVariant;
@@ -32,7 +33,6 @@ class CVariant;
 namespace dbiplus
 {
   class Dataset;
-  class field_value;
 }
 
 typedef enum {
@@ -162,6 +162,7 @@ public:
   
   static bool GetFieldValue(const dbiplus::field_value &fieldValue, CVariant &variantValue);
   static bool GetDatabaseResults(const MediaType &mediaType, const FieldList &fields, const std::unique_ptr<dbiplus::Dataset> &dataset, DatabaseResults &results);
+  static bool GetDatabaseResults(const MediaType &mediaType, const FieldList &fields, const dbiplus::record_prop &header, const std::vector<const dbiplus::sql_record*> &records, DatabaseResults &results);
 
   static std::string BuildLimitClause(int end, int start = 0);
 
@@ -798,6 +798,20 @@ bool SortUtils::SortFromDataset(const SortDescription &sortDescription, const Me
   return true;
 }
 
+bool SortUtils::SortFromRecords(const SortDescription &sortDescription, const MediaType &mediaType, const dbiplus::record_prop &header, const std::vector<const dbiplus::sql_record*> &records, DatabaseResults &results)
+{
+  FieldList fields;
+  if (!DatabaseUtils::GetSelectFields(SortUtils::GetFieldsForSorting(sortDescription.sortBy), mediaType, fields))
+    fields.clear();
+
+  if (!DatabaseUtils::GetDatabaseResults(mediaType, fields, header, records, results))
+    return false;
+
+  Sort(sortDescription, results);
+
+  return true;
+}
+
 const SortUtils::SortPreparator& SortUtils::getPreparator(SortBy sortBy)
 {
   std::map<SortBy, SortPreparator>::const_iterator it = m_preparators.find(sortBy);
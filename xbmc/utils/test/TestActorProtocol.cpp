@@ -0,0 +1,247 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "utils/ActorProtocol.h"
+#include "threads/Event.h"
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace Actor;
+
+namespace
+{
+
+class CTestProtocol : public Protocol
+{
+public:
+  CTestProtocol(CEvent *inEvent, CEvent *outEvent) : Protocol("test", inEvent, outEvent) {}
+  enum OutSignal
+  {
+    PING = 0,
+  };
+  enum InSignal
+  {
+    PONG,
+  };
+};
+
+struct SLargePayload
+{
+  int values[16];
+};
+
+// receives count messages sent by a thread of its own, the way the actors
+// poll their ports and only wait when nothing is queued
+template<typename F>
+double MessagesPerSecond(CTestProtocol &port, CEvent &outEvent, int count, F sender)
+{
+  auto start = std::chrono::steady_clock::now();
+  std::thread thread(sender);
+  Message *msg;
+  int received = 0;
+  while (received < count)
+  {
+    if (port.ReceiveOutMessage(&msg))
+    {
+      msg->Release();
+      received++;
+      continue;
+    }
+    outEvent.WaitMSec(1000);
+  }
+  thread.join();
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return count / elapsed.count();
+}
+
+}
+
+TEST(TestActorProtocol, Payloads)
+{
+  CEvent inEvent, outEvent;
+  CTestProtocol port(&inEvent, &outEvent);
+  Message *msg;
+
+  for (int i = 0; i < 3; i++)
+  {
+    int small = i;
+    SLargePayload large;
+    for (int j = 0; j < 16; j++)
+      large.values[j] = i * 16 + j;
+    port.SendOutMessage(CTestProtocol::PING, &small, sizeof(small));
+    port.SendOutMessage(CTestProtocol::PING, &large, sizeof(large));
+    port.SendOutMessage(CTestProtocol::PING);
+
+    // messages come back from the pool, payloads must not leak through
+    ASSERT_TRUE(port.ReceiveOutMessage(&msg));
+    EXPECT_EQ((int)sizeof(small), msg->payloadSize);
+    EXPECT_EQ(i, *(int*)msg->data);
+    msg->Release();
+    ASSERT_TRUE(port.ReceiveOutMessage(&msg));
+    EXPECT_EQ((int)sizeof(large), msg->payloadSize);
+    EXPECT_EQ(0, memcmp(&large, msg->data, sizeof(large)));
+    msg->Release();
+    ASSERT_TRUE(port.ReceiveOutMessage(&msg));
+    EXPECT_EQ(0, msg->payloadSize);
+    EXPECT_EQ(NULL, msg->data);
+    msg->Release();
+    EXPECT_FALSE(port.ReceiveOutMessage(&msg));
+  }
+}
+
+TEST(TestActorProtocol, Batch)
+{
+  CEvent inEvent, outEvent;
+  CTestProtocol port(&inEvent, &outEvent);
+  Message *msg;
+
+  std::vector<SLargePayload> payloads(5);
+  for (size_t i = 0; i < payloads.size(); i++)
+    payloads[i].values[0] = i;
+  port.SendInMessages(CTestProtocol::PONG, payloads.data(), sizeof(SLargePayload), payloads.size());
+  EXPECT_TRUE(inEvent.WaitMSec(0));
+
+  for (size_t i = 0; i < payloads.size(); i++)
+  {
+    ASSERT_TRUE(port.ReceiveInMessage(&msg));
+    EXPECT_EQ(CTestProtocol::PONG, msg->signal);
+    EXPECT_FALSE(msg->isOut);
+    EXPECT_EQ((int)i, ((SLargePayload*)msg->data)->values[0]);
+    msg->Release();
+  }
+  EXPECT_FALSE(port.ReceiveInMessage(&msg));
+
+  ProtocolStats stats;
+  port.GetStats(stats);
+  EXPECT_EQ(payloads.size(), stats.inMessages);
+  EXPECT_EQ(0u, stats.outMessages);
+  EXPECT_GE(stats.inLatency, stats.inLatencyMax);
+
+  port.ResetStats();
+  port.GetStats(stats);
+  EXPECT_EQ(0u, stats.inMessages);
+}
+
+TEST(TestActorProtocol, Sync)
+{
+  CEvent inEvent, outEvent;
+  CTestProtocol port(&inEvent, &outEvent);
+
+  std::thread actor([&]() {
+    Message *msg;
+    for (int i = 0; i < 100;)
+    {
+      if (port.ReceiveOutMessage(&msg))
+      {
+        int value = *(int*)msg->data + 1;
+        msg->Reply(CTestProtocol::PONG, &value, sizeof(value));
+        i++;
+        continue;
+      }
+      outEvent.WaitMSec(1000);
+    }
+  });
+
+  Message *reply;
+  for (int i = 0; i < 100; i++)
+  {
+    ASSERT_TRUE(port.SendOutMessageSync(CTestProtocol::PING, &reply, 1000, &i, sizeof(i)));
+    EXPECT_EQ(CTestProtocol::PONG, reply->signal);
+    EXPECT_EQ(i + 1, *(int*)reply->data);
+    reply->Release();
+  }
+  actor.join();
+
+  Message *msg;
+  EXPECT_FALSE(port.SendOutMessageSync(CTestProtocol::PING, &reply, 10));
+  ASSERT_TRUE(port.ReceiveOutMessage(&msg));
+  EXPECT_TRUE(msg->isSyncTimeout);
+  msg->Reply(CTestProtocol::PONG);
+  msg->Release();
+}
+
+// prints throughput only, run with --gtest_also_run_disabled_tests
+TEST(TestActorProtocol, DISABLED_Benchmark)
+{
+  CEvent inEvent, outEvent;
+  CTestProtocol port(&inEvent, &outEvent);
+  const int count = 100000;
+  const int batch = 8;
+  int small = 0;
+  SLargePayload large = {};
+  std::vector<int> smalls(batch);
+
+  double single = MessagesPerSecond(port, outEvent, count, [&]() {
+    for (int i = 0; i < count; i++)
+      port.SendOutMessage(CTestProtocol::PING, &small, sizeof(small));
+  });
+  double singleLarge = MessagesPerSecond(port, outEvent, count, [&]() {
+    for (int i = 0; i < count; i++)
+      port.SendOutMessage(CTestProtocol::PING, &large, sizeof(large));
+  });
+  double batched = MessagesPerSecond(port, outEvent, count, [&]() {
+    for (int i = 0; i < count; i += batch)
+      port.SendOutMessages(CTestProtocol::PING, smalls.data(), sizeof(int), batch);
+  });
+
+  ProtocolStats stats;
+  port.GetStats(stats);
+  EXPECT_EQ(3u * count, stats.outMessages);
+
+  std::thread actor([&]() {
+    Message *msg;
+    for (int i = 0; i < count / 10;)
+    {
+      if (port.ReceiveOutMessage(&msg))
+      {
+        msg->Reply(CTestProtocol::PONG);
+        i++;
+        continue;
+      }
+      outEvent.WaitMSec(1000);
+    }
+  });
+  auto start = std::chrono::steady_clock::now();
+  Message *reply;
+  for (int i = 0; i < count / 10; i++)
+  {
+    port.SendOutMessageSync(CTestProtocol::PING, &reply, 1000);
+    reply->Release();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  actor.join();
+  double sync = count / 10 / elapsed.count();
+
+  std::cout << std::fixed << std::setprecision(0)
+            << "messages/s small: " << single
+            << " large: " << singleLarge
+            << " batched x" << batch << ": " << batched
+            << " sync round trips/s: " << sync << std::endl;
+  std::cout << "mean queue latency: "
+            << (double)stats.outLatency / stats.outMessages << " ticks, max: "
+            << stats.outLatencyMax << " ticks" << std::endl;
+  EXPECT_GT(single, 0.0);
+}
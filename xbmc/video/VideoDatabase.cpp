@@ -52,6 +52,7 @@
 #include "interfaces/AnnouncementManager.h"
 #include "playlists/SmartPlayList.h"
 #include "profiles/ProfilesManager.h"
+#include "ServiceBroker.h"
 #include "settings/AdvancedSettings.h"
 #include "settings/MediaSettings.h"
 #include "settings/MediaSourceSettings.h"
@@ -506,8 +507,8 @@ int CVideoDatabase::GetPathId(const std::string& strPath)
 
     URIUtils::AddSlashAtEnd(strPath1);
 
-    strSQL=PrepareSQL("select idPath from path where strPath='%s'",strPath1.c_str());
-    m_pDS->query(strSQL);
+    strSQL = "select idPath from path where strPath=?";
+    m_pDS->query_prepared(strSQL, { strPath1 });
     if (!m_pDS->eof())
       idPath = m_pDS->fv("path.idPath").get_asInt();
 
@@ -708,22 +709,15 @@ int CVideoDatabase::AddPath(const std::string& strPath, const std::string &paren
 
     int idParentPath = GetPathId(parentPath.empty() ? (std::string)URIUtils::GetParentPath(strPath1) : parentPath);
 
-    // add the path
+    // add the path, unknown parent and date stay NULL
+    dbiplus::field_value parent(idParentPath);
     if (idParentPath < 0)
-    {
-      if (dateAdded.IsValid())
-        strSQL=PrepareSQL("insert into path (idPath, strPath, dateAdded) values (NULL, '%s', '%s')", strPath1.c_str(), dateAdded.GetAsDBDateTime().c_str());
-      else
-        strSQL=PrepareSQL("insert into path (idPath, strPath) values (NULL, '%s')", strPath1.c_str());
-    }
-    else
-    {
-      if (dateAdded.IsValid())
-        strSQL = PrepareSQL("insert into path (idPath, strPath, dateAdded, idParentPath) values (NULL, '%s', '%s', %i)", strPath1.c_str(), dateAdded.GetAsDBDateTime().c_str(), idParentPath);
-      else
-        strSQL=PrepareSQL("insert into path (idPath, strPath, idParentPath) values (NULL, '%s', %i)", strPath1.c_str(), idParentPath);
-    }
-    m_pDS->exec(strSQL);
+      parent.set_isNull();
+    dbiplus::field_value date(dateAdded.GetAsDBDateTime());
+    if (!dateAdded.IsValid())
+      date.set_isNull();
+    strSQL = "insert into path (idPath, strPath, dateAdded, idParentPath) values (NULL, ?, ?, ?)";
+    m_pDS->exec_prepared(strSQL, { strPath1, date, parent });
     idPath = (int)m_pDS->lastinsertid();
     return idPath;
   }
@@ -855,9 +849,8 @@ int CVideoDatabase::AddFile(const std::string& strFileNameAndPath)
     if (idPath < 0)
       return -1;
 
-    std::string strSQL=PrepareSQL("select idFile from files where strFileName='%s' and idPath=%i", strFileName.c_str(),idPath);
-
-    m_pDS->query(strSQL);
+    strSQL = "select idFile from files where strFileName=? and idPath=?";
+    m_pDS->query_prepared(strSQL, { strFileName, idPath });
     if (m_pDS->num_rows() > 0)
     {
       idFile = m_pDS->fv("idFile").get_asInt() ;
@@ -866,8 +859,8 @@ int CVideoDatabase::AddFile(const std::string& strFileNameAndPath)
     }
     m_pDS->close();
 
-    strSQL=PrepareSQL("insert into files (idFile, idPath, strFileName) values(NULL, %i, '%s')", idPath, strFileName.c_str());
-    m_pDS->exec(strSQL);
+    strSQL = "insert into files (idFile, idPath, strFileName) values(NULL, ?, ?)";
+    m_pDS->exec_prepared(strSQL, { idPath, strFileName });
     idFile = (int)m_pDS->lastinsertid();
     return idFile;
   }
@@ -915,6 +908,7 @@ void CVideoDatabase::UpdateFileDateAdded(int idFile, const std::string& strFileN
     }
 
     m_pDS->exec(PrepareSQL("UPDATE files SET dateAdded='%s' WHERE idFile=%d", finalDateAdded.GetAsDBDateTime().c_str(), idFile));
+    InvalidateIndex("file", idFile);
   }
   catch (...)
   {
@@ -1038,9 +1032,7 @@ int CVideoDatabase::GetFileId(const std::string& strFilenameAndPath)
     int idPath = GetPathId(strPath);
     if (idPath >= 0)
     {
-      std::string strSQL;
-      strSQL=PrepareSQL("select idFile from files where strFileName='%s' and idPath=%i", strFileName.c_str(),idPath);
-      m_pDS->query(strSQL);
+      m_pDS->query_prepared("select idFile from files where strFileName=? and idPath=?", { strFileName, idPath });
       if (m_pDS->num_rows() > 0)
       {
         int idFile = m_pDS->fv("files.idFile").get_asInt();
@@ -1564,6 +1556,13 @@ int CVideoDatabase::AddActor(const std::string& name, const std::string& thumbUR
 
 void CVideoDatabase::AddLinkToActor(int mediaId, const char *mediaType, int actorId, const std::string &role, int order)
 {
+  if (InBatch())
+  { // the unique index on the link table skips links we already have
+    QueueBatchInsert(GetInsertIgnore() + " INTO actor_link (actor_id, media_id, media_type, role, cast_order)",
+                     PrepareSQL("(%i,%i,'%s','%s',%i)", actorId, mediaId, mediaType, role.c_str(), order));
+    return;
+  }
+
   std::string sql=PrepareSQL("SELECT 1 FROM actor_link WHERE actor_id=%i AND media_id=%i AND media_type='%s'", actorId, mediaId, mediaType);
 
   if (GetSingleValue(sql).empty())
@@ -1576,6 +1575,13 @@ void CVideoDatabase::AddLinkToActor(int mediaId, const char *mediaType, int acto
 void CVideoDatabase::AddToLinkTable(int mediaId, const std::string& mediaType, const std::string& table, int valueId, const char *foreignKey)
 {
   const char *key = foreignKey ? foreignKey : table.c_str();
+  if (InBatch())
+  { // the unique index on the link table skips links we already have
+    QueueBatchInsert(GetInsertIgnore() + PrepareSQL(" INTO %s_link (%s_id,media_id,media_type)", table.c_str(), key),
+                     PrepareSQL("(%i,%i,'%s')", valueId, mediaId, mediaType.c_str()));
+    return;
+  }
+
   std::string sql = PrepareSQL("SELECT 1 FROM %s_link WHERE %s_id=%i AND media_id=%i AND media_type='%s'", table.c_str(), key, valueId, mediaId, mediaType.c_str());
 
   if (GetSingleValue(sql).empty())
@@ -1590,6 +1596,7 @@ void CVideoDatabase::RemoveFromLinkTable(int mediaId, const std::string& mediaTy
   const char *key = foreignKey ? foreignKey : table.c_str();
   std::string sql = PrepareSQL("DELETE FROM %s_link WHERE %s_id=%i AND media_id=%i AND media_type='%s'", table.c_str(), key, valueId, mediaId, mediaType.c_str());
 
+  FlushBatch();
   ExecuteQuery(sql);
 }
 
@@ -1609,6 +1616,7 @@ void CVideoDatabase::AddLinksToItem(int mediaId, const std::string& mediaType, c
 void CVideoDatabase::UpdateLinksToItem(int mediaId, const std::string& mediaType, const std::string& field, const std::vector<std::string>& values)
 {
   std::string sql = PrepareSQL("DELETE FROM %s_link WHERE media_id=%i AND media_type='%s'", field.c_str(), mediaId, mediaType.c_str());
+  FlushBatch();
   m_pDS->exec(sql);
 
   AddLinksToItem(mediaId, mediaType, field, values);
@@ -1630,6 +1638,7 @@ void CVideoDatabase::AddActorLinksToItem(int mediaId, const std::string& mediaTy
 void CVideoDatabase::UpdateActorLinksToItem(int mediaId, const std::string& mediaType, const std::string& field, const std::vector<std::string>& values)
 {
   std::string sql = PrepareSQL("DELETE FROM %s_link WHERE media_id=%i AND media_type='%s'", field.c_str(), mediaId, mediaType.c_str());
+  FlushBatch();
   m_pDS->exec(sql);
 
   AddActorLinksToItem(mediaId, mediaType, field, values);
@@ -1657,6 +1666,7 @@ void CVideoDatabase::RemoveTagsFromItem(int media_id, const std::string &type)
   if (type.empty())
     return;
 
+  FlushBatch();
   m_pDS2->exec(PrepareSQL("DELETE FROM tag_link WHERE media_id=%d AND media_type='%s'", media_id, type.c_str()));
 }
 
@@ -1767,6 +1777,8 @@ void CVideoDatabase::DeleteDetailsForTvShow(int idTvShow)
     if (NULL == m_pDB.get()) return ;
     if (NULL == m_pDS.get()) return ;
 
+    FlushBatch();
+
     std::string strSQL;
     strSQL=PrepareSQL("DELETE from genre_link WHERE media_id=%i AND media_type='tvshow'", idTvShow);
     m_pDS->exec(strSQL);
@@ -2244,6 +2256,7 @@ int CVideoDatabase::SetDetailsForMovie(const std::string& strFilenameAndPath, CV
       sql += PrepareSQL(", premiered = '%i'", details.GetYear());
     sql += PrepareSQL(" where idMovie=%i", idMovie);
     m_pDS->exec(sql);
+    InvalidateIndex(MediaTypeMovie, idMovie);
     CommitTransaction();
 
     return idMovie;
@@ -2343,6 +2356,7 @@ int CVideoDatabase::UpdateDetailsForMovie(int idMovie, CVideoInfoTag& details, c
       sql += PrepareSQL(", premiered = '%i'", details.GetYear());
     sql += PrepareSQL(" where idMovie=%i", idMovie);
     m_pDS->exec(sql);
+    InvalidateIndex(MediaTypeMovie, idMovie);
 
     CommitTransaction();
 
@@ -2381,6 +2395,7 @@ int CVideoDatabase::SetDetailsForMovieSet(const CVideoInfoTag& details, const st
     // and insert the new row
     std::string sql = PrepareSQL("UPDATE sets SET strSet='%s', strOverview='%s' WHERE idSet=%i", details.m_strTitle.c_str(), details.m_strPlot.c_str(), idSet);
     m_pDS->exec(sql);
+    InvalidateIndex(MediaTypeVideoCollection, idSet);
     CommitTransaction();
 
     return idSet;
@@ -2500,6 +2515,7 @@ bool CVideoDatabase::UpdateDetailsForTvShow(int idTvShow, CVideoInfoTag &details
   sql += PrepareSQL(" WHERE idShow=%i", idTvShow);
   if (ExecuteQuery(sql))
   {
+    InvalidateIndex(MediaTypeTvShow, idTvShow);
     CommitTransaction();
     return true;
   }
@@ -2638,6 +2654,7 @@ int CVideoDatabase::SetDetailsForEpisode(const std::string& strFilenameAndPath,
     sql += PrepareSQL(", idSeason = %i", idSeason);
     sql += PrepareSQL(" where idEpisode=%i", idEpisode);
     m_pDS->exec(sql);
+    InvalidateIndex(MediaTypeEpisode, idEpisode);
     CommitTransaction();
 
     return idEpisode;
@@ -2935,6 +2952,7 @@ void CVideoDatabase::DeleteResumeBookMark(const std::string &strFilenameAndPath)
   {
     std::string sql = PrepareSQL("delete from bookmark where idFile=%i and type=%i", fileID, CBookmark::RESUME);
     m_pDS->exec(sql);
+    InvalidateIndex("file", fileID);
   }
   catch(...)
   {
@@ -3001,6 +3019,7 @@ void CVideoDatabase::AddBookMarkToFile(const std::string& strFilenameAndPath, co
       strSQL=PrepareSQL("insert into bookmark (idBookmark, idFile, timeInSeconds, totalTimeInSeconds, thumbNailImage, player, playerState, type) values(NULL,%i,%f,%f,'%s','%s','%s', %i)", idFile, bookmark.timeInSeconds, bookmark.totalTimeInSeconds, bookmark.thumbNailImage.c_str(), bookmark.player.c_str(), bookmark.playerState.c_str(), (int)type);
 
     m_pDS->exec(strSQL);
+    InvalidateIndex("file", idFile);
   }
   catch (...)
   {
@@ -3034,6 +3053,7 @@ void CVideoDatabase::ClearBookMarkOfFile(const std::string& strFilenameAndPath,
         strSQL=PrepareSQL("update episode set c%02d=-1 where idFile=%i and c%02d=%i", VIDEODB_ID_EPISODE_BOOKMARK, idFile, VIDEODB_ID_EPISODE_BOOKMARK, idBookmark);
         m_pDS->exec(strSQL);
       }
+      InvalidateIndex("file", idFile);
     }
 
     m_pDS->close();
@@ -3069,6 +3089,7 @@ void CVideoDatabase::ClearBookMarksOfFile(int idFile, CBookmark::EType type /*=
       strSQL=PrepareSQL("update episode set c%02d=-1 where idFile=%i", VIDEODB_ID_EPISODE_BOOKMARK, idFile);
       m_pDS->exec(strSQL);
     }
+    InvalidateIndex("file", idFile);
   }
   catch (...)
   {
@@ -3120,6 +3141,7 @@ void CVideoDatabase::AddBookMarkForEpisode(const CVideoInfoTag& tag, const CBook
     int idBookmark = (int)m_pDS->lastinsertid();
     strSQL = PrepareSQL("update episode set c%02d=%i where c%02d=%i and c%02d=%i and idFile=%i", VIDEODB_ID_EPISODE_BOOKMARK, idBookmark, VIDEODB_ID_EPISODE_SEASON, tag.m_iSeason, VIDEODB_ID_EPISODE_EPISODE, tag.m_iEpisode, idFile);
     m_pDS->exec(strSQL);
+    InvalidateIndex("file", idFile);
   }
   catch (...)
   {
@@ -3135,6 +3157,7 @@ void CVideoDatabase::DeleteBookMarkForEpisode(const CVideoInfoTag& tag)
     m_pDS->exec(strSQL);
     strSQL = PrepareSQL("update episode set c%02d=-1 where idEpisode=%i", VIDEODB_ID_EPISODE_BOOKMARK, tag.m_iDbId);
     m_pDS->exec(strSQL);
+    InvalidateIndex(MediaTypeEpisode, tag.m_iDbId);
   }
   catch (...)
   {
@@ -3320,6 +3343,7 @@ void CVideoDatabase::DeleteEpisode(int idEpisode, bool bKeepId /* = false */)
 
       std::string strSQL = PrepareSQL("delete from episode where idEpisode=%i", idEpisode);
       m_pDS->exec(strSQL);
+      InvalidateIndex(MediaTypeEpisode, idEpisode);
     }
 
   }
@@ -3404,6 +3428,7 @@ void CVideoDatabase::DeleteSet(int idSet)
     m_pDS->exec(strSQL);
     strSQL=PrepareSQL("update movie set idSet = null where idSet = %i", idSet);
     m_pDS->exec(strSQL);
+    InvalidateIndex(MediaTypeVideoCollection, idSet);
   }
   catch (...)
   {
@@ -3422,6 +3447,7 @@ void CVideoDatabase::SetMovieSet(int idMovie, int idSet)
     ExecuteQuery(PrepareSQL("update movie set idSet = %i where idMovie = %i", idSet, idMovie));
   else
     ExecuteQuery(PrepareSQL("update movie set idSet = null where idMovie = %i", idMovie));
+  InvalidateIndex(MediaTypeMovie, idMovie);
 }
 
 void CVideoDatabase::DeleteTag(int idTag, VIDEODB_CONTENT_TYPE mediaType)
@@ -4158,10 +4184,11 @@ void CVideoDatabase::SetArtForItem(int mediaId, const MediaType &mediaType, cons
       }
     }
     else
-    { // insert
+    { // insert, replacing art of the same type queued earlier in the batch
       m_pDS->close();
-      sql = PrepareSQL("INSERT INTO art(media_id, media_type, type, url) VALUES (%d, '%s', '%s', '%s')", mediaId, mediaType.c_str(), artType.c_str(), url.c_str());
-      m_pDS->exec(sql);
+      sql = PrepareSQL("(%d, '%s', '%s', '%s')", mediaId, mediaType.c_str(), artType.c_str(), url.c_str());
+      QueueBatchInsert("INSERT INTO art(media_id, media_type, type, url)", sql,
+                       PrepareSQL("%d/%s/%s", mediaId, mediaType.c_str(), artType.c_str()));
     }
   }
   catch (...)
@@ -4202,6 +4229,7 @@ std::string CVideoDatabase::GetArtForItem(int mediaId, const MediaType &mediaTyp
 
 bool CVideoDatabase::RemoveArtForItem(int mediaId, const MediaType &mediaType, const std::string &artType)
 {
+  FlushBatch();
   return ExecuteQuery(PrepareSQL("DELETE FROM art WHERE media_id=%i AND media_type='%s' AND type='%s'", mediaId, mediaType.c_str(), artType.c_str()));
 }
 
@@ -5157,6 +5185,7 @@ void CVideoDatabase::SetPlayCount(const CFileItem &item, int count, const CDateT
     }
 
     m_pDS->exec(strSQL);
+    InvalidateIndex("file", id);
 
     // We only need to announce changes to video items in the library
     if (item.HasVideoInfoTag() && item.GetVideoInfoTag()->m_iDbId > 0)
@@ -5218,6 +5247,7 @@ void CVideoDatabase::UpdateMovieTitle(int idMovie, const std::string& strNewMovi
       CLog::Log(LOGINFO, "Changing Movie set:id:%i New Title:%s", idMovie, strNewMovieTitle.c_str());
       std::string strSQL = PrepareSQL("UPDATE sets SET strSet='%s' WHERE idSet=%i", strNewMovieTitle.c_str(), idMovie );
       m_pDS->exec(strSQL);
+      InvalidateIndex(MediaTypeVideoCollection, idMovie);
     }
 
     if (!content.empty())
@@ -6443,45 +6473,57 @@ bool CVideoDatabase::GetMoviesByWhere(const std::string& strBaseDir, const Filte
       return false;
 
     int total = -1;
-
-    std::string strSQL = "select %s from movie_view ";
-    std::string strSQLExtra;
-    if (!CDatabase::BuildSQL(strSQLExtra, extFilter, strSQLExtra))
-      return false;
-
-    // Apply the limiting directly here if there's no special sorting but limiting
-    if (extFilter.limit.empty() &&
-        sorting.sortBy == SortByNone &&
-       (sorting.limitStart > 0 || sorting.limitEnd > 0))
+    DatabaseResults results;
+    CVideoLibraryIndex::Rows indexedRows;
+    std::vector<const dbiplus::sql_record*> indexedRecords;
+    bool indexed = GetIndexedResults(CVideoLibraryIndex::VIEW_MOVIES, videoUrl, filter, sortDescription, indexedRows, indexedRecords, results, total);
+    if (indexed)
     {
-      total = (int)strtol(GetSingleValue(PrepareSQL(strSQL, "COUNT(1)") + strSQLExtra, m_pDS).c_str(), NULL, 10);
-      strSQLExtra += DatabaseUtils::BuildLimitClause(sorting.limitEnd, sorting.limitStart);
+      if (indexedRecords.empty())
+        return true;
+
+      items.SetProperty("total", total);
     }
+    else
+    {
+      std::string strSQL = "select %s from movie_view ";
+      std::string strSQLExtra;
+      if (!CDatabase::BuildSQL(strSQLExtra, extFilter, strSQLExtra))
+        return false;
 
-    strSQL = PrepareSQL(strSQL, !extFilter.fields.empty() ? extFilter.fields.c_str() : "*") + strSQLExtra;
+      // Apply the limiting directly here if there's no special sorting but limiting
+      if (extFilter.limit.empty() &&
+          sorting.sortBy == SortByNone &&
+         (sorting.limitStart > 0 || sorting.limitEnd > 0))
+      {
+        total = (int)strtol(GetSingleValue(PrepareSQL(strSQL, "COUNT(1)") + strSQLExtra, m_pDS).c_str(), NULL, 10);
+        strSQLExtra += DatabaseUtils::BuildLimitClause(sorting.limitEnd, sorting.limitStart);
+      }
 
-    int iRowsFound = RunQuery(strSQL);
-    if (iRowsFound <= 0)
-      return iRowsFound == 0;
+      strSQL = PrepareSQL(strSQL, !extFilter.fields.empty() ? extFilter.fields.c_str() : "*") + strSQLExtra;
 
-    // store the total value of items as a property
-    if (total < iRowsFound)
-      total = iRowsFound;
-    items.SetProperty("total", total);
-    
-    DatabaseResults results;
-    results.reserve(iRowsFound);
+      int iRowsFound = RunQuery(strSQL);
+      if (iRowsFound <= 0)
+        return iRowsFound == 0;
 
-    if (!SortUtils::SortFromDataset(sortDescription, MediaTypeMovie, m_pDS, results))
-      return false;
+      // store the total value of items as a property
+      if (total < iRowsFound)
+        total = iRowsFound;
+      items.SetProperty("total", total);
+
+      results.reserve(iRowsFound);
+
+      if (!SortUtils::SortFromDataset(sortDescription, MediaTypeMovie, m_pDS, results))
+        return false;
+    }
 
     // get data from returned rows
     items.Reserve(results.size());
-    const query_data &data = m_pDS->get_result_set().records;
+    const dbiplus::result_set &data = m_pDS->get_result_set();
     for (DatabaseResults::const_iterator it = results.begin(); it != results.end(); ++it)
     {
       unsigned int targetRow = (unsigned int)it->at(FieldRow).asInteger();
-      const dbiplus::sql_record* const record = data.at(targetRow);
+      const dbiplus::sql_record* const record = indexed ? indexedRecords[targetRow] : data.record(targetRow);
 
       CVideoInfoTag movie = GetDetailsForMovie(record, getDetails);
       if (CProfilesManager::GetInstance().GetMasterProfile().getLockMode() == LOCK_MODE_EVERYONE ||
@@ -6498,6 +6540,7 @@ bool CVideoDatabase::GetMoviesByWhere(const std::string& strBaseDir, const Filte
         pItem->SetOverlayImage(CGUIListItem::ICON_OVERLAY_UNWATCHED,movie.m_playCount > 0);
         items.Add(pItem);
       }
+      data.release_decoded(targetRow);
     }
 
     // cleanup
@@ -6584,11 +6627,11 @@ bool CVideoDatabase::GetTvShowsByWhere(const std::string& strBaseDir, const Filt
 
     // get data from returned rows
     items.Reserve(results.size());
-    const query_data &data = m_pDS->get_result_set().records;
+    const dbiplus::result_set &data = m_pDS->get_result_set();
     for (DatabaseResults::const_iterator it = results.begin(); it != results.end(); ++it)
     {
       unsigned int targetRow = (unsigned int)it->at(FieldRow).asInteger();
-      const dbiplus::sql_record* const record = data.at(targetRow);
+      const dbiplus::sql_record* const record = data.record(targetRow);
       
       CFileItemPtr pItem(new CFileItem());
       CVideoInfoTag movie = GetDetailsForTvShow(record, getDetails, pItem.get());
@@ -6606,6 +6649,7 @@ bool CVideoDatabase::GetTvShowsByWhere(const std::string& strBaseDir, const Filt
         pItem->SetOverlayImage(CGUIListItem::ICON_OVERLAY_UNWATCHED, (pItem->GetVideoInfoTag()->m_playCount > 0) && (pItem->GetVideoInfoTag()->m_iEpisode > 0));
         items.Add(pItem);
       }
+      data.release_decoded(targetRow);
     }
 
     // cleanup
@@ -6683,40 +6727,53 @@ bool CVideoDatabase::GetEpisodesByWhere(const std::string& strBaseDir, const Fil
     if (!BuildSQL(strBaseDir, strSQLExtra, extFilter, strSQLExtra, videoUrl, sorting))
       return false;
 
-    // Apply the limiting directly here if there's no special sorting but limiting
-    if (extFilter.limit.empty() &&
-      sorting.sortBy == SortByNone &&
-      (sorting.limitStart > 0 || sorting.limitEnd > 0))
+    DatabaseResults results;
+    CVideoLibraryIndex::Rows indexedRows;
+    std::vector<const dbiplus::sql_record*> indexedRecords;
+    bool indexed = GetIndexedResults(CVideoLibraryIndex::VIEW_EPISODES, videoUrl, filter, sorting, indexedRows, indexedRecords, results, total);
+    if (indexed)
     {
-      total = (int)strtol(GetSingleValue(PrepareSQL(strSQL, "COUNT(1)") + strSQLExtra, m_pDS).c_str(), NULL, 10);
-      strSQLExtra += DatabaseUtils::BuildLimitClause(sorting.limitEnd, sorting.limitStart);
+      if (indexedRecords.empty())
+        return true;
+
+      items.SetProperty("total", total);
     }
+    else
+    {
+      // Apply the limiting directly here if there's no special sorting but limiting
+      if (extFilter.limit.empty() &&
+        sorting.sortBy == SortByNone &&
+        (sorting.limitStart > 0 || sorting.limitEnd > 0))
+      {
+        total = (int)strtol(GetSingleValue(PrepareSQL(strSQL, "COUNT(1)") + strSQLExtra, m_pDS).c_str(), NULL, 10);
+        strSQLExtra += DatabaseUtils::BuildLimitClause(sorting.limitEnd, sorting.limitStart);
+      }
 
-    strSQL = PrepareSQL(strSQL, !extFilter.fields.empty() ? extFilter.fields.c_str() : "*") + strSQLExtra;
+      strSQL = PrepareSQL(strSQL, !extFilter.fields.empty() ? extFilter.fields.c_str() : "*") + strSQLExtra;
 
-    int iRowsFound = RunQuery(strSQL);
-    if (iRowsFound <= 0)
-      return iRowsFound == 0;
+      int iRowsFound = RunQuery(strSQL);
+      if (iRowsFound <= 0)
+        return iRowsFound == 0;
+
+      // store the total value of items as a property
+      if (total < iRowsFound)
+        total = iRowsFound;
+      items.SetProperty("total", total);
+
+      results.reserve(iRowsFound);
+      if (!SortUtils::SortFromDataset(sorting, MediaTypeEpisode, m_pDS, results))
+        return false;
+    }
 
-    // store the total value of items as a property
-    if (total < iRowsFound)
-      total = iRowsFound;
-    items.SetProperty("total", total);
-    
-    DatabaseResults results;
-    results.reserve(iRowsFound);
-    if (!SortUtils::SortFromDataset(sorting, MediaTypeEpisode, m_pDS, results))
-      return false;
-    
     // get data from returned rows
     items.Reserve(results.size());
     CLabelFormatter formatter("%H. %T", "");
 
-    const query_data &data = m_pDS->get_result_set().records;
+    const dbiplus::result_set &data = m_pDS->get_result_set();
     for (DatabaseResults::const_iterator it = results.begin(); it != results.end(); ++it)
     {
       unsigned int targetRow = (unsigned int)it->at(FieldRow).asInteger();
-      const dbiplus::sql_record* const record = data.at(targetRow);
+      const dbiplus::sql_record* const record = indexed ? indexedRecords[targetRow] : data.record(targetRow);
 
       CVideoInfoTag movie = GetDetailsForEpisode(record, getDetails);
       if (CProfilesManager::GetInstance().GetMasterProfile().getLockMode() == LOCK_MODE_EVERYONE ||
@@ -6741,6 +6798,7 @@ bool CVideoDatabase::GetEpisodesByWhere(const std::string& strBaseDir, const Fil
         pItem->m_dateTime = movie.m_firstAired;
         items.Add(pItem);
       }
+      data.release_decoded(targetRow);
     }
 
     // cleanup
@@ -7552,11 +7610,11 @@ bool CVideoDatabase::GetMusicVideosByWhere(const std::string &baseDir, const Fil
     // get data from returned rows
     items.Reserve(results.size());
     // get songs from returned subtable
-    const query_data &data = m_pDS->get_result_set().records;
+    const dbiplus::result_set &data = m_pDS->get_result_set();
     for (DatabaseResults::const_iterator it = results.begin(); it != results.end(); ++it)
     {
       unsigned int targetRow = (unsigned int)it->at(FieldRow).asInteger();
-      const dbiplus::sql_record* const record = data.at(targetRow);
+      const dbiplus::sql_record* const record = data.record(targetRow);
       
       CVideoInfoTag musicvideo = GetDetailsForMusicVideo(record, getDetails);
       if (!checkLocks || CProfilesManager::GetInstance().GetMasterProfile().getLockMode() == LOCK_MODE_EVERYONE || g_passwordManager.bMasterUser ||
@@ -7572,6 +7630,7 @@ bool CVideoDatabase::GetMusicVideosByWhere(const std::string &baseDir, const Fil
         item->SetOverlayImage(CGUIListItem::ICON_OVERLAY_UNWATCHED, musicvideo.m_playCount > 0);
         items.Add(item);
       }
+      data.release_decoded(targetRow);
     }
 
     // cleanup
@@ -9316,7 +9375,14 @@ void CVideoDatabase::InvalidatePathHash(const std::string& strPath)
 
 bool CVideoDatabase::CommitTransaction()
 {
-  if (CDatabase::CommitTransaction())
+  // inside a batch nothing is committed yet, see CDatabase::CommitBatch()
+  if (InBatch())
+    return CDatabase::CommitTransaction();
+
+  bool committed = CDatabase::CommitTransaction();
+  // a failed commit leaves nothing behind to skip, only rows to load again
+  FlushIndexChanges();
+  if (committed)
   { // number of items in the db has likely changed, so recalculate
     g_infoManager.SetLibraryBool(LIBRARY_HAS_MOVIES, HasContent(VIDEODB_CONTENT_MOVIES));
     g_infoManager.SetLibraryBool(LIBRARY_HAS_TVSHOWS, HasContent(VIDEODB_CONTENT_TVSHOWS));
@@ -9359,7 +9425,11 @@ bool CVideoDatabase::SetSingleValue(VIDEODB_CONTENT_TYPE type, int dbId, int dbF
     if (strTable.empty())
       return false;
 
-    return SetSingleValue(strTable, StringUtils::Format("c%02u", dbField), strValue, strField, dbId);
+    if (!SetSingleValue(strTable, StringUtils::Format("c%02u", dbField), strValue, strField, dbId))
+      return false;
+
+    InvalidateIndex(DatabaseUtils::MediaTypeFromVideoContentType(type), dbId);
+    return true;
   }
   catch (...)
   {
@@ -9420,6 +9490,7 @@ void CVideoDatabase::AnnounceRemove(std::string content, int id, bool scanning /
   data["id"] = id;
   if (scanning)
     data["transaction"] = true;
+  InvalidateIndex(content, id);
   ANNOUNCEMENT::CAnnouncementManager::GetInstance().Announce(ANNOUNCEMENT::VideoLibrary, "xbmc", "OnRemove", data);
 }
 
@@ -9428,9 +9499,89 @@ void CVideoDatabase::AnnounceUpdate(std::string content, int id)
   CVariant data;
   data["type"] = content;
   data["id"] = id;
+  InvalidateIndex(content, id);
   ANNOUNCEMENT::CAnnouncementManager::GetInstance().Announce(ANNOUNCEMENT::VideoLibrary, "xbmc", "OnUpdate", data);
 }
 
+bool CVideoDatabase::GetIndexedResults(CVideoLibraryIndex::View view, const CVideoDbUrl &videoUrl, const Filter &filter, const SortDescription &sorting,
+                                       CVideoLibraryIndex::Rows &rows, std::vector<const dbiplus::sql_record*> &records, DatabaseResults &results, int &total)
+{
+  // other clients may change a shared database without telling us
+  if (!g_advancedSettings.m_bVideoLibraryMemoryIndex || !m_sqlite)
+    return false;
+
+  if (filter.fields != "*" || !filter.join.empty() || !filter.where.empty() ||
+      !filter.order.empty() || !filter.group.empty() || !filter.limit.empty())
+    return false;
+
+  // only the options CVideoDatabase::GetFilter turns into conditions the index knows
+  const CUrlOptions::UrlOptions& options = videoUrl.GetOptions();
+  if (!options.empty() &&
+     (view == CVideoLibraryIndex::VIEW_MOVIES ? videoUrl.GetType() != "movies" : videoUrl.GetItemType() != "episodes"))
+    return false;
+
+  CVideoLibraryIndex::CQuery query;
+  for (CUrlOptions::UrlOptions::const_iterator option = options.begin(); option != options.end(); ++option)
+  {
+    if (!option->second.isInteger())
+      return false;
+
+    // GetFilter ignores negative show and season ids but not the others
+    int value = (int)option->second.asInteger();
+    if (option->first == "year" && value >= 0)
+      query.year = value;
+    else if (view == CVideoLibraryIndex::VIEW_MOVIES && option->first == "setid" && value >= 0)
+      query.idSet = value;
+    else if (view == CVideoLibraryIndex::VIEW_EPISODES && option->first == "tvshowid")
+      query.idShow = value;
+    else if (view == CVideoLibraryIndex::VIEW_EPISODES && option->first == "season")
+      query.season = value;
+    else
+      return false;
+  }
+
+  dbiplus::record_prop header;
+  std::string database = std::string(m_pDB->getHostName()) + m_pDB->getDatabase();
+  if (!CServiceBroker::GetVideoLibraryIndex().GetRows(view, database, *m_pDS, query, header, rows))
+    return false;
+
+  records.clear();
+  records.reserve(rows.size());
+  for (CVideoLibraryIndex::Rows::const_iterator it = rows.begin(); it != rows.end(); ++it)
+    records.push_back(it->get());
+  total = (int)records.size();
+
+  results.clear();
+  if (records.empty())
+    return true;
+
+  results.reserve(records.size());
+  return SortUtils::SortFromRecords(sorting, view == CVideoLibraryIndex::VIEW_MOVIES ? MediaTypeMovie : MediaTypeEpisode,
+                                    header, records, results);
+}
+
+void CVideoDatabase::InvalidateIndex(const std::string &type, int id)
+{
+  if (!g_advancedSettings.m_bVideoLibraryMemoryIndex || !m_sqlite)
+    return;
+
+  // rows loaded before the commit would otherwise be taken as current
+  m_indexChanges.push_back(std::make_pair(type, id));
+  if (!InTransaction())
+    FlushIndexChanges();
+}
+
+void CVideoDatabase::FlushIndexChanges()
+{
+  if (m_indexChanges.empty())
+    return;
+
+  CVideoLibraryIndex &index = CServiceBroker::GetVideoLibraryIndex();
+  for (std::vector< std::pair<std::string, int> >::const_iterator it = m_indexChanges.begin(); it != m_indexChanges.end(); ++it)
+    index.Invalidate(it->first, it->second);
+  m_indexChanges.clear();
+}
+
 bool CVideoDatabase::GetItemsForPath(const std::string &content, const std::string &strPath, CFileItemList &items)
 {
   std::string path(strPath);
@@ -9747,6 +9898,7 @@ bool CVideoDatabase::SetVideoUserRating(int dbId, int rating, const MediaType& m
       sql = PrepareSQL("UPDATE seasons SET userrating=%i WHERE idSeason = %i", rating, dbId);
 
     m_pDS->exec(sql);
+    InvalidateIndex(mediaType, dbId);
     return true;
   }
   catch (...)
@@ -28,6 +28,7 @@
 #include "dbwrappers/Database.h"
 #include "utils/SortUtils.h"
 #include "video/VideoDbUrl.h"
+#include "video/VideoLibraryIndex.h"
 #include "VideoInfoTag.h"
 
 class CFileItem;
@@ -972,6 +973,33 @@ private:
   std::vector<int> CleanMediaType(const std::string &mediaType, const std::string &cleanableFileIDs,
                                   std::map<int, bool> &pathsDeleteDecisions, std::string &deletedFileIDs, bool silent);
 
-  static void AnnounceRemove(std::string content, int id, bool scanning = false);
-  static void AnnounceUpdate(std::string content, int id);
+  void AnnounceRemove(std::string content, int id, bool scanning = false);
+  void AnnounceUpdate(std::string content, int id);
+
+  /*! \brief Get the rows of a library listing from the video library index
+   Only plain listings of movies and episodes, optionally by set, tv show, season
+   or year, are taken from the index.
+   \param view the view to list
+   \param videoUrl the videodb:// url of the listing
+   \param filter the filter passed in by the caller
+   \param sorting how to sort and limit the rows
+   \param rows receives the rows, they have to be held while records are used
+   \param records receives the rows the results refer to
+   \param results receives the sorted results
+   \param total receives the number of rows before limiting
+   \return false if the listing has to be queried from the database
+   */
+  bool GetIndexedResults(CVideoLibraryIndex::View view, const CVideoDbUrl &videoUrl, const Filter &filter, const SortDescription &sorting,
+                         CVideoLibraryIndex::Rows &rows, std::vector<const dbiplus::sql_record*> &records, DatabaseResults &results, int &total);
+
+  /*! \brief Mark library items as changed in the video library index
+   Inside a transaction the changes are passed on once it is committed.
+   \param type media type of the item, "file" for a file of the files table
+   \param id id of the item, -1 for all items of the type
+   \sa CVideoLibraryIndex::Invalidate
+   */
+  void InvalidateIndex(const std::string &type, int id);
+  void FlushIndexChanges();
+
+  std::vector< std::pair<std::string, int> > m_indexChanges;
 };
@@ -1179,9 +1179,17 @@ namespace VIDEO
 
     std::string redactPath(CURL::GetRedacted(CURL::Decode(pItem->GetPath())));
 
+    // fetch season art before the write batch is started, it may go over the network
+    std::map<int, std::map<std::string, std::string> > seasonArt;
+    if (content == CONTENT_TVSHOWS && pItem->m_bIsFolder && !libraryImport)
+      GetSeasonThumbs(movieDetails, seasonArt, CVideoThumbLoader::GetArtTypes(MediaTypeSeason), useLocal);
+
     CLog::Log(LOGDEBUG, "VideoInfoScanner: Adding new item to %s:%s", TranslateContent(content).c_str(), redactPath.c_str());
     long lResult = -1;
 
+    // write the item with as few statements as we can, committed before the next item is scraped
+    m_database.BeginBatch();
+
     if (content == CONTENT_MOVIES)
     {
       // find local trailer first
@@ -1219,11 +1227,6 @@ namespace VIDEO
         for (std::vector<std::string>::const_iterator i = multipath.begin(); i != multipath.end(); ++i)
           paths.push_back(std::make_pair(*i, URIUtils::GetParentPath(*i)));
 
-        std::map<int, std::map<std::string, std::string> > seasonArt;
-
-        if (!libraryImport)
-          GetSeasonThumbs(movieDetails, seasonArt, CVideoThumbLoader::GetArtTypes(MediaTypeSeason), useLocal);
-
         lResult = m_database.SetDetailsForTvShow(paths, movieDetails, art, seasonArt);
         movieDetails.m_iDbId = lResult;
         movieDetails.m_type = MediaTypeTvShow;
@@ -1261,6 +1264,13 @@ namespace VIDEO
         movieDetails.m_resumePoint.IsSet())
       m_database.AddBookMarkToFile(pItem->GetPath(), movieDetails.m_resumePoint, CBookmark::RESUME);
 
+    if (!m_database.CommitBatch())
+    {
+      CLog::Log(LOGERROR, "VideoInfoScanner: Failed to write %s", redactPath.c_str());
+      m_database.Close();
+      return -1;
+    }
+
     m_database.Close();
 
     CFileItemPtr itemCopy = CFileItemPtr(new CFileItem(*pItem));
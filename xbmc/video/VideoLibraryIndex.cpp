@@ -0,0 +1,440 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "VideoLibraryIndex.h"
+
+#include <cstring>
+#include <utility>
+
+#include "dbwrappers/dataset.h"
+#include "media/MediaType.h"
+#include "threads/SingleLock.h"
+#include "utils/log.h"
+#include "utils/StringUtils.h"
+#include "utils/Variant.h"
+#include "video/VideoDatabase.h"
+
+// reloading a view is cheaper than asking for more than a quarter of its rows by id
+#define INDEX_RELOAD_DIVISOR 4
+// ids per query when loading changed rows
+#define INDEX_IDS_PER_QUERY 500
+
+namespace
+{
+
+struct SViewInfo
+{
+  const char *table;
+  const char *idColumn;
+};
+
+const SViewInfo VIEWS[] =
+{
+  { "movie_view",   "idMovie" },
+  { "episode_view", "idEpisode" }
+};
+
+int GetColumn(const dbiplus::record_prop &header, const char *name)
+{
+  for (unsigned int i = 0; i < header.size(); i++)
+  {
+    if (StringUtils::EqualsNoCase(header[i].name, name))
+      return i;
+  }
+  return -1;
+}
+
+}
+
+CVideoLibraryIndex::CView::CView()
+{
+  Clear();
+}
+
+void CVideoLibraryIndex::CView::Clear()
+{
+  loaded = false;
+  header.clear();
+  rows.clear();
+  files.clear();
+  shows.clear();
+  changed.clear();
+  idColumn = fileColumn = showColumn = setColumn = -1;
+  seasonColumn = sortSeasonColumn = premieredColumn = -1;
+}
+
+CVideoLibraryIndex::CChanges::CChanges()
+{
+  for (int i = 0; i < VIEW_MAX; i++)
+    all[i] = false;
+}
+
+CVideoLibraryIndex::CVideoLibraryIndex()
+{
+}
+
+CVideoLibraryIndex::~CVideoLibraryIndex()
+{
+}
+
+bool CVideoLibraryIndex::GetRows(View view, const std::string &database, dbiplus::Dataset &dataset, const CQuery &query,
+                                 dbiplus::record_prop &header, Rows &rows)
+{
+  if (view < 0 || view >= VIEW_MAX)
+    return false;
+
+  CSingleLock lock(m_critSection);
+
+  CChanges changes;
+  {
+    CSingleLock changesLock(m_changesSection);
+    std::swap(changes, m_changes);
+  }
+
+  if (database != m_database)
+  {
+    for (int i = 0; i < VIEW_MAX; i++)
+      m_views[i].Clear();
+    m_database = database;
+  }
+  else
+    ApplyChanges(changes);
+
+  CView &index = m_views[view];
+  try
+  {
+    if (!index.loaded || index.changed.size() > index.rows.size() / INDEX_RELOAD_DIVISOR)
+      Load(view, dataset);
+    else if (!index.changed.empty())
+      Reload(view, dataset);
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s - failed to load %s", __FUNCTION__, VIEWS[view].table);
+    dataset.close();
+    index.Clear();
+    return false;
+  }
+
+  header = index.header;
+  rows.clear();
+
+  // the same as CVideoDatabase::GetFilter, the columns are text
+  std::string season = query.season >= 0 ? StringUtils::Format("%i", query.season) : "";
+  std::string year = query.year >= 0 ? StringUtils::Format("%i", query.year) : "";
+  if (view == VIEW_EPISODES && query.idShow >= 0)
+  {
+    std::map<int, std::set<int> >::const_iterator show = index.shows.find(query.idShow);
+    if (show == index.shows.end())
+      return true;
+
+    rows.reserve(show->second.size());
+    for (std::set<int>::const_iterator id = show->second.begin(); id != show->second.end(); ++id)
+    {
+      const Row &row = index.rows[*id];
+      if (Matches(view, *row, query, season, year))
+        rows.push_back(row);
+    }
+  }
+  else
+  {
+    rows.reserve(index.rows.size());
+    for (std::map<int, Row>::const_iterator it = index.rows.begin(); it != index.rows.end(); ++it)
+    {
+      if (Matches(view, *it->second, query, season, year))
+        rows.push_back(it->second);
+    }
+  }
+  return true;
+}
+
+void CVideoLibraryIndex::Invalidate(const std::string &type, int id /* = -1 */)
+{
+  CSingleLock lock(m_changesSection);
+
+  if (type == MediaTypeMovie || type == MediaTypeEpisode)
+  {
+    View view = type == MediaTypeMovie ? VIEW_MOVIES : VIEW_EPISODES;
+    if (id < 0)
+      m_changes.all[view] = true;
+    else
+      m_changes.items[view].insert(id);
+  }
+  else if (type == MediaTypeTvShow)
+  {
+    // episodes carry details of their show
+    if (id < 0)
+      m_changes.all[VIEW_EPISODES] = true;
+    else
+      m_changes.shows.insert(id);
+  }
+  else if (type == MediaTypeVideoCollection)
+  {
+    if (id < 0)
+      m_changes.all[VIEW_MOVIES] = true;
+    else
+      m_changes.sets.insert(id);
+  }
+  else if (type == "file")
+  {
+    if (id < 0)
+    {
+      for (int i = 0; i < VIEW_MAX; i++)
+        m_changes.all[i] = true;
+    }
+    else
+      m_changes.files.insert(id);
+  }
+}
+
+void CVideoLibraryIndex::Clear()
+{
+  CSingleLock lock(m_critSection);
+  for (int i = 0; i < VIEW_MAX; i++)
+    m_views[i].Clear();
+
+  CSingleLock changesLock(m_changesSection);
+  m_changes = CChanges();
+}
+
+void CVideoLibraryIndex::Announce(ANNOUNCEMENT::AnnouncementFlag flag, const char *sender, const char *message, const CVariant &data)
+{
+  if (flag != ANNOUNCEMENT::VideoLibrary || strcmp(sender, "xbmc") != 0)
+    return;
+
+  if (strcmp(message, "OnUpdate") == 0 || strcmp(message, "OnRemove") == 0)
+  {
+    // OnUpdate of a played item carries the item instead of type and id
+    const CVariant &item = data.isMember("item") ? data["item"] : data;
+    if (item.isMember("type") && item.isMember("id"))
+      Invalidate(item["type"].asString(), (int)item["id"].asInteger());
+  }
+  else if (strcmp(message, "OnCleanFinished") == 0)
+    Invalidate("file");
+}
+
+void CVideoLibraryIndex::ApplyChanges(const CChanges &changes)
+{
+  for (int view = 0; view < VIEW_MAX; view++)
+  {
+    CView &index = m_views[view];
+    if (!index.loaded)
+      continue;
+
+    if (changes.all[view])
+    {
+      index.Clear();
+      continue;
+    }
+
+    index.changed.insert(changes.items[view].begin(), changes.items[view].end());
+
+    for (std::set<int>::const_iterator file = changes.files.begin(); file != changes.files.end(); ++file)
+    {
+      std::map<int, std::set<int> >::const_iterator it = index.files.find(*file);
+      if (it != index.files.end())
+        index.changed.insert(it->second.begin(), it->second.end());
+    }
+
+    if (view == VIEW_EPISODES)
+    {
+      for (std::set<int>::const_iterator show = changes.shows.begin(); show != changes.shows.end(); ++show)
+      {
+        std::map<int, std::set<int> >::const_iterator it = index.shows.find(*show);
+        if (it != index.shows.end())
+          index.changed.insert(it->second.begin(), it->second.end());
+      }
+    }
+    else if (view == VIEW_MOVIES && !changes.sets.empty() && index.setColumn >= 0)
+    {
+      // set changes are rare, no need for another map
+      for (std::map<int, Row>::const_iterator it = index.rows.begin(); it != index.rows.end(); ++it)
+      {
+        if (changes.sets.find(it->second->at(index.setColumn).get_asInt()) != changes.sets.end())
+          index.changed.insert(it->first);
+      }
+    }
+  }
+}
+
+void CVideoLibraryIndex::Load(View view, dbiplus::Dataset &dataset)
+{
+  CView &index = m_views[view];
+  index.Clear();
+
+  dataset.query(StringUtils::Format("SELECT * FROM %s", VIEWS[view].table));
+  const dbiplus::result_set &result = dataset.get_result_set();
+  index.header = result.record_header;
+  index.idColumn = GetColumn(index.header, VIEWS[view].idColumn);
+  index.fileColumn = GetColumn(index.header, "idFile");
+  if (view == VIEW_MOVIES)
+  {
+    index.setColumn = GetColumn(index.header, "idSet");
+    index.premieredColumn = GetColumn(index.header, "premiered");
+  }
+  else
+  {
+    index.showColumn = GetColumn(index.header, "idShow");
+    index.seasonColumn = GetColumn(index.header, StringUtils::Format("c%02d", VIDEODB_ID_EPISODE_SEASON).c_str());
+    index.sortSeasonColumn = GetColumn(index.header, StringUtils::Format("c%02d", VIDEODB_ID_EPISODE_SORTSEASON).c_str());
+    index.premieredColumn = GetColumn(index.header, "premiered");
+  }
+
+  if (index.idColumn < 0)
+  {
+    dataset.close();
+    throw dbiplus::DbErrors("%s has no %s", VIEWS[view].table, VIEWS[view].idColumn);
+  }
+
+  for (unsigned int row = 0; row < result.size(); row++)
+  {
+    AddRow(index, *result.record(row));
+    result.release_decoded(row);
+  }
+  dataset.close();
+
+  index.loaded = true;
+  CLog::Log(LOGDEBUG, "%s - loaded %u rows of %s", __FUNCTION__, (unsigned int)index.rows.size(), VIEWS[view].table);
+}
+
+void CVideoLibraryIndex::Reload(View view, dbiplus::Dataset &dataset)
+{
+  CView &index = m_views[view];
+  std::set<int> changed;
+  changed.swap(index.changed);
+
+  std::set<int>::const_iterator it = changed.begin();
+  while (it != changed.end())
+  {
+    std::set<int> ids;
+    std::vector<std::string> values;
+    for (; it != changed.end() && ids.size() < INDEX_IDS_PER_QUERY; ++it)
+    {
+      ids.insert(*it);
+      values.push_back(StringUtils::Format("%i", *it));
+    }
+
+    dataset.query(StringUtils::Format("SELECT * FROM %s WHERE %s IN (%s)", VIEWS[view].table, VIEWS[view].idColumn,
+                                      StringUtils::Join(values, ",").c_str()));
+    const dbiplus::result_set &result = dataset.get_result_set();
+    for (unsigned int row = 0; row < result.size(); row++)
+    {
+      const dbiplus::sql_record &record = *result.record(row);
+      ids.erase(record.at(index.idColumn).get_asInt());
+      AddRow(index, record);
+      result.release_decoded(row);
+    }
+    dataset.close();
+
+    // whatever is left was removed
+    for (std::set<int>::const_iterator id = ids.begin(); id != ids.end(); ++id)
+      RemoveRow(index, *id);
+  }
+}
+
+void CVideoLibraryIndex::AddRow(CView &index, const dbiplus::sql_record &record)
+{
+  int id = record.at(index.idColumn).get_asInt();
+  RemoveRow(index, id);
+
+  Row row(new dbiplus::sql_record(record));
+  index.rows[id] = row;
+  if (index.fileColumn >= 0)
+    index.files[row->at(index.fileColumn).get_asInt()].insert(id);
+  if (index.showColumn >= 0)
+    index.shows[row->at(index.showColumn).get_asInt()].insert(id);
+}
+
+void CVideoLibraryIndex::RemoveRow(CView &index, int id)
+{
+  std::map<int, Row>::iterator it = index.rows.find(id);
+  if (it == index.rows.end())
+    return;
+
+  const dbiplus::sql_record &record = *it->second;
+  if (index.fileColumn >= 0)
+  {
+    std::map<int, std::set<int> >::iterator file = index.files.find(record.at(index.fileColumn).get_asInt());
+    if (file != index.files.end())
+    {
+      file->second.erase(id);
+      if (file->second.empty())
+        index.files.erase(file);
+    }
+  }
+  if (index.showColumn >= 0)
+  {
+    std::map<int, std::set<int> >::iterator show = index.shows.find(record.at(index.showColumn).get_asInt());
+    if (show != index.shows.end())
+    {
+      show->second.erase(id);
+      if (show->second.empty())
+        index.shows.erase(show);
+    }
+  }
+  index.rows.erase(it);
+}
+
+bool CVideoLibraryIndex::Matches(View view, const dbiplus::sql_record &record, const CQuery &query,
+                                 const std::string &season, const std::string &year) const
+{
+  const CView &index = m_views[view];
+
+  if (query.idSet >= 0 &&
+     (index.setColumn < 0 || record.at(index.setColumn).get_asInt() != query.idSet))
+    return false;
+
+  if (query.idShow >= 0 &&
+     (index.showColumn < 0 || record.at(index.showColumn).get_asInt() != query.idShow))
+    return false;
+
+  if (query.season >= 0 && query.idShow >= 0)
+  {
+    if (index.seasonColumn < 0 || index.sortSeasonColumn < 0)
+      return false;
+
+    const std::string &episodeSeason = record.at(index.seasonColumn).get_asString();
+    if (query.season == 0)
+    {
+      if (episodeSeason != season)
+        return false;
+    }
+    else if (episodeSeason != season)
+    {
+      // specials airing within the season
+      const std::string &sortSeason = record.at(index.sortSeasonColumn).get_asString();
+      if (episodeSeason != "0" || (sortSeason != "0" && sortSeason != season))
+        return false;
+    }
+  }
+
+  if (query.year >= 0)
+  {
+    if (index.premieredColumn < 0)
+      return false;
+
+    // movies match on the start of premiered, episodes anywhere in it
+    const std::string &premiered = record.at(index.premieredColumn).get_asString();
+    if (view == VIEW_MOVIES ? !StringUtils::StartsWith(premiered, year) : premiered.find(year) == std::string::npos)
+      return false;
+  }
+
+  return true;
+}
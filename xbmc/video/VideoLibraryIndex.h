@@ -0,0 +1,155 @@
+#pragma once
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "dbwrappers/qry_dat.h"
+#include "interfaces/IAnnouncer.h"
+#include "threads/CriticalSection.h"
+
+namespace dbiplus
+{
+  class Dataset;
+}
+
+/*!
+ \brief Rows of movie_view and episode_view kept in memory for library listings.
+
+ The first listing of a view loads all of its rows, later listings only load
+ the rows that changed since. Changes are reported by CVideoDatabase once its
+ writes are committed and by the OnUpdate/OnRemove announcements of the video
+ library. Listings are filtered on the set, tv show, season and year the
+ videodb:// paths select, anything else is left to SQL.
+ */
+class CVideoLibraryIndex : public ANNOUNCEMENT::IAnnouncer
+{
+public:
+  enum View
+  {
+    VIEW_MOVIES = 0,
+    VIEW_EPISODES,
+    VIEW_MAX
+  };
+
+  class CQuery
+  {
+  public:
+    CQuery() : idSet(-1), idShow(-1), season(-1), year(-1) {}
+
+    int idSet;
+    int idShow;
+    int season;
+    int year;
+  };
+
+  typedef std::shared_ptr<const dbiplus::sql_record> Row;
+  typedef std::vector<Row> Rows;
+
+  CVideoLibraryIndex();
+  virtual ~CVideoLibraryIndex();
+
+  /*!
+   \brief Get the rows of a view matching a query.
+
+   Rows are shared with the index and stay valid while they are held, changes
+   replace them instead of modifying them.
+
+   \param view the view to get the rows of
+   \param database identifies the database behind dataset, all views are
+                   dropped whenever it changes
+   \param dataset used to load the view or its changed rows
+   \param query the rows to get
+   \param header receives the columns of the view
+   \param rows receives the matching rows ordered by their id
+   \return false if the view couldn't be loaded
+   */
+  bool GetRows(View view, const std::string &database, dbiplus::Dataset &dataset, const CQuery &query,
+               dbiplus::record_prop &header, Rows &rows);
+
+  /*!
+   \brief Mark the rows built from a library item as changed.
+   \param type media type of the item, "file" for a file of the files table
+   \param id id of the item, -1 for all items of the type
+   */
+  void Invalidate(const std::string &type, int id = -1);
+
+  /*!
+   \brief Drop all views, they are loaded again when used next.
+   */
+  void Clear();
+
+  virtual void Announce(ANNOUNCEMENT::AnnouncementFlag flag, const char *sender, const char *message, const CVariant &data);
+
+private:
+  CVideoLibraryIndex(const CVideoLibraryIndex&);
+  CVideoLibraryIndex const& operator=(CVideoLibraryIndex const&);
+
+  class CView
+  {
+  public:
+    CView();
+    void Clear();
+
+    bool loaded;
+    dbiplus::record_prop header;
+    std::map<int, Row> rows;              // by item id
+    std::map<int, std::set<int> > files;  // item ids by file id, episodes may share a file
+    std::map<int, std::set<int> > shows;  // episode ids by tv show id
+    std::set<int> changed;                // item ids to load again
+    int idColumn;
+    int fileColumn;
+    int showColumn;
+    int setColumn;
+    int seasonColumn;
+    int sortSeasonColumn;
+    int premieredColumn;
+  };
+
+  class CChanges
+  {
+  public:
+    CChanges();
+
+    bool all[VIEW_MAX];
+    std::set<int> items[VIEW_MAX];
+    std::set<int> files;
+    std::set<int> shows;
+    std::set<int> sets;
+  };
+
+  void ApplyChanges(const CChanges &changes);
+  void Load(View view, dbiplus::Dataset &dataset);
+  void Reload(View view, dbiplus::Dataset &dataset);
+  void AddRow(CView &index, const dbiplus::sql_record &record);
+  void RemoveRow(CView &index, int id);
+  bool Matches(View view, const dbiplus::sql_record &record, const CQuery &query,
+               const std::string &season, const std::string &year) const;
+
+  CCriticalSection m_critSection;       // views, held while loading them
+  CCriticalSection m_changesSection;    // changes only, never held while loading
+  std::string m_database;
+  CView m_views[VIEW_MAX];
+  CChanges m_changes;
+};
@@ -0,0 +1,309 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "dbwrappers/sqlitedataset.h"
+#include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
+#include "media/MediaType.h"
+#include "utils/StringUtils.h"
+#include "utils/Variant.h"
+#include "video/VideoLibraryIndex.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+
+using namespace dbiplus;
+
+namespace
+{
+
+const int MOVIES = 20;
+const int SHOWS = 3;
+const int SEASONS = 3;
+const int EPISODES = 4;
+
+class TestVideoLibraryIndex : public testing::Test
+{
+protected:
+  TestVideoLibraryIndex()
+  {
+    m_path = CSpecialProtocol::TranslatePath("special://temp/");
+    XFILE::CFile::Delete(m_path + "TestVideoLibraryIndex.db");
+    m_db.setHostName(m_path.c_str());
+    m_db.setDatabase("TestVideoLibraryIndex");
+    m_db.connect(true);
+    m_ds.reset(m_db.CreateDataset());
+
+    // the columns of movie_view and episode_view the index looks at
+    m_ds->exec("CREATE TABLE movie_view (idMovie integer primary key, idFile integer, idSet integer, c00 text, premiered text)");
+    m_ds->exec("CREATE TABLE episode_view (idEpisode integer primary key, idFile integer, idShow integer, c00 text, c12 text, c15 text, premiered text)");
+
+    // movies 1 to 20 with files 1001 to 1020, the even ones in set 1, premiered 2000 to 2004
+    for (int movie = 1; movie <= MOVIES; movie++)
+      m_ds->exec(m_db.prepare("INSERT INTO movie_view VALUES (%i, %i, %s, 'movie %i', '%i-01-01')", movie, 1000 + movie,
+                              movie % 2 ? "NULL" : "1", movie, 2000 + movie % 5));
+
+    // episodes of seasons 1 to 3 of shows 1 to 3, and a special of show 1 airing in season 2
+    int idEpisode = 1;
+    for (int show = 1; show <= SHOWS; show++)
+      for (int season = 1; season <= SEASONS; season++)
+        for (int episode = 1; episode <= EPISODES; episode++, idEpisode++)
+          m_ds->exec(m_db.prepare("INSERT INTO episode_view VALUES (%i, %i, %i, 'episode %i', '%i', '-1', '%i-05-01')", idEpisode,
+                                  2000 + idEpisode, show, idEpisode, season, 2009 + show));
+    m_ds->exec("INSERT INTO episode_view VALUES (100, 2100, 1, 'special', '0', '2', '2010-05-01')");
+  }
+
+  ~TestVideoLibraryIndex()
+  {
+    m_ds.reset();
+    m_db.disconnect();
+    XFILE::CFile::Delete(m_path + "TestVideoLibraryIndex.db");
+  }
+
+  std::vector<int> GetIds(CVideoLibraryIndex::View view, const CVideoLibraryIndex::CQuery &query, const char *database = "library")
+  {
+    record_prop header;
+    CVideoLibraryIndex::Rows rows;
+    std::vector<int> ids;
+    if (!m_index.GetRows(view, database, *m_ds, query, header, rows))
+      return ids;
+
+    for (CVideoLibraryIndex::Rows::const_iterator row = rows.begin(); row != rows.end(); ++row)
+      ids.push_back((*row)->at(0).get_asInt());
+    return ids;
+  }
+
+  std::string GetTitle(CVideoLibraryIndex::View view, int id)
+  {
+    record_prop header;
+    CVideoLibraryIndex::Rows rows;
+    m_index.GetRows(view, "library", *m_ds, CVideoLibraryIndex::CQuery(), header, rows);
+    for (CVideoLibraryIndex::Rows::const_iterator row = rows.begin(); row != rows.end(); ++row)
+    {
+      if ((*row)->at(0).get_asInt() == id)
+        return (*row)->at(3).get_asString();
+    }
+    return "";
+  }
+
+  std::string m_path;
+  SqliteDatabase m_db;
+  std::unique_ptr<Dataset> m_ds;
+  CVideoLibraryIndex m_index;
+};
+
+}
+
+TEST_F(TestVideoLibraryIndex, Load)
+{
+  CVideoLibraryIndex::CQuery query;
+  EXPECT_EQ(MOVIES, (int)GetIds(CVideoLibraryIndex::VIEW_MOVIES, query).size());
+  EXPECT_EQ(SHOWS * SEASONS * EPISODES + 1, (int)GetIds(CVideoLibraryIndex::VIEW_EPISODES, query).size());
+
+  record_prop header;
+  CVideoLibraryIndex::Rows rows;
+  ASSERT_TRUE(m_index.GetRows(CVideoLibraryIndex::VIEW_MOVIES, "library", *m_ds, query, header, rows));
+  ASSERT_EQ(5u, header.size());
+  EXPECT_EQ("idMovie", header[0].name);
+  EXPECT_EQ("movie 1", rows.front()->at(3).get_asString());
+}
+
+TEST_F(TestVideoLibraryIndex, Filter)
+{
+  CVideoLibraryIndex::CQuery query;
+  query.idSet = 1;
+  std::vector<int> ids = GetIds(CVideoLibraryIndex::VIEW_MOVIES, query);
+  ASSERT_EQ(MOVIES / 2, (int)ids.size());
+  EXPECT_EQ(2, ids.front());
+
+  query.year = 2002;
+  ids = GetIds(CVideoLibraryIndex::VIEW_MOVIES, query);
+  ASSERT_EQ(2u, ids.size());
+  EXPECT_EQ(2, ids[0]);
+  EXPECT_EQ(12, ids[1]);
+
+  query = CVideoLibraryIndex::CQuery();
+  query.idShow = 1;
+  EXPECT_EQ(SEASONS * EPISODES + 1, (int)GetIds(CVideoLibraryIndex::VIEW_EPISODES, query).size());
+
+  // specials are listed in the season they aired in
+  query.season = 2;
+  ids = GetIds(CVideoLibraryIndex::VIEW_EPISODES, query);
+  ASSERT_EQ(EPISODES + 1, (int)ids.size());
+  EXPECT_EQ(100, ids.back());
+  query.season = 3;
+  EXPECT_EQ(EPISODES, (int)GetIds(CVideoLibraryIndex::VIEW_EPISODES, query).size());
+  query.season = 0;
+  ids = GetIds(CVideoLibraryIndex::VIEW_EPISODES, query);
+  ASSERT_EQ(1u, ids.size());
+  EXPECT_EQ(100, ids.front());
+
+  // episodes premiered with their show
+  query = CVideoLibraryIndex::CQuery();
+  query.year = 2011;
+  EXPECT_EQ(SEASONS * EPISODES, (int)GetIds(CVideoLibraryIndex::VIEW_EPISODES, query).size());
+  query.idShow = 1;
+  EXPECT_TRUE(GetIds(CVideoLibraryIndex::VIEW_EPISODES, query).empty());
+}
+
+TEST_F(TestVideoLibraryIndex, Invalidate)
+{
+  EXPECT_EQ("movie 3", GetTitle(CVideoLibraryIndex::VIEW_MOVIES, 3));
+
+  // not seen before it is invalidated
+  m_ds->exec("UPDATE movie_view SET c00='changed' WHERE idMovie=3");
+  EXPECT_EQ("movie 3", GetTitle(CVideoLibraryIndex::VIEW_MOVIES, 3));
+  m_index.Invalidate(MediaTypeMovie, 3);
+  EXPECT_EQ("changed", GetTitle(CVideoLibraryIndex::VIEW_MOVIES, 3));
+
+  // by the file the item is in
+  m_ds->exec("UPDATE movie_view SET c00='watched' WHERE idMovie=4");
+  m_index.Invalidate("file", 1004);
+  EXPECT_EQ("watched", GetTitle(CVideoLibraryIndex::VIEW_MOVIES, 4));
+
+  // by the show the episode belongs to
+  m_ds->exec("UPDATE episode_view SET c00='renamed' WHERE idShow=2");
+  m_index.Invalidate(MediaTypeTvShow, 2);
+  EXPECT_EQ("renamed", GetTitle(CVideoLibraryIndex::VIEW_EPISODES, SEASONS * EPISODES + 1));
+
+  // by the set the movie is in
+  m_ds->exec("UPDATE movie_view SET idSet=2 WHERE idSet=1");
+  m_index.Invalidate(MediaTypeVideoCollection, 1);
+  CVideoLibraryIndex::CQuery query;
+  query.idSet = 2;
+  EXPECT_EQ(MOVIES / 2, (int)GetIds(CVideoLibraryIndex::VIEW_MOVIES, query).size());
+
+  // announcements of the library
+  m_ds->exec("UPDATE movie_view SET c00='announced' WHERE idMovie=5");
+  CVariant data;
+  data["type"] = MediaTypeMovie;
+  data["id"] = 5;
+  m_index.Announce(ANNOUNCEMENT::VideoLibrary, "xbmc", "OnUpdate", data);
+  EXPECT_EQ("announced", GetTitle(CVideoLibraryIndex::VIEW_MOVIES, 5));
+}
+
+TEST_F(TestVideoLibraryIndex, AddRemove)
+{
+  CVideoLibraryIndex::CQuery query;
+  query.idShow = 3;
+  EXPECT_EQ(SEASONS * EPISODES, (int)GetIds(CVideoLibraryIndex::VIEW_EPISODES, query).size());
+
+  m_ds->exec("DELETE FROM episode_view WHERE idEpisode=30");
+  m_ds->exec("INSERT INTO episode_view VALUES (101, 2101, 3, 'new', '4', '-1', '2012-05-01')");
+  m_index.Invalidate(MediaTypeEpisode, 30);
+  m_index.Invalidate(MediaTypeEpisode, 101);
+
+  std::vector<int> ids = GetIds(CVideoLibraryIndex::VIEW_EPISODES, query);
+  ASSERT_EQ(SEASONS * EPISODES, (int)ids.size());
+  EXPECT_TRUE(std::find(ids.begin(), ids.end(), 30) == ids.end());
+  EXPECT_EQ(101, ids.back());
+
+  // an episode moving to another show
+  m_ds->exec("UPDATE episode_view SET idShow=1 WHERE idEpisode=101");
+  m_index.Invalidate(MediaTypeEpisode, 101);
+  EXPECT_EQ(SEASONS * EPISODES - 1, (int)GetIds(CVideoLibraryIndex::VIEW_EPISODES, query).size());
+  query.idShow = 1;
+  EXPECT_EQ(SEASONS * EPISODES + 2, (int)GetIds(CVideoLibraryIndex::VIEW_EPISODES, query).size());
+
+  // most of the view changed
+  m_ds->exec("DELETE FROM movie_view WHERE idMovie > 5");
+  for (int movie = 6; movie <= MOVIES; movie++)
+    m_index.Invalidate(MediaTypeMovie, movie);
+  EXPECT_EQ(5u, GetIds(CVideoLibraryIndex::VIEW_MOVIES, CVideoLibraryIndex::CQuery()).size());
+
+  m_ds->exec("DELETE FROM movie_view");
+  m_index.Invalidate(MediaTypeMovie);
+  EXPECT_TRUE(GetIds(CVideoLibraryIndex::VIEW_MOVIES, CVideoLibraryIndex::CQuery()).empty());
+}
+
+TEST_F(TestVideoLibraryIndex, MultiEpisodeFile)
+{
+  // a double episode, both parts stored in the same file
+  m_ds->exec("INSERT INTO episode_view VALUES (101, 2101, 3, 'part 1', '4', '-1', '2012-05-01')");
+  m_ds->exec("INSERT INTO episode_view VALUES (102, 2101, 3, 'part 2', '4', '-1', '2012-05-01')");
+  EXPECT_EQ("part 1", GetTitle(CVideoLibraryIndex::VIEW_EPISODES, 101));
+  EXPECT_EQ("part 2", GetTitle(CVideoLibraryIndex::VIEW_EPISODES, 102));
+
+  m_ds->exec("UPDATE episode_view SET c00=c00 || ' watched' WHERE idFile=2101");
+  m_index.Invalidate("file", 2101);
+  EXPECT_EQ("part 1 watched", GetTitle(CVideoLibraryIndex::VIEW_EPISODES, 101));
+  EXPECT_EQ("part 2 watched", GetTitle(CVideoLibraryIndex::VIEW_EPISODES, 102));
+
+  // removing one part keeps the other one reachable by the file
+  m_ds->exec("DELETE FROM episode_view WHERE idEpisode=101");
+  m_index.Invalidate(MediaTypeEpisode, 101);
+  m_ds->exec("UPDATE episode_view SET c00='part 2 unwatched' WHERE idEpisode=102");
+  m_index.Invalidate("file", 2101);
+  EXPECT_EQ("", GetTitle(CVideoLibraryIndex::VIEW_EPISODES, 101));
+  EXPECT_EQ("part 2 unwatched", GetTitle(CVideoLibraryIndex::VIEW_EPISODES, 102));
+}
+
+TEST_F(TestVideoLibraryIndex, Database)
+{
+  EXPECT_EQ(MOVIES, (int)GetIds(CVideoLibraryIndex::VIEW_MOVIES, CVideoLibraryIndex::CQuery()).size());
+
+  // another database is loaded from scratch, changes or not
+  m_ds->exec("DELETE FROM movie_view WHERE idMovie > 10");
+  EXPECT_EQ(MOVIES, (int)GetIds(CVideoLibraryIndex::VIEW_MOVIES, CVideoLibraryIndex::CQuery()).size());
+  EXPECT_EQ(10u, GetIds(CVideoLibraryIndex::VIEW_MOVIES, CVideoLibraryIndex::CQuery(), "profile").size());
+
+  m_ds->exec("DROP TABLE movie_view");
+  m_index.Clear();
+  EXPECT_TRUE(GetIds(CVideoLibraryIndex::VIEW_MOVIES, CVideoLibraryIndex::CQuery(), "profile").empty());
+}
+
+// prints timings only, run with --gtest_also_run_disabled_tests
+TEST_F(TestVideoLibraryIndex, DISABLED_Benchmark)
+{
+  const int movies = 5000;
+  m_ds->exec("DELETE FROM movie_view");
+  m_db.start_transaction();
+  for (int movie = 1; movie <= movies; movie++)
+    m_ds->exec(m_db.prepare("INSERT INTO movie_view VALUES (%i, %i, %i, 'movie %i', '%i-01-01')", movie, movie, movie % 50, movie, 1950 + movie % 70));
+  m_db.commit_transaction();
+
+  // listing all movies, with a play count changed in between
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 10; i++)
+  {
+    m_ds->query("SELECT * FROM movie_view");
+    const result_set &result = m_ds->get_result_set();
+    for (unsigned int row = 0; row < result.size(); row++)
+      EXPECT_FALSE(result.record(row)->empty());
+    m_ds->close();
+  }
+  std::chrono::duration<double> sql = std::chrono::steady_clock::now() - start;
+
+  GetIds(CVideoLibraryIndex::VIEW_MOVIES, CVideoLibraryIndex::CQuery());
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 10; i++)
+  {
+    m_index.Invalidate(MediaTypeMovie, i + 1);
+    EXPECT_EQ(movies, (int)GetIds(CVideoLibraryIndex::VIEW_MOVIES, CVideoLibraryIndex::CQuery()).size());
+  }
+  std::chrono::duration<double> indexed = std::chrono::steady_clock::now() - start;
+
+  std::cout << "10 listings of " << movies << " movies, sql: " << sql.count() * 1000 << " ms, index: "
+            << indexed.count() * 1000 << " ms" << std::endl;
+}